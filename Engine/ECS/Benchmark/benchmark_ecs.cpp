@@ -0,0 +1,291 @@
+#include "Laniakea/ECS/ECS.h"
+#include "Laniakea/ECS/ComponentBase.h"
+#include "Laniakea/ECS/ECSReplayer.h"
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+
+struct UnitComponent : public ComponentBase
+{
+	UnitComponent ( EntityHandle owner, int hp, int team )
+			: ComponentBase ( owner ), HP ( hp ), Team ( team )
+	{};
+	int HP = 100;
+	int Team = 0;
+};
+
+struct PositionComponent : public ComponentBase
+{
+	PositionComponent ( EntityHandle owner, SpatialPoint position )
+			: ComponentBase ( owner ), Position ( position )
+	{};
+	SpatialPoint Position;
+};
+
+template <typename Func>
+double MeasureMicroseconds ( std::size_t iterations, Func && func )
+{
+	const auto Start = std::chrono::steady_clock::now ();
+	for ( std::size_t i = 0; i < iterations; i ++ )
+		func ();
+	const std::chrono::duration <double, std::micro> Elapsed = std::chrono::steady_clock::now () - Start;
+	return Elapsed . count () / ( double ) iterations;
+}
+
+void Report ( const std::string & name, std::size_t entitiesCount, double microseconds )
+{
+	std::cout << std::left << std::setw ( 40 ) << name << std::setw ( 10 ) << entitiesCount
+			<< std::fixed << std::setprecision ( 2 ) << microseconds << " us" << std::endl;
+}
+
+void RunIndexBenchmark ( std::size_t entitiesCount )
+{
+	ECS ecs;
+	ecs . RegisterComponent <UnitComponent> ();
+	std::default_random_engine Generator;
+	std::uniform_int_distribution <int> HPDistribution ( 0, 100 );
+	std::uniform_int_distribution <int> TeamDistribution ( 0, 7 );
+
+	std::vector <EntityHandle> Entities;
+	for ( std::size_t i = 0; i < entitiesCount; i ++ ) {
+		auto e = ecs . CreateEntity ();
+		Entities . push_back ( e );
+		ecs . AddComponent <UnitComponent> ( e, { e, HPDistribution ( Generator ), TeamDistribution ( Generator ) } );
+	}
+	const auto Units = ecs . GetComponentsByType <UnitComponent> () . lock ();
+	std::vector <EntityHandle> Result;
+	Result . reserve ( entitiesCount );
+	std::size_t Sink = 0;
+
+	// Scans
+	Report ( "scan HP < 20", entitiesCount, MeasureMicroseconds ( 100, [ & ] ()
+	{
+		Result . clear ();
+		for ( const auto & Unit : * Units ) {
+			if ( Unit . HP < 20 )
+				Result . push_back ( Unit . GetOwner () );
+		}
+		Sink += Result . size ();
+	} ) );
+	Report ( "scan Team == 3", entitiesCount, MeasureMicroseconds ( 100, [ & ] ()
+	{
+		Result . clear ();
+		for ( const auto & Unit : * Units ) {
+			if ( Unit . Team == 3 )
+				Result . push_back ( Unit . GetOwner () );
+		}
+		Sink += Result . size ();
+	} ) );
+
+	// 1 % of units change HP per frame, then the query runs once
+	const auto ChangesCount = std::max ( entitiesCount / 100, std::size_t ( 1 ) );
+	std::uniform_int_distribution <std::size_t> EntityDistribution ( 0, entitiesCount - 1 );
+	Report ( "1% changes + scan (no index)", entitiesCount, MeasureMicroseconds ( 100, [ & ] ()
+	{
+		for ( std::size_t i = 0; i < ChangesCount; i ++ ) {
+			const auto Entity = Entities[ EntityDistribution ( Generator ) ];
+			ecs . GetComponent <UnitComponent> ( Entity ) . HP = HPDistribution ( Generator );
+		}
+		Result . clear ();
+		for ( const auto & Unit : * Units ) {
+			if ( Unit . HP < 20 )
+				Result . push_back ( Unit . GetOwner () );
+		}
+		Sink += Result . size ();
+	} ) );
+
+	// Index builds
+	std::shared_ptr <SortedIndex <UnitComponent, int>> ByHP;
+	std::shared_ptr <HashIndex <UnitComponent, int>> ByTeam;
+	std::shared_ptr <HistogramIndex <UnitComponent, int>> HPHistogram;
+	Report ( "build sorted index", entitiesCount, MeasureMicroseconds ( 1, [ & ] ()
+	{
+		ByHP = ecs . AddSortedIndex <UnitComponent> ( & UnitComponent::HP );
+		Sink += ByHP -> LessThan ( 0 ) . size ();
+	} ) );
+	Report ( "build hash index", entitiesCount, MeasureMicroseconds ( 1, [ & ] ()
+	{
+		ByTeam = ecs . AddHashIndex <UnitComponent> ( & UnitComponent::Team );
+	} ) );
+	Report ( "build histogram index", entitiesCount, MeasureMicroseconds ( 1, [ & ] ()
+	{
+		HPHistogram = ecs . AddHistogramIndex <UnitComponent> ( & UnitComponent::HP, 0, 101, 20 );
+	} ) );
+
+	// Indexed queries
+	Report ( "sorted index HP < 20", entitiesCount, MeasureMicroseconds ( 100, [ & ] ()
+	{
+		Sink += ByHP -> LessThan ( 20 ) . size ();
+	} ) );
+	Report ( "hash index Team == 3", entitiesCount, MeasureMicroseconds ( 100, [ & ] ()
+	{
+		Sink += ByTeam -> Equal ( 3 ) . size ();
+	} ) );
+	Report ( "histogram HP in [ 13, 37 )", entitiesCount, MeasureMicroseconds ( 100, [ & ] ()
+	{
+		Sink += HPHistogram -> Range ( 13, 37 ) . size ();
+	} ) );
+
+	// Maintenance: the same changes are marked by GetComponent and reindexed by the query
+	Report ( "1% changes + sorted query (3 indices)", entitiesCount, MeasureMicroseconds ( 100, [ & ] ()
+	{
+		for ( std::size_t i = 0; i < ChangesCount; i ++ ) {
+			const auto Entity = Entities[ EntityDistribution ( Generator ) ];
+			ecs . GetComponent <UnitComponent> ( Entity ) . HP = HPDistribution ( Generator );
+		}
+		Sink += ByHP -> LessThan ( 20 ) . size ();
+	} ) );
+
+	Report ( "destroy all (3 indices)", entitiesCount, MeasureMicroseconds ( 1, [ & ] ()
+	{
+		ecs . DestroyEntities ( Entities );
+		Sink += ByHP -> LessThan ( 20 ) . size ();
+	} ) );
+
+	std::cout << "(checksum " << Sink << ")" << std::endl << std::endl;
+}
+
+void RunSpatialBenchmark ( std::size_t entitiesCount )
+{
+	constexpr std::size_t QueriesCount = 1000;
+	constexpr float QueryRadius = 10.f;
+	ECS ecs;
+	ecs . RegisterComponent <PositionComponent> ();
+	// The world grows with the number of entities, so the density and the size of the results stay the same
+	const float WorldSize = std::cbrt ( ( float ) entitiesCount ) * 4.f;
+	std::default_random_engine Generator;
+	std::uniform_real_distribution <float> PositionDistribution ( 0.f, WorldSize );
+	std::uniform_real_distribution <float> MoveDistribution ( - 0.5f, 0.5f );
+
+	std::vector <EntityHandle> Entities;
+	for ( std::size_t i = 0; i < entitiesCount; i ++ ) {
+		auto e = ecs . CreateEntity ();
+		Entities . push_back ( e );
+		ecs . AddComponent <PositionComponent> ( e, { e, { PositionDistribution ( Generator ), PositionDistribution ( Generator ), PositionDistribution ( Generator ) } } );
+	}
+	const auto Positions = ecs . GetComponentsByType <PositionComponent> () . lock ();
+	const auto GetPosition = [] ( const PositionComponent & position ) { return position . Position; };
+	auto Grid = ecs . AddSpatialIndex <PositionComponent> ( std::make_unique <HashGrid> ( QueryRadius ), GetPosition );
+	auto Octree = ecs . AddSpatialIndex <PositionComponent> ( std::make_unique <LooseOctree> (), GetPosition );
+	const auto Pool = ecs . GetThreadPool ();
+	std::vector <EntityHandle> Result ( entitiesCount );
+	std::vector <SpatialNeighbour> Nearest ( 8 );
+	std::size_t Sink = 0;
+
+	Report ( "brute force radius x1000", entitiesCount, MeasureMicroseconds ( 1, [ & ] ()
+	{
+		for ( std::size_t Query = 0; Query < QueriesCount; Query ++ ) {
+			const auto & Center = Positions -> GetObjectByIndex ( Query ) . Position;
+			for ( const auto & Position : * Positions ) {
+				const float X = Position . Position . X - Center . X, Y = Position . Position . Y - Center . Y, Z = Position . Position . Z - Center . Z;
+				Sink += X * X + Y * Y + Z * Z <= QueryRadius * QueryRadius;
+			}
+		}
+	} ) );
+	Report ( "grid radius x1000", entitiesCount, MeasureMicroseconds ( 10, [ & ] ()
+	{
+		for ( std::size_t Query = 0; Query < QueriesCount; Query ++ )
+			Sink += Grid -> QueryRadius ( Positions -> GetObjectByIndex ( Query ) . Position, QueryRadius, Result );
+	} ) );
+	Report ( "octree radius x1000", entitiesCount, MeasureMicroseconds ( 10, [ & ] ()
+	{
+		for ( std::size_t Query = 0; Query < QueriesCount; Query ++ )
+			Sink += Octree -> QueryRadius ( Positions -> GetObjectByIndex ( Query ) . Position, QueryRadius, Result );
+	} ) );
+	Report ( "grid 8-nearest x1000", entitiesCount, MeasureMicroseconds ( 10, [ & ] ()
+	{
+		for ( std::size_t Query = 0; Query < QueriesCount; Query ++ )
+			Sink += Grid -> QueryNearest ( Positions -> GetObjectByIndex ( Query ) . Position, Nearest );
+	} ) );
+	Report ( "octree 8-nearest x1000", entitiesCount, MeasureMicroseconds ( 10, [ & ] ()
+	{
+		for ( std::size_t Query = 0; Query < QueriesCount; Query ++ )
+			Sink += Octree -> QueryNearest ( Positions -> GetObjectByIndex ( Query ) . Position, Nearest );
+	} ) );
+
+	// Refit after small moves, rebuild after the structural change
+	const auto Move = [ & ] ()
+	{
+		for ( auto & Position : * Positions ) {
+			Position . Position . X += MoveDistribution ( Generator );
+			Position . Position . Y += MoveDistribution ( Generator );
+			Position . Position . Z += MoveDistribution ( Generator );
+		}
+	};
+	for ( ThreadPool * CurrentPool : { ( ThreadPool * ) nullptr, Pool . get () } ) {
+		const std::string Suffix = CurrentPool != nullptr ? " (parallel)" : "";
+		Move ();
+		Report ( "grid sync after moves" + Suffix, entitiesCount, MeasureMicroseconds ( 1, [ & ] () { Grid -> Sync ( CurrentPool ); } ) );
+		Report ( "octree sync after moves" + Suffix, entitiesCount, MeasureMicroseconds ( 1, [ & ] () { Octree -> Sync ( CurrentPool ); } ) );
+		ecs . RemoveEntity ( Entities . back () );
+		Entities . pop_back ();
+		Report ( "grid rebuild" + Suffix, entitiesCount, MeasureMicroseconds ( 1, [ & ] () { Grid -> Sync ( CurrentPool ); } ) );
+		Report ( "octree rebuild" + Suffix, entitiesCount, MeasureMicroseconds ( 1, [ & ] () { Octree -> Sync ( CurrentPool ); } ) );
+	}
+
+	std::cout << "(checksum " << Sink << ")" << std::endl << std::endl;
+}
+
+void RunChurn ( ECS & ecs, std::size_t entitiesCount, std::size_t framesCount )
+{
+	std::vector <EntityHandle> Entities;
+	for ( std::size_t Frame = 0; Frame < framesCount; Frame ++ ) {
+		for ( std::size_t i = 0; i < entitiesCount; i ++ ) {
+			auto e = ecs . CreateEntity ();
+			Entities . push_back ( e );
+			ecs . AddComponent <UnitComponent> ( e, { e, 100, int ( i % 8 ) } );
+			ecs . AddComponent <PositionComponent> ( e, { e, { float ( i ), 0.f, 0.f } } );
+		}
+		ecs . DestroyEntities ( std::span ( Entities ) . first ( Entities . size () / 2 ) );
+		Entities . erase ( Entities . begin (), Entities . begin () + ( std::ptrdiff_t ) ( Entities . size () / 2 ) );
+		ecs . RunSystems ();
+	}
+}
+
+void RunRecordingBenchmark ( std::size_t entitiesCount )
+{
+	constexpr std::size_t FramesCount = 8;
+	const double Plain = MeasureMicroseconds ( 1, [ & ] ()
+	{
+		ECS ecs;
+		ecs . RegisterComponent <UnitComponent> ();
+		ecs . RegisterComponent <PositionComponent> ();
+		RunChurn ( ecs, entitiesCount, FramesCount );
+	} );
+
+	std::stringstream Log;
+	const double Recorded = MeasureMicroseconds ( 1, [ & ] ()
+	{
+		ECS ecs;
+		ecs . SetRecorder ( std::make_shared <ECSRecorder> ( Log ) );
+		ecs . RegisterComponent <UnitComponent> ();
+		ecs . RegisterComponent <PositionComponent> ();
+		RunChurn ( ecs, entitiesCount, FramesCount );
+	} );
+
+	ECSReplayer Replayer ( Log );
+	ECS Replayed;
+	double Replay = 0.;
+	while ( Replayer . ReplayFrame ( Replayed ) )
+		Replay += std::chrono::duration <double, std::micro> ( Replayer . GetLastFrameTime () ) . count ();
+
+	Report ( "Churn, 8 frames", entitiesCount, Plain );
+	Report ( "Churn, 8 frames, recorded", entitiesCount, Recorded );
+	Report ( "Churn, 8 frames, replayed", entitiesCount, Replay );
+	std::cout << "Log size: " << Log . str () . size () / 1024 << " KiB" << std::endl;
+}
+
+int main ()
+{
+	for ( const std::size_t EntitiesCount : { 10000, 100000 } )
+		RunIndexBenchmark ( EntitiesCount );
+	for ( const std::size_t EntitiesCount : { 10000, 100000 } )
+		RunSpatialBenchmark ( EntitiesCount );
+	for ( const std::size_t EntitiesCount : { 10000, 100000 } )
+		RunRecordingBenchmark ( EntitiesCount );
+	return 0;
+}
\ No newline at end of file
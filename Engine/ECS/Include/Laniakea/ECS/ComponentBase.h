@@ -26,5 +26,8 @@ public:
 	EntityHandle GetOwner () const;
 
 private:
+	template <typename ObjectType>
+	friend class ObjectManager;
+
 	EntityHandle m_Owner; /**< The handle of the entity that owns this component. */
 };
@@ -0,0 +1,573 @@
+#pragma once
+
+#include "ObjectManager.h"
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <span>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+/**
+ * @class IComponentIndex
+ * @brief Base secondary index interface to store it in a polymorphic manner
+ *
+ * The index is kept up to date by the ComponentManager when the component is added or removed. The mutable accessors
+ * of the ECS ( GetComponent, TryGetComponent, GetComponentChecked and ForEach ) mark the component as changed and the
+ * index rereads the keys of the marked components before its next query. Writes through the component arrays or
+ * the owning groups aren't tracked, ECS::MarkComponentChanged must follow them.
+ */
+class LANIAKEA_ECS_API IComponentIndex
+{
+public:
+	virtual ~IComponentIndex () = default;
+
+	/**
+     * @brief Indexes the component of the entity.
+     * @param entityHandle The handle of the entity.
+     * @param componentHandle The handle of the component in its component array.
+     */
+	virtual void Insert ( EntityHandle entityHandle, ComponentHandle componentHandle ) = 0;
+
+	/**
+     * @brief Removes the entity from the index if it is indexed.
+     * @param entityHandle The handle of the entity.
+     */
+	virtual void Erase ( EntityHandle entityHandle ) = 0;
+
+	/**
+     * @brief Reindexes the entity after its component has changed.
+     * @param entityHandle The handle of the entity.
+     * @param componentHandle The handle of the component in its component array.
+     */
+	virtual void Update ( EntityHandle entityHandle, ComponentHandle componentHandle ) = 0;
+
+	/**
+     * @brief Marks the component of the entity as possibly changed, its key is reread before the next query.
+     * @param entityHandle The handle of the entity.
+     * @param componentHandle The handle of the component in its component array.
+     */
+	virtual void MarkChanged ( EntityHandle entityHandle, ComponentHandle componentHandle ) = 0;
+
+	/**
+     * @brief Retrieves the number of indexed entities.
+     * @return The number of entities in the index.
+     */
+	virtual std::size_t Size () const = 0;
+};
+
+/**
+ * @class ComponentIndex
+ * @brief Common part of the secondary indices on the field of the component.
+ * @tparam T The type of the indexed component.
+ * @tparam Key The type of the indexed field.
+ *
+ * The key of each indexed entity is remembered, so the entity is erased by its old key after the component has changed.
+ * The marked components are reindexed at once by Refresh, the unchanged keys are skipped there.
+ */
+template <typename T, typename Key>
+class ComponentIndex : public IComponentIndex
+{
+
+public:
+
+	using KeyFunction = std::function <Key ( const T & )>;
+
+	/**
+     * @brief Constructor for ComponentIndex.
+     * @param components The component array the indexed components are read from.
+     * @param keyFunction The callable or the member pointer extracting the key from the component.
+     */
+	ComponentIndex ( std::shared_ptr <ObjectManager <T>> components, KeyFunction keyFunction )
+	: m_Components ( std::move ( components ) ), m_KeyFunction ( std::move ( keyFunction ) )
+	{
+
+	}
+
+	void Insert ( EntityHandle entityHandle, ComponentHandle componentHandle ) override
+	{
+		ClearChanged ( entityHandle );
+		const Key EntityKey = m_KeyFunction ( m_Components -> GetObject ( componentHandle ) );
+		m_EntityKeys . insert_or_assign ( entityHandle, EntityKey );
+		InsertKey ( entityHandle, EntityKey );
+	}
+
+	void Erase ( EntityHandle entityHandle ) override
+	{
+		ClearChanged ( entityHandle );
+		const auto It = m_EntityKeys . find ( entityHandle );
+		if ( It == m_EntityKeys . end () )
+			return;
+		EraseKey ( entityHandle, It -> second );
+		m_EntityKeys . erase ( It );
+	}
+
+	void Update ( EntityHandle entityHandle, ComponentHandle componentHandle ) override
+	{
+		ClearChanged ( entityHandle );
+		Reindex ( entityHandle, componentHandle );
+	}
+
+	void MarkChanged ( EntityHandle entityHandle, ComponentHandle componentHandle ) override
+	{
+		m_Changed . insert_or_assign ( entityHandle, componentHandle );
+	}
+
+	std::size_t Size () const override
+	{
+		return m_EntityKeys . size ();
+	}
+
+protected:
+
+	/**
+     * @brief Reindexes the components marked as changed since the last refresh, called by the queries first.
+     */
+	void Refresh ()
+	{
+		if ( m_Changed . empty () )
+			return;
+		for ( const auto & [ ChangedEntity, ChangedComponent ] : m_Changed ) {
+			Reindex ( ChangedEntity, ChangedComponent );
+		}
+		m_Changed . clear ();
+	}
+
+	/**
+     * @brief Checks if the entity is indexed.
+     * @param entityHandle The handle of the entity.
+     * @return True if the entity is indexed, false otherwise.
+     */
+	bool GetIsIndexed ( EntityHandle entityHandle ) const
+	{
+		return m_EntityKeys . count ( entityHandle ) != 0;
+	}
+
+	/**
+     * @brief Adds the entity under the key into the index structure.
+     * @param entityHandle The handle of the entity.
+     * @param key The key of the entity.
+     */
+	virtual void InsertKey ( EntityHandle entityHandle, const Key & key ) = 0;
+
+	/**
+     * @brief Removes the entity indexed under the key from the index structure.
+     * @param entityHandle The handle of the entity.
+     * @param key The key the entity was indexed under.
+     */
+	virtual void EraseKey ( EntityHandle entityHandle, const Key & key ) = 0;
+
+private:
+
+	/**
+     * @brief Moves the entity under the current key of its component if the key has changed.
+     */
+	void Reindex ( EntityHandle entityHandle, ComponentHandle componentHandle )
+	{
+		Key EntityKey = m_KeyFunction ( m_Components -> GetObject ( componentHandle ) );
+		const auto [ It, IsInserted ] = m_EntityKeys . try_emplace ( entityHandle, EntityKey );
+		if ( ! IsInserted )
+		{
+			if ( It -> second == EntityKey )
+				return;
+			EraseKey ( entityHandle, It -> second );
+			It -> second = EntityKey;
+		}
+		InsertKey ( entityHandle, EntityKey );
+	}
+
+	/**
+     * @brief Drops the change mark of the entity, its key is up to date or it is no longer indexed.
+     */
+	void ClearChanged ( EntityHandle entityHandle )
+	{
+		if ( ! m_Changed . empty () )
+			m_Changed . erase ( entityHandle );
+	}
+
+	std::shared_ptr <ObjectManager <T>> m_Components; /**< The component array the indexed components are read from. */
+	KeyFunction m_KeyFunction; /**< Extracts the key from the component. */
+	std::unordered_map <EntityHandle, Key> m_EntityKeys; /**< The keys the entities are currently indexed under. */
+	std::unordered_map <EntityHandle, ComponentHandle> m_Changed; /**< The components marked as changed since the last refresh. */
+};
+
+/**
+ * @class SortedIndex
+ * @brief Secondary index ordering the entities by the key, answers range queries with a binary search.
+ * @tparam T The type of the indexed component.
+ * @tparam Key The type of the indexed field, must be less than comparable.
+ *
+ * Insertions and erasures are buffered and merged into the sorted arrays lazily on the next query,
+ * so mass changes cost a single sort of the changes and one linear merge. The entries are ordered by the key and
+ * then by the entity, so an erased entry is found with a binary search even among many entities sharing its key.
+ */
+template <typename T, typename Key>
+class SortedIndex : public ComponentIndex <T, Key>
+{
+
+public:
+
+	using ComponentIndex <T, Key>::ComponentIndex;
+
+	/**
+     * @brief Retrieves the entities with the key in the range [ low, high ).
+     * @param low The inclusive lower bound.
+     * @param high The exclusive upper bound.
+     * @return A span over the entities ordered by the key, valid until the index is modified.
+     */
+	std::span <const EntityHandle> Range ( const Key & low, const Key & high )
+	{
+		Flush ();
+		const auto First = std::lower_bound ( m_Keys . begin (), m_Keys . end (), low );
+		const auto Last = std::lower_bound ( First, m_Keys . end (), high );
+		return Slice ( First, Last );
+	}
+
+	/**
+     * @brief Retrieves the entities with the key less than the value.
+     * @param value The exclusive upper bound.
+     * @return A span over the entities ordered by the key, valid until the index is modified.
+     */
+	std::span <const EntityHandle> LessThan ( const Key & value )
+	{
+		Flush ();
+		return Slice ( m_Keys . begin (), std::lower_bound ( m_Keys . begin (), m_Keys . end (), value ) );
+	}
+
+	/**
+     * @brief Retrieves the entities with the key greater than or equal to the value.
+     * @param value The inclusive lower bound.
+     * @return A span over the entities ordered by the key, valid until the index is modified.
+     */
+	std::span <const EntityHandle> GreaterOrEqual ( const Key & value )
+	{
+		Flush ();
+		return Slice ( std::lower_bound ( m_Keys . begin (), m_Keys . end (), value ), m_Keys . end () );
+	}
+
+	/**
+     * @brief Retrieves the entities with the key equal to the value.
+     * @param value The key.
+     * @return A span over the entities, valid until the index is modified.
+     */
+	std::span <const EntityHandle> Equal ( const Key & value )
+	{
+		Flush ();
+		const auto [ First, Last ] = std::equal_range ( m_Keys . begin (), m_Keys . end (), value );
+		return Slice ( First, Last );
+	}
+
+protected:
+
+	void InsertKey ( EntityHandle entityHandle, const Key & key ) override
+	{
+		m_Pending . push_back ( { key, entityHandle, m_Versions[ entityHandle ] } );
+	}
+
+	void EraseKey ( EntityHandle entityHandle, const Key & key ) override
+	{
+		auto & Version = m_Versions[ entityHandle ];
+		m_Erased . push_back ( { key, entityHandle, Version } );
+		Version ++;
+	}
+
+private:
+
+	struct Entry
+	{
+		Key EntryKey; /**< The key of the entity. */
+		EntityHandle Entity; /**< The indexed entity. */
+		std::uint32_t Version; /**< The version of the entity at the insertion, stale if it doesn't match the current one. */
+	};
+
+	/**
+     * @brief Drops the erased entries and merges the buffered insertions into the sorted arrays.
+     */
+	void Flush ()
+	{
+		this -> Refresh ();
+		if ( m_Pending . empty () && m_Erased . empty () )
+			return;
+		const auto EntryLess = [] ( const Entry & lhs, const Entry & rhs ) { return GetIsLess ( lhs . EntryKey, lhs . Entity, rhs . EntryKey, rhs . Entity ); };
+
+		// Erased entries are located by their keys and entities, entries inserted after the last merge are dropped by their versions
+		m_Removed . assign ( m_Keys . size (), false );
+		for ( const auto & Erased : m_Erased ) {
+			const auto [ First, Last ] = std::equal_range ( m_Keys . begin (), m_Keys . end (), Erased . EntryKey );
+			const auto EntitiesFirst = m_Entities . begin () + ( First - m_Keys . begin () );
+			const auto EntitiesLast = m_Entities . begin () + ( Last - m_Keys . begin () );
+			const auto It = std::lower_bound ( EntitiesFirst, EntitiesLast, Erased . Entity );
+			const auto Index = ( std::size_t ) ( It - m_Entities . begin () );
+			if ( It != EntitiesLast && * It == Erased . Entity && m_EntryVersions[ Index ] == Erased . Version )
+				m_Removed[ Index ] = true;
+		}
+		std::erase_if ( m_Pending, [ this ] ( const Entry & entry ) { return m_Versions[ entry . Entity ] != entry . Version; } );
+		std::sort ( m_Pending . begin (), m_Pending . end (), EntryLess );
+
+		m_Merged . clear ();
+		m_Merged . reserve ( m_Keys . size () + m_Pending . size () );
+		auto Pending = m_Pending . begin ();
+		for ( std::size_t i = 0; i < m_Keys . size (); i ++ ) {
+			if ( m_Removed[ i ] )
+				continue;
+			for ( ; Pending != m_Pending . end () && GetIsLess ( Pending -> EntryKey, Pending -> Entity, m_Keys[ i ], m_Entities[ i ] ); ++ Pending ) {
+				m_Merged . push_back ( std::move ( * Pending ) );
+			}
+			m_Merged . push_back ( { std::move ( m_Keys[ i ] ), m_Entities[ i ], m_EntryVersions[ i ] } );
+		}
+		m_Merged . insert ( m_Merged . end (), std::make_move_iterator ( Pending ), std::make_move_iterator ( m_Pending . end () ) );
+
+		m_Keys . clear ();
+		m_Entities . clear ();
+		m_EntryVersions . clear ();
+		for ( auto & Current : m_Merged ) {
+			m_Keys . push_back ( std::move ( Current . EntryKey ) );
+			m_Entities . push_back ( Current . Entity );
+			m_EntryVersions . push_back ( Current . Version );
+		}
+		for ( const auto & Erased : m_Erased ) {
+			if ( ! this -> GetIsIndexed ( Erased . Entity ) )
+				m_Versions . erase ( Erased . Entity );
+		}
+		m_Pending . clear ();
+		m_Erased . clear ();
+		m_Merged . clear ();
+	}
+
+	/**
+     * @brief Orders the entries by the key and then by the entity.
+     */
+	static bool GetIsLess ( const Key & lhsKey, EntityHandle lhsEntity, const Key & rhsKey, EntityHandle rhsEntity )
+	{
+		if ( lhsKey < rhsKey )
+			return true;
+		return ! ( rhsKey < lhsKey ) && lhsEntity < rhsEntity;
+	}
+
+	/**
+     * @brief Maps the range of the keys to the span of the entities at the same positions.
+     */
+	std::span <const EntityHandle> Slice ( typename std::vector <Key>::const_iterator first, typename std::vector <Key>::const_iterator last ) const
+	{
+		return { m_Entities . data () + ( first - m_Keys . cbegin () ), ( std::size_t ) ( last - first ) };
+	}
+
+	std::vector <Key> m_Keys; /**< The sorted keys. */
+	std::vector <EntityHandle> m_Entities; /**< The entities at the positions of their keys. */
+	std::vector <std::uint32_t> m_EntryVersions; /**< The versions of the entries at the positions of their keys. */
+	std::vector <Entry> m_Pending; /**< Insertions not merged yet. */
+	std::vector <Entry> m_Erased; /**< Erasures not merged yet with the keys and the versions of the erased entries. */
+	std::vector <Entry> m_Merged; /**< Scratch buffer of the merge. */
+	std::vector <bool> m_Removed; /**< Scratch buffer of the merge marking the erased positions. */
+	std::unordered_map <EntityHandle, std::uint32_t> m_Versions; /**< The current versions of the entities, bumped on each erase. */
+};
+
+/**
+ * @class HashIndex
+ * @brief Secondary index grouping the entities by the key, answers equality queries in constant time.
+ * @tparam T The type of the indexed component.
+ * @tparam Key The type of the indexed field, must be hashable.
+ */
+template <typename T, typename Key>
+class HashIndex : public ComponentIndex <T, Key>
+{
+
+public:
+
+	using ComponentIndex <T, Key>::ComponentIndex;
+
+	/**
+     * @brief Retrieves the entities with the key equal to the value.
+     * @param value The key.
+     * @return A span over the entities in no particular order, valid until the index is modified.
+     */
+	std::span <const EntityHandle> Equal ( const Key & value )
+	{
+		this -> Refresh ();
+		const auto It = m_Buckets . find ( value );
+		return It == m_Buckets . end () ? std::span <const EntityHandle> () : std::span <const EntityHandle> ( It -> second );
+	}
+
+protected:
+
+	void InsertKey ( EntityHandle entityHandle, const Key & key ) override
+	{
+		auto & Bucket = m_Buckets[ key ];
+		m_Positions[ entityHandle ] = Bucket . size ();
+		Bucket . push_back ( entityHandle );
+	}
+
+	void EraseKey ( EntityHandle entityHandle, const Key & key ) override
+	{
+		auto & Bucket = m_Buckets . at ( key );
+		const auto Position = m_Positions . extract ( entityHandle ) . mapped ();
+		if ( Position != Bucket . size () - 1 )
+		{
+			Bucket[ Position ] = Bucket . back ();
+			m_Positions[ Bucket[ Position ] ] = Position;
+		}
+		Bucket . pop_back ();
+		if ( Bucket . empty () )
+			m_Buckets . erase ( key );
+	}
+
+private:
+	std::unordered_map <Key, std::vector <EntityHandle>> m_Buckets; /**< The entities grouped by their keys. */
+	std::unordered_map <EntityHandle, std::size_t> m_Positions; /**< The positions of the entities in their buckets. */
+};
+
+/**
+ * @class HistogramIndex
+ * @brief Secondary index distributing the entities into equal width buckets of the key, answers approximate and exact range queries.
+ * @tparam T The type of the indexed component.
+ * @tparam Key The arithmetic type of the indexed field.
+ *
+ * Buckets fully inside the queried range are copied wholesale, only the boundary buckets are filtered by the key.
+ * Keys outside of [ min, max ) are clamped into the first and the last bucket, NaN keys go into the first bucket.
+ */
+template <typename T, typename Key>
+class HistogramIndex : public ComponentIndex <T, Key>
+{
+	static_assert ( std::is_arithmetic_v <Key>, "HistogramIndex requires the arithmetic key" );
+
+public:
+
+	/**
+     * @brief Constructor for HistogramIndex.
+     * @param components The component array the indexed components are read from.
+     * @param keyFunction The callable or the member pointer extracting the key from the component.
+     * @param min The lower bound of the first bucket.
+     * @param max The upper bound of the last bucket.
+     * @param bucketsCount The number of buckets.
+     */
+	HistogramIndex ( std::shared_ptr <ObjectManager <T>> components, typename ComponentIndex <T, Key>::KeyFunction keyFunction,
+			Key min, Key max, std::size_t bucketsCount )
+	: ComponentIndex <T, Key> ( std::move ( components ), std::move ( keyFunction ) ),
+	  m_Min ( ( double ) min ), m_BucketWidth ( ( ( double ) max - ( double ) min ) / ( double ) std::max ( bucketsCount, std::size_t ( 1 ) ) ),
+	  m_Buckets ( std::max ( bucketsCount, std::size_t ( 1 ) ) )
+	{
+
+	}
+
+	/**
+     * @brief Retrieves the entities with the key in the range [ low, high ).
+     * @param low The inclusive lower bound.
+     * @param high The exclusive upper bound.
+     * @return A span over the entities in no particular order, valid until the next query.
+     */
+	std::span <const EntityHandle> Range ( Key low, Key high )
+	{
+		this -> Refresh ();
+		m_Result . clear ();
+		if ( ! ( low < high ) )
+			return m_Result;
+		const auto First = GetBucketIndex ( low );
+		const auto Last = GetBucketIndex ( high );
+		for ( auto Index = First; Index <= Last; Index ++ ) {
+			const auto & Bucket = m_Buckets[ Index ];
+			if ( Index != First && Index != Last )
+			{
+				m_Result . insert ( m_Result . end (), Bucket . Entities . begin (), Bucket . Entities . end () );
+				continue;
+			}
+			for ( std::size_t i = 0; i < Bucket . Keys . size (); i ++ ) {
+				if ( ! ( Bucket . Keys[ i ] < low ) && Bucket . Keys[ i ] < high )
+					m_Result . push_back ( Bucket . Entities[ i ] );
+			}
+		}
+		return m_Result;
+	}
+
+	/**
+     * @brief Estimates the number of entities with the key in the range [ low, high ) without touching the entities.
+     * @param low The inclusive lower bound.
+     * @param high The exclusive upper bound.
+     * @return The number of entities in the buckets overlapping the range.
+     */
+	std::size_t EstimateRange ( Key low, Key high )
+	{
+		this -> Refresh ();
+		if ( ! ( low < high ) )
+			return 0;
+		std::size_t Count = 0;
+		for ( auto Index = GetBucketIndex ( low ); Index <= GetBucketIndex ( high ); Index ++ ) {
+			Count += m_Buckets[ Index ] . Entities . size ();
+		}
+		return Count;
+	}
+
+	/**
+     * @brief Retrieves the number of entities in the bucket.
+     * @param index The index of the bucket.
+     * @return The number of entities with the key inside the bucket.
+     */
+	std::size_t GetBucketSize ( std::size_t index )
+	{
+		this -> Refresh ();
+		return m_Buckets[ index ] . Entities . size ();
+	}
+
+	/**
+     * @brief Retrieves the number of buckets.
+     * @return The number of buckets.
+     */
+	std::size_t GetBucketsCount () const
+	{
+		return m_Buckets . size ();
+	}
+
+protected:
+
+	void InsertKey ( EntityHandle entityHandle, const Key & key ) override
+	{
+		auto & Bucket = m_Buckets[ GetBucketIndex ( key ) ];
+		m_Positions[ entityHandle ] = Bucket . Entities . size ();
+		Bucket . Keys . push_back ( key );
+		Bucket . Entities . push_back ( entityHandle );
+	}
+
+	void EraseKey ( EntityHandle entityHandle, const Key & key ) override
+	{
+		auto & Bucket = m_Buckets[ GetBucketIndex ( key ) ];
+		const auto Position = m_Positions . extract ( entityHandle ) . mapped ();
+		if ( Position != Bucket . Entities . size () - 1 )
+		{
+			Bucket . Keys[ Position ] = Bucket . Keys . back ();
+			Bucket . Entities[ Position ] = Bucket . Entities . back ();
+			m_Positions[ Bucket . Entities[ Position ] ] = Position;
+		}
+		Bucket . Keys . pop_back ();
+		Bucket . Entities . pop_back ();
+	}
+
+private:
+
+	struct Bucket
+	{
+		std::vector <Key> Keys; /**< The keys of the entities in the bucket. */
+		std::vector <EntityHandle> Entities; /**< The entities at the positions of their keys. */
+	};
+
+	/**
+     * @brief Retrieves the index of the bucket containing the key.
+     * @param key The key.
+     * @return The index of the bucket, clamped to the valid range before the conversion, so NaN and infinities are safe.
+     */
+	std::size_t GetBucketIndex ( Key key ) const
+	{
+		const double Position = m_BucketWidth > 0.0 ? ( ( double ) key - m_Min ) / m_BucketWidth : 0.0;
+		if ( ! ( Position > 0.0 ) )
+			return 0;
+		const auto LastIndex = m_Buckets . size () - 1;
+		return Position < ( double ) LastIndex ? ( std::size_t ) Position : LastIndex;
+	}
+
+	double m_Min; /**< The lower bound of the first bucket. */
+	double m_BucketWidth; /**< The width of each bucket. */
+	std::vector <Bucket> m_Buckets; /**< The entities distributed by their keys. */
+	std::unordered_map <EntityHandle, std::size_t> m_Positions; /**< The positions of the entities in their buckets. */
+	std::vector <EntityHandle> m_Result; /**< The buffer returned by the range query. */
+};
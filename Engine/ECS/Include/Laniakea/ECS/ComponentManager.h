@@ -1,7 +1,10 @@
 #pragma once
 
 #include "ObjectManager.h"
-#include "Entity.h"
+#include "QueryFilter.h"
+#include "Group.h"
+#include "ComponentIndex.h"
+#include <cassert>
 #include <memory>
 
 // Reference: https://austinmorlan.com/posts/entity_component_system/#the-component-array
@@ -32,6 +35,36 @@ public:
 		m_Components[ ComponentType ] = std::make_shared <ObjectManager <T>> ();
 	}
 
+	/**
+     * @brief Registers the component type with the component array created by the caller.
+     * @param componentType The code of the component type.
+     * @param components The component array storing the components of the type.
+     */
+	void RegisterComponent ( ComponentType componentType, std::shared_ptr <IObjectManager> components );
+
+	/**
+     * @brief Attaches the component already stored in its component array to an entity.
+     * @param entity The entity to which the component will be attached.
+     * @param componentType The code of the component type.
+     * @param componentHandle The handle of the component within its component array.
+     */
+	void AttachComponent ( Entity & entity, ComponentType componentType, ComponentHandle componentHandle );
+
+	/**
+     * @brief Removes a component of the given type from an entity.
+     * @param entity The entity from which the component will be removed.
+     * @param componentType The code of the component type.
+     */
+	void RemoveComponent ( Entity & entity, ComponentType componentType );
+
+	/**
+     * @brief Retrieves the object representation of the component attached to the entity.
+     * @param entity The entity owning the component.
+     * @param componentType The code of the component type.
+     * @return A span over the bytes of the component, valid until the component array is modified.
+     */
+	std::span <const std::byte> GetComponentBytes ( Entity & entity, ComponentType componentType );
+
 	/**
      * @brief Adds a new component to an entity.
      * @tparam T The type of the component to be added.
@@ -41,8 +74,10 @@ public:
 	template <typename T>
 	void AddComponent ( Entity & entity, const T & component )
 	{
+		AssertComponentOwner ( entity, component );
 		const auto ComponentHandle = GetComponentArray <T> () -> AddObject ( component );
 		entity . AddComponent ( { GetComponentType <T> (), ComponentHandle } );
+		OnComponentAdded ( entity, GetComponentType <T> () );
 	}
 
 	/**
@@ -54,8 +89,10 @@ public:
 	template <typename T>
 	void AddComponent ( Entity & entity, T && component )
 	{
+		AssertComponentOwner ( entity, component );
 		const auto ComponentHandle = GetComponentArray <T> () -> AddObject ( std::forward <T> ( component ) );
 		entity . AddComponent ( { GetComponentType <T> (), ComponentHandle } );
+		OnComponentAdded ( entity, GetComponentType <T> () );
 	}
 
 	/**
@@ -71,6 +108,7 @@ public:
 
 		auto ComponentArray = GetComponentArray <T> ();
 
+		OnComponentRemoving ( entity, ComponentType );
 		ComponentArray -> RemoveObject ( ComponentHandle );
 		entity . RemoveComponent ( ComponentType );
 	}
@@ -89,12 +127,222 @@ public:
 		return ComponentArray -> GetObject ( ComponentHandle );
 	}
 
+	/**
+     * @brief Retrieves a pointer to the component associated with the given entity if it is attached.
+     * @tparam T The type of the component to retrieve.
+     * @param entity The entity for which to retrieve the component.
+     * @return A pointer to the component, or nullptr if the component isn't attached or registered.
+     *
+     * Unlike the GetComponentChecked, the entity components are searched only once.
+     */
+	template <typename T>
+	T * TryGetComponent ( Entity & entity )
+	{
+		return TryGetComponent ( entity, FindComponentArray <T> () );
+	}
+
+	/**
+     * @brief Retrieves a pointer to the component associated with the given entity from the already fetched component array.
+     * @tparam T The type of the component to retrieve.
+     * @param entity The entity for which to retrieve the component.
+     * @param componentArray The component array of the type T, may be nullptr.
+     * @return A pointer to the component, or nullptr if the component isn't attached or the array is nullptr.
+     */
+	template <typename T>
+	T * TryGetComponent ( Entity & entity, ObjectManager <T> * componentArray ) const
+	{
+		if ( ! componentArray )
+			return nullptr;
+		const auto ComponentHandle = entity . GetComponentHandleChecked ( GetComponentType <T> () );
+		return ComponentHandle ? & componentArray -> GetObject ( * ComponentHandle ) : nullptr;
+	}
+
+	/**
+     * @brief Retrieves a raw pointer to the component array of the specified type.
+     * @tparam T The type of the component.
+     * @return A pointer to the component array if registered, otherwise nullptr.
+     *
+     * Intended to fetch the array once before iterating over many entities.
+     */
+	template <typename T>
+	ObjectManager <T> * FindComponentArray ()
+	{
+		const auto It = m_Components . find ( GetComponentType <T> () );
+		return It == m_Components . end () ? nullptr : static_cast <ObjectManager <T> *> ( It -> second . get () );
+	}
+
+	/**
+     * @brief Fetches the value yielded by the query term for the entity matching the query.
+     * @tparam Term The query term.
+     * @param entity The entity matching the query.
+     * @param componentArray The component array of the term component type, may be nullptr for Without and Optional terms.
+     * @return A tuple with a reference for With term, with a nullable pointer for Optional term and an empty tuple for Without term.
+     */
+	template <typename Term>
+	detail::QueryTermResult <Term> FetchQueryTerm ( Entity & entity, ObjectManager <typename detail::QueryTerm <Term>::Type> * componentArray ) const
+	{
+		using T = typename detail::QueryTerm <Term>::Type;
+		if constexpr ( detail::QueryTerm <Term>::Kind == QueryTermKind::With )
+			return { componentArray -> GetObject ( entity . GetComponentHandle ( GetComponentType <T> () ) ) };
+		else if constexpr ( detail::QueryTerm <Term>::Kind == QueryTermKind::Optional )
+			return { TryGetComponent <T> ( entity, componentArray ) };
+		else
+			return {};
+	}
+
+	/**
+     * @brief Resolves the query terms into the include and exclude masks.
+     * @tparam Terms The query terms: plain component types, query::With <T>, query::Without <T> or query::Optional <T>.
+     * @return The filter of the query.
+     */
+	template <typename ... Terms>
+	QueryFilter GetQueryFilter () const
+	{
+		Signature Include;
+		Signature Exclude;
+		( AppendQueryTerm <Terms> ( Include, Exclude ), ... );
+		return { std::move ( Include ), std::move ( Exclude ) };
+	}
+
+	/**
+     * @brief Registers an owning group of the component arrays.
+     * @tparam Ts The types of the components to be grouped. All of them must be registered and not owned by another group.
+     * @return A shared pointer to the group. The group is empty until it is populated with existing entities.
+     *
+     * Taking over an array owned by another group would break the packed prefix of that group, so it's asserted
+     * against and the first owner is kept.
+     */
+	template <typename ... Ts>
+	std::shared_ptr <Group <Ts ...>> RegisterGroup ()
+	{
+		assert ( GetCanRegisterGroup <Ts ...> () && "The components must be registered and not owned by another group" );
+		auto OwningGroup = std::make_shared <Group <Ts ...>> ( GetComponentArray <Ts> () ...,
+				std::array <ComponentType, sizeof ... ( Ts )> { GetComponentType <Ts> () ... } );
+		( m_GroupOwners . try_emplace ( GetComponentType <Ts> (), OwningGroup ), ... );
+		return OwningGroup;
+	}
+
+	/**
+     * @brief Retrieves the owning group of the components.
+     * @tparam Ts The types of the grouped components in the order of the group registration.
+     * @return A weak pointer to the group if registered, otherwise an expired weak pointer.
+     */
+	template <typename ... Ts>
+	std::weak_ptr <Group <Ts ...>> GetGroup ()
+	{
+		using FirstType = std::tuple_element_t <0, std::tuple <Ts ...>>;
+		const auto It = m_GroupOwners . find ( GetComponentType <FirstType> () );
+		if ( It == m_GroupOwners . end () )
+			return {};
+		return std::dynamic_pointer_cast <Group <Ts ...>> ( It -> second );
+	}
+
+	/**
+     * @brief Checks if an owning group of the components can be registered.
+     * @tparam Ts The types of the components to be grouped.
+     * @return True if all components are registered and none of them is owned by another group, false otherwise.
+     */
+	template <typename ... Ts>
+	bool GetCanRegisterGroup () const
+	{
+		return ( GetIsComponentRegistered <Ts> () && ... ) && ( ( m_GroupOwners . count ( GetComponentType <Ts> () ) == 0 ) && ... );
+	}
+
+	/**
+     * @brief Checks if the component array is owned by a group.
+     * @tparam T The type of the component.
+     * @return True if an owning group of the component is registered.
+     */
+	template <typename T>
+	bool GetIsComponentGrouped () const
+	{
+		return m_GroupOwners . count ( GetComponentType <T> () ) != 0;
+	}
+
+	/**
+     * @brief Adds the secondary index on the component field.
+     * @tparam IndexType The type of the index, e.g. SortedIndex <T, Key>.
+     * @tparam T The type of the indexed component. Must be registered.
+     * @tparam Args The types of the index constructor arguments following the component array.
+     * @param Arguments The index constructor arguments following the component array, starting with the key function.
+     * @return A shared pointer to the index. The index is empty until it is populated with existing entities.
+     */
+	template <typename IndexType, typename T, typename ... Args>
+	std::shared_ptr <IndexType> AddIndex ( Args && ... Arguments )
+	{
+		auto Index = std::make_shared <IndexType> ( GetComponentArray <T> (), std::forward <Args> ( Arguments ) ... );
+		m_Indices[ GetComponentType <T> () ] . push_back ( Index );
+		return Index;
+	}
+
+	/**
+     * @brief Marks the component of the entity as changed in the indices of its type, called by the mutable accessors.
+     * @param entity The entity which component was handed out by a mutable reference.
+     * @param componentType The type of the component.
+     *
+     * Costs a single branch while no component type is indexed.
+     */
+	void OnComponentAccessed ( Entity & entity, ComponentType componentType )
+	{
+		if ( ! m_Indices . empty () )
+			MarkComponentChanged ( entity, componentType );
+	}
+
+	/**
+     * @brief Marks the component of the query term as changed if the term yields a mutable component.
+     * @tparam Term The query term.
+     * @param entity The entity matching the query.
+     */
+	template <typename Term>
+	void OnQueryTermAccessed ( Entity & entity )
+	{
+		if constexpr ( detail::QueryTerm <Term>::Kind != QueryTermKind::Without )
+		{
+			const auto ComponentType = GetComponentType <typename detail::QueryTerm <Term>::Type> ();
+			if ( detail::QueryTerm <Term>::Kind == QueryTermKind::With || entity . GetHasComponent ( ComponentType ) )
+				OnComponentAccessed ( entity, ComponentType );
+		}
+	}
+
+	/**
+     * @brief Reindexes the component of the entity in all indices of the component type after its value has changed.
+     * @param entity The entity which component has changed.
+     * @param componentType The type of the changed component.
+     */
+	void OnComponentChanged ( Entity & entity, ComponentType componentType );
+
 	/**
      * @brief Notifies the component manager that an entity has been removed.
      * @param entity The entity that has been removed.
      */
 	void OnEntityRemoved ( Entity & entity );
 
+	/**
+     * @brief Notifies the component manager that a batch of entities has been removed.
+     * @param entities The removed entities, must be unique.
+     *
+     * Components are grouped by their types and removed from each component array in a single tight loop.
+     */
+	void OnEntitiesRemoved ( std::span <Entity * const> entities );
+
+	/**
+     * @brief Moves all components of the entity into the component arrays of another component manager.
+     * @param source The entity owning the components, its component information is left stale and it must be removed afterwards.
+     * @param destination The component manager receiving the components, the missing component arrays are registered.
+     * @param target The entity of the destination manager receiving the components, must not have any of them.
+     *
+     * The components are move constructed into the destination arrays, leaving the groups and indices of this manager
+     * and joining the ones of the destination.
+     */
+	void MoveComponents ( Entity & source, ComponentManager & destination, Entity & target );
+
+	/**
+     * @brief Releases the excess memory of the sparse component arrays.
+     * @param occupancy The arrays with the size below this fraction of their capacity are shrunk, 1 shrinks all of them.
+     * @return The number of shrunk component arrays.
+     */
+	std::size_t ShrinkToFit ( float occupancy = 1.f );
+
 	/**
      * @brief Retrieves the ComponentType code for the specified component type.
      * @tparam T The type of the component to get the ComponentType code for.
@@ -164,6 +412,7 @@ public:
 	template <typename T>
 	bool AddComponentChecked ( Entity & entity, const T & component )
 	{
+		AssertComponentOwner ( entity, component );
         if ( ! GetIsComponentRegistered <T> () )
             return false;
         const auto ComponentType = GetComponentType<T> ();
@@ -171,6 +420,7 @@ public:
             return false;
         const auto ComponentHandle = GetComponentArray <T> () -> AddObject ( component );
         entity . AddComponent ( { ComponentType, ComponentHandle } );
+        OnComponentAdded ( entity, ComponentType );
         return true;
 	}
 
@@ -184,6 +434,7 @@ public:
 	template <typename T>
 	bool AddComponentChecked ( Entity & entity, T && component )
 	{
+		AssertComponentOwner ( entity, component );
 		if ( ! GetIsComponentRegistered <T> () )
 			return false;
         const auto ComponentType = GetComponentType<T> ();
@@ -191,6 +442,7 @@ public:
             return false;
 		const auto ComponentHandle = GetComponentArray <T> () -> AddObject ( std::forward <T> ( component ) );
 		entity . AddComponent ( { ComponentType, ComponentHandle } );
+		OnComponentAdded ( entity, ComponentType );
 		return true;
 	}
 
@@ -212,6 +464,9 @@ public:
 
 		const auto ComponentHandle = entity . GetComponentHandle ( ComponentType );
 		const auto ComponentArray = GetComponentArray <T> ();
+		if ( ! ComponentArray -> GetIsValidHandle ( ComponentHandle ) )
+			return false;
+		OnComponentRemoving ( entity, ComponentType );
 		if ( ! ComponentArray -> RemoveObjectChecked ( ComponentHandle ) )
 			return false;
 		entity . RemoveComponent ( ComponentType );
@@ -241,6 +496,34 @@ public:
 	/* End ComponentManager safe interface */
 private:
 
+	/**
+     * @brief Asserts that the component deriving from ComponentBase is owned by the entity it is added to.
+     *
+     * ForEach reaches the entities through ComponentBase::GetOwner of the driving components, so the owner must be consistent.
+     */
+	template <typename T>
+	static void AssertComponentOwner ( [[maybe_unused]] const Entity & entity, [[maybe_unused]] const T & component )
+	{
+		if constexpr ( std::is_base_of_v <ComponentBase, std::decay_t <T>> )
+			assert ( component . GetOwner () == entity . GetHandle () && "The component must be owned by the entity it is added to" );
+	}
+
+	/**
+     * @brief Appends the component type of the query term into the corresponding mask.
+     * @tparam Term The query term.
+     * @param include The include mask.
+     * @param exclude The exclude mask.
+     */
+	template <typename Term>
+	void AppendQueryTerm ( Signature & include, Signature & exclude ) const
+	{
+		const auto ComponentType = GetComponentType <typename detail::QueryTerm <Term>::Type> ();
+		if constexpr ( detail::QueryTerm <Term>::Kind == QueryTermKind::With )
+			include . insert ( ComponentType );
+		else if constexpr ( detail::QueryTerm <Term>::Kind == QueryTermKind::Without )
+			exclude . insert ( ComponentType );
+	}
+
 	/**
      * @brief Retrieves the component array for the specified component type.
      * @tparam T The type of the component to retrieve the component array for.
@@ -266,5 +549,30 @@ private:
 		return std::static_pointer_cast <ObjectManager <T>> ( Interface );
 	}
 
+	/**
+     * @brief Moves the entity into the group owning the component type if the entity gained all grouped components
+     * and indexes the component.
+     * @param entity The entity which component was added.
+     * @param componentType The type of the added component.
+     */
+	void OnComponentAdded ( Entity & entity, ComponentType componentType );
+
+	/**
+     * @brief Moves the entity out of the group owning the component type and out of the indices before the component is removed.
+     * @param entity The entity which component is going to be removed.
+     * @param componentType The type of the component going to be removed.
+     */
+	void OnComponentRemoving ( Entity & entity, ComponentType componentType );
+
+	/**
+     * @brief Marks the component of the entity as changed in all indices of the component type.
+     * @param entity The entity which component may have changed.
+     * @param componentType The type of the component, nothing is marked if it isn't indexed.
+     */
+	void MarkComponentChanged ( Entity & entity, ComponentType componentType );
+
 	std::unordered_map <ComponentType, std::shared_ptr <IObjectManager>> m_Components; /**< The storage for component arrays managed by the ComponentManager. */
+	std::unordered_map <ComponentType, std::shared_ptr <IGroup>> m_GroupOwners; /**< The owning groups by the types of owned components. */
+	std::unordered_map <ComponentType, std::vector <ComponentHandle>> m_RemovedComponents; /**< Scratch buffers of the batch removal grouped by component types. */
+	std::unordered_map <ComponentType, std::vector <std::shared_ptr <IComponentIndex>>> m_Indices; /**< The secondary indices by the types of indexed components. */
 };
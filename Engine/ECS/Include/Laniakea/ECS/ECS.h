@@ -3,6 +3,13 @@
 #include "EntityManager.h"
 #include "ComponentManager.h"
 #include "SystemManager.h"
+#include "Query.h"
+#include "SpatialIndex.h"
+#include "Task.h"
+#include "ECSRecorder.h"
+#include <array>
+#include <chrono>
+#include <typeinfo>
 
 
 /**
@@ -27,12 +34,98 @@ public:
      */
 	EntityHandle CreateEntity ();
 
+	/**
+     * @brief Reserves a handle for the entity which is created at the next sync point.
+     * @return A valid generation tagged handle of the reserved entity.
+     *
+     * Lock-free, can be called from any thread, e.g. from worker jobs, concurrently with other ReserveEntity calls.
+     * The entity is created by MaterializeReservedEntities or EntityCommandBuffer::Execute on the owning thread,
+     * so components of the reserved entity are attached through the EntityCommandBuffer.
+     */
+	EntityHandle ReserveEntity ();
+
+	/**
+     * @brief Creates all entities reserved since the previous sync point.
+     * @return The number of created entities.
+     *
+     * Must not be called concurrently with ReserveEntity. The attached recorder records the creation of each entity.
+     */
+	std::size_t MaterializeReservedEntities ();
+
 	/**
      * @brief Removes an entity from the ECS.
      * @param entityHandle The handle of the entity to be removed.
      */
 	void RemoveEntity ( EntityHandle entityHandle );
 
+	/**
+     * @brief Moves an entity with all its components into another ECS.
+     * @param entityHandle The handle of the entity to be moved.
+     * @param destination The ECS receiving the entity, must not be this ECS.
+     * @return The handle of the entity in the destination ECS.
+     *
+     * The components are move constructed into the destination component arrays and their owners are updated.
+     * The component types missing in the destination are registered. The handle is invalid in this ECS afterwards.
+     * Neither ECS may be running its systems during the call.
+     */
+	EntityHandle MigrateEntity ( EntityHandle entityHandle, ECS & destination );
+
+	/**
+     * @brief Removes a batch of entities from the ECS.
+     * @param entityHandles The handles of the entities to be removed, must be valid and unique.
+     *
+     * Components are removed per component array and entities per system and query, each in a single loop,
+     * instead of notifying every manager once per entity.
+     */
+	void DestroyEntities ( std::span <const EntityHandle> entityHandles );
+
+	/**
+     * @brief Queues the entity to be removed by ProcessDeferredDestroys.
+     * @param entityHandle The handle of the entity to be removed.
+     *
+     * The entity stays alive and valid until it's processed. Queuing the same entity more than once is allowed.
+     */
+	void DestroyDeferred ( EntityHandle entityHandle );
+
+	static constexpr std::size_t DeferredDestroyBatchSize = 1024; /**< The number of entities removed between budget checks. */
+
+	/**
+     * @brief Removes the queued entities in batches of DeferredDestroyBatchSize.
+     * @param budget The time budget, zero to process the whole queue. The remaining entities are left for the next call.
+     * @return The number of removed entities.
+     *
+     * Stale handles, e.g. of entities removed in the meantime, are skipped. The auto compaction runs once after all batches.
+     */
+	std::size_t ProcessDeferredDestroys ( std::chrono::microseconds budget = std::chrono::microseconds::zero () );
+
+	/**
+     * @brief Retrieves the number of entities waiting in the deferred destroy queue.
+     * @return The number of queued entity handles.
+     */
+	std::size_t GetDeferredDestroysCount () const;
+
+	/**
+     * @brief Retrieves the number of entities.
+     * @return The number of created entities, excluding the reserved ones not yet materialized.
+     */
+	std::size_t GetEntitiesCount () const;
+
+	/**
+     * @brief Releases the excess memory of all component arrays, entities, systems and queries.
+     *
+     * Intended for level unloads and other points after mass removal. Handles stay valid.
+     * Must not be called concurrently with ReserveEntity.
+     */
+	void Compact ();
+
+	/**
+     * @brief Enables compaction after entity removal once the entity storage drops below the occupancy.
+     * @param occupancy The fraction of the storage capacity in use triggering the compaction, zero disables it.
+     *
+     * The triggered compaction shrinks only the component arrays below the same occupancy.
+     */
+	void SetAutoCompactOccupancy ( float occupancy );
+
 	/**
      * @brief Retrieves a reference to the entity associated with the given handle.
      * @param entityHandle The handle of the entity to retrieve.
@@ -67,9 +160,35 @@ public:
 	template <typename T>
 	void RegisterComponent ()
 	{
-		return m_ComponentManager . RegisterComponent <T> ();
+		m_ComponentManager . RegisterComponent <T> ();
+		if ( m_Recorder )
+			m_Recorder -> RecordRegisterComponent ( GetComponentType <T> (), sizeof ( T ), typeid ( T ) . name () );
 	}
 
+	/**
+     * @brief Registers the component type with the component array created by the caller.
+     * @param componentType The code of the component type.
+     * @param components The component array storing the components of the type.
+     *
+     * Type-erased counterpart of RegisterComponent, e.g. for the tools working with the component types unknown at compile time.
+     */
+	void RegisterComponent ( ComponentType componentType, std::shared_ptr <IObjectManager> components );
+
+	/**
+     * @brief Attaches the component already stored in its registered component array to an entity.
+     * @param entityHandle The handle of the entity to which the component will be attached.
+     * @param componentType The code of the component type.
+     * @param componentHandle The handle of the component within its component array.
+     */
+	void AttachComponent ( EntityHandle entityHandle, ComponentType componentType, ComponentHandle componentHandle );
+
+	/**
+     * @brief Removes a component of the given type from an entity.
+     * @param entityHandle The handle of the entity from which the component will be removed.
+     * @param componentType The code of the component type.
+     */
+	void RemoveComponent ( EntityHandle entityHandle, ComponentType componentType );
+
 	/**
      * @brief Adds a new component to an entity.
      * @tparam T The type of the component to be added.
@@ -81,7 +200,8 @@ public:
 	{
 		Entity & e = GetEntity ( entityHandle );
 		m_ComponentManager . AddComponent ( e, std::forward <T> ( component ) );
-		m_SystemManager . OnEntitySignatureChanged ( e, e . GetSignature () );
+		RecordComponentAdded <std::remove_cvref_t <T>> ( e );
+		OnEntitySignatureChanged ( e );
 	}
 
 	/**
@@ -95,7 +215,8 @@ public:
 	{
 		Entity & e = GetEntity ( entityHandle );
 		m_ComponentManager . AddComponent ( e, component );
-		m_SystemManager . OnEntitySignatureChanged ( e, e . GetSignature () );
+		RecordComponentAdded <T> ( e );
+		OnEntitySignatureChanged ( e );
 	}
 
 	/**
@@ -108,21 +229,146 @@ public:
 	{
 		Entity & e = GetEntity ( entityHandle );
 		m_ComponentManager . RemoveComponent <T> ( e );
-		m_SystemManager . OnEntitySignatureChanged ( e, e . GetSignature () );
+		if ( m_Recorder )
+			m_Recorder -> RecordRemoveComponent ( entityHandle, GetComponentType <T> () );
+		OnEntitySignatureChanged ( e );
 	}
 
 	/**
      * @brief Retrieves a reference to the component of the specified type associated with the given entity.
      * @tparam T The type of the component to retrieve.
      * @param entity The handle of the entity for which to retrieve the component.
-     * @return A reference to the component.
+     * @return A reference to the component, the indices of the component reread it before their next query.
      */
 	template <typename T>
 	T & GetComponent ( EntityHandle entity )
 	{
 		Entity & e = GetEntity ( entity );
-		return m_ComponentManager . GetComponent <T> ( e );
+		T & Component = m_ComponentManager . GetComponent <T> ( e );
+		m_ComponentManager . OnComponentAccessed ( e, GetComponentType <T> () );
+		return Component;
+	}
+
+	/**
+     * @brief Retrieves a pointer to the component of the specified type if it is attached to the entity.
+     * @tparam T The type of the component to retrieve.
+     * @param entityHandle The handle of the entity for which to retrieve the component.
+     * @return A pointer to the component, or nullptr if the component isn't attached or registered.
+     *
+     * Replaces the GetEntityHasComponent + GetComponent pair with a single lookup.
+     */
+	template <typename T>
+	T * TryGetComponent ( EntityHandle entityHandle )
+	{
+		Entity & e = GetEntity ( entityHandle );
+		T * Component = m_ComponentManager . TryGetComponent <T> ( e );
+		if ( Component )
+			m_ComponentManager . OnComponentAccessed ( e, GetComponentType <T> () );
+		return Component;
 	}
+
+	/**
+     * @brief Iterates over a view of all entities matching the query terms.
+     * @tparam Terms The query terms: plain component types, query::With <T>, query::Without <T> or query::Optional <T>.
+     * @param func The callable invoked as func ( EntityHandle, T & ..., U * ... ) for each matching entity.
+     * A reference is passed for each With term, a nullable pointer for each Optional term and nothing for Without terms.
+     *
+     * Component arrays are fetched once before the iteration. The smallest array of the With terms drives the iteration
+     * and only the rest of the terms are tested per entity, the owners are taken from ComponentBase::GetOwner. If none of
+     * the With components derives from ComponentBase all entities are scanned. The visited components are marked as
+     * changed for their indices. The callable must not create or remove entities or change their components.
+     */
+	template <typename ... Terms, typename Func>
+	void ForEach ( Func && func )
+	{
+		const auto ComponentArrays = FindQueryComponentArrays <Terms ...> ();
+		const std::array <ComponentType, sizeof ... ( Terms )> ComponentTypes {
+				m_ComponentManager . GetComponentType <typename detail::QueryTerm <Terms>::Type> () ... };
+
+		// No entity can match while a required component isn't registered.
+		bool IsEmpty = false;
+		std::size_t Driver = sizeof ... ( Terms );
+		FindQueryDriver <Terms ...> ( ComponentArrays, IsEmpty, Driver, std::index_sequence_for <Terms ...> () );
+		if ( IsEmpty )
+			return;
+
+		if ( Driver == sizeof ... ( Terms ) ) {
+			for ( Entity & e : m_EntityManager ) {
+				if ( GetIsMatchingQuery <Terms ...> ( e, ComponentTypes, Driver, std::index_sequence_for <Terms ...> () ) )
+					VisitEntity <Terms ...> ( e, func, ComponentArrays, std::index_sequence_for <Terms ...> () );
+			}
+			return;
+		}
+		ForEachInDriver <Terms ...> ( func, ComponentArrays, ComponentTypes, Driver, std::index_sequence_for <Terms ...> () );
+	}
+
+	/**
+     * @brief Registers a persistent query maintained incrementally on structural changes of entities.
+     * @tparam Terms The query terms: plain component types, query::With <T>, query::Without <T> or query::Optional <T>.
+     * @return The query bound to the backing list shared with all queries of the same filter.
+     *
+     * The backing list is populated from the existing entities once, then kept up to date by the component add / remove paths.
+     */
+	template <typename ... Terms>
+	Query <Terms ...> RegisterQuery ()
+	{
+		return Query <Terms ...> ( m_QueryManager . GetOrCreateQuery ( GetQueryFilter <Terms ...> (), m_EntityManager ) );
+	}
+
+	/**
+     * @brief Iterates over the entities of the persistent query in O(matches).
+     * @tparam Terms The query terms of the query.
+     * @param query The registered query.
+     * @param func The callable invoked as func ( EntityHandle, T & ..., U * ... ) for each matching entity.
+     *
+     * The callable must not create or remove entities or change their components.
+     */
+	template <typename ... Terms, typename Func>
+	void ForEach ( const Query <Terms ...> & query, Func && func )
+	{
+		const auto ComponentArrays = FindQueryComponentArrays <Terms ...> ();
+		for ( const EntityHandle Handle : query ) {
+			VisitEntity <Terms ...> ( GetEntity ( Handle ), func, ComponentArrays, std::index_sequence_for <Terms ...> () );
+		}
+	}
+
+	/**
+     * @brief Registers an owning group keeping the component arrays in lockstep order.
+     * @tparam Ts The types of the components to be grouped. All of them must be registered and not owned by another group.
+     * @return A weak pointer to the group populated with the existing entities.
+     */
+	template <typename ... Ts>
+	std::weak_ptr <Group <Ts ...>> RegisterGroup ()
+	{
+		auto OwningGroup = m_ComponentManager . RegisterGroup <Ts ...> ();
+		for ( Entity & e : m_EntityManager ) {
+			OwningGroup -> OnComponentAdded ( e );
+		}
+		return OwningGroup;
+	}
+
+	/**
+     * @brief Retrieves the owning group of the components.
+     * @tparam Ts The types of the grouped components in the order of the group registration.
+     * @return A weak pointer to the group if registered, otherwise an expired weak pointer.
+     */
+	template <typename ... Ts>
+	std::weak_ptr <Group <Ts ...>> GetGroup ()
+	{
+		return m_ComponentManager . GetGroup <Ts ...> ();
+	}
+
+	/**
+     * @brief Checks if the component array is owned by a group.
+     * @tparam T The type of the component.
+     * @return True if the group keeps the order of the array, so it must not be reordered by anything else.
+     */
+	template <typename T>
+	bool GetIsComponentGrouped () const
+	{
+		return m_ComponentManager . GetIsComponentGrouped <T> ();
+	}
+
 	/**
      * @brief Retrieves the ComponentType code for the specified component type.
      * @tparam T The type of the component to get the ComponentType code for.
@@ -138,6 +384,8 @@ public:
      * @brief Retrieves a weak pointer to the component array of the specified type.
      * @tparam T The type of the component to retrieve.
      * @return A weak pointer to the component array if registered, otherwise an expired weak pointer.
+     *
+     * The writes through the array aren't tracked, MarkComponentChanged must follow them if the component is indexed.
      */
 	template <typename T>
 	std::weak_ptr <ObjectManager <T>> GetComponentsByType ()
@@ -145,6 +393,107 @@ public:
 		return m_ComponentManager . GetComponentsByType <T> ();
 	}
 
+	/**
+     * @brief Adds the sorted index on the component field answering range queries.
+     * @tparam T The type of the indexed component. Must be registered.
+     * @param keyFunction The callable or the member pointer extracting the key from the component.
+     * @return A shared pointer to the index populated with existing entities.
+     */
+	template <typename T, typename Func>
+	auto AddSortedIndex ( Func && keyFunction )
+	{
+		using Key = std::decay_t <std::invoke_result_t <Func, const T &>>;
+		auto Index = m_ComponentManager . AddIndex <SortedIndex <T, Key>, T> ( std::forward <Func> ( keyFunction ) );
+		PopulateIndex ( GetComponentType <T> (), * Index );
+		return Index;
+	}
+
+	/**
+     * @brief Adds the hash index on the component field answering equality queries.
+     * @tparam T The type of the indexed component. Must be registered.
+     * @param keyFunction The callable or the member pointer extracting the key from the component.
+     * @return A shared pointer to the index populated with existing entities.
+     */
+	template <typename T, typename Func>
+	auto AddHashIndex ( Func && keyFunction )
+	{
+		using Key = std::decay_t <std::invoke_result_t <Func, const T &>>;
+		auto Index = m_ComponentManager . AddIndex <HashIndex <T, Key>, T> ( std::forward <Func> ( keyFunction ) );
+		PopulateIndex ( GetComponentType <T> (), * Index );
+		return Index;
+	}
+
+	/**
+     * @brief Adds the bucketed histogram index on the arithmetic component field.
+     * @tparam T The type of the indexed component. Must be registered.
+     * @param keyFunction The callable or the member pointer extracting the key from the component.
+     * @param min The lower bound of the first bucket.
+     * @param max The upper bound of the last bucket.
+     * @param bucketsCount The number of buckets.
+     * @return A shared pointer to the index populated with existing entities.
+     */
+	template <typename T, typename Func, typename Key = std::decay_t <std::invoke_result_t <Func, const T &>>>
+	auto AddHistogramIndex ( Func && keyFunction, Key min, Key max, std::size_t bucketsCount )
+	{
+		auto Index = m_ComponentManager . AddIndex <HistogramIndex <T, Key>, T> ( std::forward <Func> ( keyFunction ), min, max, bucketsCount );
+		PopulateIndex ( GetComponentType <T> (), * Index );
+		return Index;
+	}
+
+	/**
+     * @brief Reindexes the component of the entity after it has been changed through its component array or group.
+     * @tparam T The type of the changed component.
+     *
+     * The other mutable accessors mark the component for the reindexing themselves.
+     * @param entityHandle The handle of the entity.
+     */
+	template <typename T>
+	void MarkComponentChanged ( EntityHandle entityHandle )
+	{
+		m_ComponentManager . OnComponentChanged ( m_EntityManager . GetEntity ( entityHandle ), GetComponentType <T> () );
+	}
+
+	/**
+     * @brief Modifies the component of the entity and keeps the indices of the component up to date.
+     * @tparam T The type of the component.
+     * @param entityHandle The handle of the entity.
+     * @param func The callable invoked as func ( T & ).
+     */
+	template <typename T, typename Func>
+	void PatchComponent ( EntityHandle entityHandle, Func && func )
+	{
+		Entity & e = m_EntityManager . GetEntity ( entityHandle );
+		std::invoke ( std::forward <Func> ( func ), m_ComponentManager . GetComponent <T> ( e ) );
+		m_ComponentManager . OnComponentChanged ( e, GetComponentType <T> () );
+	}
+
+	/**
+     * @brief Adds the spatial index over the entities having the position component.
+     * @tparam T The type of the component providing the position. Must be registered.
+     * @param partition The partition storing the entities, e.g. HashGrid or LooseOctree.
+     * @param positionFunction The callable returning SpatialPoint for the component.
+     * @param radiusFunction The callable returning the bounding radius for the component, the entities are points if empty.
+     * @return A shared pointer to the index built from existing entities.
+     */
+	template <typename T>
+	std::shared_ptr <SpatialIndex <T>> AddSpatialIndex ( std::unique_ptr <ISpatialPartition> partition,
+														 typename SpatialIndex <T>::PositionFunction positionFunction,
+														 typename SpatialIndex <T>::RadiusFunction radiusFunction = {} )
+	{
+		auto Index = std::make_shared <SpatialIndex <T>> ( m_ComponentManager . GetComponentsByType <T> () . lock (), std::move ( partition ),
+														   std::move ( positionFunction ), std::move ( radiusFunction ) );
+		Index -> Sync ( GetThreadPool () . get () );
+		m_SpatialIndices . push_back ( Index );
+		return Index;
+	}
+
+	/**
+     * @brief Updates all spatial indices with the current positions of the components.
+     *
+     * Called at the start of RunSystems, so the systems query the positions of the end of the previous tick.
+     */
+	void SyncSpatialIndices ();
+
 	/**
      * @brief Checks if a component of the specified type is registered with the ECS.
      * @tparam T The type of the component to check for registration.
@@ -159,16 +508,19 @@ public:
 	/**
      * @brief Registers a new system with the ECS.
      * @tparam T The type of the system to be registered.
-     * @tparam ComponentTypes The component types required by the system.
+     * @tparam Terms The query terms of the system: required component types, query::With <T> or query::Without <T>.
+     *
+     * The terms are resolved into include / exclude masks once, so the excluded entities never get into the system.
      */
-	template <typename T, typename ... ComponentTypes>
+	template <typename T, typename ... Terms>
 	void RegisterSystem ()
 	{
-		return m_SystemManager . RegisterSystem <T> ( std::move ( GetComponentsSignature <ComponentTypes ...> () ) );
+		static_assert ( ! detail::HasOptionalQueryTerm <Terms ...>, "Systems don't take Optional terms, use TryGetComponent in the system instead" );
+		return m_SystemManager . RegisterSystem <T> ( GetQueryFilter <Terms ...> () );
 	}
 
 	/**
-     * @brief Runs a system of the specified type.
+     * @brief Runs a system of the specified type according to its schedule.
      * @tparam T The type of the system to be run.
      */
 	template <typename T>
@@ -177,6 +529,75 @@ public:
 		m_SystemManager . RunSystem <T> ( * this );
 	}
 
+	/**
+     * @brief Runs all registered systems in the registration order according to their schedules.
+     */
+	void RunSystems ();
+
+	/**
+     * @brief Takes the ownership of the task and runs it until its first suspension point.
+     * @param task The coroutine task, e.g. a function returning Task which co_awaits NextFrame, WaitFor or Job.
+     */
+	void StartTask ( Task && task );
+
+	/**
+     * @brief Resumes the tasks due on this tick in batches.
+     * @param deltaSeconds The time elapsed since the previous tick, advances the WaitFor timers.
+     */
+	void UpdateTasks ( double deltaSeconds );
+
+	/**
+     * @brief Retrieves the number of unfinished tasks.
+     * @return The number of tasks owned by the ECS.
+     */
+	std::size_t GetTasksCount () const;
+
+	/**
+     * @brief Sets the thread pool shared by the jobs of the ECS.
+     * @param threadPool The thread pool, possibly shared with other ECS instances.
+     */
+	void SetThreadPool ( std::shared_ptr <ThreadPool> threadPool );
+
+	/**
+     * @brief Retrieves the thread pool shared by the jobs of the ECS, creating it on the first use.
+     * @return A shared pointer to the thread pool.
+     */
+	std::shared_ptr <ThreadPool> GetThreadPool ();
+
+	/**
+     * @brief Sets the recorder capturing the structural operations of the ECS.
+     * @param recorder The recorder, or nullptr to stop the recording.
+     */
+	void SetRecorder ( std::shared_ptr <ECSRecorder> recorder );
+
+	/**
+     * @brief Retrieves the recorder capturing the structural operations of the ECS.
+     * @return A shared pointer to the recorder, nullptr if the ECS isn't recorded.
+     */
+	std::shared_ptr <ECSRecorder> GetRecorder () const;
+
+	/**
+     * @brief Sets the scheduling options of the system of the specified type.
+     * @tparam T The type of the system.
+     * @param schedule The new schedule of the system, must be valid (see SystemSchedule::GetIsValid).
+     */
+	template <typename T>
+	void SetSystemSchedule ( const SystemSchedule & schedule )
+	{
+		m_SystemManager . GetSystem <T> () . lock () -> SetSchedule ( schedule );
+	}
+
+	/**
+     * @brief Retrieves the recorded timing of the system of the specified type.
+     * @tparam T The type of the system.
+     * @return A copy of the system stats.
+     */
+	template <typename T>
+	SystemStats GetSystemStats ()
+	{
+		return m_SystemManager . GetSystem <T> () . lock () -> GetStats ();
+	}
+
 	/**
      * @brief Retrieves a weak pointer to the system of the specified type.
      * @tparam T The type of the system to retrieve.
@@ -220,6 +641,17 @@ public:
 	{
 		return { m_ComponentManager . GetComponentType <ComponentTypes> () ... };
 	}
+
+	/**
+     * @brief Resolves the query terms into the include and exclude masks.
+     * @tparam Terms The query terms: plain component types, query::With <T>, query::Without <T> or query::Optional <T>.
+     * @return The filter of the query.
+     */
+	template <typename ... Terms>
+	QueryFilter GetQueryFilter () const
+	{
+		return m_ComponentManager . GetQueryFilter <Terms ...> ();
+	}
 	/* End Entity Component System interface */
 
 
@@ -247,7 +679,10 @@ public:
 	template <typename T>
 	bool RegisterComponentChecked ()
 	{
-		return m_ComponentManager . RegisterComponentChecked <T> ();
+		if ( GetIsComponentRegistered <T> () )
+			return false;
+		RegisterComponent <T> ();
+		return true;
 	}
 
 	/**
@@ -265,7 +700,8 @@ public:
 		Entity & entity = GetEntity ( entityHandle );
 		if ( ! m_ComponentManager . AddComponentChecked ( entity, component ) )
 			return false;
-		m_SystemManager . OnEntitySignatureChanged ( entity, entity . GetSignature () );
+		RecordComponentAdded <T> ( entity );
+		OnEntitySignatureChanged ( entity );
 		return true;
 	}
 
@@ -284,7 +720,8 @@ public:
 		Entity & entity = GetEntity ( entityHandle );
 		if ( ! m_ComponentManager . AddComponentChecked ( entity, std::forward <T> ( component ) ) )
 			return false;
-		m_SystemManager . OnEntitySignatureChanged ( entity, entity . GetSignature () );
+		RecordComponentAdded <std::remove_cvref_t <T>> ( entity );
+		OnEntitySignatureChanged ( entity );
 		return true;
 	}
 
@@ -303,7 +740,9 @@ public:
 		Entity & e = m_EntityManager . GetEntity ( entityHandle );
 		if ( ! m_ComponentManager . RemoveComponentChecked <T> ( e ) )
 			return false;
-		m_SystemManager . OnEntitySignatureChanged ( e, e . GetSignature () );
+		if ( m_Recorder )
+			m_Recorder -> RecordRemoveComponent ( entityHandle, GetComponentType <T> () );
+		OnEntitySignatureChanged ( e );
 		return true;
 	}
 
@@ -320,7 +759,10 @@ public:
 		if ( ! _entity )
 			return std::nullopt;
 		Entity & entity = _entity . value () . get ();
-		return m_ComponentManager . GetComponentChecked <T> ( entity );
+		auto Component = m_ComponentManager . GetComponentChecked <T> ( entity );
+		if ( Component )
+			m_ComponentManager . OnComponentAccessed ( entity, GetComponentType <T> () );
+		return Component;
 	}
 
 	/**
@@ -341,14 +783,27 @@ public:
 	/**
      * @brief Registers a new system with the ECS in a safe manner.
      * @tparam T The type of the system to be registered.
-     * @tparam ComponentTypes The component types required by the system.
+     * @tparam Terms The query terms of the system: required component types, query::With <T> or query::Without <T>.
      * @return True if the system was successfully registered, false if the system is already registered.
      */
-	template <typename T, typename ... ComponentTypes>
+	template <typename T, typename ... Terms>
 	bool RegisterSystemChecked ()
 	{
-		return m_SystemManager . RegisterSystemChecked <T> (
-				std::forward <Signature> ( GetComponentsSignature <ComponentTypes...> () ) );
+		static_assert ( ! detail::HasOptionalQueryTerm <Terms ...>, "Systems don't take Optional terms, use TryGetComponent in the system instead" );
+		return m_SystemManager . RegisterSystemChecked <T> ( GetQueryFilter <Terms ...> () );
+	}
+
+	/**
+     * @brief Registers an owning group in a safe manner.
+     * @tparam Ts The types of the components to be grouped.
+     * @return A weak pointer to the group, or an expired weak pointer if any component isn't registered or is already owned by another group.
+     */
+	template <typename ... Ts>
+	std::weak_ptr <Group <Ts ...>> RegisterGroupChecked ()
+	{
+		if ( ! m_ComponentManager . GetCanRegisterGroup <Ts ...> () )
+			return {};
+		return RegisterGroup <Ts ...> ();
 	}
 
 	/**
@@ -361,11 +816,184 @@ public:
 	{
 		return m_SystemManager . RunSystemChecked <T> ( * this );
 	}
+
+	/**
+     * @brief Sets the scheduling options of the system of the specified type in a safe manner.
+     * @tparam T The type of the system.
+     * @param schedule The new schedule of the system.
+     * @return True if the schedule was set, false if the system is not registered or the schedule isn't valid.
+     */
+	template <typename T>
+	bool SetSystemScheduleChecked ( const SystemSchedule & schedule )
+	{
+		const auto System = m_SystemManager . GetSystem <T> () . lock ();
+		if ( ! System || ! schedule . GetIsValid () )
+			return false;
+		System -> SetSchedule ( schedule );
+		return true;
+	}
 	/* End Entity Component System safe interface */
 private:
 
+	/**
+     * @brief Notifies systems and queries about the change of the entity's signature.
+     * @param entity The entity whose components have changed.
+     */
+	void OnEntitySignatureChanged ( Entity & entity );
+
+	/**
+     * @brief Inserts the existing entities with the component into the newly added index.
+     * @param componentType The type of the indexed component.
+     * @param index The index to be populated.
+     */
+	void PopulateIndex ( ComponentType componentType, IComponentIndex & index );
+
+	/**
+     * @brief Releases the excess memory of the containers with occupancy below the given fraction.
+     * @param occupancy The fraction of the capacity in use below which the component arrays are shrunk.
+     */
+	void Compact ( float occupancy );
+
+	/**
+     * @brief Removes a batch of entities without the auto compaction, see DestroyEntities.
+     * @param entityHandles The handles of the entities to be removed, must be valid and unique.
+     */
+	void RemoveEntities ( std::span <const EntityHandle> entityHandles );
+
+	/**
+     * @brief Compacts the ECS if the entity storage occupancy dropped below the auto compaction threshold.
+     */
+	void AutoCompact ();
+
+	/**
+     * @brief Records the component added to the entity if the ECS is recorded.
+     * @tparam T The type of the added component.
+     * @param entity The entity to which the component was added.
+     */
+	template <typename T>
+	void RecordComponentAdded ( Entity & entity )
+	{
+		if ( m_Recorder )
+			m_Recorder -> RecordAddComponent ( entity . GetHandle (), GetComponentType <T> (),
+					std::as_bytes ( std::span ( & m_ComponentManager . GetComponent <T> ( entity ), 1 ) ) );
+	}
+
+	template <typename ... Terms>
+	std::tuple <ObjectManager <typename detail::QueryTerm <Terms>::Type> * ...> FindQueryComponentArrays ()
+	{
+		return { m_ComponentManager . FindComponentArray <typename detail::QueryTerm <Terms>::Type> () ... };
+	}
+
+	/**
+     * @brief Picks the smallest component array of the With terms deriving from ComponentBase to drive ForEach.
+     * @param isEmpty Set if a With component isn't registered, so nothing matches.
+     * @param driver Set to the index of the driving term, left as is if no term can drive.
+     */
+	template <typename ... Terms, typename ComponentArrays, std::size_t ... Indices>
+	static void FindQueryDriver ( const ComponentArrays & componentArrays, bool & isEmpty, std::size_t & driver, std::index_sequence <Indices ...> )
+	{
+		std::size_t DriverSize = 0;
+		( [ & ]
+		{
+			using Term = std::tuple_element_t <Indices, std::tuple <Terms ...>>;
+			if constexpr ( detail::QueryTerm <Term>::Kind == QueryTermKind::With ) {
+				const auto * Array = std::get <Indices> ( componentArrays );
+				if ( ! Array ) {
+					isEmpty = true;
+					return;
+				}
+				if constexpr ( std::is_base_of_v <ComponentBase, typename detail::QueryTerm <Term>::Type> ) {
+					if ( driver == sizeof ... ( Terms ) || Array -> Size () < DriverSize ) {
+						driver = Indices;
+						DriverSize = Array -> Size ();
+					}
+				}
+			}
+		} (), ... );
+	}
+
+	/**
+     * @brief Tests the entity against the query terms except the driving one, which holds by construction.
+     */
+	template <typename ... Terms, std::size_t ... Indices>
+	static bool GetIsMatchingQuery ( const Entity & e, const std::array <ComponentType, sizeof ... ( Terms )> & componentTypes,
+									 std::size_t driver, std::index_sequence <Indices ...> )
+	{
+		return ( [ & ]
+		{
+			using Term = std::tuple_element_t <Indices, std::tuple <Terms ...>>;
+			if constexpr ( detail::QueryTerm <Term>::Kind == QueryTermKind::With )
+				return Indices == driver || e . GetHasComponent ( componentTypes[ Indices ] );
+			else if constexpr ( detail::QueryTerm <Term>::Kind == QueryTermKind::Without )
+				return ! e . GetHasComponent ( componentTypes[ Indices ] );
+			else
+				return true;
+		} () && ... );
+	}
+
+	template <typename ... Terms, typename Func, typename ComponentArrays, std::size_t ... Indices>
+	void ForEachInDriver ( Func & func, const ComponentArrays & componentArrays,
+						   const std::array <ComponentType, sizeof ... ( Terms )> & componentTypes, std::size_t driver,
+						   std::index_sequence <Indices ...> )
+	{
+		( [ & ]
+		{
+			using Term = std::tuple_element_t <Indices, std::tuple <Terms ...>>;
+			if constexpr ( detail::QueryTerm <Term>::Kind == QueryTermKind::With
+						   && std::is_base_of_v <ComponentBase, typename detail::QueryTerm <Term>::Type> ) {
+				if ( Indices != driver )
+					return;
+				for ( auto & Component : * std::get <Indices> ( componentArrays ) ) {
+					Entity & e = GetEntity ( Component . GetOwner () );
+					if ( GetIsMatchingQuery <Terms ...> ( e, componentTypes, driver, std::index_sequence_for <Terms ...> () ) )
+						VisitDrivenEntity <Indices, Terms ...> ( e, Component, func, componentArrays, std::index_sequence_for <Terms ...> () );
+				}
+			}
+		} (), ... );
+	}
+
+	template <typename ... Terms, typename Func, typename ComponentArrays, std::size_t ... Indices>
+	void VisitEntity ( Entity & e, Func & func, const ComponentArrays & componentArrays, std::index_sequence <Indices ...> )
+	{
+		( m_ComponentManager . OnQueryTermAccessed <Terms> ( e ), ... );
+		std::apply ( func, std::tuple_cat ( std::make_tuple ( e . GetHandle () ),
+				m_ComponentManager . FetchQueryTerm <Terms> ( e, std::get <Indices> ( componentArrays ) ) ... ) );
+	}
+
+	/**
+     * @brief Visits the entity reached from the driving component array, the driving component is passed as is.
+     */
+	template <std::size_t Driver, typename ... Terms, typename DriverComponent, typename Func, typename ComponentArrays, std::size_t ... Indices>
+	void VisitDrivenEntity ( Entity & e, DriverComponent & driverComponent, Func & func, const ComponentArrays & componentArrays,
+							 std::index_sequence <Indices ...> )
+	{
+		( m_ComponentManager . OnQueryTermAccessed <Terms> ( e ), ... );
+		std::apply ( func, std::tuple_cat ( std::make_tuple ( e . GetHandle () ),
+				FetchDrivenQueryTerm <Terms, Indices == Driver> ( e, driverComponent, std::get <Indices> ( componentArrays ) ) ... ) );
+	}
+
+	template <typename Term, bool IsDriver, typename DriverComponent>
+	detail::QueryTermResult <Term> FetchDrivenQueryTerm ( Entity & e, DriverComponent & driverComponent,
+														  ObjectManager <typename detail::QueryTerm <Term>::Type> * componentArray ) const
+	{
+		if constexpr ( IsDriver )
+			return { driverComponent };
+		else
+			return m_ComponentManager . FetchQueryTerm <Term> ( e, componentArray );
+	}
+
 	ComponentManager m_ComponentManager;
 	EntityManager m_EntityManager;
 	SystemManager m_SystemManager;
+	QueryManager m_QueryManager;
+	std::vector <EntityHandle> m_DeferredDestroys; /**< The entities queued for ProcessDeferredDestroys, consumed from the cursor. */
+	std::size_t m_DeferredDestroysCursor = 0; /**< The number of queued entities already processed. */
+	std::vector <EntityHandle> m_DestroyBatch; /**< Scratch buffer of the currently processed deferred batch. */
+	std::vector <Entity *> m_DestroyedEntities; /**< Scratch buffer of the entities removed by DestroyEntities. */
+	std::vector <EntityHandle> m_MaterializedEntities; /**< Scratch buffer of the reserved entities materialized while recording. */
+	float m_AutoCompactOccupancy = 0.f; /**< The entity storage occupancy triggering the compaction, zero if disabled. */
+	std::vector <std::shared_ptr <ISpatialIndex>> m_SpatialIndices; /**< The spatial indices synchronized before the systems run. */
+	std::shared_ptr <ECSRecorder> m_Recorder; /**< The recorder of the structural operations, nullptr if not recorded. */
+	TaskScheduler m_TaskScheduler; /**< Runs the coroutine tasks, destroyed first as the suspended tasks may refer to the ECS. */
 
 };
@@ -0,0 +1,154 @@
+#pragma once
+
+#include "Core.h"
+#include <cstddef>
+#include <ostream>
+#include <span>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @brief The operations stored in the ECS recording, each one is followed by its arguments.
+ */
+enum class RecordedOperation : std::uint8_t
+{
+	RegisterComponent, /**< Type index, component type, size, name. */
+	CreateEntity, /**< Entity handle. */
+	RemoveEntity, /**< Entity handle. */
+	DestroyEntities, /**< Entities count, entity handles. */
+	AddComponent, /**< Entity handle, type index, payload size, payload bytes. */
+	RemoveComponent, /**< Entity handle, type index. */
+	EndFrame /**< No arguments. */
+};
+
+/**
+ * @class ECSRecorder
+ * @brief Appends the structural operations of the ECS with the component payloads into a compact binary log.
+ *
+ * Attached with ECS::SetRecorder, each RunSystems closes a frame. The integers are written as LEB128 varints and
+ * the component types are replaced by small indices registered on their first use. The records are appended into
+ * an in-memory buffer which is written to the stream once it exceeds the buffer size, so recording costs a few
+ * stores per operation plus the copy of the payload. The log is replayed with ECSReplayer.
+ */
+class LANIAKEA_ECS_API ECSRecorder
+{
+
+public:
+
+	static constexpr std::uint32_t Magic = 0x52454B4C; /**< "LKER" in the little endian order. */
+	static constexpr std::uint32_t Version = 1; /**< The version of the log format. */
+	static constexpr std::size_t DefaultBufferSize = 1 << 16; /**< The default size of the write buffer in bytes. */
+
+	/**
+     * @brief Constructor for ECSRecorder. Writes the header of the log.
+     * @param stream The binary stream receiving the log, must outlive the recorder.
+     * @param bufferSize The number of bytes buffered before they are written to the stream.
+     */
+	explicit ECSRecorder ( std::ostream & stream, std::size_t bufferSize = DefaultBufferSize );
+
+	/**
+     * @brief Destructor for ECSRecorder. Flushes the buffered records.
+     */
+	~ECSRecorder ();
+
+	ECSRecorder ( const ECSRecorder & ) = delete;
+	ECSRecorder & operator = ( const ECSRecorder & ) = delete;
+
+	/**
+     * @brief Records the registration of the component type.
+     * @param componentType The type of the component.
+     * @param size The size of the component in bytes.
+     * @param name The name of the component type for the diagnostics, may be empty.
+     */
+	void RecordRegisterComponent ( ComponentType componentType, std::size_t size, std::string_view name );
+
+	/**
+     * @brief Records the creation of the entity.
+     * @param entityHandle The handle of the created entity.
+     */
+	void RecordCreateEntity ( EntityHandle entityHandle );
+
+	/**
+     * @brief Records the removal of the entity.
+     * @param entityHandle The handle of the removed entity.
+     */
+	void RecordRemoveEntity ( EntityHandle entityHandle );
+
+	/**
+     * @brief Records the batch removal of the entities.
+     * @param entityHandles The handles of the removed entities.
+     */
+	void RecordDestroyEntities ( std::span <const EntityHandle> entityHandles );
+
+	/**
+     * @brief Records the component added to the entity, the type is registered without a name if it wasn't yet.
+     * @param entityHandle The handle of the entity.
+     * @param componentType The type of the component.
+     * @param payload The bytes of the added component.
+     */
+	void RecordAddComponent ( EntityHandle entityHandle, ComponentType componentType, std::span <const std::byte> payload );
+
+	/**
+     * @brief Records the component removed from the entity.
+     * @param entityHandle The handle of the entity.
+     * @param componentType The type of the component.
+     */
+	void RecordRemoveComponent ( EntityHandle entityHandle, ComponentType componentType );
+
+	/**
+     * @brief Records the end of the frame.
+     */
+	void RecordEndFrame ();
+
+	/**
+     * @brief Writes the buffered records to the stream and flushes it.
+     */
+	void Flush ();
+
+	/**
+     * @brief Retrieves the number of bytes recorded so far, including the buffered ones.
+     * @return The size of the log in bytes.
+     */
+	std::size_t GetRecordedBytesCount () const;
+
+	/**
+     * @brief Retrieves the number of recorded frames.
+     * @return The number of EndFrame records.
+     */
+	std::size_t GetFramesCount () const;
+
+private:
+
+	/**
+     * @brief Retrieves the index of the component type, registering it if needed.
+     */
+	std::uint32_t GetTypeIndex ( ComponentType componentType, std::size_t size, std::string_view name );
+
+	/**
+     * @brief Appends the operation code and writes the buffer out if it is full.
+     */
+	void WriteOperation ( RecordedOperation operation );
+
+	/**
+     * @brief Writes the buffered records to the stream.
+     */
+	void WriteBuffer ();
+
+	/**
+     * @brief Appends the unsigned integer as the LEB128 varint.
+     */
+	void WriteVarint ( std::uint64_t value );
+
+	/**
+     * @brief Appends the raw bytes.
+     */
+	void WriteBytes ( std::span <const std::byte> bytes );
+
+	std::ostream & m_Stream; /**< The stream receiving the log. */
+	std::vector <std::byte> m_Buffer; /**< The records not yet written to the stream. */
+	std::size_t m_BufferSize; /**< The number of bytes buffered before they are written to the stream. */
+	std::size_t m_WrittenBytesCount = 0; /**< The number of bytes written to the stream. */
+	std::size_t m_FramesCount = 0; /**< The number of recorded frames. */
+	std::unordered_map <ComponentType, std::uint32_t> m_TypeIndices; /**< The indices of the registered component types. */
+};
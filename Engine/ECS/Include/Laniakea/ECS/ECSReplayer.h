@@ -0,0 +1,128 @@
+#pragma once
+
+#include "ECS.h"
+#include <chrono>
+#include <istream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @class ECSReplayer
+ * @brief Reapplies the log written by ECSRecorder against an ECS frame by frame.
+ *
+ * The recorded component types are replaced by opaque components of the same size class, registered under the
+ * recorded type codes, so the replay reproduces the entity and component array operations of the recorded
+ * workload. Groups, queries and systems aren't recorded, the target ECS only has the ones set up by the caller.
+ * The recorded entity handles are mapped to the handles of the target ECS, the reserved entities are created
+ * where the recorded ECS materialized them, the entities which existed before the recording started are created
+ * on their first use. Each frame is decoded before it is applied, so the frame time covers only the ECS operations.
+ */
+class LANIAKEA_ECS_API ECSReplayer
+{
+
+public:
+
+	/**
+     * @brief Constructor for ECSReplayer. Reads the whole log from the stream and validates its header.
+     * @param stream The binary stream with the log.
+     */
+	explicit ECSReplayer ( std::istream & stream );
+
+	/**
+     * @brief Checks if the log is readable.
+     * @return False if the header doesn't match or a record is truncated, true otherwise.
+     */
+	bool GetIsValid () const;
+
+	/**
+     * @brief Applies the operations of the next recorded frame.
+     * @param ecs The ECS the log is replayed against, must be the same ECS for all frames of the log.
+     * @return True if a frame was replayed, false at the end of the log or if the log is invalid.
+     */
+	bool ReplayFrame ( ECS & ecs );
+
+	/**
+     * @brief Retrieves the time spent applying the operations of the last replayed frame.
+     * @return The duration of the last frame.
+     */
+	std::chrono::nanoseconds GetLastFrameTime () const;
+
+	/**
+     * @brief Retrieves the number of operations of the last replayed frame.
+     * @return The number of operations.
+     */
+	std::size_t GetLastOperationsCount () const;
+
+	/**
+     * @brief Retrieves the number of replayed frames.
+     * @return The number of frames.
+     */
+	std::size_t GetFramesCount () const;
+
+	/**
+     * @brief Retrieves the number of the recorded component types.
+     * @return The number of component types registered so far.
+     */
+	std::size_t GetComponentTypesCount () const;
+
+	/**
+     * @brief Retrieves the recorded name of the component type.
+     * @param typeIndex The index of the component type in the log.
+     * @return The name of the component type, empty if it wasn't recorded.
+     */
+	const std::string & GetComponentTypeName ( std::size_t typeIndex ) const;
+
+private:
+
+	using AddFunction = ComponentHandle ( * ) ( IObjectManager &, std::span <const std::byte> );
+
+	struct ComponentBinding
+	{
+		ComponentType Type = 0; /**< The recorded type code. */
+		std::size_t Size = 0; /**< The recorded size of the component. */
+		std::string Name; /**< The recorded name of the component type. */
+		std::shared_ptr <IObjectManager> Components; /**< The component array of the opaque components, nullptr until registered. */
+		AddFunction Add = nullptr; /**< Adds the opaque component built from the payload into the component array. */
+	};
+
+	struct Operation
+	{
+		RecordedOperation Code; /**< The recorded operation. */
+		EntityHandle Entity = 0; /**< The recorded entity handle. */
+		std::uint32_t TypeIndex = 0; /**< The index of the component type. */
+		std::size_t Offset = 0; /**< The offset of the payload in the log or of the handles in the batch buffer. */
+		std::size_t Count = 0; /**< The size of the payload or the number of the batch handles. */
+	};
+
+	/**
+     * @brief Decodes the records up to the end of the next frame.
+     */
+	bool DecodeFrame ();
+
+	/**
+     * @brief Applies the decoded operation to the ECS.
+     */
+	void Apply ( ECS & ecs, const Operation & operation );
+
+	/**
+     * @brief Retrieves the handle of the recorded entity in the target ECS, creating the entity created before the recording on its first use.
+     */
+	EntityHandle MapEntity ( ECS & ecs, EntityHandle recordedHandle );
+
+	/**
+     * @brief Reads the LEB128 varint, marks the log invalid if it is truncated.
+     */
+	std::uint64_t ReadVarint ();
+
+	std::vector <std::byte> m_Log; /**< The whole log. */
+	std::size_t m_Cursor = 0; /**< The offset of the next record. */
+	bool m_IsValid = false; /**< Whether the log is readable. */
+	std::vector <ComponentBinding> m_Bindings; /**< The component types by their indices in the log. */
+	std::vector <Operation> m_Operations; /**< The decoded operations of the current frame. */
+	std::vector <EntityHandle> m_BatchHandles; /**< The recorded handles of the batch removals of the current frame. */
+	std::vector <EntityHandle> m_Batch; /**< Scratch buffer of the mapped handles of the batch removal. */
+	std::unordered_map <EntityHandle, EntityHandle> m_Entities; /**< The handles of the target ECS by the recorded handles. */
+	std::chrono::nanoseconds m_LastFrameTime = {}; /**< The time spent applying the last frame. */
+	std::size_t m_FramesCount = 0; /**< The number of replayed frames. */
+};
@@ -0,0 +1,72 @@
+#pragma once
+
+#include "ECS.h"
+#include <functional>
+#include <type_traits>
+#include <vector>
+
+/**
+ * @class EntityCommandBuffer
+ * @brief Records structural ECS commands to be applied later on the thread owning the ECS.
+ *
+ * Each worker thread records into its own buffer without any locking, entity handles for new entities are taken
+ * with ECS::ReserveEntity. The buffer is applied with Execute at the sync point, after the reserved entities are created.
+ */
+class LANIAKEA_ECS_API EntityCommandBuffer
+{
+
+public:
+
+	/**
+     * @brief Records addition of the component to the entity.
+     * @tparam T The type of the component to be added.
+     * @param entityHandle The handle of the entity, possibly only reserved.
+     * @param component The component to be added.
+     */
+	template <typename T>
+	void AddComponent ( EntityHandle entityHandle, T && component )
+	{
+		using ComponentType = std::decay_t <T>;
+		m_Commands . emplace_back ( [ entityHandle, Component = std::forward <T> ( component ) ] ( ECS & ecs ) mutable
+		{
+			ecs . AddComponent <ComponentType> ( entityHandle, std::move ( Component ) );
+		} );
+	}
+
+	/**
+     * @brief Records removal of the component from the entity.
+     * @tparam T The type of the component to be removed.
+     * @param entityHandle The handle of the entity.
+     */
+	template <typename T>
+	void RemoveComponent ( EntityHandle entityHandle )
+	{
+		m_Commands . emplace_back ( [ entityHandle ] ( ECS & ecs )
+		{
+			ecs . RemoveComponent <T> ( entityHandle );
+		} );
+	}
+
+	/**
+     * @brief Records removal of the entity.
+     * @param entityHandle The handle of the entity.
+     */
+	void RemoveEntity ( EntityHandle entityHandle );
+
+	/**
+     * @brief Creates the reserved entities and applies the recorded commands in the recording order.
+     * @param ecs The ECS to apply the commands to. Must not be accessed by other threads during the execution.
+     *
+     * The buffer is empty after the execution.
+     */
+	void Execute ( ECS & ecs );
+
+	/**
+     * @brief Retrieves the number of recorded commands.
+     * @return The number of commands waiting for the execution.
+     */
+	std::size_t Size () const;
+
+private:
+	std::vector <std::function <void ( ECS & )>> m_Commands; /**< The recorded commands. */
+};
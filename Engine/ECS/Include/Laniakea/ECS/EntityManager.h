@@ -3,6 +3,8 @@
 #include "ObjectManager.h"
 #include "Entity.h"
 #include <memory>
+#include <atomic>
+#include <vector>
 
 
 /**
@@ -12,6 +14,10 @@
  * The EntityManager class is responsible for creating, storing, and retrieving entities in the system.
  * It uses an ObjectManager to store and manage entities efficiently.
  * The class provides both a fast regular interface and a safe interface with additional checks.
+ *
+ * Entity handles are generation tagged: the lower bits hold the slot and the upper bits hold the generation of the slot,
+ * which is bumped on removal, so a stale handle never becomes valid again when its slot is reused.
+ * Handles can be reserved from any thread with ReserveEntity, the reserved entities are created at the next sync point.
  */
 class LANIAKEA_ECS_API EntityManager
 {
@@ -26,12 +32,38 @@ public:
      */
 	EntityHandle CreateEntity ();
 
+	/**
+     * @brief Reserves a handle for the entity which is created at the next MaterializeReservedEntities call.
+     * @return A valid generation tagged handle of the reserved entity.
+     *
+     * Lock-free, can be called from any thread concurrently with other ReserveEntity calls.
+     * Must not be called concurrently with any other EntityManager method.
+     */
+	EntityHandle ReserveEntity ();
+
+	/**
+     * @brief Creates all entities reserved since the previous call and publishes released handles for reservation.
+     * @param materializedHandles The optional output the handles of the created entities are appended to.
+     * @return The number of created entities.
+     *
+     * Sync point of the reservation, must not be called concurrently with ReserveEntity.
+     */
+	std::size_t MaterializeReservedEntities ( std::vector <EntityHandle> * materializedHandles = nullptr );
+
 	/**
      * @brief Removes an entity from the manager.
      * @param entityHandle The handle of the entity to be removed.
      */
 	void RemoveEntity ( EntityHandle entityHandle );
 
+	/**
+     * @brief Removes a batch of entities from the manager.
+     * @param entityHandles The handles of the entities to be removed, must be valid and unique.
+     *
+     * The entity storage is compacted in a single pass when the batch takes a large part of it.
+     */
+	void RemoveEntities ( std::span <const EntityHandle> entityHandles );
+
 	/**
      * @brief Retrieves a reference to the entity associated with the given handle without any checks
      * @param entityHandle The handle of the entity to retrieve.
@@ -44,6 +76,26 @@ public:
      */
 	void RemoveAllEntities ();
 
+	/**
+     * @brief Releases the excess memory of the entity storage and the released handle lists.
+     *
+     * Entity handles are never renumbered, the generations of the released slots are kept.
+     * Must not be called concurrently with ReserveEntity.
+     */
+	void ShrinkToFit ();
+
+	/**
+     * @brief Retrieves the number of live entities.
+     * @return The number of entities.
+     */
+	std::size_t Size () const;
+
+	/**
+     * @brief Retrieves the number of entities the storage can hold without reallocation.
+     * @return The capacity of the entity storage.
+     */
+	std::size_t Capacity () const;
+
 	/**
      * @brief Checks if the given entity handle is valid.
      * @param entityHandle The handle of the entity to check.
@@ -51,6 +103,18 @@ public:
      */
 	bool GetIsValidEntityHandle ( EntityHandle entityHandle ) const;
 
+	/**
+     * @brief Returns an iterator to the beginning of the entities in the manager.
+     * @return An iterator pointing to the first entity.
+     */
+	std::vector <Entity>::iterator begin ();
+
+	/**
+     * @brief Returns an iterator to the end of the entities in the manager.
+     * @return An iterator pointing to the position after the last entity.
+     */
+	std::vector <Entity>::iterator end ();
+
 	/* End EntityManager interface */
 
 
@@ -71,8 +135,52 @@ public:
 
 	/* End EntityManager safe interface */
 
+	/**
+     * @brief Composes the entity handle from its slot and generation.
+     * @param slot The slot of the entity.
+     * @param generation The generation of the slot.
+     * @return The entity handle.
+     */
+	static EntityHandle MakeEntityHandle ( std::size_t slot, std::size_t generation );
+
+	/**
+     * @brief Retrieves the slot of the entity handle.
+     * @param entityHandle The entity handle.
+     * @return The slot of the entity.
+     */
+	static std::size_t GetEntitySlot ( EntityHandle entityHandle );
+
+	/**
+     * @brief Retrieves the generation of the entity handle.
+     * @param entityHandle The entity handle.
+     * @return The generation of the entity slot.
+     */
+	static std::size_t GetEntityGeneration ( EntityHandle entityHandle );
+
 private:
 
+	/**
+     * @brief Creates the entity under the handle.
+     * @param entityHandle The handle of the entity.
+     */
+	void Materialize ( EntityHandle entityHandle );
+
+	/**
+     * @brief Creates the reserved entity unless it was already created or its slot was released since the reservation.
+     * @param entityHandle The reserved handle.
+     * @param materializedHandles The optional output the handle is appended to if the entity was created.
+     * @return True if the entity was created, false otherwise.
+     */
+	bool MaterializeIfPending ( EntityHandle entityHandle, std::vector <EntityHandle> * materializedHandles );
+
+	static constexpr std::size_t SlotBits = 32; /**< The number of lower handle bits storing the slot. */
+
 	ObjectManager <Entity> m_Entities; /**< The ObjectManager to store and manage entities. */
+	std::vector <std::uint32_t> m_Generations; /**< The current generation of each slot. */
+	std::size_t m_MaterializedSlots = 0; /**< The number of fresh slots already accounted by the sync point. */
+	std::atomic <std::size_t> m_NextSlot { 0 }; /**< The next never used slot. */
+	std::vector <EntityHandle> m_RecycledHandles; /**< Released handles published for the reservation at the sync point. */
+	std::atomic <std::size_t> m_RecycledCursor { 0 }; /**< The number of published released handles taken by the reservation. */
+	std::vector <EntityHandle> m_PendingRecycledHandles; /**< Handles released since the sync point, reused by CreateEntity only. */
 };
 
@@ -0,0 +1,195 @@
+#pragma once
+
+#include "ObjectManager.h"
+#include "Entity.h"
+#include <array>
+#include <memory>
+#include <span>
+#include <tuple>
+
+// Reference: https://skypjack.github.io/2019-04-12-entt-tips-and-tricks-part-1/
+
+/**
+ * @class IGroup
+ * @brief Base owning group interface to store it in a polymorphic manner
+ */
+class LANIAKEA_ECS_API IGroup
+{
+public:
+	virtual ~IGroup () = default;
+
+	/**
+     * @brief Notifies the group that the entity gained one of the owned components.
+     * @param entity The entity which component was added.
+     */
+	virtual void OnComponentAdded ( Entity & entity ) = 0;
+
+	/**
+     * @brief Notifies the group that the entity is about to lose one of the owned components.
+     * @param entity The entity which component is going to be removed. Its components must still be valid.
+     */
+	virtual void OnComponentRemoving ( Entity & entity ) = 0;
+
+	/**
+     * @brief Retrieves the number of entities in the group.
+     * @return The number of entities owning all grouped components.
+     */
+	virtual std::size_t Size () const = 0;
+
+	/**
+     * @brief Releases the excess memory of the group bookkeeping.
+     */
+	virtual void ShrinkToFit () = 0;
+};
+
+/**
+ * @class Group
+ * @brief Owning group that keeps multiple component arrays in lockstep order.
+ *
+ * When an entity gains all grouped components, its components are swapped into the front partition of each owned
+ * array at the same index. Thus the i-th component of every owned array belongs to the same entity and iteration over
+ * the group becomes a walk over parallel linear arrays without any handle lookup.
+ * The component array can be owned by a single group only. Owned arrays must be modified through the ECS only.
+ *
+ * @tparam Ts The types of the owned components.
+ */
+template <typename ... Ts>
+class Group : public IGroup
+{
+
+public:
+
+	/**
+     * @brief Constructor for Group.
+     * @param componentArrays The component arrays owned by the group.
+     * @param componentTypes The component types of the owned arrays in the same order.
+     */
+	explicit Group ( std::shared_ptr <ObjectManager <Ts>> ... componentArrays, std::array <ComponentType, sizeof ... ( Ts )> componentTypes )
+	: m_ComponentArrays ( std::move ( componentArrays ) ... ), m_ComponentTypes ( componentTypes )
+	{
+
+	}
+
+	void OnComponentAdded ( Entity & entity ) override
+	{
+		if ( GetContains ( entity ) )
+			return;
+		for ( const auto Type : m_ComponentTypes ) {
+			if ( ! entity . GetHasComponent ( Type ) )
+				return;
+		}
+		MoveToIndex ( entity, m_Entities . size (), std::index_sequence_for <Ts ...> () );
+		m_Entities . push_back ( entity . GetHandle () );
+	}
+
+	void OnComponentRemoving ( Entity & entity ) override
+	{
+		if ( ! GetContains ( entity ) )
+			return;
+		const auto Index = GetIndex ( entity );
+		const auto Last = m_Entities . size () - 1;
+		MoveToIndex ( entity, Last, std::index_sequence_for <Ts ...> () );
+		std::swap ( m_Entities[ Index ], m_Entities[ Last ] );
+		m_Entities . pop_back ();
+	}
+
+	std::size_t Size () const override
+	{
+		return m_Entities . size ();
+	}
+
+	void ShrinkToFit () override
+	{
+		m_Entities . shrink_to_fit ();
+	}
+
+	/**
+     * @brief Invokes the callable for each entity of the group.
+     * @param func The callable invoked as func ( EntityHandle, Ts & ... ).
+     *
+     * The callable must not add or remove the grouped components.
+     */
+	template <typename Func>
+	void Each ( Func && func )
+	{
+		EachImpl ( func, std::index_sequence_for <Ts ...> () );
+	}
+
+	/**
+     * @brief Retrieves the grouped partition of the owned component array.
+     * @tparam T The type of the owned component.
+     * @return A span over the components of the group entities, the i-th element belongs to the i-th group entity.
+     */
+	template <typename T>
+	std::span <T> GetComponents ()
+	{
+		return { std::get <std::shared_ptr <ObjectManager <T>>> ( m_ComponentArrays ) -> Data (), m_Entities . size () };
+	}
+
+	/**
+     * @brief Retrieves the entities of the group.
+     * @return A span over the handles of the group entities.
+     */
+	std::span <const EntityHandle> GetEntities () const
+	{
+		return m_Entities;
+	}
+
+private:
+
+	/**
+     * @brief Retrieves the index of the entity components in the owned arrays.
+     * @param entity The entity owning all grouped components.
+     * @return The index of the entity components.
+     */
+	std::size_t GetIndex ( const Entity & entity ) const
+	{
+		const auto & FirstArray = std::get <0> ( m_ComponentArrays );
+		return FirstArray -> GetIndexFromHandle ( entity . GetComponentHandle ( m_ComponentTypes[ 0 ] ) );
+	}
+
+	/**
+     * @brief Checks if the entity is inside the group partition.
+     * @param entity The entity to check.
+     * @return True if the entity belongs to the group, false otherwise.
+     */
+	bool GetContains ( const Entity & entity ) const
+	{
+		const auto Handle = entity . GetComponentHandleChecked ( m_ComponentTypes[ 0 ] );
+		if ( ! Handle )
+			return false;
+		const auto & FirstArray = std::get <0> ( m_ComponentArrays );
+		return FirstArray -> GetIndexFromHandle ( * Handle ) < m_Entities . size ();
+	}
+
+	/**
+     * @brief Swaps the entity components to the index in each owned array.
+     * @param entity The entity owning all grouped components.
+     * @param index The destination index.
+     */
+	template <std::size_t ... Indices>
+	void MoveToIndex ( const Entity & entity, std::size_t index, std::index_sequence <Indices ...> )
+	{
+		( SwapToIndex ( * std::get <Indices> ( m_ComponentArrays ), entity . GetComponentHandle ( m_ComponentTypes[ Indices ] ), index ), ... );
+	}
+
+	template <typename T>
+	static void SwapToIndex ( ObjectManager <T> & componentArray, ObjectHandle handle, std::size_t index )
+	{
+		componentArray . SwapObjectsByIndex ( componentArray . GetIndexFromHandle ( handle ), index );
+	}
+
+	template <typename Func, std::size_t ... Indices>
+	void EachImpl ( Func & func, std::index_sequence <Indices ...> )
+	{
+		const std::tuple <Ts * ...> Data { std::get <Indices> ( m_ComponentArrays ) -> Data () ... };
+		const std::size_t Count = m_Entities . size ();
+		for ( std::size_t i = 0; i < Count; i ++ ) {
+			func ( m_Entities[ i ], std::get <Indices> ( Data )[ i ] ... );
+		}
+	}
+
+	std::tuple <std::shared_ptr <ObjectManager <Ts>> ...> m_ComponentArrays; /**< The owned component arrays. */
+	std::array <ComponentType, sizeof ... ( Ts )> m_ComponentTypes; /**< The types of the owned components. */
+	std::vector <EntityHandle> m_Entities; /**< The group entities in the order of their components in the owned arrays. */
+};
@@ -1,7 +1,12 @@
 #pragma once
 
 #include "PackedArray.h"
+#include "ComponentBase.h"
 #include "Core.h"
+#include <cstddef>
+#include <memory>
+#include <span>
+#include <type_traits>
 
 
 /**
@@ -17,7 +22,21 @@ public:
 
 	virtual void RemoveObject ( ObjectHandle handle ) = 0;
 
+	virtual void RemoveObjects ( std::span <const ObjectHandle> handles ) = 0;
+
+	virtual ObjectHandle MoveObject ( ObjectHandle handle, IObjectManager & destination, EntityHandle owner ) = 0;
+
+	virtual std::shared_ptr <IObjectManager> CreateEmpty () const = 0;
+
+	virtual std::span <const std::byte> GetObjectBytes ( ObjectHandle handle ) = 0;
+
 	virtual void Clear () = 0;
+
+	virtual void ShrinkToFit () = 0;
+
+	virtual std::size_t Size () const = 0;
+
+	virtual std::size_t Capacity () const = 0;
 };
 
 /**
@@ -67,6 +86,28 @@ public:
 		return m_Objects . Add ( std::forward <ObjectType> ( object ) );
 	}
 
+	/**
+     * @brief Inserts an object under the handle chosen by the caller.
+     * @param handle The handle of the object, must not be in use.
+     * @param object The object to be inserted.
+     * @return The handle of the inserted object.
+     *
+     * InsertObject / EraseObject leave the handle bookkeeping to the caller and must not be mixed with AddObject / RemoveObject.
+     */
+	ObjectHandle InsertObject ( ObjectHandle handle, ObjectType && object )
+	{
+		return m_Objects . Insert ( handle, std::forward <ObjectType> ( object ) );
+	}
+
+	/**
+     * @brief Erases an object inserted with InsertObject without releasing its handle for reuse.
+     * @param handle The handle of the object to be erased.
+     */
+	void EraseObject ( ObjectHandle handle )
+	{
+		m_Objects . Erase ( handle );
+	}
+
 	/**
 	* @brief Removes an object from the manager.
 	* @param handle The handle of the object to be removed.
@@ -76,6 +117,60 @@ public:
 		return m_Objects . Remove ( handle );
 	}
 
+	/**
+     * @brief Removes a batch of objects from the manager in a single non-polymorphic call.
+     * @param handles The handles of the objects to be removed, must be valid and unique.
+     */
+	void RemoveObjects ( std::span <const ObjectHandle> handles ) override
+	{
+		m_Objects . RemoveMany ( handles );
+	}
+
+	/**
+     * @brief Erases a batch of objects inserted with InsertObject without releasing their handles for reuse.
+     * @param handles The handles of the objects to be erased, must be valid and unique.
+     */
+	void EraseObjects ( std::span <const ObjectHandle> handles )
+	{
+		m_Objects . EraseMany ( handles );
+	}
+
+	/**
+     * @brief Moves an object into another manager of the same type and removes it from this one.
+     * @param handle The handle of the object to be moved.
+     * @param destination The manager receiving the object, must be an ObjectManager of the same ObjectType.
+     * @param owner The new owner of the object if it is a ComponentBase, ignored otherwise.
+     * @return The handle of the object in the destination manager.
+     */
+	ObjectHandle MoveObject ( ObjectHandle handle, IObjectManager & destination, EntityHandle owner ) override
+	{
+		ObjectType & Object = m_Objects . Get ( handle );
+		if constexpr ( std::is_base_of_v <ComponentBase, ObjectType> )
+			static_cast <ComponentBase &> ( Object ) . m_Owner = owner;
+		const auto Handle = static_cast <ObjectManager &> ( destination ) . AddObject ( std::move ( Object ) );
+		m_Objects . Remove ( handle );
+		return Handle;
+	}
+
+	/**
+     * @brief Creates an empty manager of the same ObjectType.
+     * @return A shared pointer to the new manager.
+     */
+	std::shared_ptr <IObjectManager> CreateEmpty () const override
+	{
+		return std::make_shared <ObjectManager> ();
+	}
+
+	/**
+     * @brief Retrieves the object representation of the object.
+     * @param handle The handle of the object.
+     * @return A span over the bytes of the object, valid until the object is moved or removed.
+     */
+	std::span <const std::byte> GetObjectBytes ( ObjectHandle handle ) override
+	{
+		return std::as_bytes ( std::span ( & m_Objects . Get ( handle ), 1 ) );
+	}
+
 	/**
      * @brief Removes an object from the manager by its index.
      * @param index The index of the object to be removed.
@@ -115,6 +210,35 @@ public:
 		return m_Objects.GetHandleFromIndex(index);
 	}
 
+	/**
+     * @brief Retrieves the index of the object associated with the given handle.
+     * @param handle The handle of the object.
+     * @return The index of the object.
+     */
+	std::size_t GetIndexFromHandle ( ObjectHandle handle ) const
+	{
+		return m_Objects . GetIndexFromHandle ( handle );
+	}
+
+	/**
+     * @brief Swaps two objects by their indices keeping their handles valid.
+     * @param first The index of the first object.
+     * @param second The index of the second object.
+     */
+	void SwapObjectsByIndex ( std::size_t first, std::size_t second )
+	{
+		m_Objects . SwapByIndex ( first, second );
+	}
+
+	/**
+     * @brief Retrieves a pointer to the contiguous storage of the objects.
+     * @return A pointer to the first object.
+     */
+	ObjectType * Data ()
+	{
+		return m_Objects . Data ();
+	}
+
 	/**
      * @brief Checks if the given object handle is valid.
      * @param handle The handle of the object to check.
@@ -133,15 +257,32 @@ public:
 		m_Objects . Clear ();
 	}
 
+	/**
+     * @brief Releases the excess memory of the manager, see PackedArray::ShrinkToFit.
+     */
+	void ShrinkToFit () override
+	{
+		m_Objects . ShrinkToFit ();
+	}
+
 	/**
      * @brief Retrieves the number of objects in the manager.
      * @return The number of objects in the manager.
      */
-	std::size_t Size () const
+	std::size_t Size () const override
 	{
 		return m_Objects . Size ();
 	}
 
+	/**
+     * @brief Retrieves the number of objects the manager can hold without reallocation.
+     * @return The capacity of the manager.
+     */
+	std::size_t Capacity () const override
+	{
+		return m_Objects . Capacity ();
+	}
+
 	/**
      * @brief Retrieves the next available handle for creating a new object.
      * @return The next available handle.
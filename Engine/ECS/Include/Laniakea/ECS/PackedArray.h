@@ -3,7 +3,9 @@
 #include <vector>
 #include <unordered_map>
 #include <optional>
-#include <set>
+#include <algorithm>
+#include <functional>
+#include <span>
 
 using PackedArrayHandle = std::size_t;
 
@@ -69,6 +71,46 @@ public:
      * The object is removed and its handle is released for reuse.
      */
 	void Remove ( PackedArrayHandle handle )
+	{
+		Erase ( handle );
+		m_FreeHandles . push_back ( handle );
+		std::push_heap ( m_FreeHandles . begin (), m_FreeHandles . end (), std::greater <> () );
+	}
+
+    /**
+     * @brief Remove a batch of objects from the PackedArray by their handles.
+     * @param handles The handles of the objects to be removed, must be valid and unique.
+     *
+     * The handles are released for reuse with a single heap rebuild, see EraseMany for the removal of the objects.
+     */
+	void RemoveMany ( std::span <const PackedArrayHandle> handles )
+	{
+		EraseMany ( handles );
+		m_FreeHandles . insert ( m_FreeHandles . end (), handles . begin (), handles . end () );
+		std::make_heap ( m_FreeHandles . begin (), m_FreeHandles . end (), std::greater <> () );
+	}
+
+    /**
+     * @brief Insert a new object into the PackedArray under the handle chosen by the caller.
+     * @param handle The handle of the object, must not be in use.
+     * @param object The object to be inserted.
+     * @return The handle of the inserted object.
+     *
+     * Insert / Erase leave the handle bookkeeping to the caller and must not be mixed with Add / Remove on the same array.
+     */
+	PackedArrayHandle Insert ( PackedArrayHandle handle, T && object )
+	{
+		m_HandleToIndex[ handle ] = m_Data . size ();
+		m_IndexToHandle[ m_Data . size () ] = handle;
+		m_Data . push_back ( std::forward <T> ( object ) );
+		return handle;
+	}
+
+    /**
+     * @brief Erase an object inserted with Insert without releasing its handle for reuse.
+     * @param handle The handle of the object to be erased.
+     */
+	void Erase ( PackedArrayHandle handle )
 	{
 		// Fetch all data of swapped elements
 		const auto ElementToRemoveIndex = m_HandleToIndex[ handle ];
@@ -87,8 +129,47 @@ public:
 		// Fix-up handle to index
 		m_HandleToIndex[ LastElementHandle ] = ElementToRemoveIndex;
 		m_HandleToIndex . erase ( ElementToRemoveHandle );
+	}
+
+    /**
+     * @brief Erase a batch of objects inserted with Insert without releasing their handles for reuse.
+     * @param handles The handles of the objects to be erased, must be valid and unique.
+     *
+     * A batch erasing a large part of the array compacts the remaining objects in a single pass keeping their order,
+     * each of them is moved at most once. A small batch swaps each erased object with the last one instead.
+     */
+	void EraseMany ( std::span <const PackedArrayHandle> handles )
+	{
+		if ( handles . size () * 4 < m_Data . size () )
+		{
+			for ( const auto Handle : handles ) {
+				Erase ( Handle );
+			}
+			return;
+		}
 
-		m_FreeHandles . insert ( ElementToRemoveHandle );
+		std::vector <bool> IsErased ( m_Data . size (), false );
+		for ( const auto Handle : handles ) {
+			IsErased[ m_HandleToIndex . at ( Handle ) ] = true;
+			m_HandleToIndex . erase ( Handle );
+		}
+		std::size_t Count = 0;
+		for ( std::size_t Index = 0; Index < m_Data . size (); Index ++ ) {
+			if ( IsErased[ Index ] )
+				continue;
+			if ( Count != Index )
+			{
+				const auto Handle = m_IndexToHandle . at ( Index );
+				m_Data[ Count ] = std::move ( m_Data[ Index ] );
+				m_IndexToHandle[ Count ] = Handle;
+				m_HandleToIndex[ Handle ] = Count;
+			}
+			Count ++;
+		}
+		for ( std::size_t Index = Count; Index < m_Data . size (); Index ++ ) {
+			m_IndexToHandle . erase ( Index );
+		}
+		m_Data . erase ( m_Data . begin () + ( std::ptrdiff_t ) Count, m_Data . end () );
 	}
 
     /**
@@ -131,6 +212,34 @@ public:
         return m_Data [ index ];
     }
 
+    /**
+     * @brief Swap two objects by their indices keeping their handles valid.
+     * @param first The index of the first object.
+     * @param second The index of the second object.
+     */
+    void SwapByIndex ( std::size_t first, std::size_t second )
+    {
+        if ( first == second )
+            return;
+        std::swap ( m_Data[ first ], m_Data[ second ] );
+
+        const auto FirstHandle = m_IndexToHandle[ first ];
+        const auto SecondHandle = m_IndexToHandle[ second ];
+        m_IndexToHandle[ first ] = SecondHandle;
+        m_IndexToHandle[ second ] = FirstHandle;
+        m_HandleToIndex[ FirstHandle ] = second;
+        m_HandleToIndex[ SecondHandle ] = first;
+    }
+
+    /**
+     * @brief Get a pointer to the contiguous storage of the PackedArray.
+     * @return A pointer to the first element.
+     */
+    T * Data ()
+    {
+        return m_Data . data ();
+    }
+
     /**
      * @brief Check if a given handle is valid in the PackedArray.
      * @param handle The handle to be checked.
@@ -162,6 +271,16 @@ public:
 		return m_IndexToHandle . at ( index );
 	}
 
+    /**
+     * @brief Get the index associated with a handle in the PackedArray.
+     * @param handle The handle of the object.
+     * @return The index of the object associated with the specified handle.
+     */
+	std::size_t GetIndexFromHandle ( PackedArrayHandle handle ) const
+	{
+		return m_HandleToIndex . at ( handle );
+	}
+
     /**
      * @brief Get the size of the PackedArray.
      * @return The number of elements currently stored in the PackedArray.
@@ -171,6 +290,36 @@ public:
 		return m_Data.size();
 	}
 
+    /**
+     * @brief Get the number of elements the PackedArray can hold without reallocation.
+     * @return The capacity of the underlying storage.
+     */
+	std::size_t Capacity () const
+	{
+		return m_Data . capacity ();
+	}
+
+    /**
+     * @brief Release the excess memory of the PackedArray.
+     *
+     * Free handles above the highest handle in use are forgotten, so they are handed out again in the order of
+     * a fresh array, other free handles are kept as the handles in use can't be renumbered.
+     * The storage and the handle tables are reallocated at the tight size. Handles and indices stay valid.
+     */
+	void ShrinkToFit ()
+	{
+		std::sort ( m_FreeHandles . begin (), m_FreeHandles . end () );
+		while ( ! m_FreeHandles . empty () && m_FreeHandles . back () == m_Data . size () + m_FreeHandles . size () - 1 ) {
+			m_FreeHandles . pop_back ();
+		}
+		// Sorted ascending range is a valid min-heap already
+		m_FreeHandles . shrink_to_fit ();
+		m_Data . shrink_to_fit ();
+
+		m_HandleToIndex = std::unordered_map <PackedArrayHandle, std::size_t> ( m_HandleToIndex . begin (), m_HandleToIndex . end (), m_HandleToIndex . size () );
+		m_IndexToHandle = std::unordered_map <std::size_t, PackedArrayHandle> ( m_IndexToHandle . begin (), m_IndexToHandle . end (), m_IndexToHandle . size () );
+	}
+
     /**
      * @brief Clear the PackedArray, removing all elements and invalidating all handles
      */
@@ -224,7 +373,7 @@ public:
      */
 	PackedArrayHandle GetNextHandle () const
 	{
-		return m_FreeHandles . empty () ? m_Data . size () : * m_FreeHandles . begin ();
+		return m_FreeHandles . empty () ? m_Data . size () : m_FreeHandles . front ();
 	}
 
 	// --- End PackedArray interface
@@ -308,8 +457,9 @@ private:
 		if ( m_FreeHandles . empty () ) {
 			index <= m_Data . size () ? Handle = m_Data . size () : Handle = index;
 		} else {
-			Handle = * m_FreeHandles . begin ();
-			m_FreeHandles . erase ( m_FreeHandles . begin () );
+			std::pop_heap ( m_FreeHandles . begin (), m_FreeHandles . end (), std::greater <> () );
+			Handle = m_FreeHandles . back ();
+			m_FreeHandles . pop_back ();
 		}
 
 		m_HandleToIndex[ Handle ] = index;
@@ -321,6 +471,6 @@ private:
 
 	std::unordered_map <PackedArrayHandle, std::size_t> m_HandleToIndex; /**< Mapping of handles to their corresponding indices. */
 	std::unordered_map <std::size_t, PackedArrayHandle> m_IndexToHandle; /**< Mapping of indices to their corresponding handles. */
-	std::set <PackedArrayHandle> m_FreeHandles; /**< Set of free handles that can be reused when elements are removed. */
+	std::vector <PackedArrayHandle> m_FreeHandles; /**< Min-heap of free handles that can be reused when elements are removed. */
 };
 
@@ -0,0 +1,190 @@
+#pragma once
+
+#include "ObjectManager.h"
+#include "QueryFilter.h"
+#include <map>
+#include <memory>
+
+class EntityManager;
+
+/**
+ * @class QueryState
+ * @brief Backing entity list of the persistent query.
+ *
+ * The list is maintained incrementally on structural changes of entities in the same way as System membership,
+ * so iterating the query costs O(matches). One state is shared by all queries with the same filter.
+ */
+class LANIAKEA_ECS_API QueryState
+{
+
+public:
+
+	/**
+     * @brief Constructor for QueryState.
+     * @param filter The filter deciding which entities belong to the query.
+     */
+	explicit QueryState ( QueryFilter filter );
+
+	/**
+     * @brief Handle changes in the entity's signature.
+     * @param entity The entity whose signature has changed.
+     * @param signature The new signature of the entity.
+     */
+	void OnEntitySignatureChanged ( Entity & entity, const Signature & signature );
+
+	/**
+     * @brief Remove the entity from the query if it is present.
+     * @param entity The entity that has been removed.
+     */
+	void OnEntityRemoved ( Entity & entity );
+
+	/**
+     * @brief Remove a batch of entities from the query.
+     * @param entityHandles The handles of the removed entities. Entities which aren't in the query are skipped.
+     */
+	void OnEntitiesRemoved ( std::span <const EntityHandle> entityHandles );
+
+	/**
+     * @brief Release the excess memory of the backing list.
+     */
+	void ShrinkToFit ();
+
+	/**
+     * @brief Get the filter of the query.
+     * @return A constant reference to the filter.
+     */
+	const QueryFilter & GetFilter () const;
+
+	/**
+     * @brief Get the number of entities matching the query.
+     * @return The number of entities in the query.
+     */
+	std::size_t Size () const;
+
+	/**
+     * @brief Get an iterator to the beginning of the matching entity handles.
+     * @return A const iterator to the first entity handle.
+     */
+	std::vector <EntityHandle>::const_iterator begin () const;
+
+	/**
+     * @brief Get an iterator to the end of the matching entity handles.
+     * @return A const iterator to the position after the last entity handle.
+     */
+	std::vector <EntityHandle>::const_iterator end () const;
+
+private:
+	QueryFilter m_Filter; /**< The filter deciding which entities belong to the query. */
+	std::unordered_map <EntityHandle, ObjectHandle> m_EntitiesHandles; /**< Mapping of entity handles to object handles in the query. */
+	ObjectManager <EntityHandle> m_Entities; /**< Packed handles of the entities matching the query. */
+};
+
+/**
+ * @class QueryManager
+ * @brief Owns the backing lists of persistent queries and keeps them up to date.
+ */
+class LANIAKEA_ECS_API QueryManager
+{
+
+public:
+
+	/**
+     * @brief Retrieves the query state for the filter, creating and populating it from existing entities if needed.
+     * @param filter The filter of the query.
+     * @param entityManager The entity manager used to populate a newly created state.
+     * @return A shared pointer to the state shared by all queries with the same filter.
+     */
+	std::shared_ptr <QueryState> GetOrCreateQuery ( QueryFilter && filter, EntityManager & entityManager );
+
+	/**
+     * @brief Notifies all queries of an entity's signature change.
+     * @param entity The entity whose signature has changed.
+     * @param signature The new signature of the entity.
+     */
+	void OnEntitySignatureChanged ( Entity & entity, const Signature & signature );
+
+	/**
+     * @brief Notifies all queries that an entity has been removed.
+     * @param entity The entity that has been removed.
+     */
+	void OnEntityRemoved ( Entity & entity );
+
+	/**
+     * @brief Notifies all queries that a batch of entities has been removed.
+     * @param entityHandles The handles of the removed entities.
+     */
+	void OnEntitiesRemoved ( std::span <const EntityHandle> entityHandles );
+
+	/**
+     * @brief Releases the excess memory of all backing lists.
+     */
+	void ShrinkToFit ();
+
+	/**
+     * @brief Get the number of distinct backing lists.
+     * @return The number of registered query states.
+     */
+	std::size_t GetQueriesCount () const;
+
+private:
+	std::map <QueryFilter, std::shared_ptr <QueryState>> m_Queries; /**< Query states keyed by their filters. */
+};
+
+/**
+ * @class Query
+ * @brief Persistent query over the entities matching the query terms.
+ * @tparam Terms The query terms: plain component types, query::With <T>, query::Without <T> or query::Optional <T>.
+ *
+ * Registered once with ECS::RegisterQuery and iterated any number of times.
+ * Iteration yields entity handles, ECS::ForEach ( query, func ) additionally fetches the components.
+ * The query must not be iterated while entities are created, removed or change their components.
+ */
+template <typename ... Terms>
+class Query
+{
+
+public:
+
+	Query () = default;
+
+	/**
+     * @brief Constructor for Query.
+     * @param state The shared backing list of the query.
+     */
+	explicit Query ( std::shared_ptr <QueryState> state )
+	: m_State ( std::move ( state ) )
+	{
+
+	}
+
+	/**
+     * @brief Get the number of entities matching the query.
+     * @return The number of entities in the query.
+     */
+	std::size_t Size () const
+	{
+		return m_State -> Size ();
+	}
+
+	/**
+     * @brief Check if the query is bound to the backing list.
+     * @return True if the query was registered, false if it's default constructed.
+     */
+	bool GetIsValid () const
+	{
+		return m_State != nullptr;
+	}
+
+	std::vector <EntityHandle>::const_iterator begin () const
+	{
+		return m_State -> begin ();
+	}
+
+	std::vector <EntityHandle>::const_iterator end () const
+	{
+		return m_State -> end ();
+	}
+
+private:
+	std::shared_ptr <QueryState> m_State; /**< The backing list shared with queries of the same filter. */
+};
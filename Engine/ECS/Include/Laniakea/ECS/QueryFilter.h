@@ -0,0 +1,156 @@
+#pragma once
+
+#include "Entity.h"
+#include <tuple>
+#include <type_traits>
+
+/**
+ * @brief Query terms wrapping the component types passed to systems, views and persistent queries.
+ */
+namespace query
+{
+	/**
+	 * @brief Query term requiring the component to be attached to the entity.
+	 * @tparam T The type of the component.
+	 *
+	 * Plain component types passed to queries are treated as query::With <T>.
+	 */
+	template <typename T>
+	struct With
+	{
+		using Type = T;
+	};
+
+	/**
+	 * @brief Query term requiring the component to be absent on the entity.
+	 * @tparam T The type of the component.
+	 */
+	template <typename T>
+	struct Without
+	{
+		using Type = T;
+	};
+
+	/**
+	 * @brief Query term that doesn't affect matching, but yields a nullable pointer to the component.
+	 * @tparam T The type of the component.
+	 */
+	template <typename T>
+	struct Optional
+	{
+		using Type = T;
+	};
+}
+
+/**
+ * @brief Kind of the query term.
+ */
+enum class QueryTermKind
+{
+	With,
+	Without,
+	Optional
+};
+
+namespace detail
+{
+	template <typename T>
+	struct QueryTerm
+	{
+		using Type = T;
+		static constexpr QueryTermKind Kind = QueryTermKind::With;
+	};
+
+	template <typename T>
+	struct QueryTerm <query::With <T>>
+	{
+		using Type = T;
+		static constexpr QueryTermKind Kind = QueryTermKind::With;
+	};
+
+	template <typename T>
+	struct QueryTerm <query::Without <T>>
+	{
+		using Type = T;
+		static constexpr QueryTermKind Kind = QueryTermKind::Without;
+	};
+
+	template <typename T>
+	struct QueryTerm <query::Optional <T>>
+	{
+		using Type = T;
+		static constexpr QueryTermKind Kind = QueryTermKind::Optional;
+	};
+
+	/**
+	 * @brief Tuple of values the query term yields to the callback: T & for With, T * for Optional, nothing for Without.
+	 */
+	template <typename Term>
+	using QueryTermResult = std::conditional_t <QueryTerm <Term>::Kind == QueryTermKind::With,
+			std::tuple <typename QueryTerm <Term>::Type &>,
+			std::conditional_t <QueryTerm <Term>::Kind == QueryTermKind::Optional,
+					std::tuple <typename QueryTerm <Term>::Type *>,
+					std::tuple <>>>;
+
+	/**
+	 * @brief True if any of the query terms is Optional.
+	 */
+	template <typename ... Terms>
+	inline constexpr bool HasOptionalQueryTerm = ( ( QueryTerm <Terms>::Kind == QueryTermKind::Optional ) || ... );
+}
+
+/**
+ * @class QueryFilter
+ * @brief Include / exclude masks of the query resolved from its terms.
+ *
+ * The filter is built once at the registration of a system or a query, so the membership of the entity is decided
+ * on its structural change only and iteration doesn't pay for exclusion per entity.
+ */
+class LANIAKEA_ECS_API QueryFilter
+{
+
+public:
+
+	QueryFilter () = default;
+
+	/**
+     * @brief Constructor for QueryFilter.
+     * @param include The component types required on the entity.
+     * @param exclude The component types that must be absent on the entity.
+     */
+	QueryFilter ( Signature include, Signature exclude );
+
+	/**
+     * @brief Check if the entity signature satisfies the filter.
+     * @param signature The signature of the entity.
+     * @return True if all included and none of the excluded component types are present in the signature.
+     */
+	bool GetIsMatching ( const Signature & signature ) const;
+
+	/**
+     * @brief Check if the entity satisfies the filter without building its signature.
+     * @param entity The entity to check.
+     * @return True if all included and none of the excluded components are attached to the entity.
+     */
+	bool GetIsMatching ( const Entity & entity ) const;
+
+	/**
+     * @brief Get the component types required by the filter.
+     * @return A constant reference to the include mask.
+     */
+	const Signature & GetInclude () const;
+
+	/**
+     * @brief Get the component types excluded by the filter.
+     * @return A constant reference to the exclude mask.
+     */
+	const Signature & GetExclude () const;
+
+	bool operator < ( const QueryFilter & rhs ) const;
+
+	bool operator == ( const QueryFilter & rhs ) const;
+
+private:
+	Signature m_Include; /**< Component types that must be attached to the entity. */
+	Signature m_Exclude; /**< Component types that must not be attached to the entity. */
+};
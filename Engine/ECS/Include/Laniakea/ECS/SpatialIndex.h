@@ -0,0 +1,151 @@
+#pragma once
+
+#include "ObjectManager.h"
+#include "SpatialPartition.h"
+#include "ThreadPool.h"
+#include <functional>
+#include <memory>
+#include <span>
+#include <vector>
+
+/**
+ * @class ISpatialIndex
+ * @brief Base spatial index interface to store it in a polymorphic manner
+ *
+ * The index is synchronized with the positions of the components by ECS::SyncSpatialIndices,
+ * which is also the first step of ECS::RunSystems.
+ */
+class LANIAKEA_ECS_API ISpatialIndex
+{
+public:
+	virtual ~ISpatialIndex () = default;
+
+	/**
+     * @brief Reads the positions of all components and updates the partition, O(n) in the number of components.
+     * @param threadPool The thread pool used to parallelize the update, or nullptr to update on the calling thread.
+     */
+	virtual void Sync ( ThreadPool * threadPool ) = 0;
+};
+
+/**
+ * @class SpatialIndex
+ * @brief Spatial partition over the entities having the position component.
+ * @tparam T The type of the component providing the position.
+ *
+ * The partition is refitted while the set of the components is unchanged and rebuilt when components are added or removed.
+ * Results of the queries reflect the positions at the last synchronization. Changes aren't tracked, so each Sync reads
+ * the positions of all components and refits the partition, O(n) per tick even if none of them has moved.
+ */
+template <typename T>
+class SpatialIndex : public ISpatialIndex
+{
+
+public:
+
+	using PositionFunction = std::function <SpatialPoint ( const T & )>;
+	using RadiusFunction = std::function <float ( const T & )>;
+
+	/**
+     * @brief Constructor for SpatialIndex.
+     * @param components The component array the positions are read from.
+     * @param partition The partition storing the entities, e.g. HashGrid or LooseOctree.
+     * @param positionFunction The callable extracting the position from the component.
+     * @param radiusFunction The callable extracting the bounding radius from the component, the entities are points if empty.
+     */
+	SpatialIndex ( std::shared_ptr <ObjectManager <T>> components, std::unique_ptr <ISpatialPartition> partition,
+				   PositionFunction positionFunction, RadiusFunction radiusFunction = {} )
+	: m_Components ( std::move ( components ) ), m_Partition ( std::move ( partition ) ),
+	  m_PositionFunction ( std::move ( positionFunction ) ), m_RadiusFunction ( std::move ( radiusFunction ) )
+	{
+
+	}
+
+	void Sync ( ThreadPool * threadPool ) override
+	{
+		const auto Count = m_Components -> Size ();
+		const bool IsResized = ! m_IsBuilt || Count != m_Entries . size ();
+		m_Entries . resize ( Count );
+		const auto Gather = [ this ] ( std::size_t begin, std::size_t end )
+		{
+			const T * Components = m_Components -> Data ();
+			for ( std::size_t i = begin; i < end; i ++ ) {
+				m_Entries[ i ] . Entity = Components[ i ] . GetOwner ();
+				m_Entries[ i ] . Position = m_PositionFunction ( Components[ i ] );
+				m_Entries[ i ] . Radius = m_RadiusFunction ? m_RadiusFunction ( Components[ i ] ) : 0.f;
+			}
+		};
+		if ( threadPool != nullptr )
+			threadPool -> ParallelFor ( Count, 4096, Gather );
+		else
+			Gather ( 0, Count );
+
+		// The partition detects the reordered entities itself and falls back to the rebuild
+		if ( IsResized )
+			m_Partition -> Build ( m_Entries, threadPool );
+		else
+			m_Partition -> Refit ( m_Entries, threadPool );
+		m_IsBuilt = true;
+	}
+
+	/**
+     * @brief Finds the entities within the distance from the point.
+     * @param center The center of the query sphere.
+     * @param radius The radius of the query sphere.
+     * @param result The buffer receiving the handles of the entities.
+     * @return The number of the matching entities, only the first result . size () are written.
+     */
+	std::size_t QueryRadius ( const SpatialPoint & center, float radius, std::span <EntityHandle> result ) const
+	{
+		return m_Partition -> QueryRadius ( center, radius, result );
+	}
+
+	/**
+     * @brief Finds the entities intersecting the box.
+     * @param bounds The query box.
+     * @param result The buffer receiving the handles of the entities.
+     * @return The number of the matching entities, only the first result . size () are written.
+     */
+	std::size_t QueryAABB ( const SpatialBounds & bounds, std::span <EntityHandle> result ) const
+	{
+		return m_Partition -> QueryAABB ( bounds, result );
+	}
+
+	/**
+     * @brief Finds the result . size () entities nearest to the point.
+     * @param point The query point.
+     * @param result The buffer receiving the neighbours sorted by the distance.
+     * @param maxDistance The distance beyond which the entities are ignored.
+     * @return The number of the found neighbours.
+     */
+	std::size_t QueryNearest ( const SpatialPoint & point, std::span <SpatialNeighbour> result,
+							   float maxDistance = std::numeric_limits <float>::max () ) const
+	{
+		return m_Partition -> QueryNearest ( point, result, maxDistance );
+	}
+
+	/**
+     * @brief Retrieves the number of indexed entities.
+     * @return The number of entities at the last synchronization.
+     */
+	std::size_t Size () const
+	{
+		return m_Partition -> Size ();
+	}
+
+	/**
+     * @brief Get the partition storing the entities.
+     * @return A constant reference to the partition.
+     */
+	const ISpatialPartition & GetPartition () const
+	{
+		return * m_Partition;
+	}
+
+private:
+	std::shared_ptr <ObjectManager <T>> m_Components; /**< The component array the positions are read from. */
+	std::unique_ptr <ISpatialPartition> m_Partition; /**< The partition storing the entities. */
+	PositionFunction m_PositionFunction; /**< Extracts the position from the component. */
+	RadiusFunction m_RadiusFunction; /**< Extracts the bounding radius from the component, optional. */
+	std::vector <SpatialEntry> m_Entries; /**< The entries in the order of the component array, reused between synchronizations. */
+	bool m_IsBuilt = false; /**< Whether the partition has been built. */
+};
@@ -0,0 +1,305 @@
+#pragma once
+
+#include "Core.h"
+#include <cstdint>
+#include <limits>
+#include <span>
+#include <vector>
+
+class ThreadPool;
+
+/**
+ * @struct SpatialPoint
+ * @brief Position in the world space used by the spatial partitions.
+ */
+struct LANIAKEA_ECS_API SpatialPoint
+{
+	float X = 0.f;
+	float Y = 0.f;
+	float Z = 0.f;
+};
+
+/**
+ * @struct SpatialBounds
+ * @brief Axis aligned box in the world space.
+ */
+struct LANIAKEA_ECS_API SpatialBounds
+{
+	SpatialPoint Min; /**< The corner with the smallest coordinates. */
+	SpatialPoint Max; /**< The corner with the largest coordinates. */
+};
+
+/**
+ * @struct SpatialEntry
+ * @brief Entity placed into the spatial partition as a bounding sphere.
+ */
+struct LANIAKEA_ECS_API SpatialEntry
+{
+	EntityHandle Entity = 0; /**< The handle of the entity. */
+	SpatialPoint Position; /**< The center of the bounding sphere. */
+	float Radius = 0.f; /**< The radius of the bounding sphere, zero for points. */
+};
+
+/**
+ * @struct SpatialNeighbour
+ * @brief Result of the k-nearest query.
+ */
+struct LANIAKEA_ECS_API SpatialNeighbour
+{
+	EntityHandle Entity = 0; /**< The handle of the entity. */
+	float DistanceSquared = 0.f; /**< The squared distance from the query point to the position of the entity. */
+};
+
+/**
+ * @class ISpatialPartition
+ * @brief Base spatial partition interface answering the neighbour queries.
+ *
+ * Queries write the results into the caller provided buffers and never allocate. They return the total number of
+ * matching entities, which may be greater than the size of the buffer, in that case only the buffer is filled.
+ * Queries are const and may run concurrently, Build and Refit must not overlap with them.
+ */
+class LANIAKEA_ECS_API ISpatialPartition
+{
+public:
+	virtual ~ISpatialPartition () = default;
+
+	/**
+     * @brief Builds the partition from scratch.
+     * @param entries The entities to be placed.
+     * @param threadPool The thread pool used to parallelize the build, or nullptr to build on the calling thread.
+     */
+	virtual void Build ( std::span <const SpatialEntry> entries, ThreadPool * threadPool ) = 0;
+
+	/**
+     * @brief Updates the positions of the entities placed by the last Build.
+     * @param entries The same entities in the same order as in the last Build, with the new positions.
+     * @param threadPool The thread pool used to parallelize the refit, or nullptr to refit on the calling thread.
+     *
+     * Cheaper than Build while the entities move by small distances, the partition rebuilds itself when it's not.
+     */
+	virtual void Refit ( std::span <const SpatialEntry> entries, ThreadPool * threadPool ) = 0;
+
+	/**
+     * @brief Finds the entities whose bounding spheres intersect the sphere.
+     * @param center The center of the query sphere.
+     * @param radius The radius of the query sphere.
+     * @param result The buffer receiving the handles of the entities.
+     * @return The number of the matching entities.
+     */
+	virtual std::size_t QueryRadius ( const SpatialPoint & center, float radius, std::span <EntityHandle> result ) const = 0;
+
+	/**
+     * @brief Finds the entities whose bounding spheres intersect the box.
+     * @param bounds The query box.
+     * @param result The buffer receiving the handles of the entities.
+     * @return The number of the matching entities.
+     */
+	virtual std::size_t QueryAABB ( const SpatialBounds & bounds, std::span <EntityHandle> result ) const = 0;
+
+	/**
+     * @brief Finds the entities with the positions nearest to the point.
+     * @param point The query point.
+     * @param result The buffer receiving the neighbours sorted by the distance, its size is the number of the neighbours to find.
+     * @param maxDistance The distance beyond which the entities are ignored.
+     * @return The number of the found neighbours, at most the size of the buffer.
+     */
+	virtual std::size_t QueryNearest ( const SpatialPoint & point, std::span <SpatialNeighbour> result,
+									   float maxDistance = std::numeric_limits <float>::max () ) const = 0;
+
+	/**
+     * @brief Retrieves the number of placed entities.
+     * @return The number of entities in the partition.
+     */
+	virtual std::size_t Size () const = 0;
+};
+
+/**
+ * @class HashGrid
+ * @brief Uniform grid of cells hashed into a flat table sized by the number of entities.
+ *
+ * Entities are placed into the cell of their position and stored contiguously per table slot, so a query visits
+ * the cells overlapping the query volume extended by the largest radius. Best for entities of similar sizes
+ * with the query radius around the cell size.
+ */
+class LANIAKEA_ECS_API HashGrid : public ISpatialPartition
+{
+
+public:
+
+	/**
+     * @brief Constructor for HashGrid.
+     * @param cellSize The edge length of the cubic cell.
+     */
+	explicit HashGrid ( float cellSize );
+
+	void Build ( std::span <const SpatialEntry> entries, ThreadPool * threadPool ) override;
+
+	/**
+     * @copydoc ISpatialPartition::Refit
+     *
+     * Positions are updated in place while the entities stay in their cells, otherwise the grid is rebuilt.
+     */
+	void Refit ( std::span <const SpatialEntry> entries, ThreadPool * threadPool ) override;
+
+	std::size_t QueryRadius ( const SpatialPoint & center, float radius, std::span <EntityHandle> result ) const override;
+
+	std::size_t QueryAABB ( const SpatialBounds & bounds, std::span <EntityHandle> result ) const override;
+
+	std::size_t QueryNearest ( const SpatialPoint & point, std::span <SpatialNeighbour> result,
+							   float maxDistance = std::numeric_limits <float>::max () ) const override;
+
+	std::size_t Size () const override;
+
+	/**
+     * @brief Get the edge length of the cell.
+     * @return The cell size.
+     */
+	float GetCellSize () const;
+
+private:
+
+	struct Cell
+	{
+		std::int32_t X;
+		std::int32_t Y;
+		std::int32_t Z;
+
+		bool operator == ( const Cell & rhs ) const = default;
+	};
+
+	/**
+     * @brief Computes the cell containing the point.
+     */
+	Cell GetCell ( const SpatialPoint & point ) const;
+
+	/**
+     * @brief Computes the table slot of the cell.
+     */
+	std::size_t GetSlot ( const Cell & cell ) const;
+
+	/**
+     * @brief Invokes func ( index ) for each stored entity in the cells overlapping the bounds.
+     */
+	template <typename Func>
+	void ForEachInBounds ( const SpatialBounds & bounds, Func && func ) const;
+
+	float m_CellSize; /**< The edge length of the cell. */
+	float m_InverseCellSize; /**< The inverse of the cell size. */
+	float m_MaxRadius = 0.f; /**< The largest radius of the placed entities. */
+	std::size_t m_SlotMask = 0; /**< The number of the table slots minus one. */
+	Cell m_MinCell {}; /**< The smallest coordinates of the occupied cells. */
+	Cell m_MaxCell {}; /**< The largest coordinates of the occupied cells. */
+	std::vector <std::uint32_t> m_SlotStarts; /**< The offsets of the table slots in the stored arrays, one past the last slot included. */
+	std::vector <std::uint32_t> m_EntrySlots; /**< The table slot of each input entry, scratch buffer of the build. */
+	std::vector <std::uint32_t> m_EntryIndices; /**< The stored index of each input entry. */
+	std::vector <Cell> m_Cells; /**< The cells of the stored entities. */
+	std::vector <SpatialPoint> m_Positions; /**< The positions of the stored entities. */
+	std::vector <float> m_Radii; /**< The radii of the stored entities. */
+	std::vector <EntityHandle> m_Entities; /**< The handles of the stored entities. */
+};
+
+/**
+ * @class LooseOctree
+ * @brief Octree whose nodes accept entities overhanging their bounds by half of the node size.
+ *
+ * Small entities sink to the leaves by their positions, larger ones stay in the inner nodes, so every entity is
+ * stored exactly once. Nodes keep the tight bounds of their subtrees which are refitted as the entities move,
+ * the tree is rebuilt once too many entities have left the loose bounds of their nodes. Best for entities
+ * of very different sizes and sparse worlds.
+ */
+class LANIAKEA_ECS_API LooseOctree : public ISpatialPartition
+{
+
+public:
+
+	/**
+     * @brief Constructor for LooseOctree.
+     * @param leafCapacity The number of entities above which the node is split.
+     * @param maxDepth The maximal depth of the tree.
+     */
+	explicit LooseOctree ( std::size_t leafCapacity = 16, std::size_t maxDepth = 12 );
+
+	void Build ( std::span <const SpatialEntry> entries, ThreadPool * threadPool ) override;
+
+	/**
+     * @copydoc ISpatialPartition::Refit
+     *
+     * The tight bounds of the nodes are recomputed bottom-up, the tree is rebuilt once more than 1 / 8
+     * of the entities have left the loose bounds of their nodes.
+     */
+	void Refit ( std::span <const SpatialEntry> entries, ThreadPool * threadPool ) override;
+
+	std::size_t QueryRadius ( const SpatialPoint & center, float radius, std::span <EntityHandle> result ) const override;
+
+	std::size_t QueryAABB ( const SpatialBounds & bounds, std::span <EntityHandle> result ) const override;
+
+	std::size_t QueryNearest ( const SpatialPoint & point, std::span <SpatialNeighbour> result,
+							   float maxDistance = std::numeric_limits <float>::max () ) const override;
+
+	std::size_t Size () const override;
+
+	/**
+     * @brief Retrieves the number of nodes of the tree.
+     * @return The number of nodes.
+     */
+	std::size_t GetNodesCount () const;
+
+private:
+
+	struct Node
+	{
+		SpatialPoint Center; /**< The center of the node cube. */
+		float HalfSize = 0.f; /**< Half of the edge length of the node cube. */
+		SpatialBounds Bounds; /**< The tight bounds of the entities of the subtree. */
+		std::uint32_t First = 0; /**< The index of the first stored entity of the node itself. */
+		std::uint32_t Count = 0; /**< The number of stored entities of the node itself. */
+		std::uint32_t FirstChild = 0; /**< The index of the first child, the children are stored contiguously in the octants order. */
+		std::uint8_t ChildrenMask = 0; /**< The octants having a child node. */
+	};
+
+	struct Subtree
+	{
+		std::uint32_t Root; /**< The index of the subtree root among the top nodes. */
+		std::uint32_t First; /**< The first entity of the subtree in the build order. */
+		std::uint32_t Last; /**< One past the last entity of the subtree in the build order. */
+		std::size_t Depth; /**< The depth of the subtree root. */
+		std::vector <Node> Nodes; /**< The nodes built by the job, spliced after the top nodes. */
+	};
+
+	/**
+     * @brief Fills the node over the entities [ first, last ) of the build order and builds its children.
+     * @param subtrees If not null, the nodes at the split depth are deferred to be built in parallel.
+     */
+	void BuildNode ( std::vector <Node> & nodes, std::size_t nodeIndex, std::uint32_t first, std::uint32_t last,
+					 std::size_t depth, std::vector <Subtree> * subtrees );
+
+	/**
+     * @brief Recomputes the tight bounds of the nodes [ first, last ) from the last one, children are stored after their parents.
+     */
+	void RefitNodes ( std::size_t first, std::size_t last );
+
+	/**
+     * @brief Invokes func ( index ) for each stored entity of the subtree whose nodes pass nodeTest ( bounds ).
+     */
+	template <typename NodeTest, typename Func>
+	void ForEachInNode ( std::size_t nodeIndex, const NodeTest & nodeTest, const Func & func ) const;
+
+	/**
+     * @brief Offers the entities of the subtree to the k-nearest result, the closer children first.
+     */
+	void FindNearest ( std::size_t nodeIndex, const SpatialPoint & point, std::span <SpatialNeighbour> result,
+					   std::size_t & count, float maxDistanceSquared ) const;
+
+	std::size_t m_LeafCapacity; /**< The number of entities above which the node is split. */
+	std::size_t m_MaxDepth; /**< The maximal depth of the tree. */
+	std::vector <Node> m_Nodes; /**< The nodes in the depth-first order, the root first. */
+	std::vector <std::pair <std::size_t, std::size_t>> m_SubtreeRanges; /**< The node ranges of the subtrees refitted in parallel. */
+	std::size_t m_TopNodesCount = 0; /**< The number of nodes above the subtrees, refitted after them. */
+	std::vector <std::uint32_t> m_Order; /**< The input index of each entity in the build order, scratch buffer of the build. */
+	std::vector <std::uint32_t> m_Scratch; /**< Scratch buffer of the node partitioning, the subtrees use disjoint ranges. */
+	std::vector <std::uint32_t> m_EntryIndices; /**< The stored index of each input entry. */
+	std::vector <std::uint32_t> m_EntryNodes; /**< The node storing each stored entity. */
+	std::vector <SpatialPoint> m_Positions; /**< The positions of the stored entities. */
+	std::vector <float> m_Radii; /**< The radii of the stored entities. */
+	std::vector <EntityHandle> m_Entities; /**< The handles of the stored entities. */
+};
@@ -1,7 +1,8 @@
 #pragma once
 
 #include "ObjectManager.h"
-#include "Entity.h"
+#include "QueryFilter.h"
+#include "SystemSchedule.h"
 #include <algorithm>
 
 // Forward declaration for ECS to include it in derived system classes and be able to manipulate with the system during run invoke
@@ -41,6 +42,56 @@ public:
      */
     virtual void Run ( ECS & ecs ) = 0;
 
+    /**
+     * @brief Run the system for a contiguous slice of its entities.
+     * @param ecs The ECS (Entity Component System) instance used for processing.
+     * @param first The index of the first entity of the slice in m_Entities.
+     * @param count The number of entities in the slice.
+     *
+     * Called instead of Run by the RoundRobin and Budget schedules if the system opts in with GetIsSliceable.
+     * The system must override it together with GetIsSliceable, the default implementation is never called.
+     * Entities removed during the pass swap the last entity into their place, so it may be skipped until the next pass.
+     */
+    virtual void RunSlice ( ECS & ecs, std::size_t first, std::size_t count );
+
+    /**
+     * @brief Check if the system processes subsets of its entities through RunSlice.
+     * @return True if the RoundRobin and Budget schedules may split the system into slices, false by default.
+     *
+     * Systems which aren't sliceable run whole on every tick under the RoundRobin and Budget schedules.
+     */
+    virtual bool GetIsSliceable () const;
+
+    /**
+     * @brief Run the system according to its schedule and record the timing.
+     * @param ecs The ECS (Entity Component System) instance used for processing.
+     * @return True if the system has processed any entities on this tick, false if the tick was skipped.
+     */
+    bool Execute ( ECS & ecs );
+
+    /**
+     * @brief Set the scheduling options of the system.
+     * @param schedule The new schedule, must be valid (see SystemSchedule::GetIsValid). The saved cursor and the tick counter are reset.
+     */
+    void SetSchedule ( const SystemSchedule & schedule );
+
+    /**
+     * @brief Get the scheduling options of the system.
+     * @return A constant reference to the schedule.
+     */
+    const SystemSchedule & GetSchedule () const;
+
+    /**
+     * @brief Get the recorded timing of the system.
+     * @return A constant reference to the stats.
+     */
+    const SystemStats & GetStats () const;
+
+    /**
+     * @brief Reset the recorded timing of the system.
+     */
+    void ResetStats ();
+
     /**
      * @brief Add an entity to the system.
      * @param entity The entity to be added to the system.
@@ -59,6 +110,17 @@ public:
      */
     void RemoveEntity ( Entity & entity );
 
+    /**
+     * @brief Remove a batch of entities from the system.
+     * @param entityHandles The handles of the removed entities. Entities which aren't in the system are skipped.
+     */
+    void RemoveEntities ( std::span <const EntityHandle> entityHandles );
+
+    /**
+     * @brief Release the excess memory of the system entity list.
+     */
+    void ShrinkToFit ();
+
     /**
      * @brief Set the signature for the system.
      * @param signature The new signature specifying the component types required by this system.
@@ -75,14 +137,28 @@ public:
      */
     void SetSignature ( Signature && signature );
 
+    /**
+     * @brief Set the query filter for the system.
+     * @param filter The new filter with the include and exclude masks resolved from the system query terms.
+     *
+     * This method replaces the signature of the system, allowing to express component types which must be absent on the entity.
+     */
+    void SetFilter ( QueryFilter && filter );
+
+    /**
+     * @brief Get the query filter of the system.
+     * @return A constant reference to the filter deciding which entities are processed by the system.
+     */
+    const QueryFilter & GetFilter () const;
+
     /**
      * @brief Handle changes in the entity's signature.
      * @param entity The entity whose signature has changed.
      * @param signature The new signature of the entity.
      *
      * This method is called when the signature of an entity changes.
-     * It compares the entity's new signature with the system's signature to decide whether to add or remove the entity from the system.
-     * If the entity's signature matches the system's signature, the entity is added to the system for processing.
+     * It matches the entity's new signature against the system's filter to decide whether to add or remove the entity from the system.
+     * If the entity's signature matches the system's filter, the entity is added to the system for processing.
      * Otherwise, the entity is removed from the system.
      */
     void OnEntitySignatureChanged (Entity & entity, const Signature & signature );
@@ -115,8 +191,12 @@ public:
     // End system safe interface
 
 private:
-    Signature m_Signature;  /**< The signature specifying the required component types for the system. */
+    QueryFilter m_Filter;  /**< The filter specifying the required and excluded component types for the system. */
     std::unordered_map<EntityHandle, ObjectHandle> m_EntitiesHandles;  /**< Mapping of entity handles to object handles in the system. */
+    SystemSchedule m_Schedule;  /**< The scheduling options of the system. */
+    SystemStats m_Stats;  /**< The recorded timing of the system. */
+    std::uint64_t m_TicksCount = 0;  /**< The number of ticks since the schedule was set. */
+    std::size_t m_Cursor = 0;  /**< The index of the first entity of the next slice. */
 protected:
     ObjectManager<EntityHandle> m_Entities;  /**< ObjectManager to handle entities associated with the system. */
 };
\ No newline at end of file
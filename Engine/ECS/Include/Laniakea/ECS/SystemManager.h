@@ -3,6 +3,7 @@
 #include "ObjectManager.h"
 #include "System.h"
 #include <memory>
+#include <vector>
 
 /**
  * @class SystemManager
@@ -29,12 +30,25 @@ public:
 	void RegisterSystem ( Signature && SystemSignature )
 	{
 		const auto SystemType = GetSystemType <T> ();
-		m_Systems[ SystemType ] = std::move ( std::make_shared <T> () );
+		AddSystem ( SystemType, std::make_shared <T> () );
 		m_Systems . at ( SystemType ) -> SetSignature ( std::forward <Signature> ( SystemSignature ) );
 	}
 
 	/**
-	* @brief Runs the specified system for the provided ECS instance.
+     * @brief Registers a new system with the specified query filter.
+     * @tparam T The type of the system to be registered.
+     * @param SystemFilter The filter with include and exclude masks of the system to be registered.
+     */
+	template <typename T>
+	void RegisterSystem ( QueryFilter && SystemFilter )
+	{
+		const auto SystemType = GetSystemType <T> ();
+		AddSystem ( SystemType, std::make_shared <T> () );
+		m_Systems . at ( SystemType ) -> SetFilter ( std::forward <QueryFilter> ( SystemFilter ) );
+	}
+
+	/**
+	* @brief Runs the specified system for the provided ECS instance according to its schedule.
 	* @tparam T The type of the system to be run.
 	* @param ecs The ECS instance to run the system on.
 	*/
@@ -42,9 +56,15 @@ public:
 	void RunSystem ( ECS & ecs )
 	{
 		std::shared_ptr <T> System = GetSystem <T> () . lock ();
-		System -> Run ( ecs );
+		System -> Execute ( ecs );
 	}
 
+	/**
+     * @brief Runs all registered systems in the registration order according to their schedules.
+     * @param ecs The ECS instance to run the systems on.
+     */
+	void RunSystems ( ECS & ecs );
+
 	/**
      * @brief Retrieves a weak pointer to the specified system type.
      * @tparam T The type of the system to retrieve.
@@ -105,6 +125,17 @@ public:
      * @param entity The entity that has been removed.
      */
 	void OnEntityRemoved ( Entity & entity );
+
+	/**
+     * @brief Notifies all systems that a batch of entities has been removed.
+     * @param entityHandles The handles of the removed entities.
+     */
+	void OnEntitiesRemoved ( std::span <const EntityHandle> entityHandles );
+
+	/**
+     * @brief Releases the excess memory of all systems.
+     */
+	void ShrinkToFit ();
 	/* End SystemManager interface */
 
 	/* Begin SystemManager safe interface */
@@ -124,6 +155,21 @@ public:
 		return true;
 	}
 
+	/**
+     * @brief Registers a new system with the specified query filter in a safe manner.
+     * @tparam T The type of the system to be registered.
+     * @param SystemFilter The filter with include and exclude masks of the system to be registered.
+     * @return True if the system was successfully registered, false if the system is already registered.
+     */
+	template <typename T>
+	bool RegisterSystemChecked ( QueryFilter && SystemFilter )
+	{
+		if ( GetIsSystemRegistered <T> () )
+			return false;
+		RegisterSystem <T> ( std::forward <QueryFilter> ( SystemFilter ) );
+		return true;
+	}
+
 	/**
      * @brief Runs the specified system for the provided ECS instance in a safe manner.
      * @tparam T The type of the system to be run.
@@ -136,11 +182,19 @@ public:
 		std::shared_ptr <T> System = GetSystem <T> () . lock ();
 		if ( ! System )
 			return false;
-		System -> Run ( ecs );
+		System -> Execute ( ecs );
 		return true;
 	}
 	/* End SystemManager safe interface */
 private:
 
+	/**
+     * @brief Stores the system, replacing the registered system of the same type in its place of the execution order.
+     * @param systemType The SystemType of the system.
+     * @param system The system to be stored.
+     */
+	void AddSystem ( SystemType systemType, std::shared_ptr <System> system );
+
 	std::unordered_map <SystemType, std::shared_ptr <System>> m_Systems; /**< The storage for registered systems. */
+	std::vector <std::pair <SystemType, std::shared_ptr <System>>> m_SystemsOrder; /**< The registered systems in the registration order. */
 };
\ No newline at end of file
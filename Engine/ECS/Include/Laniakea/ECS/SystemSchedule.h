@@ -0,0 +1,84 @@
+#pragma once
+
+#include "Core.h"
+#include <chrono>
+
+/**
+ * @brief Mode of the system execution.
+ */
+enum class SystemScheduleMode
+{
+	EveryTick, /**< The system processes all entities on every tick. */
+	EveryNTicks, /**< The system processes all entities on every Period-th tick. */
+	RoundRobin, /**< The system processes 1 / Period of its entities per tick, a full pass takes Period ticks. */
+	Budget /**< The system processes slices until the time budget is spent and resumes from the cursor next tick. */
+};
+
+/**
+ * @struct SystemSchedule
+ * @brief Scheduling options of the registered system.
+ *
+ * RoundRobin and Budget modes run the system through System::RunSlice only if the system overrides it and
+ * opts in with System::GetIsSliceable, the other systems run whole on every tick under these modes.
+ */
+struct LANIAKEA_ECS_API SystemSchedule
+{
+	SystemScheduleMode Mode = SystemScheduleMode::EveryTick; /**< The mode of the execution. */
+	std::uint32_t Period = 1; /**< The ticks interval of EveryNTicks or the number of buckets of RoundRobin. */
+	std::chrono::microseconds Budget { 0 }; /**< The time budget per tick of the Budget mode. */
+	std::size_t SliceSize = 64; /**< The number of entities processed between budget checks of the Budget mode. */
+
+	/**
+     * @brief Creates the schedule processing all entities on every tick.
+     * @return The schedule.
+     */
+	static SystemSchedule EveryTick ();
+
+	/**
+     * @brief Creates the schedule processing all entities on every n-th tick.
+     * @param n The ticks interval, the system runs on the first tick.
+     * @return The schedule.
+     */
+	static SystemSchedule EveryNTicks ( std::uint32_t n );
+
+	/**
+     * @brief Creates the schedule processing one of n round-robin buckets of the entities per tick.
+     * @param n The number of buckets.
+     * @return The schedule.
+     */
+	static SystemSchedule RoundRobin ( std::uint32_t n );
+
+	/**
+     * @brief Creates the schedule processing the entities until the budget is spent.
+     * @param budget The time budget per tick. At least one slice is processed per tick.
+     * @param sliceSize The number of entities processed between budget checks.
+     * @return The schedule.
+     */
+	static SystemSchedule WithBudget ( std::chrono::microseconds budget, std::size_t sliceSize = 64 );
+
+	/**
+     * @brief Checks if the schedule can be run.
+     * @return True if both the period and the slice size are non-zero.
+     */
+	bool GetIsValid () const;
+};
+
+/**
+ * @struct SystemStats
+ * @brief Timing of the system execution recorded to tune the schedules.
+ */
+struct LANIAKEA_ECS_API SystemStats
+{
+	std::uint64_t RunsCount = 0; /**< The number of ticks the system has actually run on. */
+	std::uint64_t ProcessedEntitiesCount = 0; /**< The total number of processed entities. */
+	std::size_t LastProcessedEntitiesCount = 0; /**< The number of entities processed on the last run. */
+	std::chrono::nanoseconds LastTime { 0 }; /**< The duration of the last run. */
+	std::chrono::nanoseconds MaxTime { 0 }; /**< The longest run. */
+	std::chrono::nanoseconds TotalTime { 0 }; /**< The accumulated duration of all runs. */
+
+	/**
+     * @brief Retrieves the average duration of the run.
+     * @return The average duration, zero if the system hasn't run yet.
+     */
+	std::chrono::nanoseconds GetAverageTime () const;
+};
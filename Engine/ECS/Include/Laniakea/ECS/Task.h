@@ -0,0 +1,376 @@
+#pragma once
+
+#include "ThreadPool.h"
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <coroutine>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <unordered_set>
+#include <vector>
+
+/**
+ * @class TaskFrameAllocator
+ * @brief Pooled allocator of the coroutine frames of tasks.
+ *
+ * Frames are rounded up to size classes and carved from large slabs, freed frames are kept in per-class free lists.
+ * Frames of similar tasks thus sit next to each other in memory and no heap allocation happens in the steady state.
+ * Each thread allocates from its own allocator and each frame records the allocator owning it, so a frame freed on
+ * another thread is handed back to its owner instead of entering the free lists of the freeing thread. The allocator
+ * outlives its thread until all of its frames are freed.
+ */
+class LANIAKEA_ECS_API TaskFrameAllocator
+{
+
+public:
+
+	static constexpr std::size_t SizeClassGranularity = 64; /**< The size classes step in bytes. */
+	static constexpr std::size_t MaxPooledSize = 2048; /**< Larger frames are allocated from the heap directly. */
+	static constexpr std::size_t SlabSize = 64 * 1024; /**< The size of the slab the frames are carved from. */
+
+	TaskFrameAllocator ( const TaskFrameAllocator & ) = delete;
+	TaskFrameAllocator & operator = ( const TaskFrameAllocator & ) = delete;
+
+	/**
+     * @brief Allocates the memory for the coroutine frame.
+     * @param size The size of the frame.
+     * @return A pointer to the memory.
+     */
+	void * Allocate ( std::size_t size );
+
+	/**
+     * @brief Returns the memory of the coroutine frame to the allocator it was allocated from, on any thread.
+     * @param frame The pointer returned by Allocate.
+     * @param size The size passed to Allocate.
+     */
+	static void Deallocate ( void * frame, std::size_t size );
+
+	/**
+     * @brief Retrieves the allocator of the calling thread.
+     * @return A reference to the thread local allocator.
+     */
+	static TaskFrameAllocator & Get ();
+
+private:
+
+	struct ThreadOwner;
+
+	struct FreeBlock
+	{
+		FreeBlock * Next; /**< The next free block of the same size class. */
+	};
+
+	/**
+     * @brief Precedes each pooled frame, keeps the frame aligned as the global operator new would.
+     */
+	struct alignas ( alignof ( std::max_align_t ) ) FrameHeader
+	{
+		TaskFrameAllocator * Owner; /**< The allocator owning the slab of the frame. */
+	};
+
+	using FreeLists = std::array <FreeBlock *, MaxPooledSize / SizeClassGranularity>;
+
+	TaskFrameAllocator () = default;
+
+	/**
+     * @brief Drops a reference held by the owning thread or by a frame, deletes the allocator on the last one.
+     */
+	void Release ();
+
+	FreeLists m_FreeLists {}; /**< Free blocks by size classes, used by the owning thread only. */
+	FreeLists m_RemoteFreeLists {}; /**< Blocks freed by other threads, moved to the free lists on demand. */
+	std::mutex m_RemoteMutex; /**< Guards the remote free lists. */
+	std::atomic <bool> m_HasRemoteBlocks { false }; /**< Whether the remote free lists may be non-empty. */
+	std::atomic <std::size_t> m_ReferencesCount { 1 }; /**< The owning thread and the allocated frames. */
+	std::vector <std::unique_ptr <std::byte []>> m_Slabs; /**< The slabs owning the pooled memory. */
+	std::byte * m_SlabCursor = nullptr; /**< The first unused byte of the current slab. */
+	std::size_t m_SlabRemaining = 0; /**< The number of unused bytes in the current slab. */
+};
+
+class TaskScheduler;
+
+/**
+ * @class Task
+ * @brief Coroutine suspending across frames under the TaskScheduler.
+ *
+ * The task starts suspended and is handed over to the scheduler with ECS::StartTask, which runs it until the first
+ * suspension point. Inside the task co_await NextFrame (), WaitFor ( seconds ) or Job ( func ) suspend it until
+ * the next ECS::UpdateTasks, until the time has passed or until the func has been executed on the thread pool.
+ * The task is always resumed on the thread calling ECS::UpdateTasks. Exceptions escaping the task terminate.
+ */
+class LANIAKEA_ECS_API Task
+{
+
+public:
+
+	struct promise_type
+	{
+		TaskScheduler * Scheduler = nullptr; /**< The scheduler running the task. */
+
+		Task get_return_object ()
+		{
+			return Task ( std::coroutine_handle <promise_type>::from_promise ( * this ) );
+		}
+
+		std::suspend_always initial_suspend () noexcept
+		{
+			return {};
+		}
+
+		std::suspend_always final_suspend () noexcept
+		{
+			return {};
+		}
+
+		void return_void ()
+		{
+
+		}
+
+		void unhandled_exception ()
+		{
+			std::terminate ();
+		}
+
+		static void * operator new ( std::size_t size )
+		{
+			return TaskFrameAllocator::Get () . Allocate ( size );
+		}
+
+		static void operator delete ( void * frame, std::size_t size )
+		{
+			TaskFrameAllocator::Deallocate ( frame, size );
+		}
+	};
+
+	using Handle = std::coroutine_handle <promise_type>;
+
+	Task () = default;
+
+	/**
+     * @brief Constructor for Task.
+     * @param handle The handle of the coroutine owned by the task.
+     */
+	explicit Task ( Handle handle );
+
+	Task ( Task && other ) noexcept;
+
+	Task & operator = ( Task && other ) noexcept;
+
+	Task ( const Task & ) = delete;
+	Task & operator = ( const Task & ) = delete;
+
+	/**
+     * @brief Destructor for Task. Destroys the coroutine if it wasn't handed over to the scheduler.
+     */
+	~Task ();
+
+	/**
+     * @brief Releases the ownership of the coroutine.
+     * @return The handle of the coroutine.
+     */
+	Handle Release ();
+
+	/**
+     * @brief Checks if the task owns a coroutine.
+     * @return True if the task owns a coroutine, false otherwise.
+     */
+	bool GetIsValid () const;
+
+private:
+	Handle m_Handle; /**< The owned coroutine. */
+};
+
+/**
+ * @brief Awaitable suspending the task until the next TaskScheduler::Update.
+ */
+struct LANIAKEA_ECS_API NextFrame
+{
+	bool await_ready () const noexcept
+	{
+		return false;
+	}
+
+	void await_suspend ( Task::Handle handle ) const;
+
+	void await_resume () const noexcept
+	{
+
+	}
+};
+
+/**
+ * @brief Awaitable suspending the task until the scheduler time has advanced by the given number of seconds.
+ */
+struct LANIAKEA_ECS_API WaitFor
+{
+	/**
+     * @brief Constructor for WaitFor.
+     * @param seconds The time to wait, the task isn't suspended if it's not positive.
+     */
+	explicit WaitFor ( double seconds );
+
+	bool await_ready () const noexcept
+	{
+		return Seconds <= 0.0;
+	}
+
+	void await_suspend ( Task::Handle handle ) const;
+
+	void await_resume () const noexcept
+	{
+
+	}
+
+	double Seconds; /**< The time to wait. */
+};
+
+/**
+ * @brief Awaitable executing the callable on the thread pool and resuming the task on the next update after it's done.
+ *
+ * The callable must not touch the ECS, the results are passed back through the captured references,
+ * the task frame stays alive until the task is resumed.
+ */
+class LANIAKEA_ECS_API Job
+{
+
+public:
+
+	/**
+     * @brief Constructor for Job.
+     * @param func The callable to be executed on the thread pool.
+     */
+	explicit Job ( std::function <void ()> func );
+
+	bool await_ready () const noexcept
+	{
+		return false;
+	}
+
+	void await_suspend ( Task::Handle handle );
+
+	void await_resume () const noexcept
+	{
+
+	}
+
+private:
+	std::function <void ()> m_Func; /**< The callable to be executed. */
+};
+
+/**
+ * @class TaskScheduler
+ * @brief Runs the suspended tasks in batches once per update.
+ *
+ * Tasks due on the update are collected from the next frame list, the timer heap and the finished jobs
+ * and resumed in the order of their frame addresses, which follows the slabs of the frame allocator.
+ */
+class LANIAKEA_ECS_API TaskScheduler
+{
+
+public:
+
+	TaskScheduler () = default;
+
+	/**
+     * @brief Destructor for TaskScheduler. Cancels the queued jobs of this scheduler, waits for its running ones
+     * and destroys the suspended tasks. Jobs of other schedulers sharing the thread pool aren't waited for.
+     */
+	~TaskScheduler ();
+
+	TaskScheduler ( const TaskScheduler & ) = delete;
+	TaskScheduler & operator = ( const TaskScheduler & ) = delete;
+
+	/**
+     * @brief Takes the ownership of the task and runs it until its first suspension point.
+     * @param task The task to be started.
+     */
+	void Start ( Task && task );
+
+	/**
+     * @brief Advances the scheduler time and resumes the tasks due on this update.
+     * @param deltaSeconds The time elapsed since the previous update.
+     *
+     * Tasks suspended during the update are resumed on the next update at the earliest.
+     */
+	void Update ( double deltaSeconds );
+
+	/**
+     * @brief Retrieves the number of unfinished tasks.
+     * @return The number of tasks owned by the scheduler.
+     */
+	std::size_t GetTasksCount () const;
+
+	/**
+     * @brief Sets the thread pool executing the jobs.
+     * @param threadPool The thread pool, possibly shared with other schedulers.
+     */
+	void SetThreadPool ( std::shared_ptr <ThreadPool> threadPool );
+
+	/**
+     * @brief Retrieves the thread pool executing the jobs, creating it on the first use.
+     * @return A shared pointer to the thread pool.
+     */
+	std::shared_ptr <ThreadPool> GetThreadPool ();
+
+	/**
+     * @brief Schedules the task to be resumed on the next update.
+     * @param handle The suspended task.
+     */
+	void ScheduleNextFrame ( std::coroutine_handle <> handle );
+
+	/**
+     * @brief Schedules the task to be resumed once the time has advanced by the given number of seconds.
+     * @param seconds The time to wait.
+     * @param handle The suspended task.
+     */
+	void ScheduleAfter ( double seconds, std::coroutine_handle <> handle );
+
+	/**
+     * @brief Executes the callable on the thread pool and schedules the task to be resumed after it's done.
+     * @param func The callable to be executed.
+     * @param handle The suspended task.
+     */
+	void ScheduleJob ( std::function <void ()> && func, std::coroutine_handle <> handle );
+
+private:
+
+	struct Timer
+	{
+		double WakeTime; /**< The scheduler time to resume the task at. */
+		std::coroutine_handle <> Handle; /**< The suspended task. */
+
+		bool operator > ( const Timer & rhs ) const;
+	};
+
+	/**
+     * @brief Jobs of the scheduler shared with the workers, so a job queued behind the destroyed scheduler is skipped safely.
+     */
+	struct JobsState
+	{
+		std::mutex Mutex; /**< Guards the state. */
+		std::condition_variable Idle; /**< Signaled when the last running job is finished. */
+		std::vector <std::coroutine_handle <>> Finished; /**< Tasks whose jobs have been executed. */
+		std::size_t RunningCount = 0; /**< The number of jobs being executed. */
+		bool IsCancelled = false; /**< Whether the scheduler is destroyed and the queued jobs must be skipped. */
+	};
+
+	/**
+     * @brief Resumes the task and destroys it if it has finished.
+     * @param handle The task to be resumed.
+     */
+	void Resume ( std::coroutine_handle <> handle );
+
+	std::vector <std::coroutine_handle <>> m_NextFrame; /**< Tasks waiting for the next update. */
+	std::vector <std::coroutine_handle <>> m_Resuming; /**< The batch of the tasks resumed by the current update. */
+	std::vector <Timer> m_Timers; /**< Min-heap of the waiting tasks by their wake time. */
+	std::shared_ptr <JobsState> m_Jobs = std::make_shared <JobsState> (); /**< The state of the submitted jobs. */
+	std::unordered_set <void *> m_WaitingForJobs; /**< Frame addresses of the tasks suspended on the jobs. */
+	std::shared_ptr <ThreadPool> m_ThreadPool; /**< The thread pool executing the jobs. */
+	double m_Time = 0.0; /**< The accumulated time of the updates. */
+	std::size_t m_TasksCount = 0; /**< The number of unfinished tasks. */
+};
@@ -0,0 +1,77 @@
+#pragma once
+
+#include "Core.h"
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * @class ThreadPool
+ * @brief Fixed set of worker threads executing submitted jobs.
+ *
+ * Shared by the ECS subsystems offloading work from the owning thread, e.g. coroutine jobs and parallel rebuilds.
+ */
+class LANIAKEA_ECS_API ThreadPool
+{
+
+public:
+
+	/**
+     * @brief Constructor for ThreadPool.
+     * @param threadsCount The number of worker threads, zero to use one less than the hardware concurrency.
+     */
+	explicit ThreadPool ( std::size_t threadsCount = 0 );
+
+	/**
+     * @brief Destructor for ThreadPool. Finishes the queued jobs and joins the workers.
+     */
+	~ThreadPool ();
+
+	ThreadPool ( const ThreadPool & ) = delete;
+	ThreadPool & operator = ( const ThreadPool & ) = delete;
+
+	/**
+     * @brief Queues the job to be executed by one of the workers.
+     * @param job The job to be executed.
+     */
+	void Submit ( std::function <void ()> job );
+
+	/**
+     * @brief Splits the range into chunks and executes them in parallel, the calling thread executes one of them.
+     * @param count The number of elements in the range.
+     * @param grainSize The minimal number of elements in the chunk.
+     * @param func The callable invoked as func ( begin, end ) for each chunk.
+     *
+     * Blocks until all chunks are executed. Must not be called from the worker thread of the same pool.
+     */
+	void ParallelFor ( std::size_t count, std::size_t grainSize, const std::function <void ( std::size_t, std::size_t )> & func );
+
+	/**
+     * @brief Blocks until all submitted jobs are executed.
+     */
+	void WaitIdle ();
+
+	/**
+     * @brief Retrieves the number of worker threads.
+     * @return The number of workers.
+     */
+	std::size_t GetThreadsCount () const;
+
+private:
+
+	/**
+     * @brief The loop of the worker thread.
+     */
+	void WorkerLoop ();
+
+	std::vector <std::thread> m_Workers; /**< The worker threads. */
+	std::deque <std::function <void ()>> m_Jobs; /**< The queued jobs. */
+	std::mutex m_Mutex; /**< Guards the queue and the counters. */
+	std::condition_variable m_JobsAvailable; /**< Signaled when a job is queued or the pool is stopping. */
+	std::condition_variable m_Idle; /**< Signaled when the last running job is finished. */
+	std::size_t m_RunningJobsCount = 0; /**< The number of jobs being executed. */
+	bool m_IsStopping = false; /**< Whether the workers should exit once the queue is empty. */
+};
@@ -0,0 +1,123 @@
+#pragma once
+
+#include "ECS.h"
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <vector>
+
+using WorldHandle = ObjectHandle;
+
+/**
+ * @class Universe
+ * @brief Owns a set of independent ECS worlds and ticks them in parallel.
+ *
+ * Each world is ticked by exactly one thread at a time, so the systems of a world don't need to be aware of the other worlds.
+ * The worlds are handed out to the threads dynamically, starting with the ones whose last tick was the longest,
+ * so a single heavy world doesn't end up queued behind the light ones. The component type codes are global,
+ * so the component arrays of all worlds line up and entities can be migrated between them between the ticks.
+ * A world may be ticked by a different thread each tick, so its tasks may be created, resumed and destroyed on
+ * different threads. That's safe since each task frame is returned to the allocator it was taken from.
+ */
+class LANIAKEA_ECS_API Universe
+{
+
+public:
+
+	/**
+     * @brief Constructor for Universe.
+     * @param tickPool The thread pool ticking the worlds, created with the default number of threads if nullptr.
+     * @param jobPool The thread pool shared by the jobs of all worlds, created with the default number of threads if nullptr.
+     * Must differ from the tick pool, since the systems split their work on it from the workers of the tick pool.
+     */
+	explicit Universe ( std::shared_ptr <ThreadPool> tickPool = nullptr, std::shared_ptr <ThreadPool> jobPool = nullptr );
+
+	/**
+     * @brief Creates a new empty world sharing the job pool of the universe.
+     * @return The handle of the world.
+     */
+	WorldHandle CreateWorld ();
+
+	/**
+     * @brief Destroys the world with all its entities.
+     * @param worldHandle The handle of the world to be destroyed.
+     */
+	void DestroyWorld ( WorldHandle worldHandle );
+
+	/**
+     * @brief Retrieves the world associated with the given handle.
+     * @param worldHandle The handle of the world.
+     * @return A reference to the world, stable until the world is destroyed.
+     */
+	ECS & GetWorld ( WorldHandle worldHandle );
+
+	/**
+     * @brief Checks if the world handle is valid.
+     * @param worldHandle The handle of the world.
+     * @return True if the world exists, false otherwise.
+     */
+	bool GetIsValidWorldHandle ( WorldHandle worldHandle ) const;
+
+	/**
+     * @brief Retrieves the number of worlds.
+     * @return The number of worlds.
+     */
+	std::size_t GetWorldsCount () const;
+
+	/**
+     * @brief Runs the systems and updates the tasks of every world once, the worlds are ticked in parallel.
+     * @param deltaSeconds The time elapsed since the previous tick, passed to ECS::UpdateTasks.
+     *
+     * Blocks until all worlds are ticked. Must not be called from the workers of the tick pool.
+     */
+	void Tick ( double deltaSeconds );
+
+	/**
+     * @brief Retrieves the duration of the last tick of the world.
+     * @param worldHandle The handle of the world.
+     * @return The duration of the last tick, zero if the world hasn't been ticked yet.
+     */
+	std::chrono::nanoseconds GetLastTickTime ( WorldHandle worldHandle );
+
+	/**
+     * @brief Moves an entity with all its components from one world into another.
+     * @param from The world owning the entity.
+     * @param to The world receiving the entity, must differ from the source world.
+     * @param entityHandle The handle of the entity in the source world.
+     * @return The handle of the entity in the destination world.
+     *
+     * See ECS::MigrateEntity. Must not be called during the Tick.
+     */
+	EntityHandle MigrateEntity ( WorldHandle from, WorldHandle to, EntityHandle entityHandle );
+
+	/**
+     * @brief Retrieves the thread pool ticking the worlds.
+     * @return A shared pointer to the tick pool.
+     */
+	std::shared_ptr <ThreadPool> GetTickPool () const;
+
+	/**
+     * @brief Retrieves the thread pool shared by the jobs of all worlds.
+     * @return A shared pointer to the job pool.
+     */
+	std::shared_ptr <ThreadPool> GetJobPool () const;
+
+private:
+
+	struct World
+	{
+		std::unique_ptr <ECS> Ecs; /**< The world, allocated separately so the references survive the reordering. */
+		std::chrono::nanoseconds LastTickTime = {}; /**< The duration of the last tick, orders the next tick. */
+	};
+
+	/**
+     * @brief Ticks the worlds taken from the shared cursor until none is left.
+     */
+	void TickWorlds ( double deltaSeconds );
+
+	std::shared_ptr <ThreadPool> m_TickPool; /**< The thread pool ticking the worlds. */
+	std::shared_ptr <ThreadPool> m_JobPool; /**< The thread pool shared by the jobs of the worlds. */
+	ObjectManager <World> m_Worlds; /**< The worlds packed for the iteration. */
+	std::vector <World *> m_TickOrder; /**< The worlds of the current tick sorted by their last tick time. */
+	std::atomic <std::size_t> m_TickCursor = 0; /**< The index of the next world to be ticked in the tick order. */
+};
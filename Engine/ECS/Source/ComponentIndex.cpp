@@ -0,0 +1 @@
+#include "Laniakea/ECS/ComponentIndex.h"
\ No newline at end of file
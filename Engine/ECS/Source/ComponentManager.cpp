@@ -5,10 +5,137 @@ bool ComponentManager::GetIsComponentRegistered ( ComponentType componentType )
 	return m_Components . count ( componentType ) != 0;
 }
 
+void ComponentManager::RegisterComponent ( ComponentType componentType, std::shared_ptr <IObjectManager> components )
+{
+	m_Components[ componentType ] = std::move ( components );
+}
+
+void ComponentManager::AttachComponent ( Entity & entity, ComponentType componentType, ComponentHandle componentHandle )
+{
+	entity . AddComponent ( { componentType, componentHandle } );
+	OnComponentAdded ( entity, componentType );
+}
+
+void ComponentManager::RemoveComponent ( Entity & entity, ComponentType componentType )
+{
+	const auto ComponentHandle = entity . GetComponentHandle ( componentType );
+	OnComponentRemoving ( entity, componentType );
+	m_Components . at ( componentType ) -> RemoveObject ( ComponentHandle );
+	entity . RemoveComponent ( componentType );
+}
+
+std::span <const std::byte> ComponentManager::GetComponentBytes ( Entity & entity, ComponentType componentType )
+{
+	return m_Components . at ( componentType ) -> GetObjectBytes ( entity . GetComponentHandle ( componentType ) );
+}
+
 void ComponentManager::OnEntityRemoved ( Entity & entity )
 {
 	const auto & ComponentInfo = entity . GetComponentsInfo ();
+	// Leave groups while all components are still valid, since groups look them up to restore the partition.
+	for ( const auto & info : ComponentInfo ) {
+		OnComponentRemoving ( entity, info . Type );
+	}
 	for ( const auto & info : ComponentInfo ) {
 		m_Components . at ( info . Type ) -> RemoveObjectChecked ( info . Handle );
 	}
+}
+
+void ComponentManager::OnEntitiesRemoved ( std::span <Entity * const> entities )
+{
+	for ( Entity * e : entities ) {
+		for ( const auto & info : e -> GetComponentsInfo () ) {
+			OnComponentRemoving ( * e, info . Type );
+			m_RemovedComponents[ info . Type ] . push_back ( info . Handle );
+		}
+	}
+	for ( auto & [ Type, Handles ] : m_RemovedComponents ) {
+		if ( Handles . empty () )
+			continue;
+		m_Components . at ( Type ) -> RemoveObjects ( Handles );
+		Handles . clear ();
+	}
+}
+
+void ComponentManager::MoveComponents ( Entity & source, ComponentManager & destination, Entity & target )
+{
+	const auto & ComponentInfo = source . GetComponentsInfo ();
+	for ( const auto & info : ComponentInfo ) {
+		OnComponentRemoving ( source, info . Type );
+	}
+	for ( const auto & info : ComponentInfo ) {
+		auto & Components = * m_Components . at ( info . Type );
+		auto & DestinationComponents = destination . m_Components[ info . Type ];
+		if ( ! DestinationComponents )
+			DestinationComponents = Components . CreateEmpty ();
+		const auto Handle = Components . MoveObject ( info . Handle, * DestinationComponents, target . GetHandle () );
+		target . AddComponent ( { info . Type, Handle } );
+		destination . OnComponentAdded ( target, info . Type );
+	}
+}
+
+std::size_t ComponentManager::ShrinkToFit ( float occupancy )
+{
+	std::size_t Shrunk = 0;
+	for ( auto & [ Type, Components ] : m_Components ) {
+		if ( ( float ) Components -> Size () >= occupancy * ( float ) Components -> Capacity () )
+			continue;
+		Components -> ShrinkToFit ();
+		if ( const auto It = m_GroupOwners . find ( Type ); It != m_GroupOwners . end () )
+			It -> second -> ShrinkToFit ();
+		Shrunk ++;
+	}
+	m_RemovedComponents . clear ();
+	return Shrunk;
+}
+
+void ComponentManager::OnComponentChanged ( Entity & entity, ComponentType componentType )
+{
+	const auto Indices = m_Indices . find ( componentType );
+	if ( Indices == m_Indices . end () )
+		return;
+	const auto ComponentHandle = entity . GetComponentHandle ( componentType );
+	for ( auto & Index : Indices -> second ) {
+		Index -> Update ( entity . GetHandle (), ComponentHandle );
+	}
+}
+
+void ComponentManager::MarkComponentChanged ( Entity & entity, ComponentType componentType )
+{
+	const auto Indices = m_Indices . find ( componentType );
+	if ( Indices == m_Indices . end () )
+		return;
+	const auto ComponentHandle = entity . GetComponentHandle ( componentType );
+	for ( auto & Index : Indices -> second ) {
+		Index -> MarkChanged ( entity . GetHandle (), ComponentHandle );
+	}
+}
+
+void ComponentManager::OnComponentAdded ( Entity & entity, ComponentType componentType )
+{
+	const auto It = m_GroupOwners . find ( componentType );
+	if ( It != m_GroupOwners . end () )
+		It -> second -> OnComponentAdded ( entity );
+
+	const auto Indices = m_Indices . find ( componentType );
+	if ( Indices == m_Indices . end () )
+		return;
+	const auto ComponentHandle = entity . GetComponentHandle ( componentType );
+	for ( auto & Index : Indices -> second ) {
+		Index -> Insert ( entity . GetHandle (), ComponentHandle );
+	}
+}
+
+void ComponentManager::OnComponentRemoving ( Entity & entity, ComponentType componentType )
+{
+	const auto It = m_GroupOwners . find ( componentType );
+	if ( It != m_GroupOwners . end () )
+		It -> second -> OnComponentRemoving ( entity );
+
+	const auto Indices = m_Indices . find ( componentType );
+	if ( Indices == m_Indices . end () )
+		return;
+	for ( auto & Index : Indices -> second ) {
+		Index -> Erase ( entity . GetHandle () );
+	}
 }
\ No newline at end of file
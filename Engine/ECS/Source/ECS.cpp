@@ -1,16 +1,212 @@
 #include "Laniakea/ECS/ECS.h"
+#include <algorithm>
 
 EntityHandle ECS::CreateEntity ()
 {
-	return m_EntityManager . CreateEntity ();
+	const auto Handle = m_EntityManager . CreateEntity ();
+	if ( m_Recorder )
+		m_Recorder -> RecordCreateEntity ( Handle );
+	return Handle;
+}
+
+EntityHandle ECS::ReserveEntity ()
+{
+	return m_EntityManager . ReserveEntity ();
+}
+
+std::size_t ECS::MaterializeReservedEntities ()
+{
+	if ( ! m_Recorder )
+		return m_EntityManager . MaterializeReservedEntities ();
+
+	// The replay creates the materialized entities in the same order as the recorded ones
+	m_MaterializedEntities . clear ();
+	const auto Materialized = m_EntityManager . MaterializeReservedEntities ( & m_MaterializedEntities );
+	for ( const auto Handle : m_MaterializedEntities ) {
+		m_Recorder -> RecordCreateEntity ( Handle );
+	}
+	m_MaterializedEntities . clear ();
+	return Materialized;
 }
 
 void ECS::RemoveEntity ( EntityHandle entityHandle )
 {
+	if ( m_Recorder )
+		m_Recorder -> RecordRemoveEntity ( entityHandle );
 	Entity & e = m_EntityManager . GetEntity ( entityHandle );
 	m_ComponentManager . OnEntityRemoved ( e );
 	m_SystemManager . OnEntityRemoved ( e );
+	m_QueryManager . OnEntityRemoved ( e );
+	m_EntityManager . RemoveEntity ( entityHandle );
+	AutoCompact ();
+}
+
+EntityHandle ECS::MigrateEntity ( EntityHandle entityHandle, ECS & destination )
+{
+	Entity & Source = m_EntityManager . GetEntity ( entityHandle );
+	const EntityHandle Handle = destination . CreateEntity ();
+	Entity & Target = destination . GetEntity ( Handle );
+	m_ComponentManager . MoveComponents ( Source, destination . m_ComponentManager, Target );
+	m_SystemManager . OnEntityRemoved ( Source );
+	m_QueryManager . OnEntityRemoved ( Source );
 	m_EntityManager . RemoveEntity ( entityHandle );
+	destination . OnEntitySignatureChanged ( Target );
+	if ( m_Recorder )
+		m_Recorder -> RecordRemoveEntity ( entityHandle );
+	if ( destination . m_Recorder )
+	{
+		for ( const auto & info : Target . GetComponentsInfo () ) {
+			destination . m_Recorder -> RecordAddComponent ( Handle, info . Type, destination . m_ComponentManager . GetComponentBytes ( Target, info . Type ) );
+		}
+	}
+	AutoCompact ();
+	return Handle;
+}
+
+void ECS::DestroyEntities ( std::span <const EntityHandle> entityHandles )
+{
+	RemoveEntities ( entityHandles );
+	AutoCompact ();
+}
+
+void ECS::DestroyDeferred ( EntityHandle entityHandle )
+{
+	m_DeferredDestroys . push_back ( entityHandle );
+}
+
+std::size_t ECS::ProcessDeferredDestroys ( std::chrono::microseconds budget )
+{
+	const auto Start = std::chrono::steady_clock::now ();
+	std::size_t Destroyed = 0;
+	while ( m_DeferredDestroysCursor < m_DeferredDestroys . size () )
+	{
+		const auto BatchBegin = m_DeferredDestroys . begin () + ( std::ptrdiff_t ) m_DeferredDestroysCursor;
+		const auto BatchSize = std::min ( DeferredDestroyBatchSize, m_DeferredDestroys . size () - m_DeferredDestroysCursor );
+		m_DestroyBatch . assign ( BatchBegin, BatchBegin + ( std::ptrdiff_t ) BatchSize );
+		m_DeferredDestroysCursor += BatchSize;
+
+		std::sort ( m_DestroyBatch . begin (), m_DestroyBatch . end () );
+		m_DestroyBatch . erase ( std::unique ( m_DestroyBatch . begin (), m_DestroyBatch . end () ), m_DestroyBatch . end () );
+		std::erase_if ( m_DestroyBatch, [ this ] ( EntityHandle handle ) { return ! GetIsValidEntityHandle ( handle ); } );
+
+		RemoveEntities ( m_DestroyBatch );
+		Destroyed += m_DestroyBatch . size ();
+
+		if ( budget > std::chrono::microseconds::zero () && std::chrono::steady_clock::now () - Start >= budget )
+			break;
+	}
+	m_DestroyBatch . clear ();
+
+	// The consumed handles are dropped once the cursor passes the half of the queue, so each handle is moved O(1) times
+	if ( m_DeferredDestroysCursor == m_DeferredDestroys . size () )
+	{
+		m_DeferredDestroys . clear ();
+		m_DeferredDestroysCursor = 0;
+	}
+	else if ( m_DeferredDestroysCursor * 2 >= m_DeferredDestroys . size () )
+	{
+		m_DeferredDestroys . erase ( m_DeferredDestroys . begin (), m_DeferredDestroys . begin () + ( std::ptrdiff_t ) m_DeferredDestroysCursor );
+		m_DeferredDestroysCursor = 0;
+	}
+	if ( Destroyed > 0 )
+		AutoCompact ();
+	return Destroyed;
+}
+
+std::size_t ECS::GetDeferredDestroysCount () const
+{
+	return m_DeferredDestroys . size () - m_DeferredDestroysCursor;
+}
+
+std::size_t ECS::GetEntitiesCount () const
+{
+	return m_EntityManager . Size ();
+}
+
+void ECS::Compact ()
+{
+	Compact ( 1.f );
+}
+
+void ECS::SetAutoCompactOccupancy ( float occupancy )
+{
+	m_AutoCompactOccupancy = occupancy;
+}
+
+void ECS::RunSystems ()
+{
+	SyncSpatialIndices ();
+	m_SystemManager . RunSystems ( * this );
+	if ( m_Recorder )
+		m_Recorder -> RecordEndFrame ();
+}
+
+void ECS::RegisterComponent ( ComponentType componentType, std::shared_ptr <IObjectManager> components )
+{
+	m_ComponentManager . RegisterComponent ( componentType, std::move ( components ) );
+}
+
+void ECS::AttachComponent ( EntityHandle entityHandle, ComponentType componentType, ComponentHandle componentHandle )
+{
+	Entity & e = GetEntity ( entityHandle );
+	m_ComponentManager . AttachComponent ( e, componentType, componentHandle );
+	if ( m_Recorder )
+		m_Recorder -> RecordAddComponent ( entityHandle, componentType, m_ComponentManager . GetComponentBytes ( e, componentType ) );
+	OnEntitySignatureChanged ( e );
+}
+
+void ECS::RemoveComponent ( EntityHandle entityHandle, ComponentType componentType )
+{
+	Entity & e = GetEntity ( entityHandle );
+	m_ComponentManager . RemoveComponent ( e, componentType );
+	if ( m_Recorder )
+		m_Recorder -> RecordRemoveComponent ( entityHandle, componentType );
+	OnEntitySignatureChanged ( e );
+}
+
+void ECS::SyncSpatialIndices ()
+{
+	if ( m_SpatialIndices . empty () )
+		return;
+	const auto Pool = GetThreadPool ();
+	for ( auto & Index : m_SpatialIndices ) {
+		Index -> Sync ( Pool . get () );
+	}
+}
+
+void ECS::StartTask ( Task && task )
+{
+	m_TaskScheduler . Start ( std::move ( task ) );
+}
+
+void ECS::UpdateTasks ( double deltaSeconds )
+{
+	m_TaskScheduler . Update ( deltaSeconds );
+}
+
+std::size_t ECS::GetTasksCount () const
+{
+	return m_TaskScheduler . GetTasksCount ();
+}
+
+void ECS::SetThreadPool ( std::shared_ptr <ThreadPool> threadPool )
+{
+	m_TaskScheduler . SetThreadPool ( std::move ( threadPool ) );
+}
+
+std::shared_ptr <ThreadPool> ECS::GetThreadPool ()
+{
+	return m_TaskScheduler . GetThreadPool ();
+}
+
+void ECS::SetRecorder ( std::shared_ptr <ECSRecorder> recorder )
+{
+	m_Recorder = std::move ( recorder );
+}
+
+std::shared_ptr <ECSRecorder> ECS::GetRecorder () const
+{
+	return m_Recorder;
 }
 
 Entity & ECS::GetEntity ( EntityHandle entityHandle )
@@ -35,4 +231,56 @@ bool ECS::RemoveEntityChecked ( EntityHandle entityHandle )
 		return false;
 	RemoveEntity ( entityHandle );
 	return true;
+}
+
+void ECS::OnEntitySignatureChanged ( Entity & entity )
+{
+	const Signature EntitySignature = entity . GetSignature ();
+	m_SystemManager . OnEntitySignatureChanged ( entity, EntitySignature );
+	m_QueryManager . OnEntitySignatureChanged ( entity, EntitySignature );
+}
+
+void ECS::Compact ( float occupancy )
+{
+	m_ComponentManager . ShrinkToFit ( occupancy );
+	m_EntityManager . ShrinkToFit ();
+	m_SystemManager . ShrinkToFit ();
+	m_QueryManager . ShrinkToFit ();
+	m_DeferredDestroys . shrink_to_fit ();
+	m_DestroyBatch . shrink_to_fit ();
+	m_DestroyedEntities . shrink_to_fit ();
+	m_MaterializedEntities . shrink_to_fit ();
+}
+
+void ECS::RemoveEntities ( std::span <const EntityHandle> entityHandles )
+{
+	// The handles are resolved first, so an invalid one throws before anything is recorded or removed
+	m_DestroyedEntities . clear ();
+	m_DestroyedEntities . reserve ( entityHandles . size () );
+	for ( const auto Handle : entityHandles ) {
+		m_DestroyedEntities . push_back ( & m_EntityManager . GetEntity ( Handle ) );
+	}
+	if ( m_Recorder )
+		m_Recorder -> RecordDestroyEntities ( entityHandles );
+	m_ComponentManager . OnEntitiesRemoved ( m_DestroyedEntities );
+	m_SystemManager . OnEntitiesRemoved ( entityHandles );
+	m_QueryManager . OnEntitiesRemoved ( entityHandles );
+	m_EntityManager . RemoveEntities ( entityHandles );
+	m_DestroyedEntities . clear ();
+}
+
+void ECS::AutoCompact ()
+{
+	if ( m_AutoCompactOccupancy <= 0.f )
+		return;
+	if ( ( float ) m_EntityManager . Size () < m_AutoCompactOccupancy * ( float ) m_EntityManager . Capacity () )
+		Compact ( m_AutoCompactOccupancy );
+}
+
+void ECS::PopulateIndex ( ComponentType componentType, IComponentIndex & index )
+{
+	for ( Entity & e : m_EntityManager ) {
+		if ( const auto ComponentHandle = e . GetComponentHandleChecked ( componentType ) )
+			index . Insert ( e . GetHandle (), * ComponentHandle );
+	}
 }
\ No newline at end of file
@@ -0,0 +1,126 @@
+#include "Laniakea/ECS/ECSRecorder.h"
+
+ECSRecorder::ECSRecorder ( std::ostream & stream, std::size_t bufferSize )
+: m_Stream ( stream ), m_BufferSize ( bufferSize )
+{
+	m_Buffer . reserve ( m_BufferSize + 64 );
+	const std::uint32_t Header[] = { Magic, Version };
+	WriteBytes ( std::as_bytes ( std::span ( Header ) ) );
+}
+
+ECSRecorder::~ECSRecorder ()
+{
+	Flush ();
+}
+
+void ECSRecorder::RecordRegisterComponent ( ComponentType componentType, std::size_t size, std::string_view name )
+{
+	GetTypeIndex ( componentType, size, name );
+}
+
+void ECSRecorder::RecordCreateEntity ( EntityHandle entityHandle )
+{
+	WriteOperation ( RecordedOperation::CreateEntity );
+	WriteVarint ( entityHandle );
+}
+
+void ECSRecorder::RecordRemoveEntity ( EntityHandle entityHandle )
+{
+	WriteOperation ( RecordedOperation::RemoveEntity );
+	WriteVarint ( entityHandle );
+}
+
+void ECSRecorder::RecordDestroyEntities ( std::span <const EntityHandle> entityHandles )
+{
+	WriteOperation ( RecordedOperation::DestroyEntities );
+	WriteVarint ( entityHandles . size () );
+	for ( const auto Handle : entityHandles ) {
+		WriteVarint ( Handle );
+	}
+}
+
+void ECSRecorder::RecordAddComponent ( EntityHandle entityHandle, ComponentType componentType, std::span <const std::byte> payload )
+{
+	const auto TypeIndex = GetTypeIndex ( componentType, payload . size (), {} );
+	WriteOperation ( RecordedOperation::AddComponent );
+	WriteVarint ( entityHandle );
+	WriteVarint ( TypeIndex );
+	WriteVarint ( payload . size () );
+	WriteBytes ( payload );
+}
+
+void ECSRecorder::RecordRemoveComponent ( EntityHandle entityHandle, ComponentType componentType )
+{
+	const auto It = m_TypeIndices . find ( componentType );
+	if ( It == m_TypeIndices . end () )
+		return;
+	WriteOperation ( RecordedOperation::RemoveComponent );
+	WriteVarint ( entityHandle );
+	WriteVarint ( It -> second );
+}
+
+void ECSRecorder::RecordEndFrame ()
+{
+	WriteOperation ( RecordedOperation::EndFrame );
+	m_FramesCount ++;
+}
+
+void ECSRecorder::Flush ()
+{
+	WriteBuffer ();
+	m_Stream . flush ();
+}
+
+std::size_t ECSRecorder::GetRecordedBytesCount () const
+{
+	return m_WrittenBytesCount + m_Buffer . size ();
+}
+
+std::size_t ECSRecorder::GetFramesCount () const
+{
+	return m_FramesCount;
+}
+
+std::uint32_t ECSRecorder::GetTypeIndex ( ComponentType componentType, std::size_t size, std::string_view name )
+{
+	const auto [ It, IsInserted ] = m_TypeIndices . try_emplace ( componentType, ( std::uint32_t ) m_TypeIndices . size () );
+	if ( ! IsInserted )
+		return It -> second;
+	WriteOperation ( RecordedOperation::RegisterComponent );
+	WriteVarint ( It -> second );
+	WriteVarint ( componentType );
+	WriteVarint ( size );
+	WriteVarint ( name . size () );
+	WriteBytes ( std::as_bytes ( std::span ( name ) ) );
+	return It -> second;
+}
+
+void ECSRecorder::WriteOperation ( RecordedOperation operation )
+{
+	// The previous record is complete, so the buffer is written out on the record boundary
+	if ( m_Buffer . size () >= m_BufferSize )
+		WriteBuffer ();
+	m_Buffer . push_back ( static_cast <std::byte> ( operation ) );
+}
+
+void ECSRecorder::WriteBuffer ()
+{
+	m_Stream . write ( reinterpret_cast <const char *> ( m_Buffer . data () ), ( std::streamsize ) m_Buffer . size () );
+	m_WrittenBytesCount += m_Buffer . size ();
+	m_Buffer . clear ();
+}
+
+void ECSRecorder::WriteVarint ( std::uint64_t value )
+{
+	while ( value >= 0x80 )
+	{
+		m_Buffer . push_back ( static_cast <std::byte> ( ( value & 0x7F ) | 0x80 ) );
+		value >>= 7;
+	}
+	m_Buffer . push_back ( static_cast <std::byte> ( value ) );
+}
+
+void ECSRecorder::WriteBytes ( std::span <const std::byte> bytes )
+{
+	m_Buffer . insert ( m_Buffer . end (), bytes . begin (), bytes . end () );
+}
\ No newline at end of file
@@ -0,0 +1,263 @@
+#include "Laniakea/ECS/ECSReplayer.h"
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <iterator>
+
+namespace
+{
+	/**
+     * @brief Opaque stand-in of the recorded component with the size rounded up to the size class.
+     */
+	template <std::size_t Size>
+	struct ReplayComponent
+	{
+		std::array <std::byte, Size> Bytes;
+	};
+
+	/**
+     * @brief Opaque stand-in of the recorded component too large for the size classes.
+     */
+	struct LargeReplayComponent
+	{
+		std::vector <std::byte> Bytes;
+	};
+
+	template <std::size_t Size>
+	ComponentHandle AddReplayComponent ( IObjectManager & components, std::span <const std::byte> payload )
+	{
+		ReplayComponent <Size> Component {};
+		std::memcpy ( Component . Bytes . data (), payload . data (), std::min ( Size, payload . size () ) );
+		return static_cast <ObjectManager <ReplayComponent <Size>> &> ( components ) . AddObject ( std::move ( Component ) );
+	}
+
+	ComponentHandle AddLargeReplayComponent ( IObjectManager & components, std::span <const std::byte> payload )
+	{
+		return static_cast <ObjectManager <LargeReplayComponent> &> ( components ) . AddObject ( { { payload . begin (), payload . end () } } );
+	}
+
+	constexpr std::size_t MaxReplayComponentSize = 1024; /**< The largest size class, larger components keep the payload on the heap. */
+
+	/**
+     * @brief Creates the component array of the smallest size class fitting the recorded component.
+     */
+	template <std::size_t Size = 8>
+	void BindReplayComponent ( std::size_t size, std::shared_ptr <IObjectManager> & components,
+							   ComponentHandle ( * & add ) ( IObjectManager &, std::span <const std::byte> ) )
+	{
+		if constexpr ( Size > MaxReplayComponentSize )
+		{
+			components = std::make_shared <ObjectManager <LargeReplayComponent>> ();
+			add = & AddLargeReplayComponent;
+		}
+		else if ( size > Size )
+		{
+			BindReplayComponent <Size * 2> ( size, components, add );
+		}
+		else
+		{
+			components = std::make_shared <ObjectManager <ReplayComponent <Size>>> ();
+			add = & AddReplayComponent <Size>;
+		}
+	}
+}
+
+ECSReplayer::ECSReplayer ( std::istream & stream )
+{
+	stream . seekg ( 0, std::ios::end );
+	const auto Size = stream . tellg ();
+	stream . seekg ( 0, std::ios::beg );
+	if ( Size <= 0 )
+		return;
+	m_Log . resize ( ( std::size_t ) Size );
+	stream . read ( reinterpret_cast <char *> ( m_Log . data () ), Size );
+
+	std::uint32_t Header[ 2 ] = {};
+	if ( ! stream || m_Log . size () < sizeof ( Header ) )
+		return;
+	std::memcpy ( Header, m_Log . data (), sizeof ( Header ) );
+	m_Cursor = sizeof ( Header );
+	m_IsValid = Header[ 0 ] == ECSRecorder::Magic && Header[ 1 ] == ECSRecorder::Version;
+}
+
+bool ECSReplayer::GetIsValid () const
+{
+	return m_IsValid;
+}
+
+bool ECSReplayer::ReplayFrame ( ECS & ecs )
+{
+	if ( ! DecodeFrame () )
+		return false;
+
+	const auto Start = std::chrono::steady_clock::now ();
+	for ( const auto & Operation : m_Operations ) {
+		Apply ( ecs, Operation );
+	}
+	m_LastFrameTime = std::chrono::duration_cast <std::chrono::nanoseconds> ( std::chrono::steady_clock::now () - Start );
+	m_FramesCount ++;
+	return true;
+}
+
+std::chrono::nanoseconds ECSReplayer::GetLastFrameTime () const
+{
+	return m_LastFrameTime;
+}
+
+std::size_t ECSReplayer::GetLastOperationsCount () const
+{
+	return m_Operations . size ();
+}
+
+std::size_t ECSReplayer::GetFramesCount () const
+{
+	return m_FramesCount;
+}
+
+std::size_t ECSReplayer::GetComponentTypesCount () const
+{
+	return m_Bindings . size ();
+}
+
+const std::string & ECSReplayer::GetComponentTypeName ( std::size_t typeIndex ) const
+{
+	return m_Bindings[ typeIndex ] . Name;
+}
+
+bool ECSReplayer::DecodeFrame ()
+{
+	m_Operations . clear ();
+	m_BatchHandles . clear ();
+	if ( ! m_IsValid || m_Cursor >= m_Log . size () )
+		return false;
+
+	while ( m_IsValid && m_Cursor < m_Log . size () )
+	{
+		Operation Decoded { static_cast <RecordedOperation> ( m_Log[ m_Cursor ++ ] ) };
+		switch ( Decoded . Code )
+		{
+			case RecordedOperation::RegisterComponent:
+			{
+				Decoded . TypeIndex = ( std::uint32_t ) ReadVarint ();
+				ComponentBinding Binding;
+				Binding . Type = ReadVarint ();
+				Binding . Size = ReadVarint ();
+				const auto NameSize = ReadVarint ();
+				if ( NameSize > m_Log . size () - m_Cursor || Decoded . TypeIndex != m_Bindings . size () )
+				{
+					m_IsValid = false;
+					break;
+				}
+				Binding . Name . assign ( reinterpret_cast <const char *> ( m_Log . data () + m_Cursor ), NameSize );
+				m_Cursor += NameSize;
+				m_Bindings . push_back ( std::move ( Binding ) );
+				break;
+			}
+			case RecordedOperation::CreateEntity:
+			case RecordedOperation::RemoveEntity:
+				Decoded . Entity = ReadVarint ();
+				break;
+			case RecordedOperation::DestroyEntities:
+			{
+				Decoded . Count = ReadVarint ();
+				Decoded . Offset = m_BatchHandles . size ();
+				for ( std::size_t i = 0; i < Decoded . Count && m_IsValid; i ++ ) {
+					m_BatchHandles . push_back ( ReadVarint () );
+				}
+				break;
+			}
+			case RecordedOperation::AddComponent:
+				Decoded . Entity = ReadVarint ();
+				Decoded . TypeIndex = ( std::uint32_t ) ReadVarint ();
+				Decoded . Count = ReadVarint ();
+				Decoded . Offset = m_Cursor;
+				if ( Decoded . Count > m_Log . size () - m_Cursor || Decoded . TypeIndex >= m_Bindings . size () )
+					m_IsValid = false;
+				m_Cursor += Decoded . Count;
+				break;
+			case RecordedOperation::RemoveComponent:
+				Decoded . Entity = ReadVarint ();
+				Decoded . TypeIndex = ( std::uint32_t ) ReadVarint ();
+				if ( Decoded . TypeIndex >= m_Bindings . size () )
+					m_IsValid = false;
+				break;
+			case RecordedOperation::EndFrame:
+				return true;
+			default:
+				m_IsValid = false;
+				break;
+		}
+		if ( m_IsValid )
+			m_Operations . push_back ( Decoded );
+	}
+	// The last frame may be left open when the recording stops between RunSystems calls
+	return m_IsValid;
+}
+
+void ECSReplayer::Apply ( ECS & ecs, const Operation & operation )
+{
+	switch ( operation . Code )
+	{
+		case RecordedOperation::RegisterComponent:
+		{
+			auto & Binding = m_Bindings[ operation . TypeIndex ];
+			BindReplayComponent ( Binding . Size, Binding . Components, Binding . Add );
+			ecs . RegisterComponent ( Binding . Type, Binding . Components );
+			break;
+		}
+		case RecordedOperation::CreateEntity:
+			m_Entities[ operation . Entity ] = ecs . CreateEntity ();
+			break;
+		case RecordedOperation::RemoveEntity:
+			ecs . RemoveEntity ( MapEntity ( ecs, operation . Entity ) );
+			m_Entities . erase ( operation . Entity );
+			break;
+		case RecordedOperation::DestroyEntities:
+		{
+			m_Batch . clear ();
+			for ( std::size_t i = 0; i < operation . Count; i ++ ) {
+				const auto Recorded = m_BatchHandles[ operation . Offset + i ];
+				m_Batch . push_back ( MapEntity ( ecs, Recorded ) );
+				m_Entities . erase ( Recorded );
+			}
+			ecs . DestroyEntities ( m_Batch );
+			break;
+		}
+		case RecordedOperation::AddComponent:
+		{
+			const auto & Binding = m_Bindings[ operation . TypeIndex ];
+			const auto Entity = MapEntity ( ecs, operation . Entity );
+			const auto Handle = Binding . Add ( * Binding . Components, { m_Log . data () + operation . Offset, operation . Count } );
+			ecs . AttachComponent ( Entity, Binding . Type, Handle );
+			break;
+		}
+		case RecordedOperation::RemoveComponent:
+			ecs . RemoveComponent ( MapEntity ( ecs, operation . Entity ), m_Bindings[ operation . TypeIndex ] . Type );
+			break;
+		default:
+			break;
+	}
+}
+
+EntityHandle ECSReplayer::MapEntity ( ECS & ecs, EntityHandle recordedHandle )
+{
+	const auto [ It, IsInserted ] = m_Entities . try_emplace ( recordedHandle, NULL_HANDLE );
+	if ( IsInserted )
+		It -> second = ecs . CreateEntity ();
+	return It -> second;
+}
+
+std::uint64_t ECSReplayer::ReadVarint ()
+{
+	std::uint64_t Value = 0;
+	for ( std::uint32_t Shift = 0; Shift < 64; Shift += 7 ) {
+		if ( m_Cursor >= m_Log . size () )
+			break;
+		const auto Byte = std::to_integer <std::uint64_t> ( m_Log[ m_Cursor ++ ] );
+		Value |= ( Byte & 0x7F ) << Shift;
+		if ( ( Byte & 0x80 ) == 0 )
+			return Value;
+	}
+	m_IsValid = false;
+	return 0;
+}
\ No newline at end of file
@@ -48,7 +48,8 @@ Signature Entity::GetSignature () const
 
 std::optional <ComponentHandle> Entity::GetComponentHandleChecked ( ComponentType type ) const
 {
-	if (!GetHasComponent(type))
+	const auto It = m_Components.find({type, NULL_HANDLE});
+	if (It == m_Components.end())
 		return std::nullopt;
-	return GetComponentHandle(type);
+	return It->Handle;
 }
\ No newline at end of file
@@ -0,0 +1,23 @@
+#include "Laniakea/ECS/EntityCommandBuffer.h"
+
+void EntityCommandBuffer::RemoveEntity ( EntityHandle entityHandle )
+{
+	m_Commands . emplace_back ( [ entityHandle ] ( ECS & ecs )
+	{
+		ecs . RemoveEntity ( entityHandle );
+	} );
+}
+
+void EntityCommandBuffer::Execute ( ECS & ecs )
+{
+	ecs . MaterializeReservedEntities ();
+	for ( auto & Command : m_Commands ) {
+		Command ( ecs );
+	}
+	m_Commands . clear ();
+}
+
+std::size_t EntityCommandBuffer::Size () const
+{
+	return m_Commands . size ();
+}
\ No newline at end of file
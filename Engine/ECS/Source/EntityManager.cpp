@@ -1,14 +1,72 @@
 #include "Laniakea/ECS/EntityManager.h"
+#include <algorithm>
 
 EntityHandle EntityManager::CreateEntity ()
 {
-	Entity e ( m_Entities . GetNextHandle () );
-	return m_Entities . AddObject ( e );
+	EntityHandle Handle;
+	if ( ! m_PendingRecycledHandles . empty () )
+	{
+		Handle = m_PendingRecycledHandles . back ();
+		m_PendingRecycledHandles . pop_back ();
+	}
+	else
+	{
+		Handle = ReserveEntity ();
+	}
+	Materialize ( Handle );
+	return Handle;
+}
+
+EntityHandle EntityManager::ReserveEntity ()
+{
+	const auto Cursor = m_RecycledCursor . fetch_add ( 1, std::memory_order_relaxed );
+	if ( Cursor < m_RecycledHandles . size () )
+		return m_RecycledHandles[ Cursor ];
+	return MakeEntityHandle ( m_NextSlot . fetch_add ( 1, std::memory_order_relaxed ), 0 );
+}
+
+std::size_t EntityManager::MaterializeReservedEntities ( std::vector <EntityHandle> * materializedHandles )
+{
+	std::size_t Materialized = 0;
+
+	// Released handles taken by the reservation
+	const auto Consumed = std::min ( m_RecycledCursor . load ( std::memory_order_acquire ), m_RecycledHandles . size () );
+	for ( std::size_t i = 0; i < Consumed; i ++ ) {
+		Materialized += MaterializeIfPending ( m_RecycledHandles[ i ], materializedHandles );
+	}
+
+	// Fresh slots taken by the reservation
+	const auto NextSlot = m_NextSlot . load ( std::memory_order_acquire );
+	for ( std::size_t Slot = m_MaterializedSlots; Slot < NextSlot; Slot ++ ) {
+		Materialized += MaterializeIfPending ( MakeEntityHandle ( Slot, 0 ), materializedHandles );
+	}
+	m_MaterializedSlots = NextSlot;
+
+	// Publish handles released since the previous sync point
+	m_RecycledHandles . erase ( m_RecycledHandles . begin (), m_RecycledHandles . begin () + ( std::ptrdiff_t ) Consumed );
+	m_RecycledHandles . insert ( m_RecycledHandles . end (), m_PendingRecycledHandles . begin (), m_PendingRecycledHandles . end () );
+	m_PendingRecycledHandles . clear ();
+	m_RecycledCursor . store ( 0, std::memory_order_release );
+	return Materialized;
 }
 
 void EntityManager::RemoveEntity ( EntityHandle entityHandle )
 {
-	m_Entities . RemoveObject ( entityHandle );
+	m_Entities . EraseObject ( entityHandle );
+	const auto Slot = GetEntitySlot ( entityHandle );
+	const auto Generation = ++ m_Generations[ Slot ];
+	m_PendingRecycledHandles . push_back ( MakeEntityHandle ( Slot, Generation ) );
+}
+
+void EntityManager::RemoveEntities ( std::span <const EntityHandle> entityHandles )
+{
+	m_Entities . EraseObjects ( entityHandles );
+	m_PendingRecycledHandles . reserve ( m_PendingRecycledHandles . size () + entityHandles . size () );
+	for ( const auto Handle : entityHandles ) {
+		const auto Slot = GetEntitySlot ( Handle );
+		const auto Generation = ++ m_Generations[ Slot ];
+		m_PendingRecycledHandles . push_back ( MakeEntityHandle ( Slot, Generation ) );
+	}
 }
 
 Entity & EntityManager::GetEntity ( EntityHandle entityHandle )
@@ -18,7 +76,31 @@ Entity & EntityManager::GetEntity ( EntityHandle entityHandle )
 
 void EntityManager::RemoveAllEntities ()
 {
-	m_Entities . Clear ();
+	std::vector <EntityHandle> Handles;
+	Handles . reserve ( m_Entities . Size () );
+	for ( const Entity & e : m_Entities ) {
+		Handles . push_back ( e . GetHandle () );
+	}
+	for ( const auto Handle : Handles ) {
+		RemoveEntity ( Handle );
+	}
+}
+
+void EntityManager::ShrinkToFit ()
+{
+	m_Entities . ShrinkToFit ();
+	m_RecycledHandles . shrink_to_fit ();
+	m_PendingRecycledHandles . shrink_to_fit ();
+}
+
+std::size_t EntityManager::Size () const
+{
+	return m_Entities . Size ();
+}
+
+std::size_t EntityManager::Capacity () const
+{
+	return m_Entities . Capacity ();
 }
 
 bool EntityManager::GetIsValidEntityHandle ( EntityHandle entityHandle ) const
@@ -26,6 +108,16 @@ bool EntityManager::GetIsValidEntityHandle ( EntityHandle entityHandle ) const
 	return m_Entities . GetIsValidHandle ( entityHandle );
 }
 
+std::vector <Entity>::iterator EntityManager::begin ()
+{
+	return m_Entities . begin ();
+}
+
+std::vector <Entity>::iterator EntityManager::end ()
+{
+	return m_Entities . end ();
+}
+
 std::optional <std::reference_wrapper <Entity>> EntityManager::GetEntityChecked ( EntityHandle entityHandle )
 {
 	return m_Entities . GetObjectChecked ( entityHandle );
@@ -33,5 +125,45 @@ std::optional <std::reference_wrapper <Entity>> EntityManager::GetEntityChecked
 
 bool EntityManager::RemoveEntityChecked ( EntityHandle entityHandle )
 {
-	return m_Entities . RemoveObjectChecked ( entityHandle );
+	if ( ! GetIsValidEntityHandle ( entityHandle ) )
+		return false;
+	RemoveEntity ( entityHandle );
+	return true;
+}
+
+EntityHandle EntityManager::MakeEntityHandle ( std::size_t slot, std::size_t generation )
+{
+	return ( generation << SlotBits ) | slot;
+}
+
+std::size_t EntityManager::GetEntitySlot ( EntityHandle entityHandle )
+{
+	return entityHandle & ( ( std::size_t ( 1 ) << SlotBits ) - 1 );
+}
+
+std::size_t EntityManager::GetEntityGeneration ( EntityHandle entityHandle )
+{
+	return entityHandle >> SlotBits;
+}
+
+void EntityManager::Materialize ( EntityHandle entityHandle )
+{
+	const auto Slot = GetEntitySlot ( entityHandle );
+	if ( Slot >= m_Generations . size () )
+		m_Generations . resize ( Slot + 1, 0 );
+	m_Entities . InsertObject ( entityHandle, Entity ( entityHandle ) );
+}
+
+bool EntityManager::MaterializeIfPending ( EntityHandle entityHandle, std::vector <EntityHandle> * materializedHandles )
+{
+	if ( m_Entities . GetIsValidHandle ( entityHandle ) )
+		return false;
+	const auto Slot = GetEntitySlot ( entityHandle );
+	const auto CurrentGeneration = Slot < m_Generations . size () ? m_Generations[ Slot ] : 0;
+	if ( GetEntityGeneration ( entityHandle ) != CurrentGeneration )
+		return false;
+	Materialize ( entityHandle );
+	if ( materializedHandles )
+		materializedHandles -> push_back ( entityHandle );
+	return true;
 }
\ No newline at end of file
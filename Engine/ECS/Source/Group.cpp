@@ -0,0 +1 @@
+#include "Laniakea/ECS/Group.h"
\ No newline at end of file
@@ -0,0 +1,117 @@
+#include "Laniakea/ECS/Query.h"
+#include "Laniakea/ECS/EntityManager.h"
+
+QueryState::QueryState ( QueryFilter filter )
+: m_Filter ( std::move ( filter ) )
+{
+
+}
+
+void QueryState::OnEntitySignatureChanged ( Entity & entity, const Signature & signature )
+{
+	const auto EntityHandle = entity . GetHandle ();
+	const bool Contains = m_EntitiesHandles . count ( EntityHandle ) != 0;
+	if ( m_Filter . GetIsMatching ( signature ) )
+	{
+		if ( ! Contains )
+			m_EntitiesHandles[ EntityHandle ] = m_Entities . AddObject ( EntityHandle );
+	}
+	else if ( Contains )
+	{
+		OnEntityRemoved ( entity );
+	}
+}
+
+void QueryState::OnEntityRemoved ( Entity & entity )
+{
+	const auto It = m_EntitiesHandles . find ( entity . GetHandle () );
+	if ( It == m_EntitiesHandles . end () )
+		return;
+	m_Entities . RemoveObject ( It -> second );
+	m_EntitiesHandles . erase ( It );
+}
+
+void QueryState::OnEntitiesRemoved ( std::span <const EntityHandle> entityHandles )
+{
+	for ( const auto Handle : entityHandles ) {
+		const auto It = m_EntitiesHandles . find ( Handle );
+		if ( It == m_EntitiesHandles . end () )
+			continue;
+		m_Entities . RemoveObject ( It -> second );
+		m_EntitiesHandles . erase ( It );
+	}
+}
+
+void QueryState::ShrinkToFit ()
+{
+	m_Entities . ShrinkToFit ();
+	m_EntitiesHandles . rehash ( 0 );
+}
+
+const QueryFilter & QueryState::GetFilter () const
+{
+	return m_Filter;
+}
+
+std::size_t QueryState::Size () const
+{
+	return m_Entities . Size ();
+}
+
+std::vector <EntityHandle>::const_iterator QueryState::begin () const
+{
+	return m_Entities . begin ();
+}
+
+std::vector <EntityHandle>::const_iterator QueryState::end () const
+{
+	return m_Entities . end ();
+}
+
+std::shared_ptr <QueryState> QueryManager::GetOrCreateQuery ( QueryFilter && filter, EntityManager & entityManager )
+{
+	const auto It = m_Queries . find ( filter );
+	if ( It != m_Queries . end () )
+		return It -> second;
+
+	auto State = std::make_shared <QueryState> ( filter );
+	for ( Entity & e : entityManager ) {
+		if ( filter . GetIsMatching ( e ) )
+			State -> OnEntitySignatureChanged ( e, e . GetSignature () );
+	}
+	m_Queries . emplace ( std::move ( filter ), State );
+	return State;
+}
+
+void QueryManager::OnEntitySignatureChanged ( Entity & entity, const Signature & signature )
+{
+	for ( auto & Query : m_Queries ) {
+		Query . second -> OnEntitySignatureChanged ( entity, signature );
+	}
+}
+
+void QueryManager::OnEntityRemoved ( Entity & entity )
+{
+	for ( auto & Query : m_Queries ) {
+		Query . second -> OnEntityRemoved ( entity );
+	}
+}
+
+void QueryManager::OnEntitiesRemoved ( std::span <const EntityHandle> entityHandles )
+{
+	for ( auto & Query : m_Queries ) {
+		Query . second -> OnEntitiesRemoved ( entityHandles );
+	}
+}
+
+void QueryManager::ShrinkToFit ()
+{
+	for ( auto & Query : m_Queries ) {
+		Query . second -> ShrinkToFit ();
+	}
+}
+
+std::size_t QueryManager::GetQueriesCount () const
+{
+	return m_Queries . size ();
+}
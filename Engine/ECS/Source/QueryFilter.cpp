@@ -0,0 +1,52 @@
+#include "Laniakea/ECS/QueryFilter.h"
+#include <algorithm>
+
+QueryFilter::QueryFilter ( Signature include, Signature exclude )
+: m_Include ( std::move ( include ) ), m_Exclude ( std::move ( exclude ) )
+{
+
+}
+
+bool QueryFilter::GetIsMatching ( const Signature & signature ) const
+{
+	if ( ! std::includes ( signature . begin (), signature . end (), m_Include . begin (), m_Include . end () ) )
+		return false;
+	for ( const auto Type : m_Exclude ) {
+		if ( signature . count ( Type ) != 0 )
+			return false;
+	}
+	return true;
+}
+
+bool QueryFilter::GetIsMatching ( const Entity & entity ) const
+{
+	for ( const auto Type : m_Include ) {
+		if ( ! entity . GetHasComponent ( Type ) )
+			return false;
+	}
+	for ( const auto Type : m_Exclude ) {
+		if ( entity . GetHasComponent ( Type ) )
+			return false;
+	}
+	return true;
+}
+
+const Signature & QueryFilter::GetInclude () const
+{
+	return m_Include;
+}
+
+const Signature & QueryFilter::GetExclude () const
+{
+	return m_Exclude;
+}
+
+bool QueryFilter::operator < ( const QueryFilter & rhs ) const
+{
+	return std::tie ( m_Include, m_Exclude ) < std::tie ( rhs . m_Include, rhs . m_Exclude );
+}
+
+bool QueryFilter::operator == ( const QueryFilter & rhs ) const
+{
+	return m_Include == rhs . m_Include && m_Exclude == rhs . m_Exclude;
+}
@@ -0,0 +1,708 @@
+#include "Laniakea/ECS/SpatialPartition.h"
+#include "Laniakea/ECS/ThreadPool.h"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cmath>
+#include <mutex>
+
+namespace
+{
+	constexpr std::size_t SpatialGrainSize = 4096;
+	constexpr std::size_t OctreeSplitDepth = 2; /**< The depth of the octree nodes whose subtrees are built in parallel. */
+
+	void ParallelRange ( ThreadPool * threadPool, std::size_t count, const std::function <void ( std::size_t, std::size_t )> & func )
+	{
+		if ( threadPool == nullptr || count <= SpatialGrainSize )
+		{
+			func ( 0, count );
+			return;
+		}
+		threadPool -> ParallelFor ( count, SpatialGrainSize, func );
+	}
+
+	float DistanceSquared ( const SpatialPoint & lhs, const SpatialPoint & rhs )
+	{
+		const float X = lhs . X - rhs . X;
+		const float Y = lhs . Y - rhs . Y;
+		const float Z = lhs . Z - rhs . Z;
+		return X * X + Y * Y + Z * Z;
+	}
+
+	float DistanceSquared ( const SpatialPoint & point, const SpatialBounds & bounds )
+	{
+		const float X = std::max ( { bounds . Min . X - point . X, 0.f, point . X - bounds . Max . X } );
+		const float Y = std::max ( { bounds . Min . Y - point . Y, 0.f, point . Y - bounds . Max . Y } );
+		const float Z = std::max ( { bounds . Min . Z - point . Z, 0.f, point . Z - bounds . Max . Z } );
+		return X * X + Y * Y + Z * Z;
+	}
+
+	bool GetIsOverlapping ( const SpatialBounds & lhs, const SpatialBounds & rhs )
+	{
+		return lhs . Min . X <= rhs . Max . X && rhs . Min . X <= lhs . Max . X
+			&& lhs . Min . Y <= rhs . Max . Y && rhs . Min . Y <= lhs . Max . Y
+			&& lhs . Min . Z <= rhs . Max . Z && rhs . Min . Z <= lhs . Max . Z;
+	}
+
+	SpatialBounds GetEmptyBounds ()
+	{
+		constexpr float Max = std::numeric_limits <float>::max ();
+		return { { Max, Max, Max }, { - Max, - Max, - Max } };
+	}
+
+	void Enclose ( SpatialBounds & bounds, const SpatialPoint & point, float radius )
+	{
+		bounds . Min = { std::min ( bounds . Min . X, point . X - radius ), std::min ( bounds . Min . Y, point . Y - radius ), std::min ( bounds . Min . Z, point . Z - radius ) };
+		bounds . Max = { std::max ( bounds . Max . X, point . X + radius ), std::max ( bounds . Max . Y, point . Y + radius ), std::max ( bounds . Max . Z, point . Z + radius ) };
+	}
+
+	void Enclose ( SpatialBounds & bounds, const SpatialBounds & other )
+	{
+		bounds . Min = { std::min ( bounds . Min . X, other . Min . X ), std::min ( bounds . Min . Y, other . Min . Y ), std::min ( bounds . Min . Z, other . Min . Z ) };
+		bounds . Max = { std::max ( bounds . Max . X, other . Max . X ), std::max ( bounds . Max . Y, other . Max . Y ), std::max ( bounds . Max . Z, other . Max . Z ) };
+	}
+
+	bool NeighbourLess ( const SpatialNeighbour & lhs, const SpatialNeighbour & rhs )
+	{
+		return lhs . DistanceSquared < rhs . DistanceSquared || ( lhs . DistanceSquared == rhs . DistanceSquared && lhs . Entity < rhs . Entity );
+	}
+
+	// The result buffer is kept as a max-heap by the distance until the search is finished
+	void OfferNeighbour ( std::span <SpatialNeighbour> result, std::size_t & count, const SpatialNeighbour & neighbour )
+	{
+		if ( count < result . size () )
+		{
+			result[ count ++ ] = neighbour;
+			std::push_heap ( result . begin (), result . begin () + count, NeighbourLess );
+		}
+		else if ( NeighbourLess ( neighbour, result[ 0 ] ) )
+		{
+			std::pop_heap ( result . begin (), result . begin () + count, NeighbourLess );
+			result[ count - 1 ] = neighbour;
+			std::push_heap ( result . begin (), result . begin () + count, NeighbourLess );
+		}
+	}
+
+	float GetSearchBound ( std::span <SpatialNeighbour> result, std::size_t count, float maxDistanceSquared )
+	{
+		return count == result . size () ? std::min ( result[ 0 ] . DistanceSquared, maxDistanceSquared ) : maxDistanceSquared;
+	}
+
+	std::int32_t ToCellCoordinate ( float value )
+	{
+		return ( std::int32_t ) std::clamp ( std::floor ( value ), -1.e9f, 1.e9f );
+	}
+}
+
+HashGrid::HashGrid ( float cellSize )
+: m_CellSize ( cellSize ), m_InverseCellSize ( 1.f / cellSize )
+{
+
+}
+
+void HashGrid::Build ( std::span <const SpatialEntry> entries, ThreadPool * threadPool )
+{
+	const auto Count = entries . size ();
+	const auto SlotsCount = std::bit_ceil ( std::max ( Count * 2, std::size_t ( 1 ) ) );
+	m_SlotMask = SlotsCount - 1;
+	m_MaxRadius = 0.f;
+	const Cell EmptyMinCell { std::numeric_limits <std::int32_t>::max (), std::numeric_limits <std::int32_t>::max (), std::numeric_limits <std::int32_t>::max () };
+	const Cell EmptyMaxCell { std::numeric_limits <std::int32_t>::min (), std::numeric_limits <std::int32_t>::min (), std::numeric_limits <std::int32_t>::min () };
+	m_MinCell = EmptyMinCell;
+	m_MaxCell = EmptyMaxCell;
+	m_EntrySlots . resize ( Count );
+	m_EntryIndices . resize ( Count );
+	m_Cells . resize ( Count );
+	m_Positions . resize ( Count );
+	m_Radii . resize ( Count );
+	m_Entities . resize ( Count );
+
+	std::mutex BoundsMutex;
+	ParallelRange ( threadPool, Count, [ & ] ( std::size_t begin, std::size_t end )
+	{
+		float MaxRadius = 0.f;
+		Cell MinCell = EmptyMinCell;
+		Cell MaxCell = EmptyMaxCell;
+		for ( std::size_t i = begin; i < end; i ++ ) {
+			const Cell EntryCell = GetCell ( entries[ i ] . Position );
+			m_EntrySlots[ i ] = ( std::uint32_t ) GetSlot ( EntryCell );
+			MaxRadius = std::max ( MaxRadius, entries[ i ] . Radius );
+			MinCell = { std::min ( MinCell . X, EntryCell . X ), std::min ( MinCell . Y, EntryCell . Y ), std::min ( MinCell . Z, EntryCell . Z ) };
+			MaxCell = { std::max ( MaxCell . X, EntryCell . X ), std::max ( MaxCell . Y, EntryCell . Y ), std::max ( MaxCell . Z, EntryCell . Z ) };
+		}
+		std::lock_guard Lock ( BoundsMutex );
+		m_MaxRadius = std::max ( m_MaxRadius, MaxRadius );
+		m_MinCell = { std::min ( MinCell . X, m_MinCell . X ), std::min ( MinCell . Y, m_MinCell . Y ), std::min ( MinCell . Z, m_MinCell . Z ) };
+		m_MaxCell = { std::max ( MaxCell . X, m_MaxCell . X ), std::max ( MaxCell . Y, m_MaxCell . Y ), std::max ( MaxCell . Z, m_MaxCell . Z ) };
+	} );
+
+	// Counting sort by the slot, the scatter leaves each start at the end of its slot which is shifted back afterwards
+	m_SlotStarts . assign ( SlotsCount + 1, 0 );
+	for ( std::size_t i = 0; i < Count; i ++ ) {
+		m_SlotStarts[ m_EntrySlots[ i ] + 1 ] ++;
+	}
+	for ( std::size_t Slot = 1; Slot <= SlotsCount; Slot ++ ) {
+		m_SlotStarts[ Slot ] += m_SlotStarts[ Slot - 1 ];
+	}
+	for ( std::size_t i = 0; i < Count; i ++ ) {
+		m_EntryIndices[ i ] = m_SlotStarts[ m_EntrySlots[ i ] ] ++;
+	}
+	for ( std::size_t Slot = SlotsCount; Slot > 0; Slot -- ) {
+		m_SlotStarts[ Slot ] = m_SlotStarts[ Slot - 1 ];
+	}
+	m_SlotStarts[ 0 ] = 0;
+
+	ParallelRange ( threadPool, Count, [ & ] ( std::size_t begin, std::size_t end )
+	{
+		for ( std::size_t i = begin; i < end; i ++ ) {
+			const auto Index = m_EntryIndices[ i ];
+			m_Cells[ Index ] = GetCell ( entries[ i ] . Position );
+			m_Positions[ Index ] = entries[ i ] . Position;
+			m_Radii[ Index ] = entries[ i ] . Radius;
+			m_Entities[ Index ] = entries[ i ] . Entity;
+		}
+	} );
+}
+
+void HashGrid::Refit ( std::span <const SpatialEntry> entries, ThreadPool * threadPool )
+{
+	if ( entries . size () != m_EntryIndices . size () )
+	{
+		Build ( entries, threadPool );
+		return;
+	}
+
+	std::atomic <bool> IsMoved = false;
+	std::atomic <float> MaxRadius = 0.f;
+	ParallelRange ( threadPool, entries . size (), [ & ] ( std::size_t begin, std::size_t end )
+	{
+		float ChunkMaxRadius = 0.f;
+		for ( std::size_t i = begin; i < end; i ++ ) {
+			const auto Index = m_EntryIndices[ i ];
+			if ( m_Entities[ Index ] != entries[ i ] . Entity || ! ( m_Cells[ Index ] == GetCell ( entries[ i ] . Position ) ) )
+			{
+				IsMoved . store ( true, std::memory_order_relaxed );
+				return;
+			}
+			m_Positions[ Index ] = entries[ i ] . Position;
+			m_Radii[ Index ] = entries[ i ] . Radius;
+			ChunkMaxRadius = std::max ( ChunkMaxRadius, entries[ i ] . Radius );
+		}
+		float Current = MaxRadius . load ( std::memory_order_relaxed );
+		while ( Current < ChunkMaxRadius && ! MaxRadius . compare_exchange_weak ( Current, ChunkMaxRadius, std::memory_order_relaxed ) );
+	} );
+
+	if ( IsMoved )
+	{
+		Build ( entries, threadPool );
+		return;
+	}
+	m_MaxRadius = MaxRadius;
+}
+
+std::size_t HashGrid::QueryRadius ( const SpatialPoint & center, float radius, std::span <EntityHandle> result ) const
+{
+	std::size_t Count = 0;
+	const SpatialBounds Bounds { { center . X - radius, center . Y - radius, center . Z - radius }, { center . X + radius, center . Y + radius, center . Z + radius } };
+	ForEachInBounds ( Bounds, [ & ] ( std::size_t index )
+	{
+		const float Reach = radius + m_Radii[ index ];
+		if ( DistanceSquared ( center, m_Positions[ index ] ) > Reach * Reach )
+			return;
+		if ( Count < result . size () )
+			result[ Count ] = m_Entities[ index ];
+		Count ++;
+	} );
+	return Count;
+}
+
+std::size_t HashGrid::QueryAABB ( const SpatialBounds & bounds, std::span <EntityHandle> result ) const
+{
+	std::size_t Count = 0;
+	ForEachInBounds ( bounds, [ & ] ( std::size_t index )
+	{
+		if ( DistanceSquared ( m_Positions[ index ], bounds ) > m_Radii[ index ] * m_Radii[ index ] )
+			return;
+		if ( Count < result . size () )
+			result[ Count ] = m_Entities[ index ];
+		Count ++;
+	} );
+	return Count;
+}
+
+std::size_t HashGrid::QueryNearest ( const SpatialPoint & point, std::span <SpatialNeighbour> result, float maxDistance ) const
+{
+	if ( result . empty () || m_Entities . empty () )
+		return 0;
+	std::size_t Count = 0;
+	const float MaxDistanceSquared = maxDistance * maxDistance;
+	const auto Offer = [ & ] ( std::size_t index )
+	{
+		const float Distance = DistanceSquared ( point, m_Positions[ index ] );
+		if ( Distance <= MaxDistanceSquared )
+			OfferNeighbour ( result, Count, { m_Entities[ index ], Distance } );
+	};
+
+	// Visit the shells of cells around the point while they may be closer than the farthest found neighbour
+	const Cell Center = GetCell ( point );
+	const std::int64_t MaxRing = std::max ( { ( std::int64_t ) Center . X - m_MinCell . X, ( std::int64_t ) m_MaxCell . X - Center . X,
+											  ( std::int64_t ) Center . Y - m_MinCell . Y, ( std::int64_t ) m_MaxCell . Y - Center . Y,
+											  ( std::int64_t ) Center . Z - m_MinCell . Z, ( std::int64_t ) m_MaxCell . Z - Center . Z, std::int64_t ( 0 ) } );
+	std::size_t VisitedCellsCount = 0;
+	for ( std::int64_t Ring = 0; Ring <= MaxRing; Ring ++ ) {
+		const float Gap = ( float ) std::max ( Ring - 1, std::int64_t ( 0 ) ) * m_CellSize;
+		if ( Gap * Gap > GetSearchBound ( result, Count, MaxDistanceSquared ) )
+			break;
+		// Sparse grids are cheaper to scan than to walk cell by cell
+		if ( VisitedCellsCount > m_Entities . size () )
+		{
+			Count = 0;
+			for ( std::size_t i = 0; i < m_Entities . size (); i ++ ) {
+				Offer ( i );
+			}
+			break;
+		}
+
+		const auto MinZ = std::max ( ( std::int64_t ) Center . Z - Ring, ( std::int64_t ) m_MinCell . Z );
+		const auto MaxZ = std::min ( ( std::int64_t ) Center . Z + Ring, ( std::int64_t ) m_MaxCell . Z );
+		const auto MinY = std::max ( ( std::int64_t ) Center . Y - Ring, ( std::int64_t ) m_MinCell . Y );
+		const auto MaxY = std::min ( ( std::int64_t ) Center . Y + Ring, ( std::int64_t ) m_MaxCell . Y );
+		const auto MinX = std::max ( ( std::int64_t ) Center . X - Ring, ( std::int64_t ) m_MinCell . X );
+		const auto MaxX = std::min ( ( std::int64_t ) Center . X + Ring, ( std::int64_t ) m_MaxCell . X );
+		for ( auto Z = MinZ; Z <= MaxZ; Z ++ ) {
+			for ( auto Y = MinY; Y <= MaxY; Y ++ ) {
+				const bool IsOnShell = std::abs ( Z - Center . Z ) == Ring || std::abs ( Y - Center . Y ) == Ring;
+				// Inside the shell only the two cells at the X ends belong to the ring
+				const auto Step = IsOnShell || Ring == 0 ? 1 : 2 * Ring;
+				for ( auto X = IsOnShell ? MinX : ( std::int64_t ) Center . X - Ring; X <= MaxX; X += Step ) {
+					if ( X < MinX )
+						continue;
+					const Cell Current { ( std::int32_t ) X, ( std::int32_t ) Y, ( std::int32_t ) Z };
+					const auto Slot = GetSlot ( Current );
+					for ( auto i = m_SlotStarts[ Slot ]; i < m_SlotStarts[ Slot + 1 ]; i ++ ) {
+						if ( m_Cells[ i ] == Current )
+							Offer ( i );
+					}
+					VisitedCellsCount ++;
+				}
+			}
+		}
+	}
+
+	std::sort_heap ( result . begin (), result . begin () + Count, NeighbourLess );
+	return Count;
+}
+
+std::size_t HashGrid::Size () const
+{
+	return m_Entities . size ();
+}
+
+float HashGrid::GetCellSize () const
+{
+	return m_CellSize;
+}
+
+HashGrid::Cell HashGrid::GetCell ( const SpatialPoint & point ) const
+{
+	return { ToCellCoordinate ( point . X * m_InverseCellSize ), ToCellCoordinate ( point . Y * m_InverseCellSize ), ToCellCoordinate ( point . Z * m_InverseCellSize ) };
+}
+
+std::size_t HashGrid::GetSlot ( const Cell & cell ) const
+{
+	std::uint64_t Hash = ( std::uint64_t ) ( std::uint32_t ) cell . X * 0x9E3779B97F4A7C15ull
+					   ^ ( std::uint64_t ) ( std::uint32_t ) cell . Y * 0xC2B2AE3D27D4EB4Full
+					   ^ ( std::uint64_t ) ( std::uint32_t ) cell . Z * 0x165667B19E3779F9ull;
+	Hash ^= Hash >> 32;
+	return ( std::size_t ) Hash & m_SlotMask;
+}
+
+template <typename Func>
+void HashGrid::ForEachInBounds ( const SpatialBounds & bounds, Func && func ) const
+{
+	if ( m_Entities . empty () )
+		return;
+	const Cell MinCell = GetCell ( { bounds . Min . X - m_MaxRadius, bounds . Min . Y - m_MaxRadius, bounds . Min . Z - m_MaxRadius } );
+	const Cell MaxCell = GetCell ( { bounds . Max . X + m_MaxRadius, bounds . Max . Y + m_MaxRadius, bounds . Max . Z + m_MaxRadius } );
+	const Cell Min { std::max ( MinCell . X, m_MinCell . X ), std::max ( MinCell . Y, m_MinCell . Y ), std::max ( MinCell . Z, m_MinCell . Z ) };
+	const Cell Max { std::min ( MaxCell . X, m_MaxCell . X ), std::min ( MaxCell . Y, m_MaxCell . Y ), std::min ( MaxCell . Z, m_MaxCell . Z ) };
+	if ( Min . X > Max . X || Min . Y > Max . Y || Min . Z > Max . Z )
+		return;
+
+	// Large volumes are cheaper to scan than to walk cell by cell
+	const double CellsCount = ( double ( Max . X ) - Min . X + 1 ) * ( double ( Max . Y ) - Min . Y + 1 ) * ( double ( Max . Z ) - Min . Z + 1 );
+	if ( CellsCount > ( double ) m_Entities . size () )
+	{
+		for ( std::size_t i = 0; i < m_Entities . size (); i ++ ) {
+			const auto & Current = m_Cells[ i ];
+			if ( Current . X >= Min . X && Current . X <= Max . X && Current . Y >= Min . Y && Current . Y <= Max . Y && Current . Z >= Min . Z && Current . Z <= Max . Z )
+				func ( i );
+		}
+		return;
+	}
+
+	for ( auto Z = Min . Z; Z <= Max . Z; Z ++ ) {
+		for ( auto Y = Min . Y; Y <= Max . Y; Y ++ ) {
+			for ( auto X = Min . X; X <= Max . X; X ++ ) {
+				const Cell Current { X, Y, Z };
+				const auto Slot = GetSlot ( Current );
+				for ( auto i = m_SlotStarts[ Slot ]; i < m_SlotStarts[ Slot + 1 ]; i ++ ) {
+					// Different cells may share the slot, only the entities of the visited cell are reported
+					if ( m_Cells[ i ] == Current )
+						func ( i );
+				}
+			}
+		}
+	}
+}
+
+LooseOctree::LooseOctree ( std::size_t leafCapacity, std::size_t maxDepth )
+: m_LeafCapacity ( std::max ( leafCapacity, std::size_t ( 1 ) ) ), m_MaxDepth ( maxDepth )
+{
+
+}
+
+void LooseOctree::Build ( std::span <const SpatialEntry> entries, ThreadPool * threadPool )
+{
+	const auto Count = entries . size ();
+	m_Nodes . clear ();
+	m_SubtreeRanges . clear ();
+	m_TopNodesCount = 0;
+	m_Order . resize ( Count );
+	m_Scratch . resize ( Count );
+	m_EntryIndices . resize ( Count );
+	m_EntryNodes . resize ( Count );
+	m_Positions . resize ( Count );
+	m_Radii . resize ( Count );
+	m_Entities . resize ( Count );
+	if ( Count == 0 )
+		return;
+
+	// The entities are partitioned in the input order first and stored in the build order at the end
+	SpatialBounds RootBounds = GetEmptyBounds ();
+	std::mutex BoundsMutex;
+	ParallelRange ( threadPool, Count, [ & ] ( std::size_t begin, std::size_t end )
+	{
+		SpatialBounds Bounds = GetEmptyBounds ();
+		for ( std::size_t i = begin; i < end; i ++ ) {
+			m_Order[ i ] = ( std::uint32_t ) i;
+			m_Positions[ i ] = entries[ i ] . Position;
+			m_Radii[ i ] = entries[ i ] . Radius;
+			Enclose ( Bounds, entries[ i ] . Position, 0.f );
+		}
+		std::lock_guard Lock ( BoundsMutex );
+		Enclose ( RootBounds, Bounds );
+	} );
+
+	Node Root;
+	Root . Center = { ( RootBounds . Min . X + RootBounds . Max . X ) * 0.5f, ( RootBounds . Min . Y + RootBounds . Max . Y ) * 0.5f, ( RootBounds . Min . Z + RootBounds . Max . Z ) * 0.5f };
+	Root . HalfSize = std::max ( { RootBounds . Max . X - RootBounds . Min . X, RootBounds . Max . Y - RootBounds . Min . Y, RootBounds . Max . Z - RootBounds . Min . Z, 1.e-3f } ) * 0.5f;
+	m_Nodes . push_back ( Root );
+
+	const bool IsParallel = threadPool != nullptr && Count > SpatialGrainSize;
+	std::vector <Subtree> Subtrees;
+	BuildNode ( m_Nodes, 0, 0, ( std::uint32_t ) Count, 0, IsParallel && m_MaxDepth > OctreeSplitDepth ? & Subtrees : nullptr );
+	m_TopNodesCount = m_Nodes . size ();
+
+	if ( ! Subtrees . empty () )
+	{
+		threadPool -> ParallelFor ( Subtrees . size (), 1, [ & ] ( std::size_t begin, std::size_t end )
+		{
+			for ( std::size_t i = begin; i < end; i ++ ) {
+				auto & Current = Subtrees[ i ];
+				Current . Nodes . push_back ( m_Nodes[ Current . Root ] );
+				BuildNode ( Current . Nodes, 0, Current . First, Current . Last, Current . Depth, nullptr );
+			}
+		} );
+
+		// Splice the subtrees after the top nodes, the local index 0 is the root already placed among them
+		for ( auto & Current : Subtrees ) {
+			const auto Offset = m_Nodes . size () - 1;
+			for ( std::size_t Local = 1; Local < Current . Nodes . size (); Local ++ ) {
+				auto & Spliced = m_Nodes . emplace_back ( Current . Nodes[ Local ] );
+				Spliced . FirstChild += Spliced . ChildrenMask != 0 ? ( std::uint32_t ) Offset : 0;
+			}
+			m_SubtreeRanges . emplace_back ( Offset + 1, m_Nodes . size () );
+		}
+		threadPool -> ParallelFor ( Subtrees . size (), 1, [ & ] ( std::size_t begin, std::size_t end )
+		{
+			for ( std::size_t i = begin; i < end; i ++ ) {
+				const auto & Current = Subtrees[ i ];
+				const auto Offset = m_SubtreeRanges[ i ] . first - 1;
+				auto & Root = m_Nodes[ Current . Root ];
+				Root = Current . Nodes . front ();
+				Root . FirstChild = Root . ChildrenMask != 0 ? ( std::uint32_t ) Offset + Root . FirstChild : 0;
+				for ( auto Index = Current . First; Index < Current . Last; Index ++ ) {
+					m_EntryNodes[ Index ] = m_EntryNodes[ Index ] == 0 ? Current . Root : m_EntryNodes[ Index ] + ( std::uint32_t ) Offset;
+				}
+			}
+		} );
+	}
+
+	// Store the entities in the build order, so each node owns a contiguous range
+	std::vector <SpatialPoint> Positions ( Count );
+	std::vector <float> Radii ( Count );
+	ParallelRange ( threadPool, Count, [ & ] ( std::size_t begin, std::size_t end )
+	{
+		for ( std::size_t i = begin; i < end; i ++ ) {
+			const auto Input = m_Order[ i ];
+			Positions[ i ] = m_Positions[ Input ];
+			Radii[ i ] = m_Radii[ Input ];
+			m_Entities[ i ] = entries[ Input ] . Entity;
+			m_EntryIndices[ Input ] = ( std::uint32_t ) i;
+		}
+	} );
+	m_Positions . swap ( Positions );
+	m_Radii . swap ( Radii );
+
+	if ( threadPool != nullptr && ! m_SubtreeRanges . empty () )
+	{
+		threadPool -> ParallelFor ( m_SubtreeRanges . size (), 1, [ & ] ( std::size_t begin, std::size_t end )
+		{
+			for ( std::size_t i = begin; i < end; i ++ ) {
+				RefitNodes ( m_SubtreeRanges[ i ] . first, m_SubtreeRanges[ i ] . second );
+			}
+		} );
+		RefitNodes ( 0, m_TopNodesCount );
+	}
+	else
+	{
+		RefitNodes ( 0, m_Nodes . size () );
+	}
+}
+
+void LooseOctree::Refit ( std::span <const SpatialEntry> entries, ThreadPool * threadPool )
+{
+	if ( entries . size () != m_EntryIndices . size () )
+	{
+		Build ( entries, threadPool );
+		return;
+	}
+
+	std::atomic <bool> IsChanged = false;
+	std::atomic <std::size_t> EscapedCount = 0;
+	ParallelRange ( threadPool, entries . size (), [ & ] ( std::size_t begin, std::size_t end )
+	{
+		std::size_t ChunkEscapedCount = 0;
+		for ( std::size_t i = begin; i < end; i ++ ) {
+			const auto Index = m_EntryIndices[ i ];
+			if ( m_Entities[ Index ] != entries[ i ] . Entity )
+			{
+				IsChanged . store ( true, std::memory_order_relaxed );
+				return;
+			}
+			const auto & Position = entries[ i ] . Position;
+			const auto & Owner = m_Nodes[ m_EntryNodes[ Index ] ];
+			const float Reach = entries[ i ] . Radius;
+			const float Loose = Owner . HalfSize * 2.f;
+			if ( std::abs ( Position . X - Owner . Center . X ) + Reach > Loose || std::abs ( Position . Y - Owner . Center . Y ) + Reach > Loose
+				 || std::abs ( Position . Z - Owner . Center . Z ) + Reach > Loose )
+				ChunkEscapedCount ++;
+			m_Positions[ Index ] = Position;
+			m_Radii[ Index ] = entries[ i ] . Radius;
+		}
+		EscapedCount . fetch_add ( ChunkEscapedCount, std::memory_order_relaxed );
+	} );
+
+	if ( IsChanged || EscapedCount * 8 > entries . size () )
+	{
+		Build ( entries, threadPool );
+		return;
+	}
+	if ( threadPool != nullptr && ! m_SubtreeRanges . empty () )
+	{
+		threadPool -> ParallelFor ( m_SubtreeRanges . size (), 1, [ & ] ( std::size_t begin, std::size_t end )
+		{
+			for ( std::size_t i = begin; i < end; i ++ ) {
+				RefitNodes ( m_SubtreeRanges[ i ] . first, m_SubtreeRanges[ i ] . second );
+			}
+		} );
+		RefitNodes ( 0, m_TopNodesCount );
+	}
+	else
+	{
+		RefitNodes ( 0, m_Nodes . size () );
+	}
+}
+
+std::size_t LooseOctree::QueryRadius ( const SpatialPoint & center, float radius, std::span <EntityHandle> result ) const
+{
+	std::size_t Count = 0;
+	if ( m_Nodes . empty () )
+		return Count;
+	ForEachInNode ( 0, [ & ] ( const SpatialBounds & bounds ) { return DistanceSquared ( center, bounds ) <= radius * radius; },
+					[ & ] ( std::size_t index )
+	{
+		const float Reach = radius + m_Radii[ index ];
+		if ( DistanceSquared ( center, m_Positions[ index ] ) > Reach * Reach )
+			return;
+		if ( Count < result . size () )
+			result[ Count ] = m_Entities[ index ];
+		Count ++;
+	} );
+	return Count;
+}
+
+std::size_t LooseOctree::QueryAABB ( const SpatialBounds & bounds, std::span <EntityHandle> result ) const
+{
+	std::size_t Count = 0;
+	if ( m_Nodes . empty () )
+		return Count;
+	ForEachInNode ( 0, [ & ] ( const SpatialBounds & nodeBounds ) { return GetIsOverlapping ( bounds, nodeBounds ); },
+					[ & ] ( std::size_t index )
+	{
+		if ( DistanceSquared ( m_Positions[ index ], bounds ) > m_Radii[ index ] * m_Radii[ index ] )
+			return;
+		if ( Count < result . size () )
+			result[ Count ] = m_Entities[ index ];
+		Count ++;
+	} );
+	return Count;
+}
+
+std::size_t LooseOctree::QueryNearest ( const SpatialPoint & point, std::span <SpatialNeighbour> result, float maxDistance ) const
+{
+	std::size_t Count = 0;
+	if ( result . empty () || m_Nodes . empty () )
+		return Count;
+	FindNearest ( 0, point, result, Count, maxDistance * maxDistance );
+	std::sort_heap ( result . begin (), result . begin () + Count, NeighbourLess );
+	return Count;
+}
+
+std::size_t LooseOctree::Size () const
+{
+	return m_Entities . size ();
+}
+
+std::size_t LooseOctree::GetNodesCount () const
+{
+	return m_Nodes . size ();
+}
+
+void LooseOctree::BuildNode ( std::vector <Node> & nodes, std::size_t nodeIndex, std::uint32_t first, std::uint32_t last,
+							  std::size_t depth, std::vector <Subtree> * subtrees )
+{
+	if ( subtrees != nullptr && depth == OctreeSplitDepth )
+	{
+		subtrees -> push_back ( { ( std::uint32_t ) nodeIndex, first, last, depth, {} } );
+		return;
+	}
+
+	const SpatialPoint Center = nodes[ nodeIndex ] . Center;
+	const float HalfSize = nodes[ nodeIndex ] . HalfSize;
+	nodes[ nodeIndex ] . First = first;
+	nodes[ nodeIndex ] . Count = last - first;
+	nodes[ nodeIndex ] . ChildrenMask = 0;
+	if ( last - first <= m_LeafCapacity || depth >= m_MaxDepth )
+	{
+		std::fill ( m_EntryNodes . begin () + first, m_EntryNodes . begin () + last, ( std::uint32_t ) nodeIndex );
+		return;
+	}
+
+	// Entities larger than the loose bounds of the children stay in the node and go to the bucket 0, the rest go to
+	// the bucket 1 + octant, the bit 0 of the octant is set for X above the center, the bit 1 for Y and the bit 2 for Z
+	const float StayRadius = HalfSize * 0.5f;
+	const auto GetBucket = [ & ] ( std::uint32_t i )
+	{
+		const auto & Position = m_Positions[ i ];
+		return m_Radii[ i ] > StayRadius ? 0u : 1u + ( Position . X >= Center . X ? 1u : 0u ) + ( Position . Y >= Center . Y ? 2u : 0u ) + ( Position . Z >= Center . Z ? 4u : 0u );
+	};
+	std::array <std::uint32_t, 10> Splits {};
+	for ( auto i = first; i < last; i ++ ) {
+		Splits[ GetBucket ( m_Order[ i ] ) + 1 ] ++;
+	}
+	Splits[ 0 ] = first;
+	for ( std::size_t Bucket = 1; Bucket < Splits . size (); Bucket ++ ) {
+		Splits[ Bucket ] += Splits[ Bucket - 1 ];
+	}
+	auto Cursors = Splits;
+	for ( auto i = first; i < last; i ++ ) {
+		m_Scratch[ Cursors[ GetBucket ( m_Order[ i ] ) ] ++ ] = m_Order[ i ];
+	}
+	std::copy ( m_Scratch . begin () + first, m_Scratch . begin () + last, m_Order . begin () + first );
+
+	nodes[ nodeIndex ] . Count = Splits[ 1 ] - first;
+	std::fill ( m_EntryNodes . begin () + first, m_EntryNodes . begin () + Splits[ 1 ], ( std::uint32_t ) nodeIndex );
+	std::uint8_t ChildrenMask = 0;
+	for ( std::size_t Octant = 0; Octant < 8; Octant ++ ) {
+		if ( Splits[ Octant + 1 ] != Splits[ Octant + 2 ] )
+			ChildrenMask |= ( std::uint8_t ) ( 1u << Octant );
+	}
+	if ( ChildrenMask == 0 )
+		return;
+
+	const auto FirstChild = nodes . size ();
+	nodes . resize ( FirstChild + ( std::size_t ) std::popcount ( ChildrenMask ) );
+	nodes[ nodeIndex ] . ChildrenMask = ChildrenMask;
+	nodes[ nodeIndex ] . FirstChild = ( std::uint32_t ) FirstChild;
+	const float ChildHalfSize = HalfSize * 0.5f;
+	auto ChildIndex = FirstChild;
+	for ( std::size_t Octant = 0; Octant < 8; Octant ++ ) {
+		if ( ( ChildrenMask & ( 1u << Octant ) ) == 0 )
+			continue;
+		nodes[ ChildIndex ] . Center = { Center . X + ( Octant & 1 ? ChildHalfSize : - ChildHalfSize ),
+										 Center . Y + ( Octant & 2 ? ChildHalfSize : - ChildHalfSize ),
+										 Center . Z + ( Octant & 4 ? ChildHalfSize : - ChildHalfSize ) };
+		nodes[ ChildIndex ] . HalfSize = ChildHalfSize;
+		BuildNode ( nodes, ChildIndex, Splits[ Octant + 1 ], Splits[ Octant + 2 ], depth + 1, subtrees );
+		ChildIndex ++;
+	}
+}
+
+void LooseOctree::RefitNodes ( std::size_t first, std::size_t last )
+{
+	for ( auto Index = last; Index -- > first; ) {
+		auto & Current = m_Nodes[ Index ];
+		SpatialBounds Bounds = GetEmptyBounds ();
+		for ( auto i = Current . First; i < Current . First + Current . Count; i ++ ) {
+			Enclose ( Bounds, m_Positions[ i ], m_Radii[ i ] );
+		}
+		const auto ChildrenCount = ( std::size_t ) std::popcount ( Current . ChildrenMask );
+		for ( std::size_t Child = 0; Child < ChildrenCount; Child ++ ) {
+			Enclose ( Bounds, m_Nodes[ Current . FirstChild + Child ] . Bounds );
+		}
+		Current . Bounds = Bounds;
+	}
+}
+
+template <typename NodeTest, typename Func>
+void LooseOctree::ForEachInNode ( std::size_t nodeIndex, const NodeTest & nodeTest, const Func & func ) const
+{
+	const auto & Current = m_Nodes[ nodeIndex ];
+	if ( ! nodeTest ( Current . Bounds ) )
+		return;
+	for ( auto i = Current . First; i < Current . First + Current . Count; i ++ ) {
+		func ( i );
+	}
+	const auto ChildrenCount = ( std::size_t ) std::popcount ( Current . ChildrenMask );
+	for ( std::size_t Child = 0; Child < ChildrenCount; Child ++ ) {
+		ForEachInNode ( Current . FirstChild + Child, nodeTest, func );
+	}
+}
+
+void LooseOctree::FindNearest ( std::size_t nodeIndex, const SpatialPoint & point, std::span <SpatialNeighbour> result,
+								std::size_t & count, float maxDistanceSquared ) const
+{
+	const auto & Current = m_Nodes[ nodeIndex ];
+	for ( auto i = Current . First; i < Current . First + Current . Count; i ++ ) {
+		const float Distance = DistanceSquared ( point, m_Positions[ i ] );
+		if ( Distance <= maxDistanceSquared )
+			OfferNeighbour ( result, count, { m_Entities[ i ], Distance } );
+	}
+
+	// Descend into the closer children first, so the farther ones are likely pruned
+	std::array <std::pair <float, std::size_t>, 8> Children;
+	const auto ChildrenCount = ( std::size_t ) std::popcount ( Current . ChildrenMask );
+	for ( std::size_t Child = 0; Child < ChildrenCount; Child ++ ) {
+		const auto ChildIndex = Current . FirstChild + Child;
+		Children[ Child ] = { DistanceSquared ( point, m_Nodes[ ChildIndex ] . Bounds ), ChildIndex };
+	}
+	std::sort ( Children . begin (), Children . begin () + ChildrenCount );
+	for ( std::size_t Child = 0; Child < ChildrenCount; Child ++ ) {
+		if ( Children[ Child ] . first > GetSearchBound ( result, count, maxDistanceSquared ) )
+			break;
+		FindNearest ( Children[ Child ] . second, point, result, count, maxDistanceSquared );
+	}
+}
\ No newline at end of file
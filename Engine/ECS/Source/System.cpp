@@ -1,4 +1,5 @@
 #include "Laniakea/ECS/System.h"
+#include <cassert>
 
 void System::AddEntity ( Entity & entity )
 {
@@ -14,11 +15,26 @@ void System::RemoveEntity ( Entity & entity )
 }
 
 
+void System::RemoveEntities ( std::span <const EntityHandle> entityHandles )
+{
+	for ( const auto Handle : entityHandles ) {
+		const auto It = m_EntitiesHandles . find ( Handle );
+		if ( It == m_EntitiesHandles . end () )
+			continue;
+		m_Entities . RemoveObject ( It -> second );
+		m_EntitiesHandles . erase ( It );
+	}
+}
+
+void System::ShrinkToFit ()
+{
+	m_Entities . ShrinkToFit ();
+	m_EntitiesHandles . rehash ( 0 );
+}
+
 void System::OnEntitySignatureChanged ( Entity & entity, const Signature & signature )
 {
-	const bool Match = std::includes ( signature . begin (), signature . end (), m_Signature . begin (),
-									   m_Signature . end () );
-	if ( Match )
+	if ( m_Filter . GetIsMatching ( signature ) )
 	{
 		AddEntityChecked (entity );
 	}
@@ -46,11 +62,113 @@ bool System::RemoveEntityChecked ( Entity & entity )
 
 void System::SetSignature ( Signature && signature )
 {
-	m_Signature = std::move ( signature );
+	m_Filter = QueryFilter ( std::move ( signature ), {} );
 }
 
 void System::SetSignature ( const Signature & signature )
 {
-	m_Signature = signature;
+	m_Filter = QueryFilter ( signature, {} );
+}
+
+void System::SetFilter ( QueryFilter && filter )
+{
+	m_Filter = std::move ( filter );
+}
+
+const QueryFilter & System::GetFilter () const
+{
+	return m_Filter;
+}
+
+void System::RunSlice ( ECS &, std::size_t, std::size_t )
+{
+	assert ( false && "The sliceable system must override RunSlice" );
+}
+
+bool System::GetIsSliceable () const
+{
+	return false;
 }
 
+bool System::Execute ( ECS & ecs )
+{
+	const auto Start = std::chrono::steady_clock::now ();
+	const auto EntitiesCount = m_Entities . Size ();
+	const auto Tick = m_TicksCount ++;
+	std::size_t Processed = 0;
+
+	// Slicing is opt-in, the other systems run whole on every tick
+	const auto Mode = GetIsSliceable () || m_Schedule . Mode == SystemScheduleMode::EveryNTicks ? m_Schedule . Mode : SystemScheduleMode::EveryTick;
+	switch ( Mode )
+	{
+		case SystemScheduleMode::EveryTick:
+			Run ( ecs );
+			Processed = EntitiesCount;
+			break;
+		case SystemScheduleMode::EveryNTicks:
+			if ( Tick % m_Schedule . Period != 0 )
+				return false;
+			Run ( ecs );
+			Processed = EntitiesCount;
+			break;
+		case SystemScheduleMode::RoundRobin:
+		{
+			if ( m_Cursor >= EntitiesCount )
+				m_Cursor = 0;
+			const auto BucketSize = ( EntitiesCount + m_Schedule . Period - 1 ) / m_Schedule . Period;
+			Processed = std::min ( BucketSize, EntitiesCount - m_Cursor );
+			RunSlice ( ecs, m_Cursor, Processed );
+			m_Cursor += Processed;
+			break;
+		}
+		case SystemScheduleMode::Budget:
+		{
+			// At most one full pass per tick, the slice may remove entities
+			while ( Processed < EntitiesCount && m_Entities . Size () != 0 )
+			{
+				if ( m_Cursor >= m_Entities . Size () )
+					m_Cursor = 0;
+				const auto Count = std::min ( { m_Schedule . SliceSize, m_Entities . Size () - m_Cursor, EntitiesCount - Processed } );
+				RunSlice ( ecs, m_Cursor, Count );
+				Processed += Count;
+				m_Cursor += Count;
+				if ( std::chrono::steady_clock::now () - Start >= m_Schedule . Budget )
+					break;
+			}
+			break;
+		}
+	}
+
+	const auto Time = std::chrono::duration_cast <std::chrono::nanoseconds> ( std::chrono::steady_clock::now () - Start );
+	m_Stats . RunsCount ++;
+	m_Stats . ProcessedEntitiesCount += Processed;
+	m_Stats . LastProcessedEntitiesCount = Processed;
+	m_Stats . LastTime = Time;
+	m_Stats . MaxTime = std::max ( m_Stats . MaxTime, Time );
+	m_Stats . TotalTime += Time;
+	return true;
+}
+
+void System::SetSchedule ( const SystemSchedule & schedule )
+{
+	// Zero period divides by zero in Execute, zero slice never advances the cursor
+	assert ( schedule . GetIsValid () && "The schedule period and slice size must be non-zero" );
+	m_Schedule = schedule;
+	m_TicksCount = 0;
+	m_Cursor = 0;
+}
+
+const SystemSchedule & System::GetSchedule () const
+{
+	return m_Schedule;
+}
+
+const SystemStats & System::GetStats () const
+{
+	return m_Stats;
+}
+
+void System::ResetStats ()
+{
+	m_Stats = {};
+}
\ No newline at end of file
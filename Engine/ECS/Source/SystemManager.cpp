@@ -22,4 +22,36 @@ void SystemManager::OnEntityRemoved ( Entity & entity )
 	for ( auto & System : m_Systems ) {
 		System . second -> RemoveEntityChecked ( entity );
 	}
+}
+
+void SystemManager::OnEntitiesRemoved ( std::span <const EntityHandle> entityHandles )
+{
+	for ( auto & System : m_Systems ) {
+		System . second -> RemoveEntities ( entityHandles );
+	}
+}
+
+void SystemManager::ShrinkToFit ()
+{
+	for ( auto & System : m_Systems ) {
+		System . second -> ShrinkToFit ();
+	}
+}
+
+void SystemManager::RunSystems ( ECS & ecs )
+{
+	for ( auto & System : m_SystemsOrder ) {
+		System . second -> Execute ( ecs );
+	}
+}
+
+void SystemManager::AddSystem ( SystemType systemType, std::shared_ptr <System> system )
+{
+	const auto It = std::find_if ( m_SystemsOrder . begin (), m_SystemsOrder . end (),
+			[ systemType ] ( const auto & entry ) { return entry . first == systemType; } );
+	if ( It != m_SystemsOrder . end () )
+		It -> second = system;
+	else
+		m_SystemsOrder . emplace_back ( systemType, system );
+	m_Systems[ systemType ] = std::move ( system );
 }
\ No newline at end of file
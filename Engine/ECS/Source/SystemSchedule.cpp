@@ -0,0 +1,42 @@
+#include "Laniakea/ECS/SystemSchedule.h"
+#include <algorithm>
+
+SystemSchedule SystemSchedule::EveryTick ()
+{
+	return {};
+}
+
+SystemSchedule SystemSchedule::EveryNTicks ( std::uint32_t n )
+{
+	SystemSchedule Schedule;
+	Schedule . Mode = SystemScheduleMode::EveryNTicks;
+	Schedule . Period = std::max ( n, 1u );
+	return Schedule;
+}
+
+SystemSchedule SystemSchedule::RoundRobin ( std::uint32_t n )
+{
+	SystemSchedule Schedule;
+	Schedule . Mode = SystemScheduleMode::RoundRobin;
+	Schedule . Period = std::max ( n, 1u );
+	return Schedule;
+}
+
+SystemSchedule SystemSchedule::WithBudget ( std::chrono::microseconds budget, std::size_t sliceSize )
+{
+	SystemSchedule Schedule;
+	Schedule . Mode = SystemScheduleMode::Budget;
+	Schedule . Budget = budget;
+	Schedule . SliceSize = std::max ( sliceSize, std::size_t ( 1 ) );
+	return Schedule;
+}
+
+bool SystemSchedule::GetIsValid () const
+{
+	return Period != 0 && SliceSize != 0;
+}
+
+std::chrono::nanoseconds SystemStats::GetAverageTime () const
+{
+	return RunsCount == 0 ? std::chrono::nanoseconds::zero () : TotalTime / ( std::int64_t ) RunsCount;
+}
\ No newline at end of file
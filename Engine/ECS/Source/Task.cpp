@@ -0,0 +1,302 @@
+#include "Laniakea/ECS/Task.h"
+#include <algorithm>
+#include <functional>
+#include <new>
+#include <utility>
+
+namespace
+{
+	thread_local TaskFrameAllocator * CurrentAllocator = nullptr; /**< The allocator of the thread, null until the first use and after the exit. */
+}
+
+/**
+ * @brief Holds the reference of the thread to its allocator, released when the thread exits.
+ */
+struct TaskFrameAllocator::ThreadOwner
+{
+	TaskFrameAllocator * Allocator = new TaskFrameAllocator ();
+
+	ThreadOwner ()
+	{
+		CurrentAllocator = Allocator;
+	}
+
+	~ThreadOwner ()
+	{
+		CurrentAllocator = nullptr;
+		Allocator -> Release ();
+	}
+};
+
+void * TaskFrameAllocator::Allocate ( std::size_t size )
+{
+	const auto BlockSize = size + sizeof ( FrameHeader );
+	if ( BlockSize > MaxPooledSize )
+		return ::operator new ( size );
+
+	const auto SizeClass = ( BlockSize - 1 ) / SizeClassGranularity;
+	if ( ! m_FreeLists[ SizeClass ] && m_HasRemoteBlocks . load ( std::memory_order_relaxed ) )
+	{
+		// Take back the blocks freed by other threads
+		std::lock_guard Lock ( m_RemoteMutex );
+		for ( std::size_t i = 0; i < m_FreeLists . size (); i ++ ) {
+			while ( FreeBlock * Block = m_RemoteFreeLists[ i ] )
+			{
+				m_RemoteFreeLists[ i ] = Block -> Next;
+				Block -> Next = m_FreeLists[ i ];
+				m_FreeLists[ i ] = Block;
+			}
+		}
+		m_HasRemoteBlocks . store ( false, std::memory_order_relaxed );
+	}
+
+	std::byte * Block = nullptr;
+	if ( FreeBlock * Free = m_FreeLists[ SizeClass ] )
+	{
+		m_FreeLists[ SizeClass ] = Free -> Next;
+		Block = reinterpret_cast <std::byte *> ( Free );
+	}
+	else
+	{
+		const auto ClassSize = ( SizeClass + 1 ) * SizeClassGranularity;
+		if ( m_SlabRemaining < ClassSize )
+		{
+			m_Slabs . push_back ( std::make_unique <std::byte []> ( SlabSize ) );
+			m_SlabCursor = m_Slabs . back () . get ();
+			m_SlabRemaining = SlabSize;
+		}
+		Block = m_SlabCursor;
+		m_SlabCursor += ClassSize;
+		m_SlabRemaining -= ClassSize;
+	}
+	m_ReferencesCount . fetch_add ( 1, std::memory_order_relaxed );
+	new ( Block ) FrameHeader { this };
+	return Block + sizeof ( FrameHeader );
+}
+
+void TaskFrameAllocator::Deallocate ( void * frame, std::size_t size )
+{
+	const auto BlockSize = size + sizeof ( FrameHeader );
+	if ( BlockSize > MaxPooledSize )
+	{
+		::operator delete ( frame );
+		return;
+	}
+	const auto SizeClass = ( BlockSize - 1 ) / SizeClassGranularity;
+	auto * Header = reinterpret_cast <FrameHeader *> ( static_cast <std::byte *> ( frame ) - sizeof ( FrameHeader ) );
+	TaskFrameAllocator * Owner = Header -> Owner;
+	auto * Block = reinterpret_cast <FreeBlock *> ( Header );
+	if ( Owner == CurrentAllocator )
+	{
+		Block -> Next = Owner -> m_FreeLists[ SizeClass ];
+		Owner -> m_FreeLists[ SizeClass ] = Block;
+	}
+	else
+	{
+		std::lock_guard Lock ( Owner -> m_RemoteMutex );
+		Block -> Next = Owner -> m_RemoteFreeLists[ SizeClass ];
+		Owner -> m_RemoteFreeLists[ SizeClass ] = Block;
+		Owner -> m_HasRemoteBlocks . store ( true, std::memory_order_relaxed );
+	}
+	Owner -> Release ();
+}
+
+TaskFrameAllocator & TaskFrameAllocator::Get ()
+{
+	thread_local ThreadOwner Owner;
+	return * Owner . Allocator;
+}
+
+void TaskFrameAllocator::Release ()
+{
+	if ( m_ReferencesCount . fetch_sub ( 1, std::memory_order_acq_rel ) == 1 )
+		delete this;
+}
+
+Task::Task ( Handle handle )
+: m_Handle ( handle )
+{
+
+}
+
+Task::Task ( Task && other ) noexcept
+: m_Handle ( std::exchange ( other . m_Handle, nullptr ) )
+{
+
+}
+
+Task & Task::operator = ( Task && other ) noexcept
+{
+	if ( this != & other )
+	{
+		if ( m_Handle )
+			m_Handle . destroy ();
+		m_Handle = std::exchange ( other . m_Handle, nullptr );
+	}
+	return * this;
+}
+
+Task::~Task ()
+{
+	if ( m_Handle )
+		m_Handle . destroy ();
+}
+
+Task::Handle Task::Release ()
+{
+	return std::exchange ( m_Handle, nullptr );
+}
+
+bool Task::GetIsValid () const
+{
+	return static_cast <bool> ( m_Handle );
+}
+
+void NextFrame::await_suspend ( Task::Handle handle ) const
+{
+	handle . promise () . Scheduler -> ScheduleNextFrame ( handle );
+}
+
+WaitFor::WaitFor ( double seconds )
+: Seconds ( seconds )
+{
+
+}
+
+void WaitFor::await_suspend ( Task::Handle handle ) const
+{
+	handle . promise () . Scheduler -> ScheduleAfter ( Seconds, handle );
+}
+
+Job::Job ( std::function <void ()> func )
+: m_Func ( std::move ( func ) )
+{
+
+}
+
+void Job::await_suspend ( Task::Handle handle )
+{
+	handle . promise () . Scheduler -> ScheduleJob ( std::move ( m_Func ), handle );
+}
+
+bool TaskScheduler::Timer::operator > ( const Timer & rhs ) const
+{
+	return WakeTime > rhs . WakeTime;
+}
+
+TaskScheduler::~TaskScheduler ()
+{
+	{
+		// Queued jobs are skipped, the running ones may still write into the task frames
+		std::unique_lock Lock ( m_Jobs -> Mutex );
+		m_Jobs -> IsCancelled = true;
+		m_Jobs -> Idle . wait ( Lock, [ this ] () { return m_Jobs -> RunningCount == 0; } );
+	}
+	for ( auto Handle : m_NextFrame ) {
+		Handle . destroy ();
+	}
+	for ( auto & Timer : m_Timers ) {
+		Timer . Handle . destroy ();
+	}
+	for ( auto * Address : m_WaitingForJobs ) {
+		std::coroutine_handle <>::from_address ( Address ) . destroy ();
+	}
+}
+
+void TaskScheduler::Start ( Task && task )
+{
+	auto Handle = task . Release ();
+	Handle . promise () . Scheduler = this;
+	m_TasksCount ++;
+	Resume ( Handle );
+}
+
+void TaskScheduler::Update ( double deltaSeconds )
+{
+	m_Time += deltaSeconds;
+	m_Resuming . clear ();
+	std::swap ( m_Resuming, m_NextFrame );
+
+	while ( ! m_Timers . empty () && m_Timers . front () . WakeTime <= m_Time )
+	{
+		std::pop_heap ( m_Timers . begin (), m_Timers . end (), std::greater <> () );
+		m_Resuming . push_back ( m_Timers . back () . Handle );
+		m_Timers . pop_back ();
+	}
+
+	{
+		std::lock_guard Lock ( m_Jobs -> Mutex );
+		for ( auto Handle : m_Jobs -> Finished ) {
+			m_WaitingForJobs . erase ( Handle . address () );
+		}
+		m_Resuming . insert ( m_Resuming . end (), m_Jobs -> Finished . begin (), m_Jobs -> Finished . end () );
+		m_Jobs -> Finished . clear ();
+	}
+
+	// Resume in memory order of the frames
+	std::sort ( m_Resuming . begin (), m_Resuming . end (), [] ( std::coroutine_handle <> lhs, std::coroutine_handle <> rhs )
+	{
+		return std::less <void *> () ( lhs . address (), rhs . address () );
+	} );
+	for ( auto Handle : m_Resuming ) {
+		Resume ( Handle );
+	}
+	m_Resuming . clear ();
+}
+
+std::size_t TaskScheduler::GetTasksCount () const
+{
+	return m_TasksCount;
+}
+
+void TaskScheduler::SetThreadPool ( std::shared_ptr <ThreadPool> threadPool )
+{
+	m_ThreadPool = std::move ( threadPool );
+}
+
+std::shared_ptr <ThreadPool> TaskScheduler::GetThreadPool ()
+{
+	if ( ! m_ThreadPool )
+		m_ThreadPool = std::make_shared <ThreadPool> ();
+	return m_ThreadPool;
+}
+
+void TaskScheduler::ScheduleNextFrame ( std::coroutine_handle <> handle )
+{
+	m_NextFrame . push_back ( handle );
+}
+
+void TaskScheduler::ScheduleAfter ( double seconds, std::coroutine_handle <> handle )
+{
+	m_Timers . push_back ( { m_Time + seconds, handle } );
+	std::push_heap ( m_Timers . begin (), m_Timers . end (), std::greater <> () );
+}
+
+void TaskScheduler::ScheduleJob ( std::function <void ()> && func, std::coroutine_handle <> handle )
+{
+	m_WaitingForJobs . insert ( handle . address () );
+	GetThreadPool () -> Submit ( [ Jobs = m_Jobs, Func = std::move ( func ), handle ] ()
+	{
+		{
+			std::lock_guard Lock ( Jobs -> Mutex );
+			if ( Jobs -> IsCancelled )
+				return;
+			Jobs -> RunningCount ++;
+		}
+		Func ();
+		std::lock_guard Lock ( Jobs -> Mutex );
+		Jobs -> Finished . push_back ( handle );
+		if ( -- Jobs -> RunningCount == 0 )
+			Jobs -> Idle . notify_all ();
+	} );
+}
+
+void TaskScheduler::Resume ( std::coroutine_handle <> handle )
+{
+	handle . resume ();
+	if ( handle . done () )
+	{
+		handle . destroy ();
+		m_TasksCount --;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,97 @@
+#include "Laniakea/ECS/ThreadPool.h"
+#include <algorithm>
+#include <latch>
+
+ThreadPool::ThreadPool ( std::size_t threadsCount )
+{
+	if ( threadsCount == 0 )
+		threadsCount = std::max ( std::thread::hardware_concurrency (), 2u ) - 1;
+	m_Workers . reserve ( threadsCount );
+	for ( std::size_t i = 0; i < threadsCount; i ++ ) {
+		m_Workers . emplace_back ( [ this ] () { WorkerLoop (); } );
+	}
+}
+
+ThreadPool::~ThreadPool ()
+{
+	{
+		std::lock_guard Lock ( m_Mutex );
+		m_IsStopping = true;
+	}
+	m_JobsAvailable . notify_all ();
+	for ( auto & Worker : m_Workers ) {
+		Worker . join ();
+	}
+}
+
+void ThreadPool::Submit ( std::function <void ()> job )
+{
+	{
+		std::lock_guard Lock ( m_Mutex );
+		m_Jobs . push_back ( std::move ( job ) );
+	}
+	m_JobsAvailable . notify_one ();
+}
+
+void ThreadPool::ParallelFor ( std::size_t count, std::size_t grainSize, const std::function <void ( std::size_t, std::size_t )> & func )
+{
+	if ( count == 0 )
+		return;
+	grainSize = std::max ( grainSize, std::size_t ( 1 ) );
+	const auto ChunksCount = std::min ( ( count + grainSize - 1 ) / grainSize, m_Workers . size () + 1 );
+	const auto ChunkSize = ( count + ChunksCount - 1 ) / ChunksCount;
+	if ( ChunksCount == 1 )
+	{
+		func ( 0, count );
+		return;
+	}
+
+	std::latch Done ( ( std::ptrdiff_t ) ChunksCount - 1 );
+	for ( std::size_t Chunk = 1; Chunk < ChunksCount; Chunk ++ ) {
+		const auto Begin = Chunk * ChunkSize;
+		const auto End = std::min ( Begin + ChunkSize, count );
+		Submit ( [ & func, & Done, Begin, End ] ()
+		{
+			if ( Begin < End )
+				func ( Begin, End );
+			Done . count_down ();
+		} );
+	}
+	func ( 0, std::min ( ChunkSize, count ) );
+	Done . wait ();
+}
+
+void ThreadPool::WaitIdle ()
+{
+	std::unique_lock Lock ( m_Mutex );
+	m_Idle . wait ( Lock, [ this ] () { return m_Jobs . empty () && m_RunningJobsCount == 0; } );
+}
+
+std::size_t ThreadPool::GetThreadsCount () const
+{
+	return m_Workers . size ();
+}
+
+void ThreadPool::WorkerLoop ()
+{
+	while ( true )
+	{
+		std::function <void ()> Job;
+		{
+			std::unique_lock Lock ( m_Mutex );
+			m_JobsAvailable . wait ( Lock, [ this ] () { return m_IsStopping || ! m_Jobs . empty (); } );
+			if ( m_Jobs . empty () )
+				return;
+			Job = std::move ( m_Jobs . front () );
+			m_Jobs . pop_front ();
+			m_RunningJobsCount ++;
+		}
+		Job ();
+		{
+			std::lock_guard Lock ( m_Mutex );
+			m_RunningJobsCount --;
+			if ( m_Jobs . empty () && m_RunningJobsCount == 0 )
+				m_Idle . notify_all ();
+		}
+	}
+}
\ No newline at end of file
@@ -0,0 +1,96 @@
+#include "Laniakea/ECS/Universe.h"
+#include <algorithm>
+#include <latch>
+
+Universe::Universe ( std::shared_ptr <ThreadPool> tickPool, std::shared_ptr <ThreadPool> jobPool )
+: m_TickPool ( tickPool ? std::move ( tickPool ) : std::make_shared <ThreadPool> () ),
+  m_JobPool ( jobPool ? std::move ( jobPool ) : std::make_shared <ThreadPool> () )
+{
+
+}
+
+WorldHandle Universe::CreateWorld ()
+{
+	auto Ecs = std::make_unique <ECS> ();
+	Ecs -> SetThreadPool ( m_JobPool );
+	return m_Worlds . AddObject ( { std::move ( Ecs ), {} } );
+}
+
+void Universe::DestroyWorld ( WorldHandle worldHandle )
+{
+	m_Worlds . RemoveObject ( worldHandle );
+}
+
+ECS & Universe::GetWorld ( WorldHandle worldHandle )
+{
+	return * m_Worlds . GetObject ( worldHandle ) . Ecs;
+}
+
+bool Universe::GetIsValidWorldHandle ( WorldHandle worldHandle ) const
+{
+	return m_Worlds . GetIsValidHandle ( worldHandle );
+}
+
+std::size_t Universe::GetWorldsCount () const
+{
+	return m_Worlds . Size ();
+}
+
+void Universe::Tick ( double deltaSeconds )
+{
+	m_TickOrder . clear ();
+	for ( World & world : m_Worlds ) {
+		m_TickOrder . push_back ( & world );
+	}
+	// Longest first, so the tick isn't prolonged by a heavy world started last
+	std::stable_sort ( m_TickOrder . begin (), m_TickOrder . end (),
+			[] ( const World * lhs, const World * rhs ) { return lhs -> LastTickTime > rhs -> LastTickTime; } );
+	m_TickCursor . store ( 0, std::memory_order_relaxed );
+
+	const auto HelpersCount = m_TickOrder . empty () ? 0 : std::min ( m_TickPool -> GetThreadsCount (), m_TickOrder . size () - 1 );
+	std::latch Done ( ( std::ptrdiff_t ) HelpersCount );
+	for ( std::size_t i = 0; i < HelpersCount; i ++ ) {
+		m_TickPool -> Submit ( [ this, & Done, deltaSeconds ] ()
+		{
+			TickWorlds ( deltaSeconds );
+			Done . count_down ();
+		} );
+	}
+	TickWorlds ( deltaSeconds );
+	Done . wait ();
+}
+
+std::chrono::nanoseconds Universe::GetLastTickTime ( WorldHandle worldHandle )
+{
+	return m_Worlds . GetObject ( worldHandle ) . LastTickTime;
+}
+
+EntityHandle Universe::MigrateEntity ( WorldHandle from, WorldHandle to, EntityHandle entityHandle )
+{
+	return GetWorld ( from ) . MigrateEntity ( entityHandle, GetWorld ( to ) );
+}
+
+std::shared_ptr <ThreadPool> Universe::GetTickPool () const
+{
+	return m_TickPool;
+}
+
+std::shared_ptr <ThreadPool> Universe::GetJobPool () const
+{
+	return m_JobPool;
+}
+
+void Universe::TickWorlds ( double deltaSeconds )
+{
+	while ( true )
+	{
+		const auto Index = m_TickCursor . fetch_add ( 1, std::memory_order_relaxed );
+		if ( Index >= m_TickOrder . size () )
+			return;
+		World & world = * m_TickOrder[ Index ];
+		const auto Start = std::chrono::steady_clock::now ();
+		world . Ecs -> RunSystems ();
+		world . Ecs -> UpdateTasks ( deltaSeconds );
+		world . LastTickTime = std::chrono::duration_cast <std::chrono::nanoseconds> ( std::chrono::steady_clock::now () - Start );
+	}
+}
\ No newline at end of file
@@ -2,7 +2,15 @@
 #include "Laniakea/ECS/PackedArray.h"
 #include "Laniakea/ECS/ECS.h"
 #include "Laniakea/ECS/ComponentBase.h"
+#include "Laniakea/ECS/EntityCommandBuffer.h"
+#include "Laniakea/ECS/Universe.h"
+#include "Laniakea/ECS/ECSReplayer.h"
+#include <latch>
+#include <limits>
+#include <sstream>
 #include <random>
+#include <thread>
+#include <set>
 
 #pragma region TestClasses
 struct Vector
@@ -91,6 +99,32 @@ struct DamageComponent : public ComponentBase
 };
 
 
+struct DeadComponent : public ComponentBase
+{
+	explicit DeadComponent ( EntityHandle owner )
+			: ComponentBase ( owner )
+	{};
+};
+
+class AliveMovementSystem : public System
+{
+public:
+
+	virtual void Run ( ECS & ecs ) override
+	{
+		ProcessedEntities . clear ();
+		for ( auto e : m_Entities ) {
+			auto & locationComponent = ecs . GetComponent <LocationComponent> ( e );
+			auto * movementComponent = ecs . TryGetComponent <MovementComponent> ( e );
+			if ( movementComponent )
+				locationComponent . Location += movementComponent -> Direction * movementComponent -> Speed;
+			ProcessedEntities . push_back ( e );
+		}
+	}
+
+	std::vector <EntityHandle> ProcessedEntities;
+};
+
 class DamageSystem : public System
 {
 public:
@@ -150,6 +184,44 @@ public:
 	}
 };
 
+class PerceptionSystem : public System
+{
+public:
+
+	virtual void Run ( ECS & ecs ) override
+	{
+		RunSlice ( ecs, 0, m_Entities . Size () );
+	}
+
+	virtual void RunSlice ( ECS &, std::size_t first, std::size_t count ) override
+	{
+		for ( std::size_t i = first; i < first + count; i ++ )
+			Visited . push_back ( m_Entities . GetObjectByIndex ( i ) );
+	}
+
+	virtual bool GetIsSliceable () const override
+	{
+		return true;
+	}
+
+	std::vector <EntityHandle> Visited;
+};
+
+Task CountFrames ( std::atomic <int> & counter, int frames );
+
+class TaskSpawningSystem : public System
+{
+public:
+
+	virtual void Run ( ECS & ecs ) override
+	{
+		for ( int i = 0; i < 8; i ++ )
+			ecs . StartTask ( CountFrames ( * Counter, 8 ) );
+	}
+
+	std::atomic <int> * Counter = nullptr;
+};
+
 std::vector <EntityHandle> PrepareECSSystemRun ( ECS & ecs )
 {
 	auto e1 = ecs . CreateEntity ();
@@ -184,6 +256,69 @@ std::vector <EntityHandle> PrepareECSSystemRun ( ECS & ecs )
 	}
 	return entityHandles;
 }
+Task StagedSpawn ( ECS & ecs, std::vector <EntityHandle> & spawned, int & jobResult )
+{
+	spawned . push_back ( ecs . CreateEntity () );
+	co_await NextFrame ();
+	spawned . push_back ( ecs . CreateEntity () );
+	co_await WaitFor ( 0.5 );
+	spawned . push_back ( ecs . CreateEntity () );
+	co_await Job ( [ & jobResult ] () { jobResult = 42; } );
+	spawned . push_back ( ecs . CreateEntity () );
+}
+
+Task CountFrames ( std::atomic <int> & counter, int frames )
+{
+	for ( int i = 0; i < frames; i ++ ) {
+		co_await NextFrame ();
+		counter ++;
+	}
+}
+
+Task RunJob ( int & jobResult )
+{
+	co_await Job ( [ & jobResult ] () { jobResult = 42; } );
+}
+
+SpatialPoint GetLocation ( const LocationComponent & location )
+{
+	return { location . Location . X, location . Location . Y, location . Location . Z };
+}
+
+void ExpectSpatialQueriesMatch ( ECS & ecs, const SpatialIndex <LocationComponent> & index, std::default_random_engine & gen )
+{
+	auto Locations = ecs . GetComponentsByType <LocationComponent> () . lock ();
+	std::uniform_real_distribution <float> distribution ( - 100.f, 100.f );
+	std::vector <EntityHandle> Result ( Locations -> Size () );
+	std::vector <SpatialNeighbour> Nearest ( 8 );
+	for ( int Query = 0; Query < 20; Query ++ ) {
+		const SpatialPoint Center { distribution ( gen ), distribution ( gen ), distribution ( gen ) };
+		const float Radius = 15.f;
+		std::set <EntityHandle> InRadius;
+		std::set <EntityHandle> InBox;
+		std::vector <std::pair <float, EntityHandle>> Distances;
+		for ( const auto & Location : * Locations ) {
+			const auto Position = GetLocation ( Location );
+			const float X = Position . X - Center . X, Y = Position . Y - Center . Y, Z = Position . Z - Center . Z;
+			if ( X * X + Y * Y + Z * Z <= Radius * Radius )
+				InRadius . insert ( Location . GetOwner () );
+			if ( std::abs ( X ) <= Radius && std::abs ( Y ) <= Radius && std::abs ( Z ) <= Radius )
+				InBox . insert ( Location . GetOwner () );
+			Distances . emplace_back ( X * X + Y * Y + Z * Z, Location . GetOwner () );
+		}
+		std::sort ( Distances . begin (), Distances . end () );
+
+		auto Count = index . QueryRadius ( Center, Radius, Result );
+		EXPECT_EQ ( std::set <EntityHandle> ( Result . begin (), Result . begin () + Count ), InRadius );
+		Count = index . QueryAABB ( { { Center . X - Radius, Center . Y - Radius, Center . Z - Radius }, { Center . X + Radius, Center . Y + Radius, Center . Z + Radius } }, Result );
+		EXPECT_EQ ( std::set <EntityHandle> ( Result . begin (), Result . begin () + Count ), InBox );
+		Count = index . QueryNearest ( Center, Nearest );
+		ASSERT_EQ ( Count, Nearest . size () );
+		for ( std::size_t i = 0; i < Count; i ++ ) {
+			EXPECT_EQ ( Nearest[ i ] . Entity, Distances[ i ] . second );
+		}
+	}
+}
 #pragma endregion
 TEST ( PackedArray, PackedArray )
 {
@@ -229,6 +364,31 @@ TEST ( PackedArray, PackedArray )
 	std::cout << "(Packed array) tests passed" << std::endl;
 }
 
+TEST ( PackedArray, ShrinkToFit )
+{
+	PackedArray <int> data;
+	std::vector <PackedArrayHandle> Handles;
+	for ( int i = 0; i < 100; i ++ )
+		Handles . push_back ( data . Add ( int ( i ) ) );
+	for ( int i = 10; i < 100; i ++ ) {
+		if ( i != 50 )
+			data . Remove ( Handles[ i ] );
+	}
+	data . Remove ( Handles[ 3 ] );
+
+	data . ShrinkToFit ();
+	EXPECT_EQ ( data . Capacity (), size_t ( 10 ) );
+	EXPECT_EQ ( data . Get ( Handles[ 50 ] ), 50 );
+	EXPECT_EQ ( data . Get ( Handles[ 9 ] ), 9 );
+
+	// Free handles above the highest used one are dropped, the lower ones are reused in ascending order.
+	EXPECT_EQ ( data . Add ( 3 ), Handles[ 3 ] );
+	EXPECT_EQ ( data . Add ( 10 ), Handles[ 10 ] );
+	data . Remove ( Handles[ 50 ] );
+	data . ShrinkToFit ();
+	EXPECT_EQ ( data . GetNextHandle (), PackedArrayHandle ( 11 ) );
+}
+
 class EntityComponentSystem : public testing::Test
 {
 
@@ -355,6 +515,822 @@ TEST_F ( EntityComponentSystem, SystemRun )
 	EXPECT_TRUE ( ecs . RunSystemChecked <RenderSystem> () );
 }
 
+TEST_F ( EntityComponentSystem, QueryFilter )
+{
+	ecs . RegisterComponent <LocationComponent> ();
+	ecs . RegisterComponent <MovementComponent> ();
+	ecs . RegisterComponent <DeadComponent> ();
+	ecs . RegisterSystem <AliveMovementSystem, query::With <LocationComponent>, query::Without <DeadComponent>> ();
+
+	auto e1 = ecs . CreateEntity ();
+	auto e2 = ecs . CreateEntity ();
+	auto e3 = ecs . CreateEntity ();
+	ecs . AddComponent <LocationComponent> ( e1, { e1, { 0.f, 0.f, 0.f } } );
+	ecs . AddComponent <MovementComponent> ( e1, { e1, 1.f, { 1.f, 0.f, 0.f } } );
+	ecs . AddComponent <LocationComponent> ( e2, { e2, { 0.f, 0.f, 0.f } } );
+	ecs . AddComponent <LocationComponent> ( e3, { e3, { 0.f, 0.f, 0.f } } );
+	ecs . AddComponent <DeadComponent> ( e3, DeadComponent ( e3 ) );
+
+	auto system = ecs . GetSystem <AliveMovementSystem> () . lock ();
+	ecs . RunSystem <AliveMovementSystem> ();
+	EXPECT_EQ ( system -> ProcessedEntities . size (), size_t ( 2 ) );
+	EXPECT_TRUE ( ecs . GetComponent <LocationComponent> ( e1 ) . Location == Vector ( 1.f, 0.f, 0.f ) );
+	EXPECT_TRUE ( ecs . GetComponent <LocationComponent> ( e2 ) . Location == Vector ( 0.f, 0.f, 0.f ) );
+
+	// Entity leaves the system as soon as the excluded component is attached and returns back once it's removed.
+	ecs . AddComponent <DeadComponent> ( e1, DeadComponent ( e1 ) );
+	ecs . RemoveComponent <DeadComponent> ( e3 );
+	ecs . RunSystem <AliveMovementSystem> ();
+	ASSERT_EQ ( system -> ProcessedEntities . size (), size_t ( 2 ) );
+	EXPECT_TRUE ( std::find ( system -> ProcessedEntities . begin (), system -> ProcessedEntities . end (), e1 ) == system -> ProcessedEntities . end () );
+	EXPECT_TRUE ( std::find ( system -> ProcessedEntities . begin (), system -> ProcessedEntities . end (), e3 ) != system -> ProcessedEntities . end () );
+
+	std::size_t Visited = 0;
+	std::size_t WithMovement = 0;
+	ecs . ForEach <LocationComponent, query::Without <DeadComponent>, query::Optional <MovementComponent>> (
+			[ & ] ( EntityHandle e, LocationComponent & location, MovementComponent * movement )
+			{
+				EXPECT_EQ ( location . GetOwner (), e );
+				EXPECT_NE ( e, e1 );
+				Visited ++;
+				if ( movement )
+					WithMovement ++;
+			} );
+	EXPECT_EQ ( Visited, size_t ( 2 ) );
+	EXPECT_EQ ( WithMovement, size_t ( 0 ) );
+
+	// The smaller MovementComponent array drives the view, the other terms are still tested per entity.
+	auto e4 = ecs . CreateEntity ();
+	ecs . AddComponent <MovementComponent> ( e4, { e4, 1.f, { 0.f, 1.f, 0.f } } );
+	Visited = 0;
+	ecs . ForEach <LocationComponent, MovementComponent> ( [ & ] ( EntityHandle e, LocationComponent &, MovementComponent & movement )
+	{
+		EXPECT_EQ ( e, e1 );
+		EXPECT_EQ ( movement . GetOwner (), e1 );
+		EXPECT_EQ ( & movement, & ecs . GetComponent <MovementComponent> ( e1 ) );
+		Visited ++;
+	} );
+	EXPECT_EQ ( Visited, size_t ( 1 ) );
+	Visited = 0;
+	ecs . ForEach <MovementComponent, query::Without <DeadComponent>> ( [ & ] ( EntityHandle e, MovementComponent & )
+	{
+		EXPECT_EQ ( e, e4 );
+		Visited ++;
+	} );
+	EXPECT_EQ ( Visited, size_t ( 1 ) );
+
+	// Nothing matches a required component that isn't registered.
+	Visited = 0;
+	ecs . ForEach <LocationComponent, HPComponent> ( [ & ] ( EntityHandle, LocationComponent &, HPComponent & ) { Visited ++; } );
+	EXPECT_EQ ( Visited, size_t ( 0 ) );
+
+	EXPECT_TRUE ( ecs . TryGetComponent <MovementComponent> ( e1 ) != nullptr );
+	EXPECT_TRUE ( ecs . TryGetComponent <MovementComponent> ( e2 ) == nullptr );
+
+	// The driving array reaches the entities through the owners, so a component owned by another entity is rejected
+#ifndef NDEBUG
+	EXPECT_DEATH ( ecs . AddComponent <MovementComponent> ( e2, { e1, 1.f, { 0.f, 0.f, 1.f } } ), "owned by the entity" );
+#endif
+}
+
+TEST_F ( EntityComponentSystem, PersistentQuery )
+{
+	ecs . RegisterComponent <LocationComponent> ();
+	ecs . RegisterComponent <HPComponent> ();
+	ecs . RegisterComponent <DeadComponent> ();
+
+	auto e1 = ecs . CreateEntity ();
+	auto e2 = ecs . CreateEntity ();
+	ecs . AddComponent <LocationComponent> ( e1, { e1, { 0.f, 0.f, 0.f } } );
+	ecs . AddComponent <HPComponent> ( e1, { e1, 100 } );
+
+	// Existing entities are picked up at registration.
+	auto Query = ecs . RegisterQuery <LocationComponent, query::Without <DeadComponent>, query::Optional <HPComponent>> ();
+	auto SameQuery = ecs . RegisterQuery <query::With <LocationComponent>, query::Without <DeadComponent>> ();
+	EXPECT_EQ ( Query . Size (), size_t ( 1 ) );
+	EXPECT_EQ ( SameQuery . Size (), size_t ( 1 ) );
+
+	// Structural changes update the shared backing list.
+	ecs . AddComponent <LocationComponent> ( e2, { e2, { 1.f, 1.f, 1.f } } );
+	EXPECT_EQ ( Query . Size (), size_t ( 2 ) );
+	EXPECT_EQ ( SameQuery . Size (), size_t ( 2 ) );
+
+	ecs . AddComponent <DeadComponent> ( e1, DeadComponent ( e1 ) );
+	EXPECT_EQ ( Query . Size (), size_t ( 1 ) );
+	EXPECT_EQ ( * Query . begin (), e2 );
+
+	std::size_t Visited = 0;
+	ecs . ForEach ( Query, [ & ] ( EntityHandle e, LocationComponent & location, HPComponent * hp )
+	{
+		EXPECT_EQ ( e, e2 );
+		EXPECT_EQ ( location . GetOwner (), e2 );
+		EXPECT_TRUE ( hp == nullptr );
+		Visited ++;
+	} );
+	EXPECT_EQ ( Visited, size_t ( 1 ) );
+
+	ecs . RemoveComponent <DeadComponent> ( e1 );
+	EXPECT_EQ ( Query . Size (), size_t ( 2 ) );
+	ecs . RemoveEntity ( e2 );
+	EXPECT_EQ ( Query . Size (), size_t ( 1 ) );
+	EXPECT_EQ ( * SameQuery . begin (), e1 );
+}
+
+TEST_F ( EntityComponentSystem, OwningGroup )
+{
+	ecs . RegisterComponent <LocationComponent> ();
+	ecs . RegisterComponent <MovementComponent> ();
+	ecs . RegisterComponent <HPComponent> ();
+
+	std::vector <EntityHandle> Entities;
+	for ( int i = 0; i < 8; i ++ ) {
+		auto e = ecs . CreateEntity ();
+		Entities . push_back ( e );
+		ecs . AddComponent <LocationComponent> ( e, { e, { 0.f, 0.f, 0.f } } );
+		if ( i % 2 == 0 )
+			ecs . AddComponent <MovementComponent> ( e, { e, 1.f, { 1.f, 1.f, 1.f } } );
+	}
+
+	auto GroupPtr = ecs . RegisterGroup <LocationComponent, MovementComponent> () . lock ();
+	ASSERT_TRUE ( GroupPtr );
+	EXPECT_EQ ( GroupPtr -> Size (), size_t ( 4 ) );
+	EXPECT_TRUE ( ( ecs . RegisterGroupChecked <MovementComponent, HPComponent> () . expired () ) );
+#ifndef NDEBUG
+	EXPECT_DEATH ( ( ecs . RegisterGroup <MovementComponent, HPComponent> () ), "owned by another group" );
+#endif
+	EXPECT_TRUE ( ( ecs . GetGroup <LocationComponent, MovementComponent> () . lock () == GroupPtr ) );
+
+	auto CheckLockstep = [ & ] ()
+	{
+		auto Locations = GroupPtr -> GetComponents <LocationComponent> ();
+		auto Movements = GroupPtr -> GetComponents <MovementComponent> ();
+		auto GroupEntities = GroupPtr -> GetEntities ();
+		for ( std::size_t i = 0; i < GroupPtr -> Size (); i ++ ) {
+			EXPECT_EQ ( Locations[ i ] . GetOwner (), GroupEntities[ i ] );
+			EXPECT_EQ ( Movements[ i ] . GetOwner (), GroupEntities[ i ] );
+		}
+	};
+	CheckLockstep ();
+
+	// Gaining the last grouped component moves the entity into the group.
+	ecs . AddComponent <MovementComponent> ( Entities[ 1 ], { Entities[ 1 ], 2.f, { 1.f, 0.f, 0.f } } );
+	EXPECT_EQ ( GroupPtr -> Size (), size_t ( 5 ) );
+	CheckLockstep ();
+
+	// Losing any of them moves it out of the group.
+	ecs . RemoveComponent <LocationComponent> ( Entities[ 0 ] );
+	EXPECT_TRUE ( ecs . RemoveComponentChecked <MovementComponent> ( Entities[ 2 ] ) );
+	ecs . RemoveEntity ( Entities[ 4 ] );
+	EXPECT_EQ ( GroupPtr -> Size (), size_t ( 2 ) );
+	CheckLockstep ();
+
+	GroupPtr -> Each ( [ & ] ( EntityHandle, LocationComponent & location, MovementComponent & movement )
+	{
+		location . Location += movement . Direction * movement . Speed;
+	} );
+	EXPECT_TRUE ( ecs . GetComponent <LocationComponent> ( Entities[ 1 ] ) . Location == Vector ( 2.f, 0.f, 0.f ) );
+	EXPECT_TRUE ( ecs . GetComponent <LocationComponent> ( Entities[ 6 ] ) . Location == Vector ( 1.f, 1.f, 1.f ) );
+	EXPECT_TRUE ( ecs . GetComponent <LocationComponent> ( Entities[ 3 ] ) . Location == Vector ( 0.f, 0.f, 0.f ) );
+}
+
+TEST_F ( EntityComponentSystem, BatchDestruction )
+{
+	ecs . RegisterComponent <LocationComponent> ();
+	ecs . RegisterComponent <MovementComponent> ();
+	ecs . RegisterComponent <HPComponent> ();
+	ecs . RegisterSystem <MovementSystem, LocationComponent, MovementComponent> ();
+
+	std::vector <EntityHandle> Entities;
+	for ( int i = 0; i < 3000; i ++ ) {
+		auto e = ecs . CreateEntity ();
+		Entities . push_back ( e );
+		ecs . AddComponent <LocationComponent> ( e, { e, { float ( i ), 0.f, 0.f } } );
+		if ( i % 3 == 0 )
+			ecs . AddComponent <MovementComponent> ( e, { e, 1.f, { 0.f, 1.f, 0.f } } );
+	}
+	auto Query = ecs . RegisterQuery <LocationComponent> ();
+
+	ecs . DestroyEntities ( std::span <const EntityHandle> ( Entities . data (), 1000 ) );
+	EXPECT_EQ ( Query . Size (), size_t ( 2000 ) );
+	EXPECT_FALSE ( ecs . GetIsValidEntityHandle ( Entities[ 999 ] ) );
+	EXPECT_TRUE ( ecs . RunSystemChecked <MovementSystem> () );
+	EXPECT_TRUE ( ecs . GetComponent <LocationComponent> ( Entities[ 1002 ] ) . Location == Vector ( 1002.f, 1.f, 0.f ) );
+
+	// Duplicates and stale handles in the queue are skipped.
+	for ( std::size_t i = 1000; i < Entities . size (); i ++ )
+		ecs . DestroyDeferred ( Entities[ i ] );
+	ecs . DestroyDeferred ( Entities[ 1500 ] );
+	ecs . DestroyDeferred ( Entities[ 0 ] );
+	EXPECT_EQ ( ecs . GetDeferredDestroysCount (), size_t ( 2002 ) );
+	EXPECT_TRUE ( ecs . GetIsValidEntityHandle ( Entities[ 1500 ] ) );
+
+	// A spent budget stops after the first batch, the rest stays queued for the next call.
+	EXPECT_EQ ( ecs . ProcessDeferredDestroys ( std::chrono::microseconds ( 1 ) ), ECS::DeferredDestroyBatchSize );
+	EXPECT_EQ ( ecs . GetDeferredDestroysCount (), size_t ( 2002 ) - ECS::DeferredDestroyBatchSize );
+	EXPECT_EQ ( ecs . ProcessDeferredDestroys (), size_t ( 2000 ) - ECS::DeferredDestroyBatchSize );
+	EXPECT_EQ ( ecs . GetDeferredDestroysCount (), size_t ( 0 ) );
+	EXPECT_EQ ( Query . Size (), size_t ( 0 ) );
+	EXPECT_TRUE ( ecs . RunSystemChecked <MovementSystem> () );
+
+	// Freed slots are reused by new entities.
+	auto e = ecs . CreateEntity ();
+	ecs . AddComponent <HPComponent> ( e, { e, 1 } );
+	EXPECT_EQ ( ecs . GetComponent <HPComponent> ( e ) . HP, 1 );
+}
+
+TEST_F ( EntityComponentSystem, Compaction )
+{
+	ecs . RegisterComponent <LocationComponent> ();
+	ecs . RegisterSystem <RenderSystem, LocationComponent> ();
+	auto Query = ecs . RegisterQuery <LocationComponent> ();
+
+	std::vector <EntityHandle> Entities;
+	for ( int i = 0; i < 1000; i ++ ) {
+		auto e = ecs . CreateEntity ();
+		Entities . push_back ( e );
+		ecs . AddComponent <LocationComponent> ( e, { e, { float ( i ), 0.f, 0.f } } );
+	}
+	ecs . DestroyEntities ( std::span <const EntityHandle> ( Entities . data () + 10, Entities . size () - 10 ) );
+
+	const auto Locations = ecs . GetComponentsByType <LocationComponent> () . lock ();
+	EXPECT_GE ( Locations -> Capacity (), size_t ( 1000 ) );
+	ecs . Compact ();
+	EXPECT_EQ ( Locations -> Capacity (), size_t ( 10 ) );
+	EXPECT_EQ ( Query . Size (), size_t ( 10 ) );
+	for ( int i = 0; i < 10; i ++ )
+		EXPECT_TRUE ( ecs . GetComponent <LocationComponent> ( Entities[ i ] ) . Location == Vector ( float ( i ), 0.f, 0.f ) );
+
+	// Dropping below the occupancy compacts automatically.
+	ecs . SetAutoCompactOccupancy ( 0.5f );
+	for ( int i = 0; i < 4; i ++ )
+		ecs . RemoveEntity ( Entities[ i ] );
+	EXPECT_EQ ( Locations -> Capacity (), size_t ( 10 ) );
+	ecs . RemoveEntity ( Entities[ 4 ] );
+	ecs . RemoveEntity ( Entities[ 5 ] );
+	EXPECT_EQ ( Locations -> Capacity (), size_t ( 4 ) );
+	EXPECT_TRUE ( ecs . RunSystemChecked <RenderSystem> () );
+}
+
+TEST_F ( EntityComponentSystem, SystemSchedule )
+{
+	ecs . RegisterComponent <LocationComponent> ();
+	ecs . RegisterSystem <PerceptionSystem, LocationComponent> ();
+	ecs . RegisterSystem <RenderSystem, LocationComponent> ();
+	for ( int i = 0; i < 10; i ++ ) {
+		auto e = ecs . CreateEntity ();
+		ecs . AddComponent <LocationComponent> ( e, { e, { 0.f, 0.f, 0.f } } );
+	}
+	auto Perception = ecs . GetSystem <PerceptionSystem> () . lock ();
+
+	// Every n-th tick
+	ecs . SetSystemSchedule <PerceptionSystem> ( SystemSchedule::EveryNTicks ( 3 ) );
+	for ( int i = 0; i < 6; i ++ )
+		ecs . RunSystems ();
+	EXPECT_EQ ( Perception -> Visited . size (), size_t ( 20 ) );
+	EXPECT_EQ ( ecs . GetSystemStats <PerceptionSystem> () . RunsCount, std::uint64_t ( 2 ) );
+	EXPECT_EQ ( ecs . GetSystemStats <RenderSystem> () . RunsCount, std::uint64_t ( 6 ) );
+
+	// Round-robin buckets visit every entity once per full pass
+	Perception -> Visited . clear ();
+	Perception -> ResetStats ();
+	ecs . SetSystemSchedule <PerceptionSystem> ( SystemSchedule::RoundRobin ( 4 ) );
+	ecs . RunSystem <PerceptionSystem> ();
+	EXPECT_EQ ( Perception -> Visited . size (), size_t ( 3 ) );
+	for ( int i = 0; i < 3; i ++ )
+		ecs . RunSystem <PerceptionSystem> ();
+	EXPECT_EQ ( std::set <EntityHandle> ( Perception -> Visited . begin (), Perception -> Visited . end () ) . size (), size_t ( 10 ) );
+	EXPECT_EQ ( Perception -> GetStats () . LastProcessedEntitiesCount, size_t ( 1 ) );
+
+	// Systems without slicing run whole on every tick under the round-robin schedule
+	auto Render = ecs . GetSystem <RenderSystem> () . lock ();
+	Render -> ResetStats ();
+	ecs . SetSystemSchedule <RenderSystem> ( SystemSchedule::RoundRobin ( 4 ) );
+	for ( int i = 0; i < 4; i ++ )
+		ecs . RunSystem <RenderSystem> ();
+	EXPECT_EQ ( Render -> GetStats () . RunsCount, std::uint64_t ( 4 ) );
+	EXPECT_EQ ( Render -> GetStats () . ProcessedEntitiesCount, std::uint64_t ( 40 ) );
+
+	// Budget resumes from the saved cursor
+	Perception -> Visited . clear ();
+	ecs . SetSystemSchedule <PerceptionSystem> ( SystemSchedule::WithBudget ( std::chrono::microseconds ( 0 ), 4 ) );
+	ecs . RunSystem <PerceptionSystem> ();
+	ecs . RunSystem <PerceptionSystem> ();
+	ecs . RunSystem <PerceptionSystem> ();
+	EXPECT_EQ ( Perception -> Visited . size (), size_t ( 10 ) );
+	EXPECT_EQ ( std::set <EntityHandle> ( Perception -> Visited . begin (), Perception -> Visited . end () ) . size (), size_t ( 10 ) );
+
+	Perception -> Visited . clear ();
+	ecs . SetSystemSchedule <PerceptionSystem> ( SystemSchedule::WithBudget ( std::chrono::microseconds ( 1000000 ), 4 ) );
+	ecs . RunSystem <PerceptionSystem> ();
+	EXPECT_EQ ( Perception -> Visited . size (), size_t ( 10 ) );
+	EXPECT_FALSE ( ( ecs . SetSystemScheduleChecked <DamageSystem> ( SystemSchedule::EveryTick () ) ) );
+
+	// Zero period is rejected instead of dividing by zero on the next run
+	SystemSchedule ZeroPeriod = SystemSchedule::RoundRobin ( 4 );
+	ZeroPeriod . Period = 0;
+	EXPECT_FALSE ( ZeroPeriod . GetIsValid () );
+	EXPECT_EQ ( SystemSchedule::EveryNTicks ( 0 ) . Period, 1u );
+	EXPECT_FALSE ( ( ecs . SetSystemScheduleChecked <PerceptionSystem> ( ZeroPeriod ) ) );
+	EXPECT_EQ ( Perception -> GetSchedule () . Period, 1u );
+#ifndef NDEBUG
+	EXPECT_DEATH ( ecs . SetSystemSchedule <PerceptionSystem> ( ZeroPeriod ), "must be non-zero" );
+#endif
+}
+
+TEST_F ( EntityComponentSystem, CoroutineTasks )
+{
+	std::vector <EntityHandle> Spawned;
+	int JobResult = 0;
+	ecs . StartTask ( StagedSpawn ( ecs, Spawned, JobResult ) );
+	EXPECT_EQ ( Spawned . size (), size_t ( 1 ) );
+	EXPECT_EQ ( ecs . GetTasksCount (), size_t ( 1 ) );
+
+	ecs . UpdateTasks ( 0.1 );
+	EXPECT_EQ ( Spawned . size (), size_t ( 2 ) );
+	ecs . UpdateTasks ( 0.25 );
+	EXPECT_EQ ( Spawned . size (), size_t ( 2 ) );
+	ecs . UpdateTasks ( 0.25 );
+	EXPECT_EQ ( Spawned . size (), size_t ( 3 ) );
+
+	for ( int i = 0; i < 1000 && ecs . GetTasksCount () != 0; i ++ ) {
+		std::this_thread::sleep_for ( std::chrono::milliseconds ( 1 ) );
+		ecs . UpdateTasks ( 0.0 );
+	}
+	EXPECT_EQ ( ecs . GetTasksCount (), size_t ( 0 ) );
+	EXPECT_EQ ( Spawned . size (), size_t ( 4 ) );
+	EXPECT_EQ ( JobResult, 42 );
+
+	// Thousands of suspended tasks resume in one batch per update
+	std::atomic <int> Counter = 0;
+	for ( int i = 0; i < 5000; i ++ )
+		ecs . StartTask ( CountFrames ( Counter, 3 ) );
+	for ( int i = 0; i < 3; i ++ ) {
+		ecs . UpdateTasks ( 0.016 );
+		EXPECT_EQ ( Counter . load (), 5000 * ( i + 1 ) );
+	}
+	EXPECT_EQ ( ecs . GetTasksCount (), size_t ( 0 ) );
+
+	// Suspended tasks are destroyed with the ECS
+	ecs . StartTask ( CountFrames ( Counter, 3 ) );
+	EXPECT_EQ ( ecs . GetTasksCount (), size_t ( 1 ) );
+}
+
+TEST ( TaskScheduler, FramesAndJobsAcrossThreads )
+{
+	// Frames allocated on a thread which has exited are handed back to its allocator, not to this thread
+	std::atomic <int> Counter = 0;
+	{
+		std::vector <Task> Tasks;
+		std::thread Worker ( [ & ] ()
+		{
+			for ( int i = 0; i < 256; i ++ )
+				Tasks . push_back ( CountFrames ( Counter, 1 ) );
+		} );
+		Worker . join ();
+	}
+	TaskScheduler Scheduler;
+	for ( int i = 0; i < 256; i ++ )
+		Scheduler . Start ( CountFrames ( Counter, 1 ) );
+	Scheduler . Update ( 0.0 );
+	EXPECT_EQ ( Counter . load (), 256 );
+
+	// The destroyed scheduler doesn't wait for the jobs of others on the shared pool and skips its queued jobs
+	auto Pool = std::make_shared <ThreadPool> ( 1 );
+	std::latch Unblock ( 1 );
+	Pool -> Submit ( [ & Unblock ] () { Unblock . wait (); } );
+	int JobResult = 0;
+	{
+		TaskScheduler Queued;
+		Queued . SetThreadPool ( Pool );
+		Queued . Start ( RunJob ( JobResult ) );
+		EXPECT_EQ ( Queued . GetTasksCount (), size_t ( 1 ) );
+	}
+	Unblock . count_down ();
+	Pool -> WaitIdle ();
+	EXPECT_EQ ( JobResult, 0 );
+}
+
+TEST_F ( EntityComponentSystem, SecondaryIndices )
+{
+	ecs . RegisterComponent <HPComponent> ();
+	std::vector <EntityHandle> Entities;
+	for ( int i = 0; i < 100; i ++ ) {
+		auto e = ecs . CreateEntity ();
+		Entities . push_back ( e );
+		ecs . AddComponent <HPComponent> ( e, { e, i } );
+	}
+
+	auto ByHP = ecs . AddSortedIndex <HPComponent> ( & HPComponent::HP );
+	auto ByTeam = ecs . AddHashIndex <HPComponent> ( [] ( const HPComponent & hp ) { return hp . HP % 4; } );
+	auto Histogram = ecs . AddHistogramIndex <HPComponent> ( & HPComponent::HP, 0, 100, 10 );
+	EXPECT_EQ ( ByHP -> Size (), size_t ( 100 ) );
+
+	auto Weak = ByHP -> LessThan ( 20 );
+	ASSERT_EQ ( Weak . size (), size_t ( 20 ) );
+	EXPECT_EQ ( Weak . front (), Entities[ 0 ] );
+	EXPECT_EQ ( Weak . back (), Entities[ 19 ] );
+	EXPECT_EQ ( ByHP -> Range ( 40, 45 ) . size (), size_t ( 5 ) );
+	EXPECT_EQ ( ByTeam -> Equal ( 3 ) . size (), size_t ( 25 ) );
+	EXPECT_EQ ( Histogram -> Range ( 15, 37 ) . size (), size_t ( 22 ) );
+	EXPECT_EQ ( Histogram -> EstimateRange ( 15, 37 ), size_t ( 30 ) );
+
+	// Mutation paths keep the indices up to date
+	ecs . PatchComponent <HPComponent> ( Entities[ 50 ], [] ( HPComponent & hp ) { hp . HP = 5; } );
+	ecs . GetComponent <HPComponent> ( Entities[ 60 ] ) . HP = 7;
+	ecs . MarkComponentChanged <HPComponent> ( Entities[ 60 ] );
+	ecs . RemoveEntity ( Entities[ 0 ] );
+	ecs . RemoveComponent <HPComponent> ( Entities[ 1 ] );
+	auto e = ecs . CreateEntity ();
+	ecs . AddComponent <HPComponent> ( e, { e, 3 } );
+
+	Weak = ByHP -> LessThan ( 20 );
+	EXPECT_EQ ( Weak . size (), size_t ( 21 ) );
+	EXPECT_EQ ( ByHP -> Equal ( 7 ) . size (), size_t ( 2 ) );
+	EXPECT_EQ ( ByHP -> Equal ( 3 ) . size (), size_t ( 2 ) );
+	EXPECT_EQ ( ByHP -> Equal ( 50 ) . size (), size_t ( 0 ) );
+	EXPECT_EQ ( ByTeam -> Equal ( 1 ) . size (), size_t ( 25 ) );
+	EXPECT_EQ ( Histogram -> Range ( 0, 10 ) . size (), size_t ( 11 ) );
+
+	std::vector <EntityHandle> Rest ( Entities . begin () + 2, Entities . end () );
+	ecs . DestroyEntities ( Rest );
+	EXPECT_EQ ( ByHP -> Size (), size_t ( 1 ) );
+	EXPECT_EQ ( ByHP -> GreaterOrEqual ( 0 ) . size (), size_t ( 1 ) );
+	EXPECT_EQ ( ByTeam -> Equal ( 3 ) . front (), e );
+	EXPECT_EQ ( Histogram -> GetBucketSize ( 0 ), size_t ( 1 ) );
+
+	// Entities sharing the key are erased individually
+	std::vector <EntityHandle> Same;
+	for ( int i = 0; i < 1000; i ++ ) {
+		auto Entity = ecs . CreateEntity ();
+		Same . push_back ( Entity );
+		ecs . AddComponent <HPComponent> ( Entity, { Entity, 9 } );
+	}
+	EXPECT_EQ ( ByHP -> Equal ( 9 ) . size (), size_t ( 1000 ) );
+	std::vector <EntityHandle> Odd;
+	for ( std::size_t i = 1; i < Same . size (); i += 2 )
+		Odd . push_back ( Same[ i ] );
+	ecs . DestroyEntities ( Odd );
+	std::vector <EntityHandle> Even;
+	for ( std::size_t i = 0; i < Same . size (); i += 2 )
+		Even . push_back ( Same[ i ] );
+	std::sort ( Even . begin (), Even . end () );
+	const auto Left = ByHP -> Equal ( 9 );
+	EXPECT_TRUE ( std::equal ( Left . begin (), Left . end (), Even . begin (), Even . end () ) );
+}
+
+TEST_F ( EntityComponentSystem, IndexChangeTracking )
+{
+	ecs . RegisterComponent <HPComponent> ();
+	ecs . RegisterComponent <MovementComponent> ();
+	std::vector <EntityHandle> Entities;
+	for ( int i = 0; i < 10; i ++ ) {
+		auto e = ecs . CreateEntity ();
+		Entities . push_back ( e );
+		ecs . AddComponent <HPComponent> ( e, { e, i } );
+		ecs . AddComponent <MovementComponent> ( e, { e, ( float ) i, { 1.f, 0.f, 0.f } } );
+	}
+	auto ByHP = ecs . AddSortedIndex <HPComponent> ( & HPComponent::HP );
+	auto BySpeed = ecs . AddHistogramIndex <MovementComponent> ( & MovementComponent::Speed, 0.f, 10.f, 5 );
+
+	// The mutable accessors mark the components, the next query rereads them
+	ecs . GetComponent <HPComponent> ( Entities[ 0 ] ) . HP = 50;
+	ecs . TryGetComponent <HPComponent> ( Entities[ 1 ] ) -> HP = 51;
+	ecs . GetComponentChecked <HPComponent> ( Entities[ 2 ] ) -> get () . HP = 52;
+	EXPECT_TRUE ( ByHP -> LessThan ( 3 ) . empty () );
+	EXPECT_EQ ( ByHP -> GreaterOrEqual ( 50 ) . size (), size_t ( 3 ) );
+	ecs . ForEach <HPComponent> ( [] ( EntityHandle, HPComponent & hp ) { hp . HP += 100; } );
+	EXPECT_TRUE ( ByHP -> LessThan ( 100 ) . empty () );
+	EXPECT_EQ ( ByHP -> GreaterOrEqual ( 150 ) . size (), size_t ( 3 ) );
+
+	// The marked component removed before the query is dropped from the index
+	ecs . GetComponent <HPComponent> ( Entities[ 3 ] ) . HP = 1;
+	ecs . RemoveComponent <HPComponent> ( Entities[ 3 ] );
+	EXPECT_EQ ( ByHP -> Size (), size_t ( 9 ) );
+	EXPECT_TRUE ( ByHP -> Equal ( 1 ) . empty () );
+
+	// Writes through the component array are marked explicitly
+	auto HPs = ecs . GetComponentsByType <HPComponent> () . lock ();
+	for ( auto & HP : * HPs )
+		HP . HP = 7;
+	for ( const auto Entity : Entities ) {
+		if ( ecs . GetEntityHasComponent <HPComponent> ( Entity ) )
+			ecs . MarkComponentChanged <HPComponent> ( Entity );
+	}
+	EXPECT_EQ ( ByHP -> Equal ( 7 ) . size (), size_t ( 9 ) );
+
+	// NaN and infinite keys are clamped into the first and the last bucket
+	ecs . GetComponent <MovementComponent> ( Entities[ 0 ] ) . Speed = std::numeric_limits <float>::quiet_NaN ();
+	ecs . GetComponent <MovementComponent> ( Entities[ 1 ] ) . Speed = std::numeric_limits <float>::infinity ();
+	EXPECT_EQ ( BySpeed -> GetBucketSize ( 0 ), size_t ( 1 ) );
+	EXPECT_EQ ( BySpeed -> GetBucketSize ( 4 ), size_t ( 3 ) );
+	EXPECT_EQ ( BySpeed -> Range ( 0.f, std::numeric_limits <float>::infinity () ) . size (), size_t ( 8 ) );
+	EXPECT_EQ ( BySpeed -> EstimateRange ( std::numeric_limits <float>::quiet_NaN (), 1.f ), size_t ( 0 ) );
+}
+
+TEST_F ( EntityComponentSystem, SpatialIndex )
+{
+	ecs . RegisterComponent <LocationComponent> ();
+	ecs . RegisterComponent <MovementComponent> ();
+	ecs . RegisterSystem <MovementSystem, LocationComponent, MovementComponent> ();
+	std::default_random_engine gen;
+	std::uniform_real_distribution <float> distribution ( - 100.f, 100.f );
+	std::vector <EntityHandle> Entities;
+	for ( int i = 0; i < 10000; i ++ ) {
+		auto e = ecs . CreateEntity ();
+		Entities . push_back ( e );
+		ecs . AddComponent <LocationComponent> ( e, { e, { distribution ( gen ), distribution ( gen ), distribution ( gen ) } } );
+		ecs . AddComponent <MovementComponent> ( e, { e, 0.01f, { distribution ( gen ), distribution ( gen ), distribution ( gen ) } } );
+	}
+
+	auto Grid = ecs . AddSpatialIndex <LocationComponent> ( std::make_unique <HashGrid> ( 10.f ), GetLocation );
+	auto Octree = ecs . AddSpatialIndex <LocationComponent> ( std::make_unique <LooseOctree> (), GetLocation );
+	EXPECT_EQ ( Grid -> Size (), Entities . size () );
+	EXPECT_EQ ( Octree -> Size (), Entities . size () );
+	ExpectSpatialQueriesMatch ( ecs, * Grid, gen );
+	ExpectSpatialQueriesMatch ( ecs, * Octree, gen );
+
+	// Small moves are refitted, RunSystems synchronizes the indices before the systems move the entities
+	ecs . RunSystems ();
+	ecs . RunSystems ();
+	ecs . SyncSpatialIndices ();
+	ExpectSpatialQueriesMatch ( ecs, * Grid, gen );
+	ExpectSpatialQueriesMatch ( ecs, * Octree, gen );
+
+	// Structural changes rebuild the partitions
+	ecs . DestroyEntities ( std::span <const EntityHandle> ( Entities ) . first ( 2500 ) );
+	ecs . SyncSpatialIndices ();
+	EXPECT_EQ ( Grid -> Size (), size_t ( 7500 ) );
+	ExpectSpatialQueriesMatch ( ecs, * Grid, gen );
+	ExpectSpatialQueriesMatch ( ecs, * Octree, gen );
+
+	// The buffer smaller than the result is filled and the total count is reported
+	std::array <EntityHandle, 4> Small;
+	EXPECT_GT ( Grid -> QueryRadius ( { 0.f, 0.f, 0.f }, 50.f, Small ), Small . size () );
+}
+
+TEST_F ( EntityComponentSystem, EntityHandleGeneration )
+{
+	auto e1 = ecs . CreateEntity ();
+	ecs . RemoveEntity ( e1 );
+	auto e2 = ecs . CreateEntity ();
+	// Slot is reused, but the stale handle doesn't become valid again.
+	EXPECT_NE ( e1, e2 );
+	EXPECT_EQ ( EntityManager::GetEntitySlot ( e1 ), EntityManager::GetEntitySlot ( e2 ) );
+	EXPECT_FALSE ( ecs . GetIsValidEntityHandle ( e1 ) );
+	EXPECT_TRUE ( ecs . GetIsValidEntityHandle ( e2 ) );
+}
+
+TEST_F ( EntityComponentSystem, ConcurrentEntityReservation )
+{
+	ecs . RegisterComponent <HPComponent> ();
+	ecs . RegisterSystem <RenderSystem, HPComponent> ();
+
+	// Released slots are published for the reservation at the sync point.
+	std::vector <EntityHandle> Released;
+	for ( int i = 0; i < 16; i ++ )
+		Released . push_back ( ecs . CreateEntity () );
+	for ( auto e : Released )
+		ecs . RemoveEntity ( e );
+	ecs . MaterializeReservedEntities ();
+
+	constexpr std::size_t ThreadsCount = 4;
+	constexpr std::size_t EntitiesPerThread = 256;
+	std::vector <EntityCommandBuffer> CommandBuffers ( ThreadsCount );
+	std::vector <std::vector <EntityHandle>> Reserved ( ThreadsCount );
+	std::vector <std::thread> Workers;
+	for ( std::size_t t = 0; t < ThreadsCount; t ++ ) {
+		Workers . emplace_back ( [ &, t ] ()
+		{
+			for ( std::size_t i = 0; i < EntitiesPerThread; i ++ ) {
+				const auto e = ecs . ReserveEntity ();
+				Reserved[ t ] . push_back ( e );
+				CommandBuffers[ t ] . AddComponent ( e, HPComponent ( e, int ( i ) ) );
+			}
+		} );
+	}
+	for ( auto & Worker : Workers )
+		Worker . join ();
+
+	std::set <EntityHandle> Unique;
+	for ( std::size_t t = 0; t < ThreadsCount; t ++ ) {
+		for ( auto e : Reserved[ t ] ) {
+			EXPECT_FALSE ( ecs . GetIsValidEntityHandle ( e ) );
+			Unique . insert ( e );
+		}
+	}
+	EXPECT_EQ ( Unique . size (), ThreadsCount * EntitiesPerThread );
+	for ( auto e : Released )
+		EXPECT_EQ ( Unique . count ( e ), size_t ( 0 ) );
+
+	for ( auto & CommandBuffer : CommandBuffers ) {
+		CommandBuffer . Execute ( ecs );
+		EXPECT_EQ ( CommandBuffer . Size (), size_t ( 0 ) );
+	}
+
+	for ( std::size_t t = 0; t < ThreadsCount; t ++ ) {
+		for ( std::size_t i = 0; i < EntitiesPerThread; i ++ ) {
+			const auto e = Reserved[ t ][ i ];
+			ASSERT_TRUE ( ecs . GetIsValidEntityHandle ( e ) );
+			EXPECT_EQ ( ecs . GetComponent <HPComponent> ( e ) . HP, int ( i ) );
+		}
+	}
+	EXPECT_EQ ( ecs . MaterializeReservedEntities (), size_t ( 0 ) );
+}
+
+TEST_F ( EntityComponentSystem, EntityMigration )
+{
+	ecs . RegisterComponent <LocationComponent> ();
+	ecs . RegisterComponent <MovementComponent> ();
+	ecs . RegisterComponent <HPComponent> ();
+	ecs . RegisterSystem <MovementSystem, LocationComponent, MovementComponent> ();
+	auto SourceGroup = ecs . RegisterGroup <LocationComponent, MovementComponent> () . lock ();
+
+	std::vector <EntityHandle> Entities;
+	for ( int i = 0; i < 4; i ++ ) {
+		auto e = ecs . CreateEntity ();
+		Entities . push_back ( e );
+		ecs . AddComponent <LocationComponent> ( e, { e, { float ( i ), 0.f, 0.f } } );
+		ecs . AddComponent <MovementComponent> ( e, { e, 1.f, { 0.f, 1.f, 0.f } } );
+		ecs . AddComponent <HPComponent> ( e, { e, 10 * i } );
+	}
+
+	// The destination lacks the HPComponent, its array is registered by the migration.
+	ECS Destination;
+	Destination . RegisterComponent <LocationComponent> ();
+	Destination . RegisterComponent <MovementComponent> ();
+	Destination . RegisterSystem <MovementSystem, LocationComponent, MovementComponent> ();
+	auto DestinationQuery = Destination . RegisterQuery <LocationComponent, HPComponent> ();
+	Destination . CreateEntity ();
+
+	const auto Migrated = ecs . MigrateEntity ( Entities[ 1 ], Destination );
+	EXPECT_FALSE ( ecs . GetIsValidEntityHandle ( Entities[ 1 ] ) );
+	ASSERT_TRUE ( Destination . GetIsValidEntityHandle ( Migrated ) );
+	EXPECT_EQ ( SourceGroup -> Size (), size_t ( 3 ) );
+	EXPECT_EQ ( DestinationQuery . Size (), size_t ( 1 ) );
+	ASSERT_TRUE ( Destination . GetIsComponentRegistered <HPComponent> () );
+	EXPECT_EQ ( Destination . GetComponent <HPComponent> ( Migrated ) . HP, 10 );
+	EXPECT_EQ ( Destination . GetComponent <HPComponent> ( Migrated ) . GetOwner (), Migrated );
+	EXPECT_EQ ( Destination . GetComponent <LocationComponent> ( Migrated ) . GetOwner (), Migrated );
+
+	// The migrated entity is processed by the systems of the destination only.
+	ecs . RunSystems ();
+	Destination . RunSystems ();
+	EXPECT_TRUE ( Destination . GetComponent <LocationComponent> ( Migrated ) . Location == Vector ( 1.f, 1.f, 0.f ) );
+	EXPECT_TRUE ( ecs . GetComponent <LocationComponent> ( Entities[ 2 ] ) . Location == Vector ( 2.f, 1.f, 0.f ) );
+	for ( auto & Location : * ecs . GetComponentsByType <LocationComponent> () . lock () )
+		EXPECT_TRUE ( ecs . GetIsValidEntityHandle ( Location . GetOwner () ) );
+
+	// Migrating back lands in the source group again.
+	const auto Returned = Destination . MigrateEntity ( Migrated, ecs );
+	EXPECT_EQ ( SourceGroup -> Size (), size_t ( 4 ) );
+	EXPECT_EQ ( DestinationQuery . Size (), size_t ( 0 ) );
+	EXPECT_EQ ( ecs . GetComponent <HPComponent> ( Returned ) . HP, 10 );
+	EXPECT_EQ ( Destination . GetComponentsByType <HPComponent> () . lock () -> Size (), size_t ( 0 ) );
+}
+
+TEST_F ( EntityComponentSystem, RecordAndReplay )
+{
+	std::stringstream Log;
+	auto Recorder = std::make_shared <ECSRecorder> ( Log, 64 );
+	ecs . SetRecorder ( Recorder );
+	ecs . RegisterComponent <LocationComponent> ();
+	ecs . RegisterComponent <HPComponent> ();
+	ecs . RegisterSystem <RenderSystem, HPComponent> ();
+
+	std::vector <std::size_t> EntitiesCounts;
+	std::vector <EntityHandle> Entities;
+	for ( int Frame = 0; Frame < 4; Frame ++ ) {
+		for ( int i = 0; i < 32; i ++ ) {
+			const auto e = ecs . CreateEntity ();
+			Entities . push_back ( e );
+			ecs . AddComponent <LocationComponent> ( e, { e, { float ( i ), 0.f, 0.f } } );
+			if ( i % 2 == 0 )
+				ecs . AddComponent <HPComponent> ( e, { e, i } );
+		}
+		ecs . RemoveComponent <LocationComponent> ( Entities[ Frame ] );
+		ecs . RemoveEntity ( Entities[ Entities . size () - 1 ] );
+		Entities . pop_back ();
+		ecs . DestroyEntities ( std::span ( Entities ) . subspan ( Entities . size () - 4 ) );
+		Entities . resize ( Entities . size () - 4 );
+		// Reserved entities are created by the replay where they were materialized, even without components
+		Entities . push_back ( ecs . ReserveEntity () );
+		ecs . MaterializeReservedEntities ();
+		const auto Reserved = ecs . ReserveEntity ();
+		EntityCommandBuffer CommandBuffer;
+		CommandBuffer . AddComponent ( Reserved, HPComponent ( Reserved, 1 ) );
+		CommandBuffer . Execute ( ecs );
+		Entities . push_back ( Reserved );
+		// A batch with an invalid handle throws before it is recorded or removes anything
+		const auto RecordedBytesCount = Recorder -> GetRecordedBytesCount ();
+		const EntityHandle InvalidBatch[] = { Entities[ Frame ], EntityHandle ( - 1 ) };
+		EXPECT_ANY_THROW ( ecs . DestroyEntities ( InvalidBatch ) );
+		EXPECT_TRUE ( ecs . GetIsValidEntityHandle ( Entities[ Frame ] ) );
+		EXPECT_EQ ( Recorder -> GetRecordedBytesCount (), RecordedBytesCount );
+		ecs . RunSystems ();
+		EntitiesCounts . push_back ( ecs . GetEntitiesCount () );
+	}
+	EXPECT_EQ ( Recorder -> GetFramesCount (), size_t ( 4 ) );
+	ecs . SetRecorder ( nullptr );
+	Recorder . reset ();
+
+	ECSReplayer Replayer ( Log );
+	ASSERT_TRUE ( Replayer . GetIsValid () );
+	ECS Replayed;
+	for ( std::size_t Frame = 0; Frame < EntitiesCounts . size (); Frame ++ ) {
+		ASSERT_TRUE ( Replayer . ReplayFrame ( Replayed ) );
+		EXPECT_GT ( Replayer . GetLastOperationsCount (), size_t ( 0 ) );
+		EXPECT_EQ ( Replayed . GetEntitiesCount (), EntitiesCounts[ Frame ] );
+	}
+	EXPECT_FALSE ( Replayer . ReplayFrame ( Replayed ) );
+	EXPECT_TRUE ( Replayer . GetIsValid () );
+	EXPECT_EQ ( Replayer . GetFramesCount (), size_t ( 4 ) );
+	ASSERT_EQ ( Replayer . GetComponentTypesCount (), size_t ( 2 ) );
+	EXPECT_EQ ( Replayer . GetComponentTypeName ( 0 ), typeid ( LocationComponent ) . name () );
+	EXPECT_TRUE ( Replayed . GetIsComponentRegistered <HPComponent> () );
+
+	// A truncated log replays the complete records and then stops
+	std::stringstream Truncated ( Log . str () . substr ( 0, Log . str () . size () / 2 ) );
+	ECSReplayer TruncatedReplayer ( Truncated );
+	ECS TruncatedReplayed;
+	while ( TruncatedReplayer . ReplayFrame ( TruncatedReplayed ) );
+	EXPECT_FALSE ( TruncatedReplayer . GetIsValid () );
+	EXPECT_GE ( TruncatedReplayer . GetFramesCount (), size_t ( 1 ) );
+}
+
+TEST ( Universe, ParallelTick )
+{
+	Universe Worlds ( std::make_shared <ThreadPool> ( 3 ), std::make_shared <ThreadPool> ( 2 ) );
+	std::vector <WorldHandle> Handles;
+	for ( int w = 0; w < 8; w ++ ) {
+		const auto Handle = Worlds . CreateWorld ();
+		Handles . push_back ( Handle );
+		ECS & World = Worlds . GetWorld ( Handle );
+		EXPECT_EQ ( World . GetThreadPool (), Worlds . GetJobPool () );
+		World . RegisterComponent <LocationComponent> ();
+		World . RegisterComponent <MovementComponent> ();
+		World . RegisterSystem <MovementSystem, LocationComponent, MovementComponent> ();
+		// Uneven worlds, the heavy ones are ticked first on the following ticks
+		for ( int i = 0; i < ( w + 1 ) * 100; i ++ ) {
+			const auto e = World . CreateEntity ();
+			World . AddComponent <LocationComponent> ( e, { e, { 0.f, 0.f, 0.f } } );
+			World . AddComponent <MovementComponent> ( e, { e, 1.f, { 1.f, 0.f, 0.f } } );
+		}
+	}
+
+	std::vector <EntityHandle> Lobby;
+	for ( int t = 0; t < 3; t ++ ) {
+		Worlds . Tick ( 1. / 60. );
+		// Each world is ticked exactly once per tick
+		for ( const auto Handle : Handles ) {
+			for ( auto & Location : * Worlds . GetWorld ( Handle ) . GetComponentsByType <LocationComponent> () . lock () )
+				ASSERT_EQ ( Location . Location . X, float ( t + 1 ) );
+			EXPECT_GT ( Worlds . GetLastTickTime ( Handle ) . count (), 0 );
+		}
+	}
+
+	// Move an entity from the lobby into a match between the ticks and destroy the lobby.
+	ECS & LobbyWorld = Worlds . GetWorld ( Handles[ 0 ] );
+	const auto Player = LobbyWorld . CreateEntity ();
+	LobbyWorld . AddComponent <LocationComponent> ( Player, { Player, { 3.f, 0.f, 0.f } } );
+	LobbyWorld . AddComponent <MovementComponent> ( Player, { Player, 1.f, { 1.f, 0.f, 0.f } } );
+	const auto Migrated = Worlds . MigrateEntity ( Handles[ 0 ], Handles[ 7 ], Player );
+	Worlds . DestroyWorld ( Handles[ 0 ] );
+	EXPECT_FALSE ( Worlds . GetIsValidWorldHandle ( Handles[ 0 ] ) );
+	EXPECT_EQ ( Worlds . GetWorldsCount (), size_t ( 7 ) );
+
+	Worlds . Tick ( 1. / 60. );
+	ECS & Match = Worlds . GetWorld ( Handles[ 7 ] );
+	EXPECT_EQ ( Match . GetComponentsByType <LocationComponent> () . lock () -> Size (), size_t ( 801 ) );
+	for ( auto & Location : * Match . GetComponentsByType <LocationComponent> () . lock () )
+		EXPECT_EQ ( Location . Location . X, 4.f );
+	EXPECT_EQ ( Match . GetComponent <LocationComponent> ( Migrated ) . GetOwner (), Migrated );
+}
+
+TEST ( Universe, TasksStartedBySystems )
+{
+	// Worlds are picked up by any tick thread, so the task frames are allocated and freed on different threads
+	std::atomic <int> Counter = 0;
+	{
+		Universe Worlds ( std::make_shared <ThreadPool> ( 3 ), std::make_shared <ThreadPool> ( 2 ) );
+		for ( int w = 0; w < 16; w ++ ) {
+			ECS & World = Worlds . GetWorld ( Worlds . CreateWorld () );
+			World . RegisterSystem <TaskSpawningSystem> ();
+			World . GetSystem <TaskSpawningSystem> () . lock () -> Counter = & Counter;
+		}
+		for ( int t = 0; t < 3; t ++ )
+			Worlds . Tick ( 1. / 60. );
+		// Each tick starts 8 tasks per world, resumed by the task update of the same tick and of each following one
+		EXPECT_EQ ( Counter . load (), 16 * 8 * ( 3 + 2 + 1 ) );
+	}
+
+	// The frames freed above must not have entered the free lists of this thread
+	ECS Fresh;
+	for ( int i = 0; i < 256; i ++ )
+		Fresh . StartTask ( CountFrames ( Counter, 1 ) );
+	Fresh . UpdateTasks ( 0.0 );
+	EXPECT_EQ ( Fresh . GetTasksCount (), size_t ( 0 ) );
+}
+
 int main ( int argc, char ** argv )
 {
 	testing::InitGoogleTest( &argc, argv );
@@ -0,0 +1,89 @@
+#include "Laniakea/ECS/ECSReplayer.h"
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+struct FrameTiming
+{
+	std::size_t Frame = 0;
+	std::size_t OperationsCount = 0;
+	double Microseconds = 0.;
+};
+
+double GetPercentile ( std::vector <double> times, double percentile )
+{
+	const auto Index = std::min ( times . size () - 1, ( std::size_t ) ( percentile * ( double ) times . size () ) );
+	std::nth_element ( times . begin (), times . begin () + ( std::ptrdiff_t ) Index, times . end () );
+	return times[ Index ];
+}
+
+int main ( int argc, char ** argv )
+{
+	if ( argc < 2 )
+	{
+		std::cerr << "Usage: Replay-ECS <log> [--frames] [--slowest N]" << std::endl;
+		return 1;
+	}
+	bool IsPrintingFrames = false;
+	std::size_t SlowestCount = 10;
+	for ( int i = 2; i < argc; i ++ ) {
+		const std::string Argument = argv[ i ];
+		if ( Argument == "--frames" )
+			IsPrintingFrames = true;
+		else if ( Argument == "--slowest" && i + 1 < argc )
+			SlowestCount = std::stoul ( argv[ ++ i ] );
+	}
+
+	std::ifstream Stream ( argv[ 1 ], std::ios::binary );
+	ECSReplayer Replayer ( Stream );
+	if ( ! Replayer . GetIsValid () )
+	{
+		std::cerr << "Not an ECS recording: " << argv[ 1 ] << std::endl;
+		return 1;
+	}
+
+	ECS Replayed;
+	std::vector <FrameTiming> Frames;
+	while ( Replayer . ReplayFrame ( Replayed ) ) {
+		const std::chrono::duration <double, std::micro> Elapsed = Replayer . GetLastFrameTime ();
+		Frames . push_back ( { Frames . size (), Replayer . GetLastOperationsCount (), Elapsed . count () } );
+		if ( IsPrintingFrames )
+			std::cout << std::setw ( 8 ) << Frames . back () . Frame << std::setw ( 10 ) << Frames . back () . OperationsCount
+					<< std::fixed << std::setprecision ( 2 ) << std::setw ( 12 ) << Frames . back () . Microseconds << " us" << std::endl;
+	}
+	if ( ! Replayer . GetIsValid () )
+		std::cerr << "The recording is truncated after frame " << Frames . size () << std::endl;
+	if ( Frames . empty () )
+		return 1;
+
+	std::vector <double> Times;
+	double Total = 0.;
+	std::size_t OperationsCount = 0;
+	for ( const auto & Frame : Frames ) {
+		Times . push_back ( Frame . Microseconds );
+		Total += Frame . Microseconds;
+		OperationsCount += Frame . OperationsCount;
+	}
+	std::cout << std::fixed << std::setprecision ( 2 )
+			<< "Frames:          " << Frames . size () << std::endl
+			<< "Operations:      " << OperationsCount << std::endl
+			<< "Component types: " << Replayer . GetComponentTypesCount () << std::endl
+			<< "Entities:        " << Replayed . GetEntitiesCount () << std::endl
+			<< "Total:           " << Total << " us" << std::endl
+			<< "Average:         " << Total / ( double ) Frames . size () << " us" << std::endl
+			<< "Median:          " << GetPercentile ( Times, 0.5 ) << " us" << std::endl
+			<< "99th percentile: " << GetPercentile ( Times, 0.99 ) << " us" << std::endl
+			<< "Max:             " << * std::max_element ( Times . begin (), Times . end () ) << " us" << std::endl;
+
+	SlowestCount = std::min ( SlowestCount, Frames . size () );
+	std::partial_sort ( Frames . begin (), Frames . begin () + ( std::ptrdiff_t ) SlowestCount, Frames . end (),
+			[] ( const FrameTiming & lhs, const FrameTiming & rhs ) { return lhs . Microseconds > rhs . Microseconds; } );
+	std::cout << "Slowest frames:" << std::endl;
+	for ( std::size_t i = 0; i < SlowestCount; i ++ ) {
+		std::cout << std::setw ( 8 ) << Frames[ i ] . Frame << std::setw ( 10 ) << Frames[ i ] . OperationsCount
+				<< std::setw ( 12 ) << Frames[ i ] . Microseconds << " us" << std::endl;
+	}
+	return 0;
+}
\ No newline at end of file
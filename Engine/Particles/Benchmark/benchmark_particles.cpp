@@ -0,0 +1,80 @@
+#include "Laniakea/ECS/ECS.h"
+#include "Laniakea/Particles/ParticleSystem.h"
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+
+template <typename Func>
+double MeasureMicroseconds ( std::size_t iterations, Func && func )
+{
+	const auto Start = std::chrono::steady_clock::now ();
+	for ( std::size_t i = 0; i < iterations; i ++ )
+		func ();
+	const std::chrono::duration <double, std::micro> Elapsed = std::chrono::steady_clock::now () - Start;
+	return Elapsed . count () / ( double ) iterations;
+}
+
+void Report ( const std::string & name, std::size_t particlesCount, double microseconds )
+{
+	std::cout << std::left << std::setw ( 48 ) << name << std::setw ( 10 ) << particlesCount
+			<< std::fixed << std::setprecision ( 2 ) << microseconds << " us" << std::endl;
+}
+
+void RunKernelBenchmark ( std::size_t particlesCount )
+{
+	std::default_random_engine Generator;
+	std::uniform_real_distribution <float> Distribution ( - 10.f, 10.f );
+	ParticleBuffer Buffer;
+	Buffer . Reserve ( particlesCount );
+	for ( std::size_t i = 0; i < particlesCount; i ++ ) {
+		Buffer . Add ( { Distribution ( Generator ), Distribution ( Generator ), Distribution ( Generator ) },
+					   { Distribution ( Generator ), Distribution ( Generator ), Distribution ( Generator ) }, 1000.f, {} );
+	}
+	Report ( "kernel: update, no deaths", particlesCount, MeasureMicroseconds ( 30, [ & ] ()
+	{
+		Buffer . Update ( 1.f / 60.f, { 0.f, - 9.81f, 0.f } );
+	} ) );
+}
+
+void RunSystemBenchmark ( std::size_t particlesCount )
+{
+	ECS ecs;
+	ecs . RegisterComponent <ParticleEmitterComponent> ();
+	ecs . RegisterSystem <ParticleSystem, ParticleEmitterComponent> ();
+	auto System = ecs . GetSystem <ParticleSystem> () . lock ();
+	System -> SetMaxParticles ( particlesCount );
+
+	// The emitters replace the dying particles, so the count stays close to the target in the steady state
+	constexpr std::size_t EmittersCount = 100;
+	constexpr float Lifetime = 2.f;
+	for ( std::size_t i = 0; i < EmittersCount; i ++ ) {
+		auto e = ecs . CreateEntity ();
+		ParticleEmitterComponent Emitter ( e, { ( float ) i, 0.f, 0.f }, ( float ) particlesCount / ( Lifetime * ( float ) EmittersCount ), Lifetime );
+		Emitter . Velocity = { 0.f, 5.f, 0.f };
+		Emitter . VelocitySpread = { 1.f, 1.f, 1.f };
+		ecs . AddComponent <ParticleEmitterComponent> ( e, Emitter );
+	}
+	for ( int Tick = 0; Tick < 150; Tick ++ ) {
+		ecs . RunSystem <ParticleSystem> ();
+	}
+
+	std::size_t DeadCount = 0;
+	constexpr std::size_t FramesCount = 30;
+	Report ( "frame: update + compaction + emission", System -> GetParticles () . Size (), MeasureMicroseconds ( FramesCount, [ & ] ()
+	{
+		ecs . RunSystem <ParticleSystem> ();
+		DeadCount += System -> GetLastDeadCount ();
+	} ) );
+	std::cout << "(dead particles per frame " << DeadCount / FramesCount << ")" << std::endl << std::endl;
+}
+
+int main ()
+{
+	for ( const std::size_t ParticlesCount : { 100000, 1000000 } ) {
+		RunKernelBenchmark ( ParticlesCount );
+		RunSystemBenchmark ( ParticlesCount );
+	}
+	return 0;
+}
@@ -0,0 +1,19 @@
+#pragma once
+
+#ifdef LANIAKEA_PLATFORM_WINDOWS
+	#ifdef LANIAKEA_BUILD_DLL
+		#define LANIAKEA_PARTICLES_API __declspec (dllexport)
+	#else
+		#define LANIAKEA_PARTICLES_API __declspec(dllimport)
+	#endif
+#else
+	#error Laniakea supports only windows
+#endif
+
+// The widest instruction set enabled by the compiler flags is used by the update kernel, e.g. /arch:AVX2 or -mavx2
+#if defined ( __AVX__ )
+	#define LANIAKEA_PARTICLES_AVX 1
+#endif
+#if defined ( __SSE2__ ) || defined ( _M_X64 ) || ( defined ( _M_IX86_FP ) && _M_IX86_FP >= 2 )
+	#define LANIAKEA_PARTICLES_SSE 1
+#endif
@@ -0,0 +1,102 @@
+#pragma once
+
+#include "Core.h"
+#include "Laniakea/ECS/SpatialPartition.h"
+#include <array>
+#include <cstddef>
+#include <span>
+#include <vector>
+
+/**
+ * @struct ParticleColor
+ * @brief Linear RGBA color of the particle.
+ */
+struct LANIAKEA_PARTICLES_API ParticleColor
+{
+	float R = 1.f; /**< The red channel. */
+	float G = 1.f; /**< The green channel. */
+	float B = 1.f; /**< The blue channel. */
+	float A = 1.f; /**< The opacity. */
+};
+
+/**
+ * @enum ParticleStream
+ * @brief The float arrays storing the particles.
+ */
+enum class ParticleStream : std::size_t
+{
+	PositionX,
+	PositionY,
+	PositionZ,
+	VelocityX,
+	VelocityY,
+	VelocityZ,
+	Lifetime,
+	ColorR,
+	ColorG,
+	ColorB,
+	ColorA,
+	Count
+};
+
+/**
+ * @class ParticleBuffer
+ * @brief Structure of arrays storing the particles as plain floats.
+ *
+ * Each attribute lives in its own contiguous array, so the update kernel loads four or eight particles with a single
+ * instruction. The particles are unordered, the dead ones are removed by the update compacting the survivors in place.
+ */
+class LANIAKEA_PARTICLES_API ParticleBuffer
+{
+
+public:
+
+	static constexpr std::size_t StreamsCount = ( std::size_t ) ParticleStream::Count;
+
+	/**
+     * @brief Appends the particle.
+     * @param position The position of the particle.
+     * @param velocity The velocity of the particle in units per second.
+     * @param lifetime The remaining lifetime in seconds.
+     * @param color The color of the particle.
+     */
+	void Add ( const SpatialPoint & position, const SpatialPoint & velocity, float lifetime, const ParticleColor & color );
+
+	/**
+     * @brief Integrates the particles and removes the ones whose lifetime has run out.
+     * @param timeStep The time step in seconds.
+     * @param acceleration The acceleration applied to all particles, e.g. the gravity.
+     * @return The number of the removed particles.
+     *
+     * The integration and the stream compaction are fused into a single pass over the arrays. The survivors keep
+     * their relative order.
+     */
+	std::size_t Update ( float timeStep, const SpatialPoint & acceleration );
+
+	/**
+     * @brief Get the array of the particle attribute.
+     * @param stream The attribute.
+     * @return A span over Size () values, valid until the particles are added or updated.
+     */
+	std::span <const float> GetStream ( ParticleStream stream ) const;
+
+	/**
+     * @brief Retrieves the number of the particles.
+     * @return The number of the alive particles.
+     */
+	std::size_t Size () const;
+
+	/**
+     * @brief Reserves the memory for the particles, so adding them doesn't reallocate.
+     * @param capacity The number of the particles.
+     */
+	void Reserve ( std::size_t capacity );
+
+	/**
+     * @brief Removes all particles, the memory is kept.
+     */
+	void Clear ();
+
+private:
+	std::array <std::vector <float>, StreamsCount> m_Streams; /**< The attribute arrays indexed by ParticleStream. */
+};
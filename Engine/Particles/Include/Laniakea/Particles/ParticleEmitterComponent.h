@@ -0,0 +1,31 @@
+#pragma once
+
+#include "Core.h"
+#include "ParticleBuffer.h"
+#include "Laniakea/ECS/ComponentBase.h"
+
+/**
+ * @struct ParticleEmitterComponent
+ * @brief Spawns the particles of the ParticleSystem at a constant rate.
+ *
+ * The emitter is a regular component, the particles it spawns are not entities and live in the ParticleBuffer of the system.
+ */
+struct LANIAKEA_PARTICLES_API ParticleEmitterComponent : public ComponentBase
+{
+	/**
+     * @brief Constructor for ParticleEmitterComponent.
+     * @param owner The handle of the entity that owns this component.
+     * @param position The world space position the particles are spawned at.
+     * @param rate The number of the particles spawned per second.
+     * @param lifetime The lifetime of the particles in seconds.
+     */
+	ParticleEmitterComponent ( EntityHandle owner, const SpatialPoint & position, float rate, float lifetime );
+
+	SpatialPoint Position; /**< The world space position the particles are spawned at. */
+	SpatialPoint Velocity = { 0.f, 0.f, 0.f }; /**< The initial velocity of the particles in units per second. */
+	SpatialPoint VelocitySpread = { 0.f, 0.f, 0.f }; /**< The maximal random deviation of the initial velocity along each axis. */
+	ParticleColor Color; /**< The color of the particles. */
+	float Rate; /**< The number of the particles spawned per second. */
+	float Lifetime; /**< The lifetime of the particles in seconds. */
+	float PendingParticles = 0.f; /**< The fraction of the particle carried over to the next tick. */
+};
@@ -0,0 +1,66 @@
+#pragma once
+
+#include "ParticleBuffer.h"
+#include "Laniakea/Render/Attribute.h"
+#include "Laniakea/Render/VertexArray.h"
+#include <vector>
+
+/**
+ * @struct ParticleInstance
+ * @brief Per instance vertex data of the particle, interleaved for the upload.
+ */
+struct LANIAKEA_PARTICLES_API ParticleInstance
+{
+	float X, Y, Z; /**< The position of the particle. */
+	float R, G, B, A; /**< The color of the particle. */
+};
+
+/**
+ * @class ParticleRenderer
+ * @brief Draws the particles as instanced camera facing quads.
+ *
+ * The particles are interleaved into the ParticleInstance array and uploaded with a single buffer write, the whole
+ * buffer is then drawn with one instanced draw call of a four vertex triangle strip. The bound shader receives the
+ * quad corner in [ -1, 1 ] as a vec2 and the position and the color of the instance as a vec3 and a vec4, it expands
+ * the corner in the view space. The renderer requires the current GL context.
+ */
+class LANIAKEA_PARTICLES_API ParticleRenderer
+{
+
+public:
+
+	/**
+     * @brief Constructor for ParticleRenderer.
+     * @param cornerSlot The attribute location of the quad corner.
+     * @param positionSlot The attribute location of the particle position.
+     * @param colorSlot The attribute location of the particle color.
+     */
+	ParticleRenderer ( unsigned int cornerSlot, unsigned int positionSlot, unsigned int colorSlot );
+
+	ParticleRenderer ( const ParticleRenderer & ) = delete;
+
+	ParticleRenderer & operator = ( const ParticleRenderer & ) = delete;
+
+	/**
+     * @brief Uploads the particles to the instance buffer.
+     * @param particles The particles to draw.
+     */
+	void Upload ( const ParticleBuffer & particles );
+
+	/**
+     * @brief Draws the uploaded particles with the bound shader.
+     */
+	void Draw ();
+
+	/**
+     * @brief Get the number of the uploaded particles.
+     * @return The number of the instances drawn by Draw.
+     */
+	unsigned int GetInstancesCount () const;
+
+private:
+	lk::gfx::Attribute m_Corners; /**< The four corners of the quad. */
+	lk::gfx::Attribute m_Instances; /**< The interleaved particles, one instance each. */
+	lk::gfx::VertexArray m_VertexArray; /**< The corners per vertex and the particles per instance, set up once. */
+	std::vector <ParticleInstance> m_InstanceData; /**< The interleaved particles, reused between the uploads. */
+};
@@ -0,0 +1,95 @@
+#pragma once
+
+#include "ParticleBuffer.h"
+#include "ParticleEmitterComponent.h"
+#include "Laniakea/ECS/System.h"
+#include <random>
+#include <span>
+
+/**
+ * @class ParticleSystem
+ * @brief Spawns the particles of the ParticleEmitterComponent and simulates them.
+ *
+ * Registered as ecs . RegisterSystem <ParticleSystem, ParticleEmitterComponent> (). Each tick integrates the particles
+ * by the fixed time step, removes the dead ones and spawns the new ones of every emitter. The particles are stored
+ * in a single ParticleBuffer shared by all emitters, ready to be uploaded by the ParticleRenderer.
+ */
+class LANIAKEA_PARTICLES_API ParticleSystem : public System
+{
+
+public:
+
+	/**
+     * @brief Simulates the particles of the ParticleEmitterComponent array of the ECS.
+     * @param ecs The ECS owning the emitters.
+     */
+	void Run ( ECS & ecs ) override;
+
+	/**
+     * @brief Simulates the particles and spawns the new ones.
+     * @param emitters The emitters, their pending particle fractions are updated.
+     */
+	void Update ( std::span <ParticleEmitterComponent> emitters );
+
+	/**
+     * @brief Get the particles.
+     * @return A constant reference to the particle buffer.
+     */
+	const ParticleBuffer & GetParticles () const;
+
+	/**
+     * @brief Set the time step of the simulation.
+     * @param timeStep The time step in seconds, 1 / 60 by default.
+     */
+	void SetTimeStep ( float timeStep );
+
+	/**
+     * @brief Get the time step of the simulation.
+     * @return The time step in seconds.
+     */
+	float GetTimeStep () const;
+
+	/**
+     * @brief Set the acceleration applied to all particles.
+     * @param acceleration The acceleration, the gravity along -Y by default.
+     */
+	void SetAcceleration ( const SpatialPoint & acceleration );
+
+	/**
+     * @brief Get the acceleration applied to all particles.
+     * @return The acceleration.
+     */
+	const SpatialPoint & GetAcceleration () const;
+
+	/**
+     * @brief Set the maximal number of the particles, the emitters stop spawning when it is reached.
+     * @param maxParticles The maximal number of the particles.
+     */
+	void SetMaxParticles ( std::size_t maxParticles );
+
+	/**
+     * @brief Get the maximal number of the particles.
+     * @return The maximal number of the particles.
+     */
+	std::size_t GetMaxParticles () const;
+
+	/**
+     * @brief Get the number of the particles removed by the last update.
+     * @return The number of the particles whose lifetime has run out.
+     */
+	std::size_t GetLastDeadCount () const;
+
+private:
+
+	/**
+     * @brief Spawns the particles of the emitter accumulated during the time step.
+     */
+	void Emit ( ParticleEmitterComponent & emitter );
+
+	ParticleBuffer m_Particles; /**< The particles of all emitters. */
+	float m_TimeStep = 1.f / 60.f; /**< The time step in seconds. */
+	SpatialPoint m_Acceleration = { 0.f, - 9.81f, 0.f }; /**< The acceleration applied to all particles. */
+	std::size_t m_MaxParticles = 1 << 20; /**< The maximal number of the particles. */
+	std::size_t m_LastDeadCount = 0; /**< The number of the particles removed by the last update. */
+	std::minstd_rand m_Generator; /**< Randomizes the initial velocities. */
+};
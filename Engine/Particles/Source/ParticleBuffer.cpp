@@ -0,0 +1,199 @@
+#include "Laniakea/Particles/ParticleBuffer.h"
+#include <algorithm>
+#include <bit>
+#include <utility>
+#ifdef LANIAKEA_PARTICLES_AVX
+#include <immintrin.h>
+#elif defined ( LANIAKEA_PARTICLES_SSE )
+#include <emmintrin.h>
+#endif
+
+namespace
+{
+	constexpr std::size_t IntegratedStreamsCount = ( std::size_t ) ParticleStream::ColorR; /**< The streams written by the kernel, the colors are only moved. */
+
+	/**
+     * @brief The operations of the kernel on one particle.
+     */
+	struct ScalarLanes
+	{
+		using Type = float;
+		static constexpr std::size_t Width = 1;
+		static constexpr unsigned FullMask = 1;
+
+		static Type Load ( const float * data ) { return * data; }
+		static void Store ( float * data, Type value ) { * data = value; }
+		static Type Set ( float value ) { return value; }
+		static Type Add ( Type lhs, Type rhs ) { return lhs + rhs; }
+		static Type Sub ( Type lhs, Type rhs ) { return lhs - rhs; }
+		static Type Mul ( Type lhs, Type rhs ) { return lhs * rhs; }
+		static unsigned GetPositiveMask ( Type value ) { return value > 0.f ? 1u : 0u; }
+	};
+
+#ifdef LANIAKEA_PARTICLES_SSE
+	/**
+     * @brief The operations of the kernel on four particles.
+     */
+	struct SSELanes
+	{
+		using Type = __m128;
+		static constexpr std::size_t Width = 4;
+		static constexpr unsigned FullMask = 0xF;
+
+		static Type Load ( const float * data ) { return _mm_loadu_ps ( data ); }
+		static void Store ( float * data, Type value ) { _mm_storeu_ps ( data, value ); }
+		static Type Set ( float value ) { return _mm_set1_ps ( value ); }
+		static Type Add ( Type lhs, Type rhs ) { return _mm_add_ps ( lhs, rhs ); }
+		static Type Sub ( Type lhs, Type rhs ) { return _mm_sub_ps ( lhs, rhs ); }
+		static Type Mul ( Type lhs, Type rhs ) { return _mm_mul_ps ( lhs, rhs ); }
+		static unsigned GetPositiveMask ( Type value ) { return ( unsigned ) _mm_movemask_ps ( _mm_cmpgt_ps ( value, _mm_setzero_ps () ) ); }
+	};
+#endif
+
+#ifdef LANIAKEA_PARTICLES_AVX
+	/**
+     * @brief The operations of the kernel on eight particles.
+     */
+	struct AVXLanes
+	{
+		using Type = __m256;
+		static constexpr std::size_t Width = 8;
+		static constexpr unsigned FullMask = 0xFF;
+
+		static Type Load ( const float * data ) { return _mm256_loadu_ps ( data ); }
+		static void Store ( float * data, Type value ) { _mm256_storeu_ps ( data, value ); }
+		static Type Set ( float value ) { return _mm256_set1_ps ( value ); }
+		static Type Add ( Type lhs, Type rhs ) { return _mm256_add_ps ( lhs, rhs ); }
+		static Type Sub ( Type lhs, Type rhs ) { return _mm256_sub_ps ( lhs, rhs ); }
+		static Type Mul ( Type lhs, Type rhs ) { return _mm256_mul_ps ( lhs, rhs ); }
+		static unsigned GetPositiveMask ( Type value ) { return ( unsigned ) _mm256_movemask_ps ( _mm256_cmp_ps ( value, _mm256_setzero_ps (), _CMP_GT_OQ ) ); }
+	};
+#endif
+
+	/**
+     * @brief Integrates the particles [ read, end ) in the blocks of Lanes::Width and writes the survivors from write.
+     * @return The index past the last processed particle and the index past the last written survivor.
+     *
+     * The survivors are never written past the block just read, so the compaction is done in place. The blocks where
+     * every particle survives are stored whole, the others are stored to the stack and copied particle by particle.
+     */
+	template <typename Lanes>
+	std::pair <std::size_t, std::size_t> Integrate ( float * const * streams, std::size_t read, std::size_t end, std::size_t write,
+													 float timeStep, const SpatialPoint & acceleration )
+	{
+		using Type = typename Lanes::Type;
+		constexpr std::size_t Width = Lanes::Width;
+		const Type Step = Lanes::Set ( timeStep );
+		const Type DeltaX = Lanes::Set ( acceleration . X * timeStep );
+		const Type DeltaY = Lanes::Set ( acceleration . Y * timeStep );
+		const Type DeltaZ = Lanes::Set ( acceleration . Z * timeStep );
+		float * const PositionX = streams[ ( std::size_t ) ParticleStream::PositionX ];
+		float * const PositionY = streams[ ( std::size_t ) ParticleStream::PositionY ];
+		float * const PositionZ = streams[ ( std::size_t ) ParticleStream::PositionZ ];
+		float * const VelocityX = streams[ ( std::size_t ) ParticleStream::VelocityX ];
+		float * const VelocityY = streams[ ( std::size_t ) ParticleStream::VelocityY ];
+		float * const VelocityZ = streams[ ( std::size_t ) ParticleStream::VelocityZ ];
+		float * const Lifetime = streams[ ( std::size_t ) ParticleStream::Lifetime ];
+
+		for ( ; read + Width <= end; read += Width ) {
+			Type Values[ IntegratedStreamsCount ];
+			Values[ ( std::size_t ) ParticleStream::VelocityX ] = Lanes::Add ( Lanes::Load ( VelocityX + read ), DeltaX );
+			Values[ ( std::size_t ) ParticleStream::VelocityY ] = Lanes::Add ( Lanes::Load ( VelocityY + read ), DeltaY );
+			Values[ ( std::size_t ) ParticleStream::VelocityZ ] = Lanes::Add ( Lanes::Load ( VelocityZ + read ), DeltaZ );
+			Values[ ( std::size_t ) ParticleStream::PositionX ] = Lanes::Add ( Lanes::Load ( PositionX + read ), Lanes::Mul ( Values[ ( std::size_t ) ParticleStream::VelocityX ], Step ) );
+			Values[ ( std::size_t ) ParticleStream::PositionY ] = Lanes::Add ( Lanes::Load ( PositionY + read ), Lanes::Mul ( Values[ ( std::size_t ) ParticleStream::VelocityY ], Step ) );
+			Values[ ( std::size_t ) ParticleStream::PositionZ ] = Lanes::Add ( Lanes::Load ( PositionZ + read ), Lanes::Mul ( Values[ ( std::size_t ) ParticleStream::VelocityZ ], Step ) );
+			Values[ ( std::size_t ) ParticleStream::Lifetime ] = Lanes::Sub ( Lanes::Load ( Lifetime + read ), Step );
+			const auto AliveMask = Lanes::GetPositiveMask ( Values[ ( std::size_t ) ParticleStream::Lifetime ] );
+
+			if ( AliveMask == Lanes::FullMask )
+			{
+				for ( std::size_t Stream = 0; Stream < IntegratedStreamsCount; Stream ++ ) {
+					Lanes::Store ( streams[ Stream ] + write, Values[ Stream ] );
+				}
+				if ( write != read )
+				{
+					for ( auto Stream = IntegratedStreamsCount; Stream < ParticleBuffer::StreamsCount; Stream ++ ) {
+						Lanes::Store ( streams[ Stream ] + write, Lanes::Load ( streams[ Stream ] + read ) );
+					}
+				}
+				write += Width;
+				continue;
+			}
+
+			if ( AliveMask == 0 )
+				continue;
+			alignas ( 32 ) float Lane[ IntegratedStreamsCount ][ Width ];
+			for ( std::size_t Stream = 0; Stream < IntegratedStreamsCount; Stream ++ ) {
+				Lanes::Store ( Lane[ Stream ], Values[ Stream ] );
+			}
+			for ( auto Mask = AliveMask; Mask != 0; Mask &= Mask - 1 ) {
+				const auto Index = ( std::size_t ) std::countr_zero ( Mask );
+				for ( std::size_t Stream = 0; Stream < IntegratedStreamsCount; Stream ++ ) {
+					streams[ Stream ][ write ] = Lane[ Stream ][ Index ];
+				}
+				for ( auto Stream = IntegratedStreamsCount; Stream < ParticleBuffer::StreamsCount; Stream ++ ) {
+					streams[ Stream ][ write ] = streams[ Stream ][ read + Index ];
+				}
+				write ++;
+			}
+		}
+		return { read, write };
+	}
+}
+
+void ParticleBuffer::Add ( const SpatialPoint & position, const SpatialPoint & velocity, float lifetime, const ParticleColor & color )
+{
+	const float Values[ StreamsCount ] = { position . X, position . Y, position . Z, velocity . X, velocity . Y, velocity . Z,
+										   lifetime, color . R, color . G, color . B, color . A };
+	for ( std::size_t Stream = 0; Stream < StreamsCount; Stream ++ ) {
+		m_Streams[ Stream ] . push_back ( Values[ Stream ] );
+	}
+}
+
+std::size_t ParticleBuffer::Update ( float timeStep, const SpatialPoint & acceleration )
+{
+	const auto Count = Size ();
+	float * Streams[ StreamsCount ];
+	for ( std::size_t Stream = 0; Stream < StreamsCount; Stream ++ ) {
+		Streams[ Stream ] = m_Streams[ Stream ] . data ();
+	}
+
+	std::pair <std::size_t, std::size_t> Cursor = { 0, 0 };
+#ifdef LANIAKEA_PARTICLES_AVX
+	Cursor = Integrate <AVXLanes> ( Streams, Cursor . first, Count, Cursor . second, timeStep, acceleration );
+#endif
+#ifdef LANIAKEA_PARTICLES_SSE
+	Cursor = Integrate <SSELanes> ( Streams, Cursor . first, Count, Cursor . second, timeStep, acceleration );
+#endif
+	Cursor = Integrate <ScalarLanes> ( Streams, Cursor . first, Count, Cursor . second, timeStep, acceleration );
+
+	for ( auto & Stream : m_Streams ) {
+		Stream . resize ( Cursor . second );
+	}
+	return Count - Cursor . second;
+}
+
+std::span <const float> ParticleBuffer::GetStream ( ParticleStream stream ) const
+{
+	return m_Streams[ ( std::size_t ) stream ];
+}
+
+std::size_t ParticleBuffer::Size () const
+{
+	return m_Streams[ 0 ] . size ();
+}
+
+void ParticleBuffer::Reserve ( std::size_t capacity )
+{
+	for ( auto & Stream : m_Streams ) {
+		Stream . reserve ( capacity );
+	}
+}
+
+void ParticleBuffer::Clear ()
+{
+	for ( auto & Stream : m_Streams ) {
+		Stream . clear ();
+	}
+}
\ No newline at end of file
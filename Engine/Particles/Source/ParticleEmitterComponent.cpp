@@ -0,0 +1,7 @@
+#include "Laniakea/Particles/ParticleEmitterComponent.h"
+
+ParticleEmitterComponent::ParticleEmitterComponent ( EntityHandle owner, const SpatialPoint & position, float rate, float lifetime )
+: ComponentBase ( owner ), Position ( position ), Rate ( rate ), Lifetime ( lifetime )
+{
+
+}
\ No newline at end of file
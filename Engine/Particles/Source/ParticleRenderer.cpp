@@ -0,0 +1,55 @@
+#include "Laniakea/Particles/ParticleRenderer.h"
+#include "Laniakea/Render/Renderer.h"
+#include "glad/glad.h"
+#include <cstddef>
+
+namespace
+{
+	lk::gfx::VertexLayout MakeParticleLayout ( unsigned int cornerSlot, unsigned int positionSlot, unsigned int colorSlot )
+	{
+		lk::gfx::VertexLayout Layout;
+		Layout . AddStream () . Add ( cornerSlot, 2, GL_FLOAT );
+		Layout . AddStream ( sizeof ( ParticleInstance ), 1 )
+				. Add ( { positionSlot, 3, GL_FLOAT, offsetof ( ParticleInstance, X ) } )
+				. Add ( { colorSlot, 4, GL_FLOAT, offsetof ( ParticleInstance, R ) } );
+		return Layout;
+	}
+}
+
+ParticleRenderer::ParticleRenderer ( unsigned int cornerSlot, unsigned int positionSlot, unsigned int colorSlot )
+: m_VertexArray ( MakeParticleLayout ( cornerSlot, positionSlot, colorSlot ), { m_Corners, m_Instances } )
+{
+	float Corners[] = { - 1.f, - 1.f, 1.f, - 1.f, - 1.f, 1.f, 1.f, 1.f };
+	m_Corners . Set ( Corners, 8 );
+}
+
+void ParticleRenderer::Upload ( const ParticleBuffer & particles )
+{
+	const auto Count = particles . Size ();
+	const auto PositionX = particles . GetStream ( ParticleStream::PositionX );
+	const auto PositionY = particles . GetStream ( ParticleStream::PositionY );
+	const auto PositionZ = particles . GetStream ( ParticleStream::PositionZ );
+	const auto ColorR = particles . GetStream ( ParticleStream::ColorR );
+	const auto ColorG = particles . GetStream ( ParticleStream::ColorG );
+	const auto ColorB = particles . GetStream ( ParticleStream::ColorB );
+	const auto ColorA = particles . GetStream ( ParticleStream::ColorA );
+	m_InstanceData . resize ( Count );
+	for ( std::size_t i = 0; i < Count; i ++ ) {
+		m_InstanceData[ i ] = { PositionX[ i ], PositionY[ i ], PositionZ[ i ], ColorR[ i ], ColorG[ i ], ColorB[ i ], ColorA[ i ] };
+	}
+	m_Instances . Stream ( m_InstanceData . data (), ( unsigned int ) m_InstanceData . size () );
+}
+
+void ParticleRenderer::Draw ()
+{
+	if ( m_Instances . GetCount () == 0 )
+		return;
+	m_VertexArray . Bind ();
+	lk::gfx::Renderer::RenderInstanced ( 4, m_Instances . GetCount (), lk::gfx::DrawMode::TriangleStrip );
+	m_VertexArray . Unbind ();
+}
+
+unsigned int ParticleRenderer::GetInstancesCount () const
+{
+	return m_Instances . GetCount ();
+}
\ No newline at end of file
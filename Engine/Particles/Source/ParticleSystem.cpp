@@ -0,0 +1,81 @@
+#include "Laniakea/Particles/ParticleSystem.h"
+#include "Laniakea/ECS/ECS.h"
+#include <algorithm>
+#include <cmath>
+
+void ParticleSystem::Run ( ECS & ecs )
+{
+	const auto Emitters = ecs . GetComponentsByType <ParticleEmitterComponent> () . lock ();
+	if ( ! Emitters )
+	{
+		Update ( {} );
+		return;
+	}
+	Update ( std::span <ParticleEmitterComponent> ( Emitters -> Data (), Emitters -> Size () ) );
+}
+
+void ParticleSystem::Update ( std::span <ParticleEmitterComponent> emitters )
+{
+	m_LastDeadCount = m_Particles . Update ( m_TimeStep, m_Acceleration );
+	for ( auto & Emitter : emitters ) {
+		Emit ( Emitter );
+	}
+}
+
+const ParticleBuffer & ParticleSystem::GetParticles () const
+{
+	return m_Particles;
+}
+
+void ParticleSystem::SetTimeStep ( float timeStep )
+{
+	m_TimeStep = timeStep;
+}
+
+float ParticleSystem::GetTimeStep () const
+{
+	return m_TimeStep;
+}
+
+void ParticleSystem::SetAcceleration ( const SpatialPoint & acceleration )
+{
+	m_Acceleration = acceleration;
+}
+
+const SpatialPoint & ParticleSystem::GetAcceleration () const
+{
+	return m_Acceleration;
+}
+
+void ParticleSystem::SetMaxParticles ( std::size_t maxParticles )
+{
+	m_MaxParticles = maxParticles;
+}
+
+std::size_t ParticleSystem::GetMaxParticles () const
+{
+	return m_MaxParticles;
+}
+
+std::size_t ParticleSystem::GetLastDeadCount () const
+{
+	return m_LastDeadCount;
+}
+
+void ParticleSystem::Emit ( ParticleEmitterComponent & emitter )
+{
+	emitter . PendingParticles += emitter . Rate * m_TimeStep;
+	const float Whole = std::floor ( emitter . PendingParticles );
+	emitter . PendingParticles -= Whole;
+	const auto Count = std::min ( ( std::size_t ) std::max ( Whole, 0.f ), m_MaxParticles - std::min ( m_MaxParticles, m_Particles . Size () ) );
+	if ( Count == 0 )
+		return;
+
+	std::uniform_real_distribution <float> Spread ( - 1.f, 1.f );
+	for ( std::size_t i = 0; i < Count; i ++ ) {
+		const SpatialPoint Velocity { emitter . Velocity . X + emitter . VelocitySpread . X * Spread ( m_Generator ),
+									  emitter . Velocity . Y + emitter . VelocitySpread . Y * Spread ( m_Generator ),
+									  emitter . Velocity . Z + emitter . VelocitySpread . Z * Spread ( m_Generator ) };
+		m_Particles . Add ( emitter . Position, Velocity, emitter . Lifetime, emitter . Color );
+	}
+}
\ No newline at end of file
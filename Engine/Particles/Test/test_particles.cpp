@@ -0,0 +1,124 @@
+#include "gtest/gtest.h"
+#include "Laniakea/ECS/ECS.h"
+#include "Laniakea/Particles/ParticleSystem.h"
+#include <random>
+
+#pragma region TestClasses
+class Particles : public testing::Test
+{
+
+	public:
+		ECS ecs;
+};
+
+struct ReferenceParticle
+{
+	float Values[ ParticleBuffer::StreamsCount ];
+};
+
+std::vector <ReferenceParticle> GetParticles ( const ParticleBuffer & buffer )
+{
+	std::vector <ReferenceParticle> Particles ( buffer . Size () );
+	for ( std::size_t Stream = 0; Stream < ParticleBuffer::StreamsCount; Stream ++ ) {
+		const auto Values = buffer . GetStream ( ( ParticleStream ) Stream );
+		for ( std::size_t i = 0; i < Particles . size (); i ++ )
+			Particles[ i ] . Values[ Stream ] = Values[ i ];
+	}
+	return Particles;
+}
+#pragma endregion
+
+TEST_F ( Particles, UpdateAndCompaction )
+{
+	// The odd count leaves a tail for the scalar path after the vector blocks
+	std::default_random_engine gen;
+	std::uniform_real_distribution <float> value ( - 10.f, 10.f );
+	std::uniform_real_distribution <float> lifetime ( 0.f, 0.5f );
+	ParticleBuffer Buffer;
+	for ( int i = 0; i < 1003; i ++ ) {
+		Buffer . Add ( { value ( gen ), value ( gen ), value ( gen ) }, { value ( gen ), value ( gen ), value ( gen ) }, lifetime ( gen ),
+					   { value ( gen ), value ( gen ), value ( gen ), ( float ) i } );
+	}
+
+	const SpatialPoint Acceleration { 0.f, - 9.81f, 1.f };
+	constexpr float TimeStep = 0.1f;
+	auto Expected = GetParticles ( Buffer );
+	for ( int Frame = 0; Frame < 6; Frame ++ ) {
+		std::vector <ReferenceParticle> Survivors;
+		for ( auto Particle : Expected ) {
+			auto & Values = Particle . Values;
+			Values[ ( std::size_t ) ParticleStream::VelocityX ] += Acceleration . X * TimeStep;
+			Values[ ( std::size_t ) ParticleStream::VelocityY ] += Acceleration . Y * TimeStep;
+			Values[ ( std::size_t ) ParticleStream::VelocityZ ] += Acceleration . Z * TimeStep;
+			Values[ ( std::size_t ) ParticleStream::PositionX ] += Values[ ( std::size_t ) ParticleStream::VelocityX ] * TimeStep;
+			Values[ ( std::size_t ) ParticleStream::PositionY ] += Values[ ( std::size_t ) ParticleStream::VelocityY ] * TimeStep;
+			Values[ ( std::size_t ) ParticleStream::PositionZ ] += Values[ ( std::size_t ) ParticleStream::VelocityZ ] * TimeStep;
+			Values[ ( std::size_t ) ParticleStream::Lifetime ] -= TimeStep;
+			if ( Values[ ( std::size_t ) ParticleStream::Lifetime ] > 0.f )
+				Survivors . push_back ( Particle );
+		}
+
+		EXPECT_EQ ( Buffer . Update ( TimeStep, Acceleration ), Expected . size () - Survivors . size () );
+		Expected = Survivors;
+		const auto Actual = GetParticles ( Buffer );
+		ASSERT_EQ ( Actual . size (), Expected . size () );
+		for ( std::size_t i = 0; i < Actual . size (); i ++ ) {
+			for ( std::size_t Stream = 0; Stream < ParticleBuffer::StreamsCount; Stream ++ ) {
+				EXPECT_FLOAT_EQ ( Actual[ i ] . Values[ Stream ], Expected[ i ] . Values[ Stream ] );
+			}
+		}
+	}
+	EXPECT_EQ ( Buffer . Size (), size_t ( 0 ) );
+}
+
+TEST_F ( Particles, Emission )
+{
+	ecs . RegisterComponent <ParticleEmitterComponent> ();
+	ecs . RegisterSystem <ParticleSystem, ParticleEmitterComponent> ();
+	auto System = ecs . GetSystem <ParticleSystem> () . lock ();
+	System -> SetTimeStep ( 0.1f );
+
+	// 15 particles per second spawn 1.5 per tick and live 5 ticks
+	auto e = ecs . CreateEntity ();
+	ParticleEmitterComponent Emitter ( e, { 1.f, 2.f, 3.f }, 15.f, 0.45f );
+	Emitter . Velocity = { 0.f, 10.f, 0.f };
+	Emitter . VelocitySpread = { 1.f, 0.f, 1.f };
+	ecs . AddComponent <ParticleEmitterComponent> ( e, Emitter );
+
+	ecs . RunSystem <ParticleSystem> ();
+	EXPECT_EQ ( System -> GetParticles () . Size (), size_t ( 1 ) );
+	ecs . RunSystem <ParticleSystem> ();
+	EXPECT_EQ ( System -> GetParticles () . Size (), size_t ( 3 ) );
+	const auto VelocityX = System -> GetParticles () . GetStream ( ParticleStream::VelocityX );
+	const auto VelocityY = System -> GetParticles () . GetStream ( ParticleStream::VelocityY );
+	for ( std::size_t i = 0; i < System -> GetParticles () . Size (); i ++ ) {
+		EXPECT_LE ( std::abs ( VelocityX[ i ] ), 1.f );
+		EXPECT_LE ( VelocityY[ i ], 10.f );
+	}
+
+	// The spawn and the death rates balance out
+	for ( int Tick = 0; Tick < 20; Tick ++ ) {
+		ecs . RunSystem <ParticleSystem> ();
+	}
+	EXPECT_GE ( System -> GetParticles () . Size (), size_t ( 6 ) );
+	EXPECT_LE ( System -> GetParticles () . Size (), size_t ( 8 ) );
+	EXPECT_GT ( System -> GetLastDeadCount (), size_t ( 0 ) );
+
+	// The cap stops the emission, removing the emitter lets the particles die out
+	System -> SetMaxParticles ( 4 );
+	for ( int Tick = 0; Tick < 6; Tick ++ ) {
+		ecs . RunSystem <ParticleSystem> ();
+	}
+	EXPECT_EQ ( System -> GetParticles () . Size (), size_t ( 4 ) );
+	ecs . RemoveEntity ( e );
+	for ( int Tick = 0; Tick < 5; Tick ++ ) {
+		ecs . RunSystem <ParticleSystem> ();
+	}
+	EXPECT_EQ ( System -> GetParticles () . Size (), size_t ( 0 ) );
+}
+
+int main ( int argc, char ** argv )
+{
+	testing::InitGoogleTest ( & argc, argv );
+	return RUN_ALL_TESTS ();
+}
\ No newline at end of file
@@ -0,0 +1,87 @@
+#include "Laniakea/ECS/ECS.h"
+#include "Laniakea/Physics/BroadphaseSystem.h"
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+
+template <typename Func>
+double MeasureMicroseconds ( std::size_t iterations, Func && func )
+{
+	const auto Start = std::chrono::steady_clock::now ();
+	for ( std::size_t i = 0; i < iterations; i ++ )
+		func ();
+	const std::chrono::duration <double, std::micro> Elapsed = std::chrono::steady_clock::now () - Start;
+	return Elapsed . count () / ( double ) iterations;
+}
+
+void Report ( const std::string & name, std::size_t bodiesCount, double microseconds )
+{
+	std::cout << std::left << std::setw ( 48 ) << name << std::setw ( 10 ) << bodiesCount
+			<< std::fixed << std::setprecision ( 2 ) << microseconds << " us" << std::endl;
+}
+
+void RunBroadphaseBenchmark ( std::size_t bodiesCount, bool isParallel )
+{
+	ECS ecs;
+	ecs . RegisterComponent <AABBComponent> ();
+	ecs . RegisterSystem <BroadphaseSystem, AABBComponent> ();
+	auto System = ecs . GetSystem <BroadphaseSystem> () . lock ();
+	System -> SetIsParallel ( isParallel );
+
+	// The world grows with the number of bodies, so each body overlaps a few others
+	const float WorldSize = std::cbrt ( ( float ) bodiesCount ) * 4.f;
+	std::default_random_engine Generator;
+	std::uniform_real_distribution <float> PositionDistribution ( 0.f, WorldSize );
+	std::uniform_real_distribution <float> ExtentDistribution ( 0.25f, 1.f );
+	std::uniform_real_distribution <float> VelocityDistribution ( - 0.2f, 0.2f );
+	std::vector <SpatialPoint> Velocities;
+	for ( std::size_t i = 0; i < bodiesCount; i ++ ) {
+		auto e = ecs . CreateEntity ();
+		const SpatialPoint Center { PositionDistribution ( Generator ), PositionDistribution ( Generator ), PositionDistribution ( Generator ) };
+		const float Extent = ExtentDistribution ( Generator );
+		ecs . AddComponent <AABBComponent> ( e, { e, { { Center . X - Extent, Center . Y - Extent, Center . Z - Extent }, { Center . X + Extent, Center . Y + Extent, Center . Z + Extent } } } );
+		Velocities . push_back ( { VelocityDistribution ( Generator ), VelocityDistribution ( Generator ), VelocityDistribution ( Generator ) } );
+	}
+	const auto Bodies = ecs . GetComponentsByType <AABBComponent> () . lock ();
+	const std::string Suffix = isParallel ? " (parallel)" : "";
+	std::size_t Sink = 0;
+
+	Report ( "initial sort + sweep" + Suffix, bodiesCount, MeasureMicroseconds ( 1, [ & ] ()
+	{
+		ecs . RunSystem <BroadphaseSystem> ();
+		Sink += System -> GetPairs () . size ();
+	} ) );
+
+	// All bodies are dynamic and move every frame
+	constexpr std::size_t FramesCount = 30;
+	std::size_t MovesCount = 0;
+	double MoveTime = 0.;
+	Report ( "frame: insertion sort + sweep" + Suffix, bodiesCount, MeasureMicroseconds ( FramesCount, [ & ] ()
+	{
+		const auto Start = std::chrono::steady_clock::now ();
+		for ( std::size_t i = 0; i < Bodies -> Size (); i ++ ) {
+			auto & Bounds = Bodies -> GetObjectByIndex ( i ) . Bounds;
+			const auto & Velocity = Velocities[ i ];
+			Bounds . Min = { Bounds . Min . X + Velocity . X, Bounds . Min . Y + Velocity . Y, Bounds . Min . Z + Velocity . Z };
+			Bounds . Max = { Bounds . Max . X + Velocity . X, Bounds . Max . Y + Velocity . Y, Bounds . Max . Z + Velocity . Z };
+		}
+		MoveTime += std::chrono::duration <double, std::micro> ( std::chrono::steady_clock::now () - Start ) . count ();
+		ecs . RunSystem <BroadphaseSystem> ();
+		MovesCount += System -> GetLastMovesCount ();
+		Sink += System -> GetPairs () . size ();
+	} ) - MoveTime / FramesCount );
+	std::cout << "(pairs per frame " << System -> GetPairs () . size () << ", insertion moves per frame " << MovesCount / FramesCount
+			<< ", checksum " << Sink << ")" << std::endl << std::endl;
+}
+
+int main ()
+{
+	for ( const std::size_t BodiesCount : { 10000, 100000 } ) {
+		RunBroadphaseBenchmark ( BodiesCount, false );
+		RunBroadphaseBenchmark ( BodiesCount, true );
+	}
+	return 0;
+}
\ No newline at end of file
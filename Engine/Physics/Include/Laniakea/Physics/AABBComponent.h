@@ -0,0 +1,21 @@
+#pragma once
+
+#include "Core.h"
+#include "Laniakea/ECS/ComponentBase.h"
+#include "Laniakea/ECS/SpatialPartition.h"
+
+/**
+ * @struct AABBComponent
+ * @brief World space axis aligned bounding box of the body, read by the BroadphaseSystem.
+ */
+struct LANIAKEA_PHYSICS_API AABBComponent : public ComponentBase
+{
+	/**
+     * @brief Constructor for AABBComponent.
+     * @param owner The handle of the entity that owns this component.
+     * @param bounds The bounding box of the body.
+     */
+	AABBComponent ( EntityHandle owner, const SpatialBounds & bounds );
+
+	SpatialBounds Bounds; /**< The bounding box of the body. */
+};
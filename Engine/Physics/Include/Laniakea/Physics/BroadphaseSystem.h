@@ -0,0 +1,151 @@
+#pragma once
+
+#include "AABBComponent.h"
+#include "Laniakea/ECS/System.h"
+#include "Laniakea/ECS/ThreadPool.h"
+#include <cstdint>
+#include <span>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @struct BroadphasePair
+ * @brief Pair of the entities whose bounding boxes overlap.
+ */
+struct LANIAKEA_PHYSICS_API BroadphasePair
+{
+	EntityHandle First; /**< The entity with the smaller handle. */
+	EntityHandle Second; /**< The entity with the larger handle. */
+};
+
+/**
+ * @class BroadphaseSystem
+ * @brief Finds the overlapping AABBComponent pairs with the sweep and prune.
+ *
+ * Registered as ecs . RegisterSystem <BroadphaseSystem, AABBComponent> (). The sort axis is the one with the largest
+ * spread of the centers, the plane of the other two axes is split into a grid of columns and each column runs its own
+ * sweep along the sort axis, so the number of the candidates doesn't grow with the length of the world. Each column
+ * keeps its order between the frames and re-sorts the nearly sorted boxes with the insertion sort. The sweep tests
+ * the remaining two axes of four candidates at once with SSE. The columns are swept on the ECS thread pool when
+ * the system is parallel.
+ */
+class LANIAKEA_PHYSICS_API BroadphaseSystem : public System
+{
+
+public:
+
+	/**
+     * @brief Finds the overlapping pairs of the AABBComponent array of the ECS.
+     * @param ecs The ECS owning the components.
+     */
+	void Run ( ECS & ecs ) override;
+
+	/**
+     * @brief Finds the overlapping pairs of the bodies.
+     * @param bodies The bounding boxes, e.g. the packed AABBComponent array. The infinite bounds overlap as expected,
+     * the boxes with a NaN bound don't overlap anything.
+     * @param threadPool The thread pool used by the parallel sweep, or nullptr to sweep on the calling thread.
+     */
+	void Update ( std::span <const AABBComponent> bodies, ThreadPool * threadPool );
+
+	/**
+     * @brief Get the pairs found by the last update.
+     * @return A span over the pair buffer, valid until the next update.
+     */
+	std::span <const BroadphasePair> GetPairs () const;
+
+	/**
+     * @brief Set whether the sweep is split across the ECS thread pool.
+     * @param isParallel True to sweep in parallel, small body counts are always swept on the calling thread.
+     */
+	void SetIsParallel ( bool isParallel );
+
+	/**
+     * @brief Check whether the sweep is split across the ECS thread pool.
+     * @return True if the sweep is parallel.
+     */
+	bool GetIsParallel () const;
+
+	/**
+     * @brief Get the axis the bodies are sorted along.
+     * @return 0 for X, 1 for Y, 2 for Z.
+     */
+	std::size_t GetSortAxis () const;
+
+	/**
+     * @brief Get the number of the insertion sort moves of the last update.
+     * @return The number of moves, zero if the bodies were sorted from scratch.
+     */
+	std::size_t GetLastMovesCount () const;
+
+	/**
+     * @brief Get the number of the sweep columns.
+     * @return The number of columns, including the empty ones.
+     */
+	std::size_t GetColumnsCount () const;
+
+private:
+
+	struct CellRange
+	{
+		std::int32_t MinB; /**< The first cell along the second axis. */
+		std::int32_t MaxB; /**< The last cell along the second axis. */
+		std::int32_t MinC; /**< The first cell along the third axis. */
+		std::int32_t MaxC; /**< The last cell along the third axis. */
+
+		bool operator == ( const CellRange & rhs ) const = default;
+	};
+
+	struct Column
+	{
+		std::int32_t B = 0; /**< The cell of the column along the second axis. */
+		std::int32_t C = 0; /**< The cell of the column along the third axis. */
+		bool IsSorted = false; /**< Whether the order is kept from the previous frame. */
+		std::size_t MovesCount = 0; /**< The number of the insertion sort moves of the last update. */
+		std::vector <std::uint32_t> Bodies; /**< The indices of the bodies sorted by the minima along the sort axis. */
+		std::vector <float> Keys; /**< The minima along the sort axis in the sorted order. */
+		std::vector <float> MinA; /**< The minima along the sort axis in the sorted order, padded with infinities. */
+		std::vector <float> MaxA; /**< The maxima along the sort axis. */
+		std::vector <float> MinB; /**< The minima along the second axis. */
+		std::vector <float> MaxB; /**< The maxima along the second axis. */
+		std::vector <float> MinC; /**< The minima along the third axis. */
+		std::vector <float> MaxC; /**< The maxima along the third axis. */
+		std::vector <BroadphasePair> Pairs; /**< The pairs found in the column. */
+	};
+
+	/**
+     * @brief Chooses the sort axis and the columns and moves the bodies between the columns.
+     */
+	void UpdateColumns ( std::span <const AABBComponent> bodies );
+
+	/**
+     * @brief Computes the cells along the second and the third axis overlapped by the bounds.
+     */
+	CellRange GetCellRange ( const SpatialBounds & bounds ) const;
+
+	/**
+     * @brief Retrieves the column of the cell, creating it if needed.
+     */
+	Column & GetColumn ( std::int32_t b, std::int32_t c );
+
+	/**
+     * @brief Re-sorts the column and sweeps it.
+     */
+	void UpdateColumn ( Column & column, std::span <const AABBComponent> bodies ) const;
+
+	/**
+     * @brief Tests each body of the sorted column against the bodies following it and collects the overlapping pairs.
+     */
+	void Sweep ( Column & column, std::span <const AABBComponent> bodies ) const;
+
+	bool m_IsParallel = true; /**< Whether the columns are swept in parallel. */
+	std::size_t m_Axis = 0; /**< The sort axis. */
+	float m_CellSize = 1.f; /**< The size of the column along the second and the third axis. */
+	CellRange m_Grid = {}; /**< The cells of the grid, the bodies leaving it are clamped to the border columns. */
+	std::size_t m_LastMovesCount = 0; /**< The number of the insertion sort moves of the last update. */
+	std::vector <EntityHandle> m_Owners; /**< The owners of the components at the last update, detect the structural changes. */
+	std::vector <CellRange> m_BodyCells; /**< The cells overlapped by each body at the last update. */
+	std::vector <Column> m_Columns; /**< The columns in the creation order, so the pairs are deterministic. */
+	std::unordered_map <std::uint64_t, std::uint32_t> m_ColumnIndices; /**< The indices of the columns by their cells. */
+	std::vector <BroadphasePair> m_Pairs; /**< The pairs found by the last update, reused between the updates. */
+};
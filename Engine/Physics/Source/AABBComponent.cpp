@@ -0,0 +1,7 @@
+#include "Laniakea/Physics/AABBComponent.h"
+
+AABBComponent::AABBComponent ( EntityHandle owner, const SpatialBounds & bounds )
+: ComponentBase ( owner ), Bounds ( bounds )
+{
+
+}
\ No newline at end of file
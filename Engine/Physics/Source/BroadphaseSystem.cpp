@@ -0,0 +1,361 @@
+#include "Laniakea/Physics/BroadphaseSystem.h"
+#include "Laniakea/ECS/ECS.h"
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <limits>
+#include <numeric>
+#ifdef LANIAKEA_PHYSICS_SSE
+#include <emmintrin.h>
+#endif
+
+namespace
+{
+	constexpr std::size_t SweepPadding = 4; /**< The SSE sweep reads up to four bodies past the last one. */
+	constexpr std::size_t ParallelBodiesCount = 4096; /**< The minimal number of bodies swept in parallel. */
+	constexpr double BodiesPerColumn = 64.; /**< The average number of bodies the columns are sized for. */
+	constexpr float ExtentsPerColumn = 4.f; /**< The minimal column size in the average extents, keeps the bodies in few columns. */
+
+	float GetAxisValue ( const SpatialPoint & point, std::size_t axis )
+	{
+		return axis == 0 ? point . X : axis == 1 ? point . Y : point . Z;
+	}
+
+	std::int32_t GetCell ( float value, float cellSize )
+	{
+		constexpr float Limit = 1 << 30;
+		if ( std::isnan ( value ) )
+			return 0;
+		return ( std::int32_t ) std::clamp ( std::floor ( value / cellSize ), - Limit, Limit );
+	}
+
+	/**
+	 * @brief Orders the NaN minima after all others, so the sort stays a strict weak ordering and such bodies pair with none.
+	 */
+	float GetSortKey ( const SpatialBounds & bounds, std::size_t axis )
+	{
+		const float Value = GetAxisValue ( bounds . Min, axis );
+		return std::isnan ( Value ) ? std::numeric_limits <float>::infinity () : Value;
+	}
+}
+
+void BroadphaseSystem::Run ( ECS & ecs )
+{
+	const auto Components = ecs . GetComponentsByType <AABBComponent> () . lock ();
+	if ( ! Components )
+	{
+		m_Pairs . clear ();
+		return;
+	}
+	Update ( std::span <const AABBComponent> ( Components -> Data (), Components -> Size () ), m_IsParallel ? ecs . GetThreadPool () . get () : nullptr );
+}
+
+void BroadphaseSystem::Update ( std::span <const AABBComponent> bodies, ThreadPool * threadPool )
+{
+	UpdateColumns ( bodies );
+
+	if ( threadPool != nullptr && bodies . size () >= ParallelBodiesCount )
+	{
+		threadPool -> ParallelFor ( m_Columns . size (), 1, [ this, bodies ] ( std::size_t begin, std::size_t end )
+		{
+			for ( auto i = begin; i < end; i ++ ) {
+				UpdateColumn ( m_Columns[ i ], bodies );
+			}
+		} );
+	}
+	else
+	{
+		for ( auto & Column : m_Columns ) {
+			UpdateColumn ( Column, bodies );
+		}
+	}
+
+	// Concatenated in the creation order of the columns, so the serial and the parallel sweeps report the same sequence
+	m_Pairs . clear ();
+	m_LastMovesCount = 0;
+	for ( const auto & Column : m_Columns ) {
+		m_Pairs . insert ( m_Pairs . end (), Column . Pairs . begin (), Column . Pairs . end () );
+		m_LastMovesCount += Column . MovesCount;
+	}
+}
+
+std::span <const BroadphasePair> BroadphaseSystem::GetPairs () const
+{
+	return m_Pairs;
+}
+
+void BroadphaseSystem::SetIsParallel ( bool isParallel )
+{
+	m_IsParallel = isParallel;
+}
+
+bool BroadphaseSystem::GetIsParallel () const
+{
+	return m_IsParallel;
+}
+
+std::size_t BroadphaseSystem::GetSortAxis () const
+{
+	return m_Axis;
+}
+
+std::size_t BroadphaseSystem::GetLastMovesCount () const
+{
+	return m_LastMovesCount;
+}
+
+std::size_t BroadphaseSystem::GetColumnsCount () const
+{
+	return m_Columns . size ();
+}
+
+void BroadphaseSystem::UpdateColumns ( std::span <const AABBComponent> bodies )
+{
+	const auto Count = bodies . size ();
+	bool IsChanged = Count != m_Owners . size ();
+	double Sum[ 3 ] = { 0., 0., 0. };
+	double SquaresSum[ 3 ] = { 0., 0., 0. };
+	for ( std::size_t i = 0; i < Count; i ++ ) {
+		const auto & Bounds = bodies[ i ] . Bounds;
+		for ( std::size_t Axis = 0; Axis < 3; Axis ++ ) {
+			const double Center = 0.5 * ( GetAxisValue ( Bounds . Min, Axis ) + GetAxisValue ( Bounds . Max, Axis ) );
+			Sum[ Axis ] += Center;
+			SquaresSum[ Axis ] += Center * Center;
+		}
+		IsChanged = IsChanged || m_Owners[ i ] != bodies[ i ] . GetOwner ();
+	}
+
+	// The axis with the largest spread separates the most bodies, it is switched only if clearly better to avoid resorting
+	std::size_t BestAxis = m_Axis;
+	double BestVariance = 0.;
+	for ( std::size_t Axis = 0; Axis < 3 && Count > 0; Axis ++ ) {
+		const double Variance = SquaresSum[ Axis ] / ( double ) Count - ( Sum[ Axis ] / ( double ) Count ) * ( Sum[ Axis ] / ( double ) Count );
+		const double Weight = Axis == m_Axis ? 1.5 : 1.;
+		if ( Variance * Weight > BestVariance )
+		{
+			BestVariance = Variance * Weight;
+			BestAxis = Axis;
+		}
+	}
+
+	if ( ! IsChanged && BestAxis == m_Axis )
+	{
+		// Only the bodies crossing the column borders move between the columns, the rest keep their sorted positions
+		for ( std::size_t i = 0; i < Count; i ++ ) {
+			const auto Cells = GetCellRange ( bodies[ i ] . Bounds );
+			const auto & OldCells = m_BodyCells[ i ];
+			if ( Cells == OldCells )
+				continue;
+			const auto IsInRange = [] ( const CellRange & range, std::int32_t b, std::int32_t c )
+			{
+				return b >= range . MinB && b <= range . MaxB && c >= range . MinC && c <= range . MaxC;
+			};
+			for ( auto b = OldCells . MinB; b <= OldCells . MaxB; b ++ ) {
+				for ( auto c = OldCells . MinC; c <= OldCells . MaxC; c ++ ) {
+					if ( IsInRange ( Cells, b, c ) )
+						continue;
+					auto & Bodies = GetColumn ( b, c ) . Bodies;
+					Bodies . erase ( std::find ( Bodies . begin (), Bodies . end (), ( std::uint32_t ) i ) );
+				}
+			}
+			for ( auto b = Cells . MinB; b <= Cells . MaxB; b ++ ) {
+				for ( auto c = Cells . MinC; c <= Cells . MaxC; c ++ ) {
+					if ( ! IsInRange ( OldCells, b, c ) )
+						GetColumn ( b, c ) . Bodies . push_back ( ( std::uint32_t ) i );
+				}
+			}
+			m_BodyCells[ i ] = Cells;
+		}
+		return;
+	}
+
+	// The columns are sized for the current distribution and filled from scratch
+	m_Axis = BestAxis;
+	const auto AxisB = ( m_Axis + 1 ) % 3;
+	const auto AxisC = ( m_Axis + 2 ) % 3;
+	double ExtentsSum = 0.;
+	float MinB = std::numeric_limits <float>::max ();
+	float MaxB = std::numeric_limits <float>::lowest ();
+	float MinC = std::numeric_limits <float>::max ();
+	float MaxC = std::numeric_limits <float>::lowest ();
+	// The grid covers the finite bounds only, the infinite boxes are clamped into it instead of spanning 2^31 cells
+	for ( const auto & Body : bodies ) {
+		const auto & Bounds = Body . Bounds;
+		const float BodyMin[ 2 ] = { GetAxisValue ( Bounds . Min, AxisB ), GetAxisValue ( Bounds . Min, AxisC ) };
+		const float BodyMax[ 2 ] = { GetAxisValue ( Bounds . Max, AxisB ), GetAxisValue ( Bounds . Max, AxisC ) };
+		for ( std::size_t Axis = 0; Axis < 2; Axis ++ ) {
+			if ( std::isfinite ( BodyMin[ Axis ] ) && std::isfinite ( BodyMax[ Axis ] ) )
+				ExtentsSum += BodyMax[ Axis ] - BodyMin[ Axis ];
+		}
+		if ( std::isfinite ( BodyMin[ 0 ] ) )
+			MinB = std::min ( MinB, BodyMin[ 0 ] );
+		if ( std::isfinite ( BodyMax[ 0 ] ) )
+			MaxB = std::max ( MaxB, BodyMax[ 0 ] );
+		if ( std::isfinite ( BodyMin[ 1 ] ) )
+			MinC = std::min ( MinC, BodyMin[ 1 ] );
+		if ( std::isfinite ( BodyMax[ 1 ] ) )
+			MaxC = std::max ( MaxC, BodyMax[ 1 ] );
+	}
+	MinB = std::min ( MinB, MaxB );
+	MinC = std::min ( MinC, MaxC );
+	const double Area = Count > 0 ? ( ( double ) MaxB - MinB ) * ( ( double ) MaxC - MinC ) : 0.;
+	const double CellSize = std::max ( ( double ) ExtentsPerColumn * ExtentsSum / ( 2. * ( double ) std::max ( Count, std::size_t ( 1 ) ) ),
+									   std::sqrt ( Area * BodiesPerColumn / ( double ) std::max ( Count, std::size_t ( 1 ) ) ) );
+	m_CellSize = std::isfinite ( CellSize ) && CellSize > 0. ? ( float ) CellSize : 1.f;
+	m_Grid = { GetCell ( MinB, m_CellSize ), GetCell ( MaxB, m_CellSize ), GetCell ( MinC, m_CellSize ), GetCell ( MaxC, m_CellSize ) };
+	if ( Count == 0 )
+		m_Grid = { 0, 0, 0, 0 };
+
+	m_Columns . clear ();
+	m_ColumnIndices . clear ();
+	m_Owners . resize ( Count );
+	m_BodyCells . resize ( Count );
+	for ( std::size_t i = 0; i < Count; i ++ ) {
+		m_Owners[ i ] = bodies[ i ] . GetOwner ();
+		m_BodyCells[ i ] = GetCellRange ( bodies[ i ] . Bounds );
+		for ( auto b = m_BodyCells[ i ] . MinB; b <= m_BodyCells[ i ] . MaxB; b ++ ) {
+			for ( auto c = m_BodyCells[ i ] . MinC; c <= m_BodyCells[ i ] . MaxC; c ++ ) {
+				GetColumn ( b, c ) . Bodies . push_back ( ( std::uint32_t ) i );
+			}
+		}
+	}
+}
+
+BroadphaseSystem::CellRange BroadphaseSystem::GetCellRange ( const SpatialBounds & bounds ) const
+{
+	const auto AxisB = ( m_Axis + 1 ) % 3;
+	const auto AxisC = ( m_Axis + 2 ) % 3;
+	// Clamping keeps the cells monotonic in the coordinates, which the ownership of the pairs relies on
+	return { std::clamp ( GetCell ( GetAxisValue ( bounds . Min, AxisB ), m_CellSize ), m_Grid . MinB, m_Grid . MaxB ),
+			 std::clamp ( GetCell ( GetAxisValue ( bounds . Max, AxisB ), m_CellSize ), m_Grid . MinB, m_Grid . MaxB ),
+			 std::clamp ( GetCell ( GetAxisValue ( bounds . Min, AxisC ), m_CellSize ), m_Grid . MinC, m_Grid . MaxC ),
+			 std::clamp ( GetCell ( GetAxisValue ( bounds . Max, AxisC ), m_CellSize ), m_Grid . MinC, m_Grid . MaxC ) };
+}
+
+BroadphaseSystem::Column & BroadphaseSystem::GetColumn ( std::int32_t b, std::int32_t c )
+{
+	const auto Key = ( ( std::uint64_t ) ( std::uint32_t ) b << 32 ) | ( std::uint32_t ) c;
+	const auto [ Iterator, IsInserted ] = m_ColumnIndices . try_emplace ( Key, ( std::uint32_t ) m_Columns . size () );
+	if ( IsInserted )
+	{
+		auto & Column = m_Columns . emplace_back ();
+		Column . B = b;
+		Column . C = c;
+	}
+	return m_Columns[ Iterator -> second ];
+}
+
+void BroadphaseSystem::UpdateColumn ( Column & column, std::span <const AABBComponent> bodies ) const
+{
+	const auto Count = column . Bodies . size ();
+	column . Keys . resize ( Count );
+	for ( std::size_t i = 0; i < Count; i ++ ) {
+		column . Keys[ i ] = GetSortKey ( bodies[ column . Bodies[ i ] ] . Bounds, m_Axis );
+	}
+
+	// Nearly sorted since the last frame, the insertion sort moves each body only past the bodies it has overtaken
+	column . MovesCount = 0;
+	for ( std::size_t i = 1; column . IsSorted && i < Count; i ++ ) {
+		const float Key = column . Keys[ i ];
+		const auto Index = column . Bodies[ i ];
+		auto j = i;
+		for ( ; j > 0 && column . Keys[ j - 1 ] > Key; j -- ) {
+			column . Keys[ j ] = column . Keys[ j - 1 ];
+			column . Bodies[ j ] = column . Bodies[ j - 1 ];
+		}
+		column . Keys[ j ] = Key;
+		column . Bodies[ j ] = Index;
+		column . MovesCount += i - j;
+		// Teleports make the insertion sort quadratic, sorting from scratch is cheaper then
+		if ( column . MovesCount > Count * 8 )
+			column . IsSorted = false;
+	}
+	if ( ! column . IsSorted )
+	{
+		std::sort ( column . Bodies . begin (), column . Bodies . end (), [ this, bodies ] ( std::uint32_t lhs, std::uint32_t rhs )
+		{
+			return GetSortKey ( bodies[ lhs ] . Bounds, m_Axis ) < GetSortKey ( bodies[ rhs ] . Bounds, m_Axis );
+		} );
+		for ( std::size_t i = 0; i < Count; i ++ ) {
+			column . Keys[ i ] = GetSortKey ( bodies[ column . Bodies[ i ] ] . Bounds, m_Axis );
+		}
+		column . MovesCount = 0;
+		column . IsSorted = true;
+	}
+
+	const auto AxisB = ( m_Axis + 1 ) % 3;
+	const auto AxisC = ( m_Axis + 2 ) % 3;
+	constexpr float Infinity = std::numeric_limits <float>::infinity ();
+	column . MinA . assign ( Count + SweepPadding, Infinity );
+	column . MaxA . assign ( Count + SweepPadding, - Infinity );
+	column . MinB . assign ( Count + SweepPadding, Infinity );
+	column . MaxB . assign ( Count + SweepPadding, - Infinity );
+	column . MinC . assign ( Count + SweepPadding, Infinity );
+	column . MaxC . assign ( Count + SweepPadding, - Infinity );
+	for ( std::size_t i = 0; i < Count; i ++ ) {
+		const auto & Bounds = bodies[ column . Bodies[ i ] ] . Bounds;
+		column . MinA[ i ] = column . Keys[ i ];
+		column . MaxA[ i ] = GetAxisValue ( Bounds . Max, m_Axis );
+		// A NaN minimum is swept as an infinity, the NaN passed on keeps the body from overlapping anything as it should
+		const bool IsNaN = std::isnan ( GetAxisValue ( Bounds . Min, m_Axis ) );
+		column . MinB[ i ] = IsNaN ? std::numeric_limits <float>::quiet_NaN () : GetAxisValue ( Bounds . Min, AxisB );
+		column . MaxB[ i ] = GetAxisValue ( Bounds . Max, AxisB );
+		column . MinC[ i ] = GetAxisValue ( Bounds . Min, AxisC );
+		column . MaxC[ i ] = GetAxisValue ( Bounds . Max, AxisC );
+	}
+	Sweep ( column, bodies );
+}
+
+void BroadphaseSystem::Sweep ( Column & column, std::span <const AABBComponent> bodies ) const
+{
+	// The pair spanning several columns is owned by the column of the larger minima only, so it is reported once
+	const auto AddPair = [ this, & column, bodies ] ( std::size_t lhs, std::size_t rhs )
+	{
+		const auto First = column . Bodies[ lhs ];
+		const auto Second = column . Bodies[ rhs ];
+		if ( std::max ( m_BodyCells[ First ] . MinB, m_BodyCells[ Second ] . MinB ) != column . B ||
+			 std::max ( m_BodyCells[ First ] . MinC, m_BodyCells[ Second ] . MinC ) != column . C )
+			return;
+		const auto FirstOwner = bodies[ First ] . GetOwner ();
+		const auto SecondOwner = bodies[ Second ] . GetOwner ();
+		column . Pairs . push_back ( { std::min ( FirstOwner, SecondOwner ), std::max ( FirstOwner, SecondOwner ) } );
+	};
+
+	column . Pairs . clear ();
+	for ( std::size_t i = 0, Count = column . Bodies . size (); i < Count; i ++ ) {
+		auto j = i + 1;
+#ifdef LANIAKEA_PHYSICS_SSE
+		const __m128 MaxA = _mm_set1_ps ( column . MaxA[ i ] );
+		const __m128 MinB = _mm_set1_ps ( column . MinB[ i ] );
+		const __m128 MaxB = _mm_set1_ps ( column . MaxB[ i ] );
+		const __m128 MinC = _mm_set1_ps ( column . MinC[ i ] );
+		const __m128 MaxC = _mm_set1_ps ( column . MaxC[ i ] );
+		while ( j < Count )
+		{
+			// The candidates are sorted by the minimum, so the first one starting past the maximum ends the sweep.
+			// The padding lanes are masked out, an infinite maximum would take them for candidates
+			const unsigned LanesMask = Count - j >= 4 ? 0xFu : ( 1u << ( Count - j ) ) - 1;
+			const __m128 InRange = _mm_cmple_ps ( _mm_loadu_ps ( & column . MinA[ j ] ), MaxA );
+			const auto RangeMask = ( unsigned ) _mm_movemask_ps ( InRange ) & LanesMask;
+			if ( RangeMask == 0 )
+				break;
+			__m128 Overlap = _mm_and_ps ( InRange, _mm_cmple_ps ( _mm_loadu_ps ( & column . MinB[ j ] ), MaxB ) );
+			Overlap = _mm_and_ps ( Overlap, _mm_cmpge_ps ( _mm_loadu_ps ( & column . MaxB[ j ] ), MinB ) );
+			Overlap = _mm_and_ps ( Overlap, _mm_cmple_ps ( _mm_loadu_ps ( & column . MinC[ j ] ), MaxC ) );
+			Overlap = _mm_and_ps ( Overlap, _mm_cmpge_ps ( _mm_loadu_ps ( & column . MaxC[ j ] ), MinC ) );
+			for ( auto Mask = ( unsigned ) _mm_movemask_ps ( Overlap ) & LanesMask; Mask != 0; Mask &= Mask - 1 ) {
+				AddPair ( i, j + ( std::size_t ) std::countr_zero ( Mask ) );
+			}
+			if ( RangeMask != 0xF )
+				break;
+			j += 4;
+		}
+#else
+		for ( ; j < Count && column . MinA[ j ] <= column . MaxA[ i ]; j ++ ) {
+			if ( column . MinB[ j ] <= column . MaxB[ i ] && column . MaxB[ j ] >= column . MinB[ i ] &&
+				 column . MinC[ j ] <= column . MaxC[ i ] && column . MaxC[ j ] >= column . MinC[ i ] )
+				AddPair ( i, j );
+		}
+#endif
+	}
+}
\ No newline at end of file
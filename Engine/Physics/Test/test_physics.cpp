@@ -0,0 +1,198 @@
+#include "gtest/gtest.h"
+#include "Laniakea/ECS/ECS.h"
+#include "Laniakea/Physics/BroadphaseSystem.h"
+#include <limits>
+#include <random>
+#include <set>
+
+#pragma region TestClasses
+class Broadphase : public testing::Test
+{
+
+	public:
+		ECS ecs;
+};
+
+SpatialBounds MakeBox ( std::default_random_engine & gen, float worldSize )
+{
+	std::uniform_real_distribution <float> position ( 0.f, worldSize );
+	std::uniform_real_distribution <float> extent ( 0.1f, 2.f );
+	const SpatialPoint Center { position ( gen ), position ( gen ), position ( gen ) };
+	const SpatialPoint HalfSize { extent ( gen ), extent ( gen ), extent ( gen ) };
+	return { { Center . X - HalfSize . X, Center . Y - HalfSize . Y, Center . Z - HalfSize . Z },
+			 { Center . X + HalfSize . X, Center . Y + HalfSize . Y, Center . Z + HalfSize . Z } };
+}
+
+std::set <std::pair <EntityHandle, EntityHandle>> FindPairsBruteForce ( ECS & ecs )
+{
+	auto Bodies = ecs . GetComponentsByType <AABBComponent> () . lock ();
+	std::set <std::pair <EntityHandle, EntityHandle>> Pairs;
+	for ( std::size_t i = 0; i < Bodies -> Size (); i ++ ) {
+		for ( std::size_t j = i + 1; j < Bodies -> Size (); j ++ ) {
+			const auto & A = Bodies -> GetObjectByIndex ( i );
+			const auto & B = Bodies -> GetObjectByIndex ( j );
+			if ( A . Bounds . Min . X <= B . Bounds . Max . X && B . Bounds . Min . X <= A . Bounds . Max . X
+				 && A . Bounds . Min . Y <= B . Bounds . Max . Y && B . Bounds . Min . Y <= A . Bounds . Max . Y
+				 && A . Bounds . Min . Z <= B . Bounds . Max . Z && B . Bounds . Min . Z <= A . Bounds . Max . Z )
+				Pairs . emplace ( std::min ( A . GetOwner (), B . GetOwner () ), std::max ( A . GetOwner (), B . GetOwner () ) );
+		}
+	}
+	return Pairs;
+}
+
+std::set <std::pair <EntityHandle, EntityHandle>> GetPairs ( const BroadphaseSystem & system )
+{
+	std::set <std::pair <EntityHandle, EntityHandle>> Pairs;
+	for ( const auto & Pair : system . GetPairs () ) {
+		EXPECT_LT ( Pair . First, Pair . Second );
+		EXPECT_TRUE ( Pairs . emplace ( Pair . First, Pair . Second ) . second );
+	}
+	return Pairs;
+}
+#pragma endregion
+
+TEST_F ( Broadphase, SweepAndPrune )
+{
+	ecs . RegisterComponent <AABBComponent> ();
+	ecs . RegisterSystem <BroadphaseSystem, AABBComponent> ();
+	auto System = ecs . GetSystem <BroadphaseSystem> () . lock ();
+	std::default_random_engine gen;
+	std::vector <EntityHandle> Entities;
+	for ( int i = 0; i < 3000; i ++ ) {
+		auto e = ecs . CreateEntity ();
+		Entities . push_back ( e );
+		ecs . AddComponent <AABBComponent> ( e, { e, MakeBox ( gen, 60.f ) } );
+	}
+
+	ecs . RunSystem <BroadphaseSystem> ();
+	auto Expected = FindPairsBruteForce ( ecs );
+	EXPECT_FALSE ( Expected . empty () );
+	EXPECT_EQ ( GetPairs ( * System ), Expected );
+
+	// Small moves keep the order nearly sorted and are handled by the insertion sort
+	std::uniform_real_distribution <float> move ( - 0.3f, 0.3f );
+	auto Bodies = ecs . GetComponentsByType <AABBComponent> () . lock ();
+	for ( int Frame = 0; Frame < 3; Frame ++ ) {
+		for ( auto & Body : * Bodies ) {
+			const SpatialPoint Offset { move ( gen ), move ( gen ), move ( gen ) };
+			Body . Bounds . Min = { Body . Bounds . Min . X + Offset . X, Body . Bounds . Min . Y + Offset . Y, Body . Bounds . Min . Z + Offset . Z };
+			Body . Bounds . Max = { Body . Bounds . Max . X + Offset . X, Body . Bounds . Max . Y + Offset . Y, Body . Bounds . Max . Z + Offset . Z };
+		}
+		ecs . RunSystem <BroadphaseSystem> ();
+		EXPECT_GT ( System -> GetLastMovesCount (), size_t ( 0 ) );
+		EXPECT_EQ ( GetPairs ( * System ), FindPairsBruteForce ( ecs ) );
+	}
+
+	// Structural changes sort from scratch
+	ecs . DestroyEntities ( std::span <const EntityHandle> ( Entities ) . first ( 1000 ) );
+	ecs . RunSystem <BroadphaseSystem> ();
+	EXPECT_EQ ( System -> GetLastMovesCount (), size_t ( 0 ) );
+	EXPECT_EQ ( GetPairs ( * System ), FindPairsBruteForce ( ecs ) );
+}
+
+TEST_F ( Broadphase, SortAxis )
+{
+	ecs . RegisterComponent <AABBComponent> ();
+	ecs . RegisterSystem <BroadphaseSystem, AABBComponent> ();
+	auto System = ecs . GetSystem <BroadphaseSystem> () . lock ();
+	// Bodies spread along Z and stacked in X and Y
+	for ( int i = 0; i < 100; i ++ ) {
+		auto e = ecs . CreateEntity ();
+		const float Z = ( float ) i * 1.5f;
+		ecs . AddComponent <AABBComponent> ( e, { e, { { 0.f, 0.f, Z }, { 1.f, 1.f, Z + 1.f } } } );
+	}
+	ecs . RunSystem <BroadphaseSystem> ();
+	EXPECT_EQ ( System -> GetSortAxis (), size_t ( 2 ) );
+	EXPECT_TRUE ( System -> GetPairs () . empty () );
+}
+
+TEST_F ( Broadphase, ColumnCrossing )
+{
+	std::default_random_engine gen;
+	std::vector <AABBComponent> Bodies;
+	for ( EntityHandle e = 0; e < 5000; e ++ ) {
+		Bodies . emplace_back ( e, MakeBox ( gen, 100.f ) );
+	}
+	BroadphaseSystem System;
+	System . Update ( Bodies, nullptr );
+	EXPECT_GT ( System . GetColumnsCount (), size_t ( 1 ) );
+
+	// Large moves carry the bodies across the columns and out of the grid, the pairs are still reported once
+	std::uniform_real_distribution <float> move ( - 20.f, 20.f );
+	for ( int Frame = 0; Frame < 4; Frame ++ ) {
+		for ( auto & Body : Bodies ) {
+			const SpatialPoint Offset { move ( gen ), move ( gen ), move ( gen ) };
+			Body . Bounds . Min = { Body . Bounds . Min . X + Offset . X, Body . Bounds . Min . Y + Offset . Y, Body . Bounds . Min . Z + Offset . Z };
+			Body . Bounds . Max = { Body . Bounds . Max . X + Offset . X, Body . Bounds . Max . Y + Offset . Y, Body . Bounds . Max . Z + Offset . Z };
+		}
+		System . Update ( Bodies, nullptr );
+		std::set <std::pair <EntityHandle, EntityHandle>> Expected;
+		for ( std::size_t i = 0; i < Bodies . size (); i ++ ) {
+			for ( std::size_t j = i + 1; j < Bodies . size (); j ++ ) {
+				const auto & A = Bodies[ i ] . Bounds;
+				const auto & B = Bodies[ j ] . Bounds;
+				if ( A . Min . X <= B . Max . X && B . Min . X <= A . Max . X && A . Min . Y <= B . Max . Y && B . Min . Y <= A . Max . Y
+					 && A . Min . Z <= B . Max . Z && B . Min . Z <= A . Max . Z )
+					Expected . emplace ( Bodies[ i ] . GetOwner (), Bodies[ j ] . GetOwner () );
+			}
+		}
+		EXPECT_EQ ( GetPairs ( System ), Expected );
+	}
+}
+
+TEST_F ( Broadphase, ParallelSweep )
+{
+	ThreadPool Pool ( 3 );
+	std::default_random_engine gen;
+	std::vector <AABBComponent> Bodies;
+	for ( EntityHandle e = 0; e < 20000; e ++ ) {
+		Bodies . emplace_back ( e, MakeBox ( gen, 150.f ) );
+	}
+	BroadphaseSystem Serial;
+	BroadphaseSystem Parallel;
+	Serial . Update ( Bodies, nullptr );
+	Parallel . Update ( Bodies, & Pool );
+	ASSERT_FALSE ( Serial . GetPairs () . empty () );
+	EXPECT_EQ ( GetPairs ( Serial ), GetPairs ( Parallel ) );
+	EXPECT_TRUE ( std::equal ( Serial . GetPairs () . begin (), Serial . GetPairs () . end (), Parallel . GetPairs () . begin (), Parallel . GetPairs () . end (),
+							   [] ( const BroadphasePair & lhs, const BroadphasePair & rhs ) { return lhs . First == rhs . First && lhs . Second == rhs . Second; } ) );
+}
+
+TEST_F ( Broadphase, NonFiniteBounds )
+{
+	constexpr float Infinity = std::numeric_limits <float>::infinity ();
+	constexpr float NaN = std::numeric_limits <float>::quiet_NaN ();
+	std::default_random_engine gen;
+	// The small counts end the sweep inside the SSE padding, where an infinite maximum used to read past the columns
+	for ( EntityHandle Count : { 1u, 2u, 3u, 5u, 7u, 200u } ) {
+		std::vector <AABBComponent> Bodies;
+		Bodies . emplace_back ( 0u, SpatialBounds { { - Infinity, - Infinity, - Infinity }, { Infinity, Infinity, Infinity } } );
+		Bodies . emplace_back ( 1u, SpatialBounds { { 0.f, 0.f, 0.f }, { Infinity, 5.f, 5.f } } );
+		Bodies . emplace_back ( 2u, SpatialBounds { { NaN, 0.f, 0.f }, { NaN, 1.f, 1.f } } );
+		Bodies . emplace_back ( 3u, SpatialBounds { { 0.f, NaN, 0.f }, { 1.f, 1.f, NaN } } );
+		for ( EntityHandle e = 4; e < 4 + Count; e ++ ) {
+			Bodies . emplace_back ( e, MakeBox ( gen, 20.f ) );
+		}
+		BroadphaseSystem System;
+		for ( int Frame = 0; Frame < 2; Frame ++ ) {
+			System . Update ( Bodies, nullptr );
+			std::set <std::pair <EntityHandle, EntityHandle>> Expected;
+			for ( std::size_t i = 0; i < Bodies . size (); i ++ ) {
+				for ( std::size_t j = i + 1; j < Bodies . size (); j ++ ) {
+					const auto & A = Bodies[ i ] . Bounds;
+					const auto & B = Bodies[ j ] . Bounds;
+					if ( A . Min . X <= B . Max . X && B . Min . X <= A . Max . X && A . Min . Y <= B . Max . Y && B . Min . Y <= A . Max . Y
+						 && A . Min . Z <= B . Max . Z && B . Min . Z <= A . Max . Z )
+						Expected . emplace ( Bodies[ i ] . GetOwner (), Bodies[ j ] . GetOwner () );
+				}
+			}
+			EXPECT_EQ ( GetPairs ( System ), Expected );
+		}
+	}
+}
+
+int main ( int argc, char ** argv )
+{
+	testing::InitGoogleTest( &argc, argv );
+	return RUN_ALL_TESTS();
+}
\ No newline at end of file
@@ -7,9 +7,14 @@ namespace lk
 namespace gfx
 {
 
+class StreamBuffer;
+
 namespace detail
 {
 	void LANIAKEA_RENDER_API _SetAttributeImpl ( unsigned int handle, const void * data, unsigned int size, unsigned int length );
+	void LANIAKEA_RENDER_API _StreamAttributeImpl ( unsigned int handle, const void * data, unsigned int size, unsigned int length );
+	void LANIAKEA_RENDER_API _UpdateAttributeImpl ( unsigned int handle, unsigned int capacity, const void * data, unsigned int size,
+													unsigned int first, unsigned int length, StreamBuffer & staging );
 }
 struct LANIAKEA_RENDER_API AttributeDescriptor
 {
@@ -18,6 +23,7 @@ struct LANIAKEA_RENDER_API AttributeDescriptor
 	unsigned int Type; // GLenum type (GL_FLOAT, GL_INT etc)
 	int Stride;
 	unsigned int Offset;
+	unsigned int Divisor = 0; // 0 advances per vertex, N advances once per N instances
 };
 
 class LANIAKEA_RENDER_API Attribute
@@ -35,6 +41,7 @@ class LANIAKEA_RENDER_API Attribute
 		void Set ( T * Array, unsigned int Length )
 		{
 			m_Count = Length;
+			m_Size = sizeof ( T ) * Length;
 			detail::_SetAttributeImpl ( m_Handle, ( void * ) Array, sizeof ( T ), Length );
 		}
 		template <typename T>
@@ -43,6 +50,35 @@ class LANIAKEA_RENDER_API Attribute
 			Set ( Array.data(), Array.size() );
 		}
 
+		// Replaces the contents rewritten every frame, e.g. the instance data. The storage is orphaned before the upload,
+		// so the upload doesn't wait for the draws still reading the previous contents
+		template <typename T>
+		void Stream ( const T * Array, unsigned int Length )
+		{
+			m_Count = Length;
+			m_Size = sizeof ( T ) * Length;
+			detail::_StreamAttributeImpl ( m_Handle, ( const void * ) Array, sizeof ( T ), Length );
+		}
+
+		// Allocates the storage for Length elements without contents, e.g. the destination of the Update calls.
+		// The previous contents are discarded.
+		template <typename T>
+		void Allocate ( unsigned int Length )
+		{
+			m_Count = Length;
+			m_Size = sizeof ( T ) * Length;
+			detail::_SetAttributeImpl ( m_Handle, nullptr, sizeof ( T ), Length );
+		}
+
+		// Replaces the elements [ First, First + Length ) keeping the rest. The elements are written to the staging ring
+		// and copied on the GPU, so the update neither reallocates the storage nor waits for the draws reading it.
+		// Throws RenderException if the range exceeds the contents set last.
+		template <typename T>
+		void Update ( const T * Array, unsigned int First, unsigned int Length, StreamBuffer & Staging )
+		{
+			detail::_UpdateAttributeImpl ( m_Handle, m_Size, ( const void * ) Array, sizeof ( T ), First, Length, Staging );
+		}
+
 		void BindTo ( const AttributeDescriptor & Descriptor );
 
 		void UnbindFrom ( unsigned int Slot );
@@ -53,6 +89,7 @@ class LANIAKEA_RENDER_API Attribute
 
 	private:
 		unsigned int m_Count;
+		unsigned int m_Size;
 		unsigned int m_Handle;
 };
 } // namespace gfx
@@ -0,0 +1,27 @@
+#pragma once
+#include "Laniakea/Render/Core.h"
+#include "Laniakea/Render/CompressedImage.h"
+
+namespace lk
+{
+namespace gfx
+{
+
+// CPU encoders of the block compressed formats, run offline by the Compress-Texture tool so loading a texture
+// is a plain copy of the blocks to the GPU. The endpoints are fit along the principal axis of the block colors
+// and each texel takes the nearest palette entry. BC7 textures can be loaded but aren't encoded here, its mode
+// and partition search is left to the dedicated encoders.
+
+// Encodes 16 RGBA8 texels, row by row, into an 8 byte BC1 block. The alpha is dropped.
+LANIAKEA_RENDER_API void CompressBC1Block ( const unsigned char * Texels, unsigned char * Output );
+
+// Encodes 16 RGBA8 texels, row by row, into a 16 byte BC3 block
+LANIAKEA_RENDER_API void CompressBC3Block ( const unsigned char * Texels, unsigned char * Output );
+
+// Compresses an RGBA8 image and, with GenerateMips, its mip chain down to 1x1 made by a 2x2 box filter. The sRGB
+// images are filtered in linear space. Throws RenderException for BC7.
+LANIAKEA_RENDER_API CompressedImage CompressImage ( const unsigned char * Pixels, unsigned int Width, unsigned int Height,
+													CompressedFormat Format, bool IsSRGB, bool GenerateMips );
+
+} // namespace gfx
+} // namespace lk
@@ -0,0 +1,57 @@
+#pragma once
+#include "Laniakea/Render/Core.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace lk
+{
+namespace gfx
+{
+
+// Block compressed formats, each 4x4 texel block takes 8 (BC1) or 16 bytes (BC3, BC7)
+enum class CompressedFormat
+{
+	BC1, // RGB with 1 bit alpha, 4 bits per texel
+	BC3, // RGBA, 8 bits per texel
+	BC7  // RGBA of higher quality, 8 bits per texel
+};
+
+struct CompressedMipLevel
+{
+	unsigned int Width;
+	unsigned int Height;
+	size_t Offset; // Into CompressedImage::Data
+	size_t Size;
+};
+
+// A block compressed image with its mip chain, as stored in the DDS and KTX2 containers. The levels go from
+// the full size image down, their data is uploaded as is with glCompressedTexImage2D.
+struct LANIAKEA_RENDER_API CompressedImage
+{
+	CompressedFormat Format = CompressedFormat::BC1;
+	bool IsSRGB = false;
+	unsigned int Width = 0;
+	unsigned int Height = 0;
+	std::vector<CompressedMipLevel> Levels;
+	std::vector<unsigned char> Data;
+};
+
+LANIAKEA_RENDER_API size_t GetBlockSize ( CompressedFormat Format );
+
+// Size of the level data, the image is padded to whole blocks
+LANIAKEA_RENDER_API size_t GetCompressedSize ( CompressedFormat Format, unsigned int Width, unsigned int Height );
+
+// True if the file starts with the DDS or the KTX2 signature
+LANIAKEA_RENDER_API bool GetIsCompressedImageFile ( const std::string & Path );
+
+// Reads a DDS (DXT1, DXT5 or DX10 with BC1, BC3, BC7) or a KTX2 (BC1, BC3, BC7 without supercompression) file.
+// Throws RenderException if the file can't be read, is malformed or holds another format.
+LANIAKEA_RENDER_API CompressedImage LoadCompressedImage ( const std::string & Path );
+
+// Writes the image as DDS or KTX2, picked by the extension of the path (.dds or .ktx2). Throws RenderException on failure.
+LANIAKEA_RENDER_API void SaveCompressedImage ( const CompressedImage & Image, const std::string & Path );
+
+} // namespace gfx
+} // namespace lk
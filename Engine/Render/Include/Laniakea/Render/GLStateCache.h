@@ -0,0 +1,126 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include "Laniakea/Render/Core.h"
+
+namespace lk
+{
+namespace gfx
+{
+
+// Shadows the binding and fixed function state of the current GL context, so the lk::gfx classes skip the calls
+// setting a value which is already current. All lk::gfx classes route their binds through GLStateCache::GetCurrent(),
+// code issuing the same GL calls directly must call Invalidate() afterwards, or the cache will skip calls it shouldn't.
+class LANIAKEA_RENDER_API GLStateCache
+{
+	public:
+		GLStateCache ();
+
+		GLStateCache ( const GLStateCache & ) = delete;
+
+		GLStateCache & operator = ( const GLStateCache & ) = delete;
+
+		// The cache of the context current on the calling thread, a GL context is current on one thread at a time.
+		// Call Invalidate() after making another context current on the thread.
+		static GLStateCache & GetCurrent ();
+
+		void UseProgram ( unsigned int Program );
+
+		// Switching the vertex array switches the element array buffer binding as well, so it is forgotten
+		void BindVertexArray ( unsigned int VertexArray );
+
+		// Target is a GLenum buffer target (GL_ARRAY_BUFFER, GL_UNIFORM_BUFFER etc), untracked targets are passed through
+		void BindBuffer ( unsigned int Target, unsigned int Buffer );
+
+		// Binds the range to the indexed binding point, the generic binding of the target changes as well.
+		// The uniform buffer binding points below UniformBindingsCount are tracked, others are passed through
+		void BindBufferRange ( unsigned int Target, unsigned int Index, unsigned int Buffer, unsigned int Offset, unsigned int Size );
+
+		// Unit is the zero based texture unit index, not GL_TEXTURE0 + Unit
+		void ActiveTexture ( unsigned int Unit );
+
+		// Activates the unit and binds the texture to it, Target is a GLenum texture target (GL_TEXTURE_2D etc)
+		void BindTexture ( unsigned int Unit, unsigned int Target, unsigned int Texture );
+
+		void SetBlend ( bool IsEnabled );
+
+		// Source and Destination are GLenum blend factors (GL_SRC_ALPHA etc)
+		void SetBlendFunc ( unsigned int Source, unsigned int Destination );
+
+		void SetDepthTest ( bool IsEnabled );
+
+		void SetDepthMask ( bool IsWritable );
+
+		// Function is a GLenum comparison function (GL_LESS etc)
+		void SetDepthFunc ( unsigned int Function );
+
+		void SetCullFace ( bool IsEnabled );
+
+		// Mode is GL_BACK, GL_FRONT or GL_FRONT_AND_BACK
+		void SetCullFaceMode ( unsigned int Mode );
+
+		// Forgets the whole state, the next call of each setter reaches GL
+		void Invalidate ();
+
+		// GL reverts the current bindings of a deleted object to zero, the owners of the objects report the deletions
+		// so a new object reusing the name isn't taken for the bound one
+		void OnProgramDeleted ( unsigned int Program );
+		void OnVertexArrayDeleted ( unsigned int VertexArray );
+		void OnBufferDeleted ( unsigned int Buffer );
+		void OnTextureDeleted ( unsigned int Texture );
+
+		// Resets the per frame counters
+		void BeginFrame ();
+
+		// Number of calls skipped since the last BeginFrame() because they wouldn't change the state
+		uint64_t GetAvoidedCallsCount () const;
+
+		// Number of calls passed to GL since the last BeginFrame()
+		uint64_t GetIssuedCallsCount () const;
+
+		unsigned int GetProgram () const;
+		unsigned int GetVertexArray () const;
+		unsigned int GetBuffer ( unsigned int Target ) const;
+		unsigned int GetTexture ( unsigned int Unit, unsigned int Target ) const;
+
+		// Value of the getters while the state is unknown
+		static constexpr unsigned int Unknown = 0xFFFFFFFF;
+
+		static constexpr unsigned int TextureUnitsCount = 32;
+
+		static constexpr unsigned int UniformBindingsCount = 16;
+
+	private:
+		struct BufferRange
+		{
+			unsigned int Buffer;
+			unsigned int Offset;
+			unsigned int Size;
+		};
+
+		// Compares the cached value with the requested one and updates it, returns true if the call must be issued
+		bool Update ( unsigned int & Cached, unsigned int Value );
+
+		static constexpr unsigned int BufferTargetsCount = 8;
+		static constexpr unsigned int TextureTargetsCount = 4;
+
+		unsigned int m_Program;
+		unsigned int m_VertexArray;
+		unsigned int m_ActiveTexture;
+		std::array <unsigned int, BufferTargetsCount> m_Buffers;
+		std::array <std::array <unsigned int, TextureTargetsCount>, TextureUnitsCount> m_Textures;
+		std::array <BufferRange, UniformBindingsCount> m_UniformRanges;
+		unsigned int m_Blend;
+		unsigned int m_BlendSource;
+		unsigned int m_BlendDestination;
+		unsigned int m_DepthTest;
+		unsigned int m_DepthMask;
+		unsigned int m_DepthFunc;
+		unsigned int m_CullFace;
+		unsigned int m_CullFaceMode;
+		uint64_t m_AvoidedCallsCount;
+		uint64_t m_IssuedCallsCount;
+};
+
+} // namespace gfx
+} // namespace lk
@@ -6,6 +6,8 @@ namespace lk
 namespace gfx
 {
 
+class StreamBuffer;
+
 class LANIAKEA_RENDER_API IndexBuffer
 {
 public:
@@ -16,6 +18,8 @@ public:
 
 	void Set ( unsigned int * Array, unsigned int Length );
 	void Set (  std::vector <unsigned int> & Array );
+	// Replaces the indices [ First, First + Length ) through the staging ring, see Attribute::Update
+	void Update ( const unsigned int * Array, unsigned int First, unsigned int Length, StreamBuffer & Staging );
 
 	unsigned int GetCount () const;
 	unsigned int GetHandle () const;
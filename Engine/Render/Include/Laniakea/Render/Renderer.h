@@ -9,6 +9,7 @@ namespace gfx
 {
 
 class IndexBuffer;
+class VertexArray;
 
 enum class DrawMode
 {
@@ -26,6 +27,13 @@ class LANIAKEA_RENDER_API Renderer
 public:
 	static void Render ( IndexBuffer & IndexBuffer, DrawMode DrawMode );
 	static void Render ( unsigned int VertexCount, DrawMode DrawMode );
+	// Binds the vertex array and draws all its indices, or all vertices if it has no index buffer. The vertex array is left bound.
+	static void Render ( const VertexArray & VertexArray, DrawMode DrawMode );
+	static void RenderInstanced ( unsigned int VertexCount, unsigned int InstanceCount, DrawMode DrawMode );
+	static void RenderIndexedInstanced ( IndexBuffer & IndexBuffer, unsigned int InstanceCount, DrawMode DrawMode );
+	// Draws InstanceCount instances of the whole vertex array, the streams with a non zero divisor advance per instance.
+	// The vertex array is left bound.
+	static void RenderInstanced ( const VertexArray & VertexArray, unsigned int InstanceCount, DrawMode DrawMode );
 
 
 private:
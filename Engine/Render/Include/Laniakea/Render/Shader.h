@@ -1,6 +1,10 @@
 #pragma once
 #include "Laniakea/Render/Core.h"
+#include "Laniakea/Render/ShaderLocationTable.h"
+#include "Laniakea/Render/UniformId.h"
+#include <array>
 #include <string>
+#include <string_view>
 #include <map>
 #include <exception>
 
@@ -19,10 +23,24 @@ struct LANIAKEA_RENDER_API ShaderAttributeData
 	uint32_t Location;
 };
 
+// Uniform block reflected from the linked program. Offsets maps the member names as reported by GL
+// ("Frame.View", "pointLights[0].position" etc, without the instance name) to their byte offsets in the block.
+struct LANIAKEA_RENDER_API ShaderUniformBlockData
+{
+	std::string Name;
+	uint32_t Index;
+	uint32_t Size;
+	uint32_t Binding;
+	std::map<std::string, uint32_t> Offsets;
+};
+
+class ShaderCache;
+
 class LANIAKEA_RENDER_API Shader
 {
 	public:
-		Shader ( const std::string & VertexShader, const std::string & FragmentShader );
+		// With a cache the linked program and its reflection are loaded from the cache if present, and stored otherwise
+		Shader ( const std::string & VertexShader, const std::string & FragmentShader, ShaderCache * Cache = nullptr );
 		~Shader ();
 
 		// Delete copy and assignment constructors;
@@ -31,25 +49,82 @@ class LANIAKEA_RENDER_API Shader
 		uint32_t GetHandle() const;
 		void Bind() const;
 		void Unbind() const;
-		bool GetIsUniformExists ( const std::string & UniformName ) const;
-		uint32_t GetUniformLocation ( const std::string & UniformName ) const;
-		bool GetIsAttributeExists ( const std::string & AttributeName ) const;
-		uint32_t GetAttributeLocation ( const std::string & AttributeName ) const;
+		bool GetIsUniformExists ( std::string_view UniformName ) const;
+		bool GetIsUniformExists ( UniformId Id ) const;
+		uint32_t GetUniformLocation ( std::string_view UniformName ) const;
+		// Location of the uniform or -1, the lookup for the per draw code: no string, no throw. See UniformId
+		// for the colliding names, the lookups by name are exact.
+		int32_t FindUniformLocation ( UniformId Id ) const;
+		bool GetIsAttributeExists ( std::string_view AttributeName ) const;
+		bool GetIsAttributeExists ( UniformId Id ) const;
+		uint32_t GetAttributeLocation ( std::string_view AttributeName ) const;
+		int32_t FindAttributeLocation ( UniformId Id ) const;
+		bool GetIsUniformBlockExists ( const std::string & BlockName ) const;
+		const ShaderUniformBlockData & GetUniformBlock ( const std::string & BlockName ) const;
+		// Sources the block from the uniform buffer range bound to the binding point, e.g. UniformBuffer::FrameBinding
+		void SetUniformBlockBinding ( const std::string & BlockName, uint32_t Binding );
 
 
 
 	private:
-		void Load ( const std::string & VertexShader, const std::string & FragmentShader );
+		friend class ShaderCompiler;
+
+		struct DeferredLoad {};
+
+		// Creates the program only, ShaderCompiler loads it with Submit() and Finish()
+		explicit Shader ( DeferredLoad );
+
+		void Load ( const std::string & VertexShader, const std::string & FragmentShader, ShaderCache * Cache );
+		// Issues the compilation and the linking without waiting for them, returns true if the program was loaded from the cache
+		bool Submit ( const std::string & VertexShader, const std::string & FragmentShader, ShaderCache * Cache );
+		// True once the driver finished the linking, requires KHR_parallel_shader_compile
+		bool GetIsLinkCompleted () const;
+		// Checks the compile and link statuses, throws RenderException with the log on failure, reflects the program
+		void Finish ();
 		void ReadShaders ( const std::string & VertexShader, const std::string & FragmentShader, std::string & OutVS, std::string & OutFS);
-		uint32_t CompileVertexShader ( const std::string & VertexSource );
-		uint32_t CompileFragmentShader ( const std::string & ShaderSource );
-		void LinkShaders( uint32_t VSHandle, uint32_t FSHandle );
+		uint32_t CompileShader ( uint32_t Type, const std::string & Source );
+		void CheckShader ( uint32_t ShaderHandle, const char * Stage );
+		void LinkShaders();
+		void CheckLink();
+		void ReleaseShaders();
 		void PopulateAttributes();
 		void PopulateUniforms();
+		void PopulateUniformBlocks();
 
 		uint32_t m_Handle;
-		std::map<std::string, uint32_t> m_Attributes;
-		std::map<std::string, uint32_t> m_Uniforms;
+		uint32_t m_VSHandle;
+		uint32_t m_FSHandle;
+		uint64_t m_CacheKey;
+		ShaderCache * m_Cache;
+		ShaderLocationTable m_Attributes;
+		ShaderLocationTable m_Uniforms;
+		std::map<std::string, ShaderUniformBlockData> m_UniformBlocks;
+};
+
+// Locations of a fixed set of uniforms resolved once, e.g. by a material when its shader is assigned, so setting
+// the uniforms of the material does no lookups at all. The uniforms missing in the shader resolve to -1 and setting
+// them is a no-op. Resolve it again when the shader changes.
+//
+//     static constexpr std::array <UniformId, 2> MaterialUniforms { "material.diffuseColor"_uid, "material.shininess"_uid };
+//     UniformLocationTable <2> Locations ( shader, MaterialUniforms );
+//     Uniform::Set ( Locations[ 1 ], Shininess );
+template <size_t N>
+class UniformLocationTable
+{
+	public:
+		UniformLocationTable ( const Shader & Program, const std::array<UniformId, N> & Ids )
+		{
+			for ( size_t i = 0; i < N; i ++ )
+				m_Locations[ i ] = Program . FindUniformLocation ( Ids[ i ] );
+		}
+
+		int32_t operator [] ( size_t Index ) const
+		{
+			return m_Locations[ Index ];
+		}
+
+	private:
+		std::array<int32_t, N> m_Locations;
 };
 
 } // lk
@@ -0,0 +1,70 @@
+#pragma once
+#include "Laniakea/Render/Core.h"
+#include "Laniakea/Render/Shader.h"
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace lk
+{
+namespace gfx
+{
+
+// On-disk cache of the linked shader programs. A program linked from the sources is stored as its glGetProgramBinary
+// blob together with the reflected attribute, uniform and uniform block tables, the next start loads it with
+// glProgramBinary and skips the compilation, the linking and the reflection queries. The entries are keyed by a hash
+// of both sources and of the GL vendor, renderer and version strings, so a driver update misses instead of feeding
+// the driver a binary it can't use. A rejected or corrupt entry is a miss, the program is compiled and stored again.
+//
+//     ShaderCache Cache ( "Cache/Shaders" );
+//     Shader Lit ( "Lit.vs", "Lit.fs", & Cache );
+class LANIAKEA_RENDER_API ShaderCache
+{
+	public:
+		// Creates the directory if it doesn't exist, reads the driver strings of the current context
+		explicit ShaderCache ( const std::string & Directory );
+
+		ShaderCache ( const ShaderCache & ) = delete;
+
+		ShaderCache & operator = ( const ShaderCache & ) = delete;
+
+		// Key of the program linked from the sources by the current driver
+		uint64_t GetKey ( const std::string & VertexSource, const std::string & FragmentSource ) const;
+
+		// Loads the entry into the program and fills the tables, returns false and leaves the tables empty
+		// if there is no entry, it is corrupt or the driver rejects the binary
+		bool Load ( uint64_t Key, uint32_t Program, ShaderLocationTable & Attributes,
+					ShaderLocationTable & Uniforms, std::map<std::string, ShaderUniformBlockData> & UniformBlocks );
+
+		// Writes the entry of the linked program, the program should be linked with GL_PROGRAM_BINARY_RETRIEVABLE_HINT set
+		void Store ( uint64_t Key, uint32_t Program, const ShaderLocationTable & Attributes,
+					 const ShaderLocationTable & Uniforms, const std::map<std::string, ShaderUniformBlockData> & UniformBlocks );
+
+		// False if the driver exposes no program binary formats, the cache misses every time then
+		bool GetIsSupported () const;
+
+		const std::string & GetDirectory () const;
+
+		unsigned int GetHitsCount () const;
+
+		unsigned int GetMissesCount () const;
+
+		static constexpr uint32_t Magic = 0x43534B4C; // "LKSC" in the little endian order
+		static constexpr uint32_t Version = 3;
+
+	private:
+		bool LoadEntry ( uint64_t Key, uint32_t Program, ShaderLocationTable & Attributes,
+						 ShaderLocationTable & Uniforms, std::map<std::string, ShaderUniformBlockData> & UniformBlocks ) const;
+
+		std::string GetPath ( uint64_t Key ) const;
+
+		std::string m_Directory;
+		uint64_t m_DriverHash;
+		std::vector<int32_t> m_BinaryFormats;
+		unsigned int m_HitsCount;
+		unsigned int m_MissesCount;
+};
+
+} // namespace gfx
+} // namespace lk
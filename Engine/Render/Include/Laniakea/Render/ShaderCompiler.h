@@ -0,0 +1,100 @@
+#pragma once
+#include "Laniakea/Render/Core.h"
+#include "Laniakea/Render/Shader.h"
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace lk
+{
+namespace gfx
+{
+
+class ShaderCache;
+
+// A shader being compiled by ShaderCompiler. Until it is ready, or if it fails, Get() returns the fallback shader
+// of the compiler, so the draws using the handle keep working while the compilation runs.
+class LANIAKEA_RENDER_API ShaderHandle
+{
+	public:
+		ShaderHandle () = default;
+
+		bool GetIsReady () const;
+
+		bool GetIsFailed () const;
+
+		// The compile or link log if the shader failed
+		const std::string & GetError () const;
+
+		// The compiled shader once ready, the fallback shader until then
+		const Shader & Get () const;
+
+	private:
+		friend class ShaderCompiler;
+
+		enum class Status
+		{
+			Pending,
+			Ready,
+			Failed
+		};
+
+		struct State
+		{
+			std::unique_ptr<Shader> Program;
+			const Shader * Fallback;
+			Status CurrentStatus;
+			std::string Error;
+		};
+
+		explicit ShaderHandle ( std::shared_ptr<State> SharedState );
+
+		std::shared_ptr<State> m_State;
+};
+
+// Compiles shaders without blocking the render thread. Submit() issues the compilation and the linking and returns
+// at once, the compile and link statuses, which block until the driver is done, are queried later by Poll(). With
+// KHR_parallel_shader_compile the driver compiles on its own threads and Poll() finishes only the programs reporting
+// GL_COMPLETION_STATUS_KHR, so it never blocks. Without it Poll() finishes the oldest program per call, spreading
+// the stalls over the frames. A loading screen submits all its shaders first and loads the other assets meanwhile:
+//
+//     ShaderCompiler Compiler ( Unlit, & Cache );
+//     auto Lit = Compiler . Submit ( "Lit.vs", "Lit.fs" );
+//     while ( Compiler . Poll () > 0 || ! AssetsLoaded () ) { LoadNextAsset (); DrawLoadingScreen (); }
+class LANIAKEA_RENDER_API ShaderCompiler
+{
+	public:
+		// The fallback is drawn instead of the pending and failed shaders, it must outlive the handles
+		explicit ShaderCompiler ( const Shader & Fallback, ShaderCache * Cache = nullptr );
+
+		ShaderCompiler ( const ShaderCompiler & ) = delete;
+
+		ShaderCompiler & operator = ( const ShaderCompiler & ) = delete;
+
+		// Sources are paths or the sources themselves, as for Shader. A shader found in the cache is ready at once.
+		// Never throws, an error raised by the submission fails the handle with the error recorded.
+		ShaderHandle Submit ( const std::string & VertexShader, const std::string & FragmentShader );
+
+		// Finishes the completed shaders, returns the number of the pending ones
+		size_t Poll ();
+
+		// Blocks until all submitted shaders are finished
+		void Finish ();
+
+		size_t GetPendingCount () const;
+
+		// True if the driver exposes KHR_parallel_shader_compile
+		bool GetIsParallel () const;
+
+	private:
+		// Checks the statuses and reflects the program, a failure is recorded in the handle instead of thrown
+		static void Complete ( ShaderHandle::State & PendingState );
+
+		const Shader & m_Fallback;
+		ShaderCache * m_Cache;
+		bool m_IsParallel;
+		std::vector<std::shared_ptr<ShaderHandle::State>> m_Pending;
+};
+
+} // namespace gfx
+} // namespace lk
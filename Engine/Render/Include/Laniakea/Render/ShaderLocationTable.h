@@ -0,0 +1,65 @@
+#pragma once
+#include "Laniakea/Render/Core.h"
+#include "Laniakea/Render/UniformId.h"
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace lk
+{
+namespace gfx
+{
+
+// Name to location table of a shader, a flat array sorted by the UniformId of the names. A lookup is a binary search
+// over 8 byte entries comparing integers. The names are kept in a parallel array and the names sharing an id are
+// kept next to each other ordered by the name, so a lookup by name compares the names on the id ties and never takes
+// a colliding name for another one. A lookup by id can't tell them apart.
+class LANIAKEA_RENDER_API ShaderLocationTable
+{
+	public:
+		struct Entry
+		{
+			uint32_t Id;
+			uint32_t Location;
+		};
+
+		// Adds the name, if the name is added more than once the first location is kept
+		void Add ( std::string_view Name, uint32_t Location );
+
+		// Sorts the added names and drops the duplicates. The names hashing to the same id are all kept.
+		void Build ();
+
+		// Replaces the entries and their names, e.g. with the ones read from ShaderCache. Returns false and keeps
+		// the table if the entries aren't sorted by their ids and names, repeat a name or don't match the names.
+		bool Assign ( std::vector<Entry> Entries, std::vector<std::string> Names );
+
+		// Location of the name, -1 if the shader has no such name. GL ignores the glUniform* calls with location -1.
+		// A name missing in the shader whose id collides with a present name gets the location of that name.
+		// The id shared by several names of the shader returns -1, only the lookup by name resolves them.
+		int32_t Find ( UniformId Id ) const;
+
+		// Location of the name, -1 if the shader has no such name, exact even for colliding ids
+		int32_t Find ( std::string_view Name ) const;
+
+		bool GetIsExists ( UniformId Id ) const;
+
+		bool GetIsExists ( std::string_view Name ) const;
+
+		const std::vector<Entry> & GetEntries () const;
+
+		// Names parallel to GetEntries ()
+		const std::vector<std::string> & GetNames () const;
+
+		size_t GetSize () const;
+
+	private:
+		// Index of the first entry with the id, m_Entries . size () if none
+		size_t FindIndex ( uint32_t Id ) const;
+
+		std::vector<Entry> m_Entries;
+		std::vector<std::string> m_Names; // Parallel to m_Entries
+};
+
+} // namespace gfx
+} // namespace lk
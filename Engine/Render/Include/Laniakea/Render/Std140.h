@@ -0,0 +1,91 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include "glm/glm.hpp"
+
+namespace lk
+{
+namespace gfx
+{
+namespace std140
+{
+
+// Compile time std140 layout of the uniform block members, so the C++ struct mirroring a block can be checked
+// against it with static_assert instead of debugging garbage in the shader:
+//
+//     struct FrameBlock { glm::mat4 View; glm::vec3 CameraPosition; float Time; glm::vec4 Lights[ 4 ]; };
+//     using FrameLayout = std140::Layout <glm::mat4, glm::vec3, float, glm::vec4[ 4 ]>;
+//     LK_STD140_CHECK ( FrameBlock, Time, FrameLayout, 2 );
+//     static_assert ( sizeof ( FrameBlock ) == FrameLayout::Size );
+//
+// Scalars and vectors align to their size (vec3 to 16 bytes), arrays and matrices align their elements and columns
+// to 16 bytes. A glm::vec3 member followed by a vec3 or a vec4 needs a float of padding in the C++ struct.
+
+constexpr size_t RoundUp ( size_t Value, size_t Alignment )
+{
+	return ( Value + Alignment - 1 ) / Alignment * Alignment;
+}
+
+template <typename T>
+struct Traits;
+
+template <size_t TAlignment, size_t TSize>
+struct BasicTraits
+{
+	static constexpr size_t Alignment = TAlignment;
+	static constexpr size_t Size = TSize;
+};
+
+template <> struct Traits <float> : BasicTraits <4, 4> {};
+template <> struct Traits <int32_t> : BasicTraits <4, 4> {};
+template <> struct Traits <uint32_t> : BasicTraits <4, 4> {};
+template <> struct Traits <glm::vec2> : BasicTraits <8, 8> {};
+template <> struct Traits <glm::vec3> : BasicTraits <16, 12> {};
+template <> struct Traits <glm::vec4> : BasicTraits <16, 16> {};
+template <> struct Traits <glm::ivec2> : BasicTraits <8, 8> {};
+template <> struct Traits <glm::ivec4> : BasicTraits <16, 16> {};
+template <> struct Traits <glm::mat4> : BasicTraits <16, 64> {};
+
+// Array elements are padded to 16 bytes, e.g. a float[ 4 ] takes 64 bytes
+template <typename T, size_t N>
+struct Traits <T[ N ]>
+{
+	static constexpr size_t Alignment = RoundUp ( Traits <T>::Alignment, 16 );
+	static constexpr size_t Stride = RoundUp ( Traits <T>::Size, Alignment );
+	static constexpr size_t Size = Stride * N;
+};
+
+// Nested structs align to 16 bytes and their size is padded to 16 bytes, Ts are the types of their members
+template <typename ... Ts>
+struct Layout
+{
+	static constexpr std::array <size_t, sizeof ... ( Ts )> Offsets = [] ()
+	{
+		std::array <size_t, sizeof ... ( Ts )> Result {};
+		size_t Offset = 0;
+		size_t Index = 0;
+		( ( Offset = RoundUp ( Offset, Traits <Ts>::Alignment ), Result[ Index ++ ] = Offset, Offset += Traits <Ts>::Size ), ... );
+		return Result;
+	} ();
+
+	static constexpr size_t Alignment = 16;
+
+	static constexpr size_t Size = [] ()
+	{
+		size_t Offset = 0;
+		( ( Offset = RoundUp ( Offset, Traits <Ts>::Alignment ) + Traits <Ts>::Size ), ... );
+		return RoundUp ( Offset, 16 );
+	} ();
+};
+
+template <typename ... Ts>
+struct Traits <Layout <Ts ...>> : BasicTraits <Layout <Ts ...>::Alignment, Layout <Ts ...>::Size> {};
+
+} // namespace std140
+} // namespace gfx
+} // namespace lk
+
+// Fails the compilation if Member of Struct isn't at the std140 offset of the Index-th member of the layout
+#define LK_STD140_CHECK( Struct, Member, Layout, Index ) \
+	static_assert ( offsetof ( Struct, Member ) == Layout::Offsets[ Index ], #Struct "::" #Member " doesn't match the std140 layout" )
@@ -0,0 +1,79 @@
+#pragma once
+#include <deque>
+#include "Laniakea/Render/Core.h"
+
+namespace lk
+{
+namespace gfx
+{
+
+// Ring buffer for the data rewritten every frame: dynamic geometry, instance data, uniform blocks or the staging of
+// the buffer updates. The storage is allocated once and written sequentially, so an upload never reallocates the
+// driver storage. With GL 4.4 the buffer is persistently mapped (glBufferStorage + GL_MAP_PERSISTENT_BIT) and a write
+// is a memcpy, otherwise each write maps its range with glMapBufferRange and the storage is orphaned on the wrap.
+// The ranges written between two Fence() calls are guarded by a fence sync, a write reaching a range the GPU may
+// still read waits for the fence instead of overwriting it.
+class LANIAKEA_RENDER_API StreamBuffer
+{
+	public:
+		// A written range, Offset is the offset in the buffer to pass to glBindBufferRange, glVertexAttribPointer etc
+		struct Range
+		{
+			unsigned int Offset;
+			unsigned int Size;
+		};
+
+		// Capacity in bytes, it should hold the data of a few frames so the writes don't wait for the GPU
+		explicit StreamBuffer ( unsigned int Capacity = 4 * 1024 * 1024 );
+
+		~StreamBuffer ();
+
+		StreamBuffer ( const StreamBuffer & ) = delete;
+
+		StreamBuffer & operator = ( const StreamBuffer & ) = delete;
+
+		// Copies Size bytes to the next free range starting at a multiple of Alignment. Throws RenderException
+		// if Size exceeds the capacity.
+		Range Write ( const void * Data, unsigned int Size, unsigned int Alignment = 16 );
+
+		// Writes the data and copies it to [ Offset, Offset + Size ) of another buffer on the GPU. The copy is ordered
+		// after the draws already issued, so updating a buffer in use doesn't wait for them.
+		void CopyTo ( unsigned int Buffer, unsigned int Offset, const void * Data, unsigned int Size );
+
+		// Guards the ranges written since the last call, call it once the draws reading them are issued, e.g. at the end of the frame
+		void Fence ();
+
+		unsigned int GetHandle () const;
+
+		unsigned int GetCapacity () const;
+
+		// True if the buffer is persistently mapped, false on the glMapBufferRange fallback
+		bool GetIsPersistent () const;
+
+		// Number of writes which had to wait for the GPU, a growing count means the capacity is too small
+		unsigned int GetWaitsCount () const;
+
+	private:
+		struct FencedRange
+		{
+			unsigned int Begin;
+			unsigned int End;
+			void * Sync;
+		};
+
+		// Waits for the fenced ranges overlapping [ Begin, End ) and for all ranges fenced before them
+		void WaitForRange ( unsigned int Begin, unsigned int End );
+
+		void ReleaseFences ();
+
+		unsigned int m_Handle;
+		unsigned int m_Capacity;
+		unsigned int m_Head;
+		unsigned int m_PendingBegin;
+		unsigned int m_WaitsCount;
+		unsigned char * m_Mapped;
+		std::deque <FencedRange> m_Fences;
+};
+
+} // namespace gfx
+} // namespace lk
@@ -1,3 +1,4 @@
+#pragma once
 #include "Laniakea/Render/Core.h"
 #include <string>
 
@@ -6,14 +7,25 @@ namespace lk
 namespace gfx
 {
 
+struct CompressedImage;
+
 class LANIAKEA_RENDER_API Texture
 {
 public:
+	// Loads the images stb_image decodes and the DDS and KTX2 files with BC1, BC3 or BC7 blocks. The block compressed
+	// levels are uploaded as they are, the mipmaps are generated only for the uncompressed images.
 	Texture ( const std::string & Path );
 	~Texture ();
 
 	unsigned int GetHandle () const;
 
+	unsigned int GetWidth () const;
+
+	unsigned int GetHeight () const;
+
+	// False while a texture created by TextureLoader shows its placeholder
+	bool GetIsLoaded () const;
+
 	Texture ( const Texture & ) = delete;
 	Texture & operator = ( const Texture & ) = delete;
 
@@ -21,12 +33,26 @@ public:
 	void Unset ( unsigned int TextureIndex );
 
 private:
+	friend class TextureLoader;
+
+	struct Placeholder {};
+
+	// A 1x1 texture of the placeholder color, TextureLoader uploads the image into it once decoded
+	explicit Texture ( Placeholder );
+
 	void Load ( const std::string & Path );
 
+	// Replaces the image and generates the mipmaps. Pixels is an offset into the bound GL_PIXEL_UNPACK_BUFFER if any
+	void Upload ( unsigned int Width, unsigned int Height, unsigned int Channels, const void * Pixels );
+
+	// Uploads the compressed levels, throws RenderException if the driver doesn't support the format or rejects a level
+	void Upload ( const CompressedImage & Image, const std::string & Path );
+
 	unsigned int m_Width;
 	unsigned int m_Height;
 	unsigned int m_Channels;
 	unsigned int m_Handle;
+	bool m_IsLoaded;
 };
 
 } // lk
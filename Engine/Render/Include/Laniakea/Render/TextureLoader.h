@@ -0,0 +1,111 @@
+#pragma once
+#include "Laniakea/Render/Core.h"
+#include "Laniakea/Render/Texture.h"
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace lk
+{
+namespace gfx
+{
+
+// Loads textures without blocking the GL thread. Load() returns a texture at once, showing a 1x1 grey placeholder,
+// while worker threads decode the file. Update(), called once per frame on the GL thread, uploads the decoded images
+// through a pool of pixel unpack buffers, so glTexImage2D only queues a copy on the GPU, and stops once the images
+// uploaded in the frame exceed the byte budget, so a burst of finished decodes doesn't stall a single frame.
+//
+//     TextureLoader Loader;
+//     auto Diffuse = Loader . Load ( "Barrel_Diffuse.png" );
+//     while ( running ) { Loader . Update (); Diffuse -> Set ( Slot, 0 ); draw (); }
+class LANIAKEA_RENDER_API TextureLoader
+{
+	public:
+		// UploadBudget is in bytes per Update(), at least one image is uploaded per call however large.
+		// ThreadsCount of zero picks half of the hardware threads.
+		explicit TextureLoader ( size_t UploadBudget = 16 * 1024 * 1024, unsigned int ThreadsCount = 0, unsigned int PixelBuffersCount = 4 );
+
+		// Discards the queued files and joins the workers
+		~TextureLoader ();
+
+		TextureLoader ( const TextureLoader & ) = delete;
+
+		TextureLoader & operator = ( const TextureLoader & ) = delete;
+
+		// The texture is usable at once. If the file can't be decoded it keeps the placeholder and the path is
+		// reported by GetFailedPaths(). A texture released before its upload is skipped.
+		std::shared_ptr<Texture> Load ( const std::string & Path );
+
+		// Uploads the decoded images within the budget, returns the number of the textures still pending
+		size_t Update ();
+
+		// Blocks until all loaded textures are uploaded
+		void Finish ();
+
+		// Textures queued, being decoded or waiting for the upload
+		size_t GetPendingCount () const;
+
+		// Bytes uploaded by the last Update()
+		size_t GetUploadedBytesCount () const;
+
+		const std::vector<std::string> & GetFailedPaths () const;
+
+	private:
+		struct Request
+		{
+			std::weak_ptr<Texture> Target;
+			std::string Path;
+		};
+
+		struct DecodedImage
+		{
+			std::weak_ptr<Texture> Target;
+			std::string Path;
+			unsigned char * Pixels; // Null if the decoding failed
+			unsigned int Width;
+			unsigned int Height;
+			unsigned int Channels;
+		};
+
+		struct PixelBuffer
+		{
+			unsigned int Handle;
+			size_t Capacity;
+			void * Fence; // Guards the copy of the last upload, null when the buffer is free
+		};
+
+		void RunWorker ();
+
+		// Uploads the image through a free pixel buffer, returns false if all buffers are in use. With Wait the
+		// oldest buffer is waited for instead.
+		bool Upload ( DecodedImage & Image, bool Wait );
+
+		PixelBuffer * AcquirePixelBuffer ( bool Wait );
+
+		// Uploads at most Budget bytes of the decoded images, but at least one image
+		void UploadDecoded ( size_t Budget, bool Wait );
+
+		size_t m_UploadBudget;
+		size_t m_UploadedBytesCount;
+		size_t m_PendingCount;
+		size_t m_NextPixelBuffer;
+		std::vector<PixelBuffer> m_PixelBuffers;
+		std::vector<std::string> m_FailedPaths;
+
+		// Shared with the workers
+		mutable std::mutex m_Mutex;
+		std::condition_variable m_RequestAdded;
+		std::condition_variable m_ImageDecoded;
+		std::deque<Request> m_Requests;
+		std::deque<DecodedImage> m_Decoded;
+		bool m_IsStopping;
+		std::vector<std::thread> m_Workers;
+};
+
+} // namespace gfx
+} // namespace lk
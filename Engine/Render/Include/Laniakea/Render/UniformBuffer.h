@@ -0,0 +1,59 @@
+#pragma once
+#include "Laniakea/Render/Core.h"
+#include "Laniakea/Render/StreamBuffer.h"
+
+namespace lk
+{
+namespace gfx
+{
+
+// Allocates the uniform blocks of a frame from a single large uniform buffer. Each block is written once to the next
+// range of the ring and bound with glBindBufferRange, so the per frame constants cost one upload and one bind per frame
+// instead of a glUniform* call per value and draw, and the per material and per object blocks switch by rebinding
+// a range of the same buffer. The block structs should follow the std140 layout, see Std140.h.
+//
+//     auto Frame = Uniforms . Write ( FrameConstants );
+//     Uniforms . Bind ( UniformBuffer::FrameBinding, Frame );
+//     for ( each object ) { Uniforms . Bind ( UniformBuffer::ObjectBinding, Uniforms . Write ( ObjectConstants ) ); draw (); }
+//     Uniforms . EndFrame ();
+class LANIAKEA_RENDER_API UniformBuffer
+{
+	public:
+		// Binding points of the blocks by their update frequency, assign them with Shader::SetUniformBlockBinding
+		static constexpr unsigned int FrameBinding = 0;
+		static constexpr unsigned int MaterialBinding = 1;
+		static constexpr unsigned int ObjectBinding = 2;
+
+		// Capacity in bytes, it should hold the blocks of a few frames
+		explicit UniformBuffer ( unsigned int Capacity = 4 * 1024 * 1024 );
+
+		UniformBuffer ( const UniformBuffer & ) = delete;
+
+		UniformBuffer & operator = ( const UniformBuffer & ) = delete;
+
+		// Copies the block to the next range aligned to GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT
+		StreamBuffer::Range Write ( const void * Data, unsigned int Size );
+
+		template <typename T>
+		StreamBuffer::Range Write ( const T & Block )
+		{
+			return Write ( & Block, sizeof ( T ) );
+		}
+
+		// Binds the written range to the binding point, binding the range already bound there is skipped
+		void Bind ( unsigned int Binding, const StreamBuffer::Range & Range );
+
+		// Call after the draws of the frame are issued, the ranges written in the frame aren't overwritten until the GPU is done with them
+		void EndFrame ();
+
+		unsigned int GetHandle () const;
+
+		unsigned int GetOffsetAlignment () const;
+
+	private:
+		StreamBuffer m_Buffer;
+		unsigned int m_OffsetAlignment;
+};
+
+} // namespace gfx
+} // namespace lk
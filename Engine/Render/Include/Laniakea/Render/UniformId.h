@@ -0,0 +1,57 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+namespace lk
+{
+namespace gfx
+{
+
+// 32 bit FNV-1a hash of a uniform or attribute name as reported by the shader reflection ("PVMMatrix",
+// "pointLights[3].position" etc). The ids of literal names are computed at compile time:
+//
+//     using namespace lk::gfx::literals;
+//     const auto Location = shader . FindUniformLocation ( "PVMMatrix"_uid );
+//
+// An id carries no name, so the lookup by id returns -1 for the id shared by several names of one shader, and the
+// id of a name missing in the shader may collide with the id of a present name and return the location of that
+// other name. The lookups by name compare the names on the id ties and are exact.
+struct UniformId
+{
+	uint32_t Hash;
+
+	friend constexpr bool operator == ( UniformId Left, UniformId Right )
+	{
+		return Left . Hash == Right . Hash;
+	}
+
+	friend constexpr bool operator < ( UniformId Left, UniformId Right )
+	{
+		return Left . Hash < Right . Hash;
+	}
+};
+
+constexpr UniformId MakeUniformId ( std::string_view Name )
+{
+	uint32_t Hash = 2166136261u;
+	for ( const char Character : Name )
+	{
+		Hash ^= static_cast <unsigned char> ( Character );
+		Hash *= 16777619u;
+	}
+	return UniformId { Hash };
+}
+
+inline namespace literals
+{
+
+constexpr UniformId operator "" _uid ( const char * Name, size_t Length )
+{
+	return MakeUniformId ( std::string_view ( Name, Length ) );
+}
+
+} // namespace literals
+
+} // namespace gfx
+} // namespace lk
@@ -0,0 +1,52 @@
+#pragma once
+#include <functional>
+#include <vector>
+#include "Laniakea/Render/Core.h"
+#include "Laniakea/Render/VertexLayout.h"
+
+namespace lk
+{
+namespace gfx
+{
+
+class Attribute;
+class IndexBuffer;
+
+// Owns a vertex array object with the attribute setup of the layout recorded once at creation,
+// so binding the mesh for a draw is a single glBindVertexArray.
+class LANIAKEA_RENDER_API VertexArray
+{
+	public:
+		// Buffers[ i ] sources the stream i of the layout. The buffers and the index buffer must outlive the vertex array,
+		// later Set calls on them are picked up since the vertex array refers to the buffer objects, not their contents.
+		VertexArray ( const VertexLayout & Layout, const std::vector <std::reference_wrapper <const Attribute>> & Buffers,
+					  const IndexBuffer * Indices = nullptr );
+
+		~VertexArray ();
+
+		VertexArray ( const VertexArray & ) = delete;
+
+		VertexArray & operator = ( const VertexArray & ) = delete;
+
+		void Bind () const;
+
+		void Unbind () const;
+
+		// Number of vertices of the first per-vertex stream, or of the indices if the vertex array has an index buffer
+		unsigned int GetCount () const;
+
+		bool GetIsIndexed () const;
+
+		const VertexLayout & GetLayout () const;
+
+		unsigned int GetHandle () const;
+
+	private:
+		VertexLayout m_Layout;
+		const Attribute * m_VertexCountSource;
+		const IndexBuffer * m_Indices;
+		unsigned int m_Handle;
+};
+
+} // namespace gfx
+} // namespace lk
@@ -0,0 +1,56 @@
+#pragma once
+#include <vector>
+#include "Laniakea/Render/Core.h"
+
+namespace lk
+{
+namespace gfx
+{
+
+struct LANIAKEA_RENDER_API VertexElement
+{
+	unsigned int Slot;
+	unsigned int Size; // Number of components, 1 to 4
+	unsigned int Type; // GLenum type (GL_FLOAT, GL_INT etc)
+	unsigned int Offset; // Byte offset within the vertex of the stream
+	bool Normalized = false;
+};
+
+struct LANIAKEA_RENDER_API VertexStream
+{
+	unsigned int Stride; // Byte size of one vertex of the stream
+	unsigned int Divisor; // 0 advances per vertex, N advances once per N instances
+	std::vector <VertexElement> Elements;
+};
+
+// Describes the vertex attributes sourced from one or more buffers.
+// Each stream is one buffer, the elements of a stream are interleaved within it:
+//     VertexLayout Layout;
+//     Layout . AddStream () . Add ( 0, 3, GL_FLOAT ) . Add ( 1, 3, GL_FLOAT );  // interleaved position and normal
+//     Layout . AddStream () . Add ( 2, 2, GL_FLOAT );                          // texture coordinates in their own buffer
+class LANIAKEA_RENDER_API VertexLayout
+{
+	public:
+		// Starts a new stream, the next elements are appended to it.
+		// A zero stride is computed from the elements of the stream as if they were tightly packed.
+		VertexLayout & AddStream ( unsigned int Stride = 0, unsigned int Divisor = 0 );
+
+		// Appends an element after the previous element of the last stream.
+		VertexLayout & Add ( unsigned int Slot, unsigned int Size, unsigned int Type, bool Normalized = false );
+
+		// Appends an element at the explicit byte offset of the last stream, e.g. to skip the padding of the vertex struct.
+		VertexLayout & Add ( const VertexElement & Element );
+
+		const std::vector <VertexStream> & GetStreams () const;
+
+		unsigned int GetStride ( unsigned int Stream ) const;
+
+		static unsigned int GetTypeSize ( unsigned int Type );
+
+	private:
+		std::vector <VertexStream> m_Streams;
+		std::vector <unsigned int> m_PackedStrides; // Byte size of the elements of each stream, used for the zero strides
+};
+
+} // namespace gfx
+} // namespace lk
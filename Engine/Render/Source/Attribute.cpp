@@ -1,6 +1,9 @@
 #include "glad/glad.h"
 #include "Laniakea/Render/Attribute.h"
 #include "Laniakea/Render/RenderException.h"
+#include "Laniakea/Render/GLStateCache.h"
+#include "Laniakea/Render/StreamBuffer.h"
+#include <cstdint>
 
 
 
@@ -14,10 +17,12 @@ Attribute::Attribute ()
 {
 	glGenBuffers ( 1, & m_Handle );
 	m_Count = 0;
+	m_Size = 0;
 }
 
 Attribute::~Attribute ()
 {
+	GLStateCache::GetCurrent () . OnBufferDeleted ( m_Handle );
 	glDeleteBuffers ( 1, & m_Handle );
 }
 
@@ -34,19 +39,17 @@ unsigned int Attribute::GetCount () const
 
 void Attribute::BindTo ( const AttributeDescriptor & Descriptor )
 {
-	glBindBuffer ( GL_ARRAY_BUFFER, m_Handle );
+	GLStateCache::GetCurrent () . BindBuffer ( GL_ARRAY_BUFFER, m_Handle );
 	glEnableVertexAttribArray ( Descriptor . Slot );
 	glVertexAttribPointer ( Descriptor . Slot, Descriptor . Size, Descriptor . Type, GL_FALSE, Descriptor . Stride,
 							( void * ) ( uintptr_t ) Descriptor . Offset );
-	glBindBuffer ( GL_ARRAY_BUFFER, 0 );
+	glVertexAttribDivisor ( Descriptor . Slot, Descriptor . Divisor );
 	LK_RENDER_CHECK_ERROR()
 }
 
 void Attribute::UnbindFrom ( unsigned int Slot )
 {
-	glBindBuffer ( GL_ARRAY_BUFFER, m_Handle );
 	glDisableVertexAttribArray ( Slot );
-	glBindBuffer ( GL_ARRAY_BUFFER, m_Handle );
 	LK_RENDER_CHECK_ERROR()
 }
 
@@ -59,12 +62,25 @@ namespace gfx {
 namespace detail {
 
 	void _SetAttributeImpl(unsigned int handle, const void* data, unsigned int size, unsigned int length) {
-		glBindBuffer(GL_ARRAY_BUFFER, handle);
+		GLStateCache::GetCurrent () . BindBuffer ( GL_ARRAY_BUFFER, handle );
 		glBufferData(GL_ARRAY_BUFFER, size * length, data, GL_STATIC_DRAW);
-		glBindBuffer(GL_ARRAY_BUFFER, 0);
 		LK_RENDER_CHECK_ERROR()
 	}
 
+	void _StreamAttributeImpl(unsigned int handle, const void* data, unsigned int size, unsigned int length) {
+		GLStateCache::GetCurrent () . BindBuffer ( GL_ARRAY_BUFFER, handle );
+		glBufferData(GL_ARRAY_BUFFER, size * length, nullptr, GL_STREAM_DRAW);
+		glBufferSubData(GL_ARRAY_BUFFER, 0, size * length, data);
+		LK_RENDER_CHECK_ERROR()
+	}
+
+	void _UpdateAttributeImpl(unsigned int handle, unsigned int capacity, const void* data, unsigned int size,
+							  unsigned int first, unsigned int length, StreamBuffer& staging) {
+		if ( ( ( uint64_t ) first + length ) * size > capacity )
+			throw RenderException ( "Updated range exceeds the buffer contents" );
+		staging.CopyTo ( handle, first * size, data, size * length );
+	}
+
 } // namespace detail
 } // namespace gfx
 } // namespace lk
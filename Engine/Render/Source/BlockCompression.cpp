@@ -0,0 +1,268 @@
+#include "Laniakea/Render/BlockCompression.h"
+#include "Laniakea/Render/RenderException.h"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+namespace lk
+{
+namespace gfx
+{
+
+namespace
+{
+
+constexpr int TexelsCount = 16;
+
+struct Color
+{
+	float R, G, B;
+};
+
+uint16_t PackRGB565 ( const Color & Value )
+{
+	const auto Quantize = [] ( float Channel, int Max )
+	{
+		return ( uint16_t ) std::lround ( std::clamp ( Channel, 0.f, 255.f ) * ( float ) Max / 255.f );
+	};
+	return ( uint16_t ) ( ( Quantize ( Value . R, 31 ) << 11 ) | ( Quantize ( Value . G, 63 ) << 5 ) | Quantize ( Value . B, 31 ) );
+}
+
+// Expands the bits as the decoder does, so the palette matches the decoded one
+Color UnpackRGB565 ( uint16_t Packed )
+{
+	const int R = ( Packed >> 11 ) & 31;
+	const int G = ( Packed >> 5 ) & 63;
+	const int B = Packed & 31;
+	return { ( float ) ( ( R << 3 ) | ( R >> 2 ) ), ( float ) ( ( G << 2 ) | ( G >> 4 ) ), ( float ) ( ( B << 3 ) | ( B >> 2 ) ) };
+}
+
+// Writes the 8 byte color block, always in the 4 color mode so BC3 can use it as well
+void CompressColorBlock ( const unsigned char * Texels, unsigned char * Output )
+{
+	Color Mean { 0.f, 0.f, 0.f };
+	for ( int i = 0; i < TexelsCount; i ++ )
+	{
+		Mean . R += Texels[ i * 4 ];
+		Mean . G += Texels[ i * 4 + 1 ];
+		Mean . B += Texels[ i * 4 + 2 ];
+	}
+	Mean = { Mean . R / TexelsCount, Mean . G / TexelsCount, Mean . B / TexelsCount };
+
+	// Principal axis of the colors by the power iteration on their covariance
+	float Covariance [ 6 ] = {};
+	for ( int i = 0; i < TexelsCount; i ++ )
+	{
+		const float R = Texels[ i * 4 ] - Mean . R, G = Texels[ i * 4 + 1 ] - Mean . G, B = Texels[ i * 4 + 2 ] - Mean . B;
+		Covariance[ 0 ] += R * R; Covariance[ 1 ] += R * G; Covariance[ 2 ] += R * B;
+		Covariance[ 3 ] += G * G; Covariance[ 4 ] += G * B; Covariance[ 5 ] += B * B;
+	}
+	// Starting from the covariance column of the largest variance, a start orthogonal to the axis would never converge
+	Color Axis { 1.f, 1.f, 1.f };
+	if ( Covariance[ 0 ] >= Covariance[ 3 ] && Covariance[ 0 ] >= Covariance[ 5 ] && Covariance[ 0 ] > 0.f )
+		Axis = { Covariance[ 0 ], Covariance[ 1 ], Covariance[ 2 ] };
+	else if ( Covariance[ 3 ] >= Covariance[ 5 ] && Covariance[ 3 ] > 0.f )
+		Axis = { Covariance[ 1 ], Covariance[ 3 ], Covariance[ 4 ] };
+	else if ( Covariance[ 5 ] > 0.f )
+		Axis = { Covariance[ 2 ], Covariance[ 4 ], Covariance[ 5 ] };
+	for ( int Iteration = 0; Iteration < 8; Iteration ++ )
+	{
+		const Color Next { Covariance[ 0 ] * Axis . R + Covariance[ 1 ] * Axis . G + Covariance[ 2 ] * Axis . B,
+						   Covariance[ 1 ] * Axis . R + Covariance[ 3 ] * Axis . G + Covariance[ 4 ] * Axis . B,
+						   Covariance[ 2 ] * Axis . R + Covariance[ 4 ] * Axis . G + Covariance[ 5 ] * Axis . B };
+		const float Length = std::max ( { std::fabs ( Next . R ), std::fabs ( Next . G ), std::fabs ( Next . B ) } );
+		if ( Length < 1e-6f )
+			break;
+		Axis = { Next . R / Length, Next . G / Length, Next . B / Length };
+	}
+	const float AxisLengthSquared = Axis . R * Axis . R + Axis . G * Axis . G + Axis . B * Axis . B;
+
+	// The endpoints are the extreme projections, inset by 1/16 of the range as the palette rarely needs the extremes
+	float MinProjection = 0.f, MaxProjection = 0.f;
+	for ( int i = 0; i < TexelsCount; i ++ )
+	{
+		const float Projection = ( ( Texels[ i * 4 ] - Mean . R ) * Axis . R + ( Texels[ i * 4 + 1 ] - Mean . G ) * Axis . G
+								   + ( Texels[ i * 4 + 2 ] - Mean . B ) * Axis . B ) / AxisLengthSquared;
+		MinProjection = std::min ( MinProjection, Projection );
+		MaxProjection = std::max ( MaxProjection, Projection );
+	}
+	const float Inset = ( MaxProjection - MinProjection ) / 16.f;
+	MinProjection += Inset;
+	MaxProjection -= Inset;
+	uint16_t Color0 = PackRGB565 ( { Mean . R + Axis . R * MaxProjection, Mean . G + Axis . G * MaxProjection, Mean . B + Axis . B * MaxProjection } );
+	uint16_t Color1 = PackRGB565 ( { Mean . R + Axis . R * MinProjection, Mean . G + Axis . G * MinProjection, Mean . B + Axis . B * MinProjection } );
+	if ( Color0 < Color1 )
+		std::swap ( Color0, Color1 );
+
+	uint32_t Indices = 0;
+	if ( Color0 != Color1 )
+	{
+		const Color Endpoint0 = UnpackRGB565 ( Color0 ), Endpoint1 = UnpackRGB565 ( Color1 );
+		const std::array<Color, 4> Palette {
+			Endpoint0, Endpoint1,
+			Color { ( 2.f * Endpoint0 . R + Endpoint1 . R ) / 3.f, ( 2.f * Endpoint0 . G + Endpoint1 . G ) / 3.f, ( 2.f * Endpoint0 . B + Endpoint1 . B ) / 3.f },
+			Color { ( Endpoint0 . R + 2.f * Endpoint1 . R ) / 3.f, ( Endpoint0 . G + 2.f * Endpoint1 . G ) / 3.f, ( Endpoint0 . B + 2.f * Endpoint1 . B ) / 3.f } };
+		for ( int i = 0; i < TexelsCount; i ++ )
+		{
+			uint32_t Best = 0;
+			float BestError = 1e30f;
+			for ( uint32_t j = 0; j < 4; j ++ )
+			{
+				const float R = Texels[ i * 4 ] - Palette[ j ] . R, G = Texels[ i * 4 + 1 ] - Palette[ j ] . G, B = Texels[ i * 4 + 2 ] - Palette[ j ] . B;
+				const float Error = R * R + G * G + B * B;
+				if ( Error < BestError )
+				{
+					BestError = Error;
+					Best = j;
+				}
+			}
+			Indices |= Best << ( 2 * i );
+		}
+	}
+	std::memcpy ( Output, & Color0, 2 );
+	std::memcpy ( Output + 2, & Color1, 2 );
+	std::memcpy ( Output + 4, & Indices, 4 );
+}
+
+// Writes the 8 byte alpha block in the 8 alpha mode
+void CompressAlphaBlock ( const unsigned char * Texels, unsigned char * Output )
+{
+	int Alpha0 = 0, Alpha1 = 255;
+	for ( int i = 0; i < TexelsCount; i ++ )
+	{
+		Alpha0 = std::max ( Alpha0, ( int ) Texels[ i * 4 + 3 ] );
+		Alpha1 = std::min ( Alpha1, ( int ) Texels[ i * 4 + 3 ] );
+	}
+	uint64_t Indices = 0;
+	if ( Alpha0 != Alpha1 )
+	{
+		int Palette [ 8 ] = { Alpha0, Alpha1 };
+		for ( int j = 1; j < 7; j ++ )
+			Palette[ j + 1 ] = ( ( 7 - j ) * Alpha0 + j * Alpha1 ) / 7;
+		for ( int i = 0; i < TexelsCount; i ++ )
+		{
+			uint64_t Best = 0;
+			int BestError = 256;
+			for ( uint64_t j = 0; j < 8; j ++ )
+			{
+				const int Error = std::abs ( Texels[ i * 4 + 3 ] - Palette[ j ] );
+				if ( Error < BestError )
+				{
+					BestError = Error;
+					Best = j;
+				}
+			}
+			Indices |= Best << ( 3 * i );
+		}
+	}
+	Output[ 0 ] = ( unsigned char ) Alpha0;
+	Output[ 1 ] = ( unsigned char ) Alpha1;
+	for ( int i = 0; i < 6; i ++ )
+		Output[ 2 + i ] = ( unsigned char ) ( Indices >> ( 8 * i ) );
+}
+
+float DecodeSRGB ( unsigned char Value )
+{
+	const float Normalized = Value / 255.f;
+	return Normalized <= 0.04045f ? Normalized / 12.92f : std::pow ( ( Normalized + 0.055f ) / 1.055f, 2.4f );
+}
+
+unsigned char EncodeSRGB ( float Value )
+{
+	const float Encoded = Value <= 0.0031308f ? Value * 12.92f : 1.055f * std::pow ( Value, 1.f / 2.4f ) - 0.055f;
+	return ( unsigned char ) std::lround ( std::clamp ( Encoded, 0.f, 1.f ) * 255.f );
+}
+
+std::vector<unsigned char> Downsample ( const std::vector<unsigned char> & Pixels, unsigned int Width, unsigned int Height, bool IsSRGB )
+{
+	const unsigned int NextWidth = std::max ( 1u, Width / 2 ), NextHeight = std::max ( 1u, Height / 2 );
+	std::vector<unsigned char> Result ( ( size_t ) NextWidth * NextHeight * 4 );
+	for ( unsigned int y = 0; y < NextHeight; y ++ )
+		for ( unsigned int x = 0; x < NextWidth; x ++ )
+			for ( unsigned int Channel = 0; Channel < 4; Channel ++ )
+			{
+				// The alpha is linear in the sRGB images as well
+				const bool IsLinear = ! IsSRGB || Channel == 3;
+				float Sum = 0.f;
+				for ( unsigned int Sample = 0; Sample < 4; Sample ++ )
+				{
+					const unsigned int SourceX = std::min ( Width - 1, x * 2 + ( Sample & 1 ) );
+					const unsigned int SourceY = std::min ( Height - 1, y * 2 + ( Sample >> 1 ) );
+					const unsigned char Value = Pixels[ ( ( size_t ) SourceY * Width + SourceX ) * 4 + Channel ];
+					Sum += IsLinear ? Value : DecodeSRGB ( Value );
+				}
+				Result[ ( ( size_t ) y * NextWidth + x ) * 4 + Channel ] = IsLinear ? ( unsigned char ) std::lround ( Sum / 4.f ) : EncodeSRGB ( Sum / 4.f );
+			}
+	return Result;
+}
+
+void CompressLevel ( const unsigned char * Pixels, unsigned int Width, unsigned int Height, CompressedFormat Format, unsigned char * Output )
+{
+	unsigned char Texels [ TexelsCount * 4 ];
+	const size_t BlockSize = GetBlockSize ( Format );
+	for ( unsigned int BlockY = 0; BlockY < Height; BlockY += 4 )
+		for ( unsigned int BlockX = 0; BlockX < Width; BlockX += 4 )
+		{
+			// The blocks crossing the border repeat the last row and column
+			for ( unsigned int i = 0; i < TexelsCount; i ++ )
+			{
+				const unsigned int x = std::min ( Width - 1, BlockX + i % 4 );
+				const unsigned int y = std::min ( Height - 1, BlockY + i / 4 );
+				std::memcpy ( Texels + i * 4, Pixels + ( ( size_t ) y * Width + x ) * 4, 4 );
+			}
+			if ( Format == CompressedFormat::BC1 )
+				CompressBC1Block ( Texels, Output );
+			else
+				CompressBC3Block ( Texels, Output );
+			Output += BlockSize;
+		}
+}
+
+} // namespace
+
+void CompressBC1Block ( const unsigned char * Texels, unsigned char * Output )
+{
+	CompressColorBlock ( Texels, Output );
+}
+
+void CompressBC3Block ( const unsigned char * Texels, unsigned char * Output )
+{
+	CompressAlphaBlock ( Texels, Output );
+	CompressColorBlock ( Texels, Output + 8 );
+}
+
+CompressedImage CompressImage ( const unsigned char * Pixels, unsigned int Width, unsigned int Height, CompressedFormat Format,
+								bool IsSRGB, bool GenerateMips )
+{
+	if ( Format == CompressedFormat::BC7 )
+		throw RenderException ( "BC7 encoding isn't supported, compress to BC1 or BC3" );
+	if ( Width == 0 || Height == 0 )
+		throw RenderException ( "Can't compress an empty image" );
+
+	CompressedImage Image;
+	Image . Format = Format;
+	Image . IsSRGB = IsSRGB;
+	Image . Width = Width;
+	Image . Height = Height;
+	std::vector<unsigned char> Level ( Pixels, Pixels + ( size_t ) Width * Height * 4 );
+	for ( ;; )
+	{
+		const size_t Offset = Image . Data . size ();
+		const size_t Size = GetCompressedSize ( Format, Width, Height );
+		Image . Data . resize ( Offset + Size );
+		CompressLevel ( Level . data (), Width, Height, Format, Image . Data . data () + Offset );
+		Image . Levels . push_back ( { Width, Height, Offset, Size } );
+		if ( ! GenerateMips || ( Width == 1 && Height == 1 ) )
+			break;
+		Level = Downsample ( Level, Width, Height, IsSRGB );
+		Width = std::max ( 1u, Width / 2 );
+		Height = std::max ( 1u, Height / 2 );
+	}
+	return Image;
+}
+
+} // namespace gfx
+} // namespace lk
@@ -0,0 +1,404 @@
+#include "Laniakea/Render/CompressedImage.h"
+#include "Laniakea/Render/RenderException.h"
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+
+namespace lk
+{
+namespace gfx
+{
+
+namespace
+{
+
+constexpr uint32_t DDSMagic = 0x20534444; // "DDS "
+constexpr size_t DDSHeaderSize = 124;
+constexpr size_t DDSHeaderDX10Size = 20;
+constexpr uint32_t DDSPixelFormatFourCC = 0x4;
+constexpr uint32_t DDSFlags = 0x1 | 0x2 | 0x4 | 0x1000 | 0x20000 | 0x80000; // CAPS, HEIGHT, WIDTH, PIXELFORMAT, MIPMAPCOUNT, LINEARSIZE
+constexpr uint32_t DDSCapsTexture = 0x1000;
+constexpr uint32_t DDSCapsMipmap = 0x8 | 0x400000; // COMPLEX, MIPMAP
+constexpr uint32_t DDSDimensionTexture2D = 3;
+constexpr uint32_t DDSMiscTextureCube = 0x4;
+
+constexpr uint32_t MakeFourCC ( char A, char B, char C, char D )
+{
+	return ( uint32_t ) ( unsigned char ) A | ( ( uint32_t ) ( unsigned char ) B << 8 ) | ( ( uint32_t ) ( unsigned char ) C << 16 )
+		   | ( ( uint32_t ) ( unsigned char ) D << 24 );
+}
+
+constexpr unsigned char KTX2Identifier [ 12 ] = { 0xAB, 0x4B, 0x54, 0x58, 0x20, 0x32, 0x30, 0xBB, 0x0D, 0x0A, 0x1A, 0x0A };
+constexpr size_t KTX2HeaderSize = 80; // Identifier, header and index, the level index follows
+constexpr size_t KTX2LevelIndexEntrySize = 24;
+
+// DXGI_FORMAT and VkFormat values of the formats, the sRGB variant follows the UNORM one
+struct FormatCodes
+{
+	CompressedFormat Format;
+	uint32_t DXGI;
+	uint32_t Vulkan;
+	uint32_t DataFormatModel; // KHR_DF_MODEL of the data format descriptor
+};
+
+constexpr FormatCodes Codes [] = {
+	{ CompressedFormat::BC1, 71, 133, 128 },
+	{ CompressedFormat::BC3, 77, 137, 130 },
+	{ CompressedFormat::BC7, 98, 145, 134 }
+};
+
+const FormatCodes & GetCodes ( CompressedFormat Format )
+{
+	return * std::find_if ( std::begin ( Codes ), std::end ( Codes ), [ Format ] ( const FormatCodes & Item ) { return Item . Format == Format; } );
+}
+
+uint32_t ReadU32 ( const unsigned char * Data )
+{
+	uint32_t Value;
+	std::memcpy ( & Value, Data, sizeof ( Value ) );
+	return Value;
+}
+
+uint64_t ReadU64 ( const unsigned char * Data )
+{
+	uint64_t Value;
+	std::memcpy ( & Value, Data, sizeof ( Value ) );
+	return Value;
+}
+
+template <typename T>
+void Append ( std::vector<unsigned char> & Output, T Value )
+{
+	const auto * Bytes = reinterpret_cast <const unsigned char *> ( & Value );
+	Output . insert ( Output . end (), Bytes, Bytes + sizeof ( T ) );
+}
+
+std::vector<unsigned char> ReadFile ( const std::string & Path )
+{
+	std::ifstream File ( Path, std::ios::binary );
+	if ( ! File )
+		throw RenderException ( "Can't open compressed texture: " + Path );
+	return { std::istreambuf_iterator<char> ( File ), std::istreambuf_iterator<char> () };
+}
+
+// A full mip chain of the larger side, more levels in a header mean a corrupted file
+unsigned int GetMaxLevelsCount ( unsigned int Width, unsigned int Height )
+{
+	unsigned int Count = 1;
+	for ( unsigned int Size = std::max ( Width, Height ); Size > 1; Size >>= 1 )
+		Count ++;
+	return Count;
+}
+
+// Fills the levels from the full size down, the level data is expected to follow each other from Data.
+// Returns false if the levels take more than AvailableSize bytes, the sizes are checked before they can overflow
+bool AddLevels ( CompressedImage & Image, unsigned int LevelsCount, size_t AvailableSize )
+{
+	const size_t BlockSize = GetBlockSize ( Image . Format );
+	size_t Offset = 0;
+	for ( unsigned int i = 0; i < LevelsCount; i ++ )
+	{
+		const unsigned int Width = std::max ( 1u, Image . Width >> i );
+		const unsigned int Height = std::max ( 1u, Image . Height >> i );
+		const size_t BlocksCount = ( size_t ) ( Width / 4 + ( Width % 4 != 0 ) ) * ( Height / 4 + ( Height % 4 != 0 ) );
+		if ( BlocksCount > ( AvailableSize - Offset ) / BlockSize )
+			return false;
+		const size_t Size = BlocksCount * BlockSize;
+		Image . Levels . push_back ( { Width, Height, Offset, Size } );
+		Offset += Size;
+	}
+	return true;
+}
+
+CompressedImage ParseDDS ( const std::vector<unsigned char> & File, const std::string & Path )
+{
+	if ( File . size () < 4 + DDSHeaderSize || ReadU32 ( File . data () + 4 ) != DDSHeaderSize )
+		throw RenderException ( "Malformed DDS header: " + Path );
+	const unsigned char * Header = File . data () + 4;
+	CompressedImage Image;
+	Image . Height = ReadU32 ( Header + 8 );
+	Image . Width = ReadU32 ( Header + 12 );
+	const unsigned int LevelsCount = std::max ( 1u, ReadU32 ( Header + 24 ) );
+	if ( ( ReadU32 ( Header + 76 ) & DDSPixelFormatFourCC ) == 0 )
+		throw RenderException ( "DDS holds uncompressed pixels, only BC1, BC3 and BC7 are supported: " + Path );
+
+	size_t DataOffset = 4 + DDSHeaderSize;
+	const uint32_t FourCC = ReadU32 ( Header + 80 );
+	if ( FourCC == MakeFourCC ( 'D', 'X', 'T', '1' ) )
+		Image . Format = CompressedFormat::BC1;
+	else if ( FourCC == MakeFourCC ( 'D', 'X', 'T', '5' ) )
+		Image . Format = CompressedFormat::BC3;
+	else if ( FourCC == MakeFourCC ( 'D', 'X', '1', '0' ) )
+	{
+		if ( File . size () < DataOffset + DDSHeaderDX10Size )
+			throw RenderException ( "Malformed DDS header: " + Path );
+		const unsigned char * HeaderDX10 = File . data () + DataOffset;
+		DataOffset += DDSHeaderDX10Size;
+		if ( ReadU32 ( HeaderDX10 + 4 ) != DDSDimensionTexture2D || ( ReadU32 ( HeaderDX10 + 8 ) & DDSMiscTextureCube ) != 0
+			 || ReadU32 ( HeaderDX10 + 12 ) > 1 )
+			throw RenderException ( "Only single 2D textures are supported in DDS: " + Path );
+		const uint32_t DXGI = ReadU32 ( HeaderDX10 );
+		const auto Found = std::find_if ( std::begin ( Codes ), std::end ( Codes ), [ DXGI ] ( const FormatCodes & Item )
+		{
+			return DXGI == Item . DXGI || DXGI == Item . DXGI + 1;
+		} );
+		if ( Found == std::end ( Codes ) )
+			throw RenderException ( "Unsupported DXGI format " + std::to_string ( DXGI ) + " in " + Path );
+		Image . Format = Found -> Format;
+		Image . IsSRGB = DXGI == Found -> DXGI + 1;
+	}
+	else
+		throw RenderException ( "Unsupported DDS format, only BC1, BC3 and BC7 are supported: " + Path );
+
+	if ( Image . Width == 0 || Image . Height == 0 || LevelsCount > GetMaxLevelsCount ( Image . Width, Image . Height ) )
+		throw RenderException ( "Malformed DDS header: " + Path );
+	if ( ! AddLevels ( Image, LevelsCount, File . size () - DataOffset ) )
+		throw RenderException ( "Truncated DDS file: " + Path );
+	const size_t DataSize = Image . Levels . back () . Offset + Image . Levels . back () . Size;
+	Image . Data . assign ( File . begin () + ( std::ptrdiff_t ) DataOffset, File . begin () + ( std::ptrdiff_t ) ( DataOffset + DataSize ) );
+	return Image;
+}
+
+CompressedImage ParseKTX2 ( const std::vector<unsigned char> & File, const std::string & Path )
+{
+	if ( File . size () < KTX2HeaderSize )
+		throw RenderException ( "Malformed KTX2 header: " + Path );
+	const unsigned char * Header = File . data () + sizeof ( KTX2Identifier );
+	const uint32_t VulkanFormat = ReadU32 ( Header );
+	CompressedImage Image;
+	Image . Width = ReadU32 ( Header + 8 );
+	Image . Height = ReadU32 ( Header + 12 );
+	const uint32_t Depth = ReadU32 ( Header + 16 );
+	const uint32_t LayersCount = ReadU32 ( Header + 20 );
+	const uint32_t FacesCount = ReadU32 ( Header + 24 );
+	const unsigned int LevelsCount = std::max ( 1u, ReadU32 ( Header + 28 ) );
+	const uint32_t Supercompression = ReadU32 ( Header + 32 );
+
+	const auto Found = std::find_if ( std::begin ( Codes ), std::end ( Codes ), [ VulkanFormat ] ( const FormatCodes & Item )
+	{
+		// BC1 has the RGB variants ( 131, 132 ) in front of the RGBA ones
+		return ( VulkanFormat >= Item . Vulkan && VulkanFormat <= Item . Vulkan + 1 )
+			   || ( Item . Format == CompressedFormat::BC1 && ( VulkanFormat == 131 || VulkanFormat == 132 ) );
+	} );
+	if ( Found == std::end ( Codes ) )
+		throw RenderException ( "Unsupported KTX2 format " + std::to_string ( VulkanFormat ) + ", only BC1, BC3 and BC7 are supported: " + Path );
+	Image . Format = Found -> Format;
+	Image . IsSRGB = VulkanFormat == Found -> Vulkan + 1 || VulkanFormat == 132;
+	if ( Supercompression != 0 )
+		throw RenderException ( "Supercompressed KTX2 isn't supported: " + Path );
+	if ( Depth != 0 || LayersCount > 1 || FacesCount != 1 || Image . Width == 0 || Image . Height == 0 )
+		throw RenderException ( "Only single 2D textures are supported in KTX2: " + Path );
+	if ( LevelsCount > GetMaxLevelsCount ( Image . Width, Image . Height ) )
+		throw RenderException ( "Malformed KTX2 header: " + Path );
+	const size_t LevelIndexEnd = KTX2HeaderSize + LevelsCount * KTX2LevelIndexEntrySize;
+	if ( File . size () < LevelIndexEnd )
+		throw RenderException ( "Malformed KTX2 level index: " + Path );
+
+	// Every level is checked against the file before anything is allocated from the header values
+	if ( ! AddLevels ( Image, LevelsCount, File . size () - LevelIndexEnd ) )
+		throw RenderException ( "Truncated KTX2 file: " + Path );
+	for ( unsigned int i = 0; i < LevelsCount; i ++ )
+	{
+		const unsigned char * Entry = File . data () + KTX2HeaderSize + i * KTX2LevelIndexEntrySize;
+		const uint64_t Offset = ReadU64 ( Entry );
+		const uint64_t Length = ReadU64 ( Entry + 8 );
+		if ( Length != Image . Levels[ i ] . Size || Offset < LevelIndexEnd || Offset > File . size () || File . size () - Offset < Length )
+			throw RenderException ( "Malformed KTX2 level " + std::to_string ( i ) + ": " + Path );
+	}
+
+	// The level index goes from the full size level down, the data in the file from the smallest level up
+	Image . Data . resize ( Image . Levels . back () . Offset + Image . Levels . back () . Size );
+	for ( unsigned int i = 0; i < LevelsCount; i ++ )
+	{
+		const auto & Level = Image . Levels[ i ];
+		const uint64_t Offset = ReadU64 ( File . data () + KTX2HeaderSize + i * KTX2LevelIndexEntrySize );
+		std::memcpy ( Image . Data . data () + Level . Offset, File . data () + Offset, Level . Size );
+	}
+	return Image;
+}
+
+std::vector<unsigned char> WriteDDS ( const CompressedImage & Image )
+{
+	const bool IsDX10 = Image . IsSRGB || Image . Format == CompressedFormat::BC7;
+	uint32_t FourCC = MakeFourCC ( 'D', 'X', '1', '0' );
+	if ( ! IsDX10 )
+		FourCC = Image . Format == CompressedFormat::BC1 ? MakeFourCC ( 'D', 'X', 'T', '1' ) : MakeFourCC ( 'D', 'X', 'T', '5' );
+
+	std::vector<unsigned char> Output;
+	Append ( Output, DDSMagic );
+	Append ( Output, ( uint32_t ) DDSHeaderSize );
+	Append ( Output, DDSFlags );
+	Append ( Output, ( uint32_t ) Image . Height );
+	Append ( Output, ( uint32_t ) Image . Width );
+	Append ( Output, ( uint32_t ) Image . Levels . front () . Size );
+	Append ( Output, ( uint32_t ) 0 ); // Depth
+	Append ( Output, ( uint32_t ) Image . Levels . size () );
+	for ( int i = 0; i < 11; i ++ )
+		Append ( Output, ( uint32_t ) 0 );
+	// Pixel format: size, flags, FourCC, bit count and 4 masks
+	Append ( Output, ( uint32_t ) 32 );
+	Append ( Output, DDSPixelFormatFourCC );
+	Append ( Output, FourCC );
+	for ( int i = 0; i < 5; i ++ )
+		Append ( Output, ( uint32_t ) 0 );
+	Append ( Output, DDSCapsTexture | ( Image . Levels . size () > 1 ? DDSCapsMipmap : 0 ) );
+	for ( int i = 0; i < 4; i ++ )
+		Append ( Output, ( uint32_t ) 0 );
+	if ( IsDX10 )
+	{
+		Append ( Output, GetCodes ( Image . Format ) . DXGI + ( Image . IsSRGB ? 1 : 0 ) );
+		Append ( Output, DDSDimensionTexture2D );
+		Append ( Output, ( uint32_t ) 0 ); // Misc flags
+		Append ( Output, ( uint32_t ) 1 ); // Array size
+		Append ( Output, ( uint32_t ) 0 ); // Alpha mode unknown
+	}
+	Output . insert ( Output . end (), Image . Data . begin (), Image . Data . end () );
+	return Output;
+}
+
+std::vector<unsigned char> WriteKTX2 ( const CompressedImage & Image )
+{
+	const auto & Format = GetCodes ( Image . Format );
+	const uint32_t BlockSize = ( uint32_t ) GetBlockSize ( Image . Format );
+
+	// Basic data format descriptor: one sample per compressed channel, BC3 stores the alpha block first
+	std::vector<unsigned char> Descriptor;
+	const uint32_t SamplesCount = Image . Format == CompressedFormat::BC3 ? 2 : 1;
+	const uint32_t DescriptorBlockSize = 24 + 16 * SamplesCount;
+	Append ( Descriptor, ( uint32_t ) ( 4 + DescriptorBlockSize ) );
+	Append ( Descriptor, ( uint32_t ) 0 ); // Khronos vendor, basic descriptor type
+	Append ( Descriptor, ( uint32_t ) ( 2 | ( DescriptorBlockSize << 16 ) ) ); // Version 1.3
+	Append ( Descriptor, ( uint8_t ) Format . DataFormatModel );
+	Append ( Descriptor, ( uint8_t ) 1 ); // BT.709 primaries
+	Append ( Descriptor, ( uint8_t ) ( Image . IsSRGB ? 2 : 1 ) ); // Transfer function
+	Append ( Descriptor, ( uint8_t ) 0 ); // Flags, alpha straight
+	Append ( Descriptor, ( uint32_t ) 0x00000303 ); // 4x4x1x1 texel block
+	Append ( Descriptor, ( uint32_t ) BlockSize ); // Bytes of plane 0
+	Append ( Descriptor, ( uint32_t ) 0 );
+	const auto AppendSample = [ & Descriptor ] ( uint32_t BitOffset, uint32_t Channel )
+	{
+		Append ( Descriptor, ( uint32_t ) ( BitOffset | ( 63u << 16 ) | ( Channel << 24 ) ) );
+		Append ( Descriptor, ( uint32_t ) 0 ); // Sample position
+		Append ( Descriptor, ( uint32_t ) 0 ); // Lower
+		Append ( Descriptor, ( uint32_t ) 0xFFFFFFFF ); // Upper
+	};
+	if ( Image . Format == CompressedFormat::BC3 )
+	{
+		AppendSample ( 0, 15 ); // Alpha
+		AppendSample ( 64, 0 ); // Color
+	}
+	else
+	{
+		AppendSample ( 0, 0 );
+		if ( Image . Format == CompressedFormat::BC7 )
+			Descriptor[ 4 + 24 + 2 ] = 127; // BC7 samples the whole 128 bit block
+	}
+
+	const size_t LevelIndexSize = Image . Levels . size () * KTX2LevelIndexEntrySize;
+	const size_t DescriptorOffset = KTX2HeaderSize + LevelIndexSize;
+	std::vector<unsigned char> Output ( std::begin ( KTX2Identifier ), std::end ( KTX2Identifier ) );
+	Append ( Output, Format . Vulkan + ( Image . IsSRGB ? 1 : 0 ) );
+	Append ( Output, ( uint32_t ) 1 ); // Type size of the compressed formats
+	Append ( Output, ( uint32_t ) Image . Width );
+	Append ( Output, ( uint32_t ) Image . Height );
+	Append ( Output, ( uint32_t ) 0 ); // Depth
+	Append ( Output, ( uint32_t ) 0 ); // Layers
+	Append ( Output, ( uint32_t ) 1 ); // Faces
+	Append ( Output, ( uint32_t ) Image . Levels . size () );
+	Append ( Output, ( uint32_t ) 0 ); // No supercompression
+	Append ( Output, ( uint32_t ) DescriptorOffset );
+	Append ( Output, ( uint32_t ) Descriptor . size () );
+	Append ( Output, ( uint32_t ) 0 ); // No key/value data
+	Append ( Output, ( uint32_t ) 0 );
+	Append ( Output, ( uint64_t ) 0 ); // No supercompression global data
+	Append ( Output, ( uint64_t ) 0 );
+
+	// The levels are stored from the smallest up, each aligned to the block size
+	std::vector<uint64_t> LevelOffsets ( Image . Levels . size () );
+	size_t Offset = DescriptorOffset + Descriptor . size ();
+	for ( size_t i = Image . Levels . size (); i -- > 0; )
+	{
+		Offset = ( Offset + BlockSize - 1 ) / BlockSize * BlockSize;
+		LevelOffsets[ i ] = Offset;
+		Offset += Image . Levels[ i ] . Size;
+	}
+	for ( size_t i = 0; i < Image . Levels . size (); i ++ )
+	{
+		Append ( Output, LevelOffsets[ i ] );
+		Append ( Output, ( uint64_t ) Image . Levels[ i ] . Size );
+		Append ( Output, ( uint64_t ) Image . Levels[ i ] . Size );
+	}
+	Output . insert ( Output . end (), Descriptor . begin (), Descriptor . end () );
+	for ( size_t i = Image . Levels . size (); i -- > 0; )
+	{
+		Output . resize ( LevelOffsets[ i ], 0 );
+		const auto Begin = Image . Data . begin () + ( std::ptrdiff_t ) Image . Levels[ i ] . Offset;
+		Output . insert ( Output . end (), Begin, Begin + ( std::ptrdiff_t ) Image . Levels[ i ] . Size );
+	}
+	return Output;
+}
+
+bool GetIsExtension ( const std::string & Path, const char * Extension )
+{
+	const size_t Length = std::strlen ( Extension );
+	if ( Path . size () < Length )
+		return false;
+	return std::equal ( Path . end () - ( std::ptrdiff_t ) Length, Path . end (), Extension, [] ( char Left, char Right )
+	{
+		return std::tolower ( ( unsigned char ) Left ) == Right;
+	} );
+}
+
+} // namespace
+
+size_t GetBlockSize ( CompressedFormat Format )
+{
+	return Format == CompressedFormat::BC1 ? 8 : 16;
+}
+
+size_t GetCompressedSize ( CompressedFormat Format, unsigned int Width, unsigned int Height )
+{
+	return ( size_t ) ( ( Width + 3 ) / 4 ) * ( ( Height + 3 ) / 4 ) * GetBlockSize ( Format );
+}
+
+bool GetIsCompressedImageFile ( const std::string & Path )
+{
+	unsigned char Signature [ sizeof ( KTX2Identifier ) ] = {};
+	std::ifstream File ( Path, std::ios::binary );
+	if ( ! File . read ( reinterpret_cast <char *> ( Signature ), sizeof ( Signature ) ) )
+		return false;
+	return ReadU32 ( Signature ) == DDSMagic || std::memcmp ( Signature, KTX2Identifier, sizeof ( KTX2Identifier ) ) == 0;
+}
+
+CompressedImage LoadCompressedImage ( const std::string & Path )
+{
+	const auto File = ReadFile ( Path );
+	if ( File . size () >= 4 && ReadU32 ( File . data () ) == DDSMagic )
+		return ParseDDS ( File, Path );
+	if ( File . size () >= sizeof ( KTX2Identifier ) && std::memcmp ( File . data (), KTX2Identifier, sizeof ( KTX2Identifier ) ) == 0 )
+		return ParseKTX2 ( File, Path );
+	throw RenderException ( "Not a DDS or KTX2 file: " + Path );
+}
+
+void SaveCompressedImage ( const CompressedImage & Image, const std::string & Path )
+{
+	if ( Image . Levels . empty () )
+		throw RenderException ( "Compressed image has no levels: " + Path );
+	std::vector<unsigned char> Output;
+	if ( GetIsExtension ( Path, ".dds" ) )
+		Output = WriteDDS ( Image );
+	else if ( GetIsExtension ( Path, ".ktx2" ) )
+		Output = WriteKTX2 ( Image );
+	else
+		throw RenderException ( "Compressed images are saved as .dds or .ktx2: " + Path );
+
+	std::ofstream File ( Path, std::ios::binary | std::ios::trunc );
+	File . write ( reinterpret_cast <const char *> ( Output . data () ), ( std::streamsize ) Output . size () );
+	if ( ! File )
+		throw RenderException ( "Can't write compressed texture: " + Path );
+}
+
+} // namespace gfx
+} // namespace lk
@@ -0,0 +1,298 @@
+#include "glad/glad.h"
+#include "Laniakea/Render/GLStateCache.h"
+#include "Laniakea/Render/RenderException.h"
+#include <string>
+
+namespace lk
+{
+namespace gfx
+{
+
+namespace
+{
+	constexpr unsigned int UntrackedTarget = 0xFFFFFFFF;
+
+	// Index of the tracked buffer target, or UntrackedTarget
+	unsigned int GetBufferTargetIndex ( unsigned int Target )
+	{
+		switch ( Target )
+		{
+			case GL_ARRAY_BUFFER: return 0;
+			case GL_ELEMENT_ARRAY_BUFFER: return 1;
+			case GL_UNIFORM_BUFFER: return 2;
+			case GL_PIXEL_UNPACK_BUFFER: return 3;
+			case GL_PIXEL_PACK_BUFFER: return 4;
+			case GL_COPY_READ_BUFFER: return 5;
+			case GL_COPY_WRITE_BUFFER: return 6;
+			case GL_DRAW_INDIRECT_BUFFER: return 7;
+			default: return UntrackedTarget;
+		}
+	}
+
+	// Index of the tracked texture target, or UntrackedTarget
+	unsigned int GetTextureTargetIndex ( unsigned int Target )
+	{
+		switch ( Target )
+		{
+			case GL_TEXTURE_2D: return 0;
+			case GL_TEXTURE_CUBE_MAP: return 1;
+			case GL_TEXTURE_2D_ARRAY: return 2;
+			case GL_TEXTURE_3D: return 3;
+			default: return UntrackedTarget;
+		}
+	}
+
+	void SetCapability ( unsigned int Capability, bool IsEnabled )
+	{
+		if ( IsEnabled )
+			glEnable ( Capability );
+		else
+			glDisable ( Capability );
+	}
+}
+
+GLStateCache::GLStateCache ()
+{
+	Invalidate ();
+	BeginFrame ();
+}
+
+GLStateCache & GLStateCache::GetCurrent ()
+{
+	thread_local GLStateCache Cache;
+	return Cache;
+}
+
+bool GLStateCache::Update ( unsigned int & Cached, unsigned int Value )
+{
+	if ( Cached == Value && Value != Unknown )
+	{
+		m_AvoidedCallsCount ++;
+		return false;
+	}
+	Cached = Value;
+	m_IssuedCallsCount ++;
+	return true;
+}
+
+void GLStateCache::UseProgram ( unsigned int Program )
+{
+	if ( Update ( m_Program, Program ) )
+		glUseProgram ( Program );
+}
+
+void GLStateCache::BindVertexArray ( unsigned int VertexArray )
+{
+	if ( Update ( m_VertexArray, VertexArray ) )
+	{
+		glBindVertexArray ( VertexArray );
+		m_Buffers[ GetBufferTargetIndex ( GL_ELEMENT_ARRAY_BUFFER ) ] = Unknown;
+	}
+}
+
+void GLStateCache::BindBuffer ( unsigned int Target, unsigned int Buffer )
+{
+	const auto Index = GetBufferTargetIndex ( Target );
+	if ( Index == UntrackedTarget )
+	{
+		m_IssuedCallsCount ++;
+		glBindBuffer ( Target, Buffer );
+	}
+	else if ( Update ( m_Buffers[ Index ], Buffer ) )
+		glBindBuffer ( Target, Buffer );
+}
+
+void GLStateCache::BindBufferRange ( unsigned int Target, unsigned int Index, unsigned int Buffer, unsigned int Offset, unsigned int Size )
+{
+	const auto TargetIndex = GetBufferTargetIndex ( Target );
+	if ( Target == GL_UNIFORM_BUFFER && Index < UniformBindingsCount )
+	{
+		auto & Cached = m_UniformRanges[ Index ];
+		if ( Cached . Buffer == Buffer && Cached . Offset == Offset && Cached . Size == Size && Buffer != Unknown )
+		{
+			m_AvoidedCallsCount ++;
+			return;
+		}
+		Cached = { Buffer, Offset, Size };
+	}
+	m_IssuedCallsCount ++;
+	glBindBufferRange ( Target, Index, Buffer, Offset, Size );
+	if ( TargetIndex != UntrackedTarget )
+		m_Buffers[ TargetIndex ] = Buffer;
+}
+
+void GLStateCache::ActiveTexture ( unsigned int Unit )
+{
+	if ( Unit >= TextureUnitsCount )
+		throw RenderException ( "Texture unit " + std::to_string ( Unit ) + " is out of the tracked range" );
+	if ( Update ( m_ActiveTexture, Unit ) )
+		glActiveTexture ( GL_TEXTURE0 + Unit );
+}
+
+void GLStateCache::BindTexture ( unsigned int Unit, unsigned int Target, unsigned int Texture )
+{
+	if ( Unit >= TextureUnitsCount )
+		throw RenderException ( "Texture unit " + std::to_string ( Unit ) + " is out of the tracked range" );
+	const auto Index = GetTextureTargetIndex ( Target );
+	if ( Index == UntrackedTarget )
+	{
+		ActiveTexture ( Unit );
+		m_IssuedCallsCount ++;
+		glBindTexture ( Target, Texture );
+		return;
+	}
+	// The unit is only activated when the binding changes
+	auto & Cached = m_Textures[ Unit ][ Index ];
+	if ( Cached == Texture && Texture != Unknown )
+	{
+		m_AvoidedCallsCount ++;
+		return;
+	}
+	ActiveTexture ( Unit );
+	Update ( Cached, Texture );
+	glBindTexture ( Target, Texture );
+}
+
+void GLStateCache::SetBlend ( bool IsEnabled )
+{
+	if ( Update ( m_Blend, IsEnabled ) )
+		SetCapability ( GL_BLEND, IsEnabled );
+}
+
+void GLStateCache::SetBlendFunc ( unsigned int Source, unsigned int Destination )
+{
+	if ( m_BlendSource == Source && m_BlendDestination == Destination )
+	{
+		m_AvoidedCallsCount ++;
+		return;
+	}
+	m_BlendSource = Source;
+	m_BlendDestination = Destination;
+	m_IssuedCallsCount ++;
+	glBlendFunc ( Source, Destination );
+}
+
+void GLStateCache::SetDepthTest ( bool IsEnabled )
+{
+	if ( Update ( m_DepthTest, IsEnabled ) )
+		SetCapability ( GL_DEPTH_TEST, IsEnabled );
+}
+
+void GLStateCache::SetDepthMask ( bool IsWritable )
+{
+	if ( Update ( m_DepthMask, IsWritable ) )
+		glDepthMask ( IsWritable ? GL_TRUE : GL_FALSE );
+}
+
+void GLStateCache::SetDepthFunc ( unsigned int Function )
+{
+	if ( Update ( m_DepthFunc, Function ) )
+		glDepthFunc ( Function );
+}
+
+void GLStateCache::SetCullFace ( bool IsEnabled )
+{
+	if ( Update ( m_CullFace, IsEnabled ) )
+		SetCapability ( GL_CULL_FACE, IsEnabled );
+}
+
+void GLStateCache::SetCullFaceMode ( unsigned int Mode )
+{
+	if ( Update ( m_CullFaceMode, Mode ) )
+		glCullFace ( Mode );
+}
+
+void GLStateCache::Invalidate ()
+{
+	m_Program = Unknown;
+	m_VertexArray = Unknown;
+	m_ActiveTexture = Unknown;
+	m_Buffers . fill ( Unknown );
+	for ( auto & Unit : m_Textures )
+		Unit . fill ( Unknown );
+	m_UniformRanges . fill ( { Unknown, Unknown, Unknown } );
+	m_Blend = Unknown;
+	m_BlendSource = Unknown;
+	m_BlendDestination = Unknown;
+	m_DepthTest = Unknown;
+	m_DepthMask = Unknown;
+	m_DepthFunc = Unknown;
+	m_CullFace = Unknown;
+	m_CullFaceMode = Unknown;
+}
+
+void GLStateCache::OnProgramDeleted ( unsigned int Program )
+{
+	// A current program stays in use until another one is made current, but its name is freed only after that,
+	// forgetting it keeps the next UseProgram from being skipped
+	if ( m_Program == Program )
+		m_Program = Unknown;
+}
+
+void GLStateCache::OnVertexArrayDeleted ( unsigned int VertexArray )
+{
+	if ( m_VertexArray == VertexArray )
+	{
+		m_VertexArray = 0;
+		m_Buffers[ GetBufferTargetIndex ( GL_ELEMENT_ARRAY_BUFFER ) ] = Unknown;
+	}
+}
+
+void GLStateCache::OnBufferDeleted ( unsigned int Buffer )
+{
+	for ( auto & Cached : m_Buffers )
+		if ( Cached == Buffer )
+			Cached = 0;
+	for ( auto & Cached : m_UniformRanges )
+		if ( Cached . Buffer == Buffer )
+			Cached = { 0, 0, 0 };
+}
+
+void GLStateCache::OnTextureDeleted ( unsigned int Texture )
+{
+	for ( auto & Unit : m_Textures )
+		for ( auto & Cached : Unit )
+			if ( Cached == Texture )
+				Cached = 0;
+}
+
+void GLStateCache::BeginFrame ()
+{
+	m_AvoidedCallsCount = 0;
+	m_IssuedCallsCount = 0;
+}
+
+uint64_t GLStateCache::GetAvoidedCallsCount () const
+{
+	return m_AvoidedCallsCount;
+}
+
+uint64_t GLStateCache::GetIssuedCallsCount () const
+{
+	return m_IssuedCallsCount;
+}
+
+unsigned int GLStateCache::GetProgram () const
+{
+	return m_Program;
+}
+
+unsigned int GLStateCache::GetVertexArray () const
+{
+	return m_VertexArray;
+}
+
+unsigned int GLStateCache::GetBuffer ( unsigned int Target ) const
+{
+	const auto Index = GetBufferTargetIndex ( Target );
+	return Index != UntrackedTarget ? m_Buffers[ Index ] : Unknown;
+}
+
+unsigned int GLStateCache::GetTexture ( unsigned int Unit, unsigned int Target ) const
+{
+	const auto Index = GetTextureTargetIndex ( Target );
+	return Index != UntrackedTarget && Unit < TextureUnitsCount ? m_Textures[ Unit ][ Index ] : Unknown;
+}
+
+} // namespace gfx
+} // namespace lk
@@ -1,6 +1,9 @@
 #include "glad/glad.h"
 #include "Laniakea/Render/IndexBuffer.h"
 #include "Laniakea/Render/RenderException.h"
+#include "Laniakea/Render/GLStateCache.h"
+#include "Laniakea/Render/StreamBuffer.h"
+#include <cstdint>
 
 
 namespace lk
@@ -16,6 +19,7 @@ IndexBuffer::IndexBuffer ()
 
 IndexBuffer::~IndexBuffer ()
 {
+	GLStateCache::GetCurrent () . OnBufferDeleted ( m_Handle );
 	glDeleteBuffers (1, &m_Handle);
 }
 
@@ -34,12 +38,19 @@ void IndexBuffer::Set ( unsigned int * Array, unsigned int Length )
 	m_Count = Length;
 	unsigned int Size = sizeof ( unsigned int );
 
-	glBindBuffer ( GL_ELEMENT_ARRAY_BUFFER, m_Handle );
-	glBufferData ( GL_ELEMENT_ARRAY_BUFFER, Size * m_Count, Array, GL_STATIC_DRAW );
-	glBindBuffer ( GL_ELEMENT_ARRAY_BUFFER, 0 );
+	// Uploaded through the array buffer target, the element array buffer binding belongs to the bound vertex array
+	GLStateCache::GetCurrent () . BindBuffer ( GL_ARRAY_BUFFER, m_Handle );
+	glBufferData ( GL_ARRAY_BUFFER, Size * m_Count, Array, GL_STATIC_DRAW );
 	LK_RENDER_CHECK_ERROR()
 }
 
+void IndexBuffer::Update ( const unsigned int * Array, unsigned int First, unsigned int Length, StreamBuffer & Staging )
+{
+	if ( ( uint64_t ) First + Length > m_Count )
+		throw RenderException ( "Updated range exceeds the index buffer contents" );
+	Staging.CopyTo ( m_Handle, First * sizeof ( unsigned int ), Array, Length * sizeof ( unsigned int ) );
+}
+
 void IndexBuffer::Set ( std::vector <unsigned int> & Array )
 {
 	Set ( Array.data(), (unsigned int) Array.size() );
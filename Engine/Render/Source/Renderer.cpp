@@ -1,6 +1,8 @@
 #include "Laniakea/Render/Renderer.h"
 #include "Laniakea/Render/IndexBuffer.h"
+#include "Laniakea/Render/VertexArray.h"
 #include "Laniakea/Render/RenderException.h"
+#include "Laniakea/Render/GLStateCache.h"
 #include "glad/glad.h"
 
 namespace lk
@@ -14,14 +16,46 @@ namespace gfx
 		LK_RENDER_CHECK_ERROR()
 	}
 
+	void Renderer::RenderInstanced ( unsigned int VertexCount, unsigned int InstanceCount, DrawMode DrawMode )
+	{
+		glDrawArraysInstanced ( GetGLDrawModeFromDrawMode ( DrawMode ), 0, VertexCount, InstanceCount );
+		LK_RENDER_CHECK_ERROR()
+	}
+
+	void Renderer::RenderIndexedInstanced ( IndexBuffer & IndexBuffer, unsigned int InstanceCount, DrawMode DrawMode )
+	{
+		GLStateCache::GetCurrent () . BindBuffer ( GL_ELEMENT_ARRAY_BUFFER, IndexBuffer.GetHandle() );
+		glDrawElementsInstanced ( GetGLDrawModeFromDrawMode ( DrawMode ), IndexBuffer.GetCount(), GL_UNSIGNED_INT, 0, InstanceCount );
+		LK_RENDER_CHECK_ERROR()
+	}
+
 	void Renderer::Render ( IndexBuffer & IndexBuffer, DrawMode DrawMode )
 	{
 		auto Handle = IndexBuffer.GetHandle();
 		auto NumIndices = IndexBuffer.GetCount();
 
-		glBindBuffer ( GL_ELEMENT_ARRAY_BUFFER, Handle );
+		GLStateCache::GetCurrent () . BindBuffer ( GL_ELEMENT_ARRAY_BUFFER, Handle );
 		glDrawElements ( GetGLDrawModeFromDrawMode ( DrawMode ), NumIndices, GL_UNSIGNED_INT, 0 );
-		glBindBuffer ( GL_ELEMENT_ARRAY_BUFFER, 0 );
+		LK_RENDER_CHECK_ERROR()
+	}
+
+	void Renderer::Render ( const VertexArray & VertexArray, DrawMode DrawMode )
+	{
+		VertexArray.Bind();
+		if ( VertexArray.GetIsIndexed() )
+			glDrawElements ( GetGLDrawModeFromDrawMode ( DrawMode ), VertexArray.GetCount(), GL_UNSIGNED_INT, 0 );
+		else
+			glDrawArrays ( GetGLDrawModeFromDrawMode ( DrawMode ), 0, VertexArray.GetCount() );
+		LK_RENDER_CHECK_ERROR()
+	}
+
+	void Renderer::RenderInstanced ( const VertexArray & VertexArray, unsigned int InstanceCount, DrawMode DrawMode )
+	{
+		VertexArray.Bind();
+		if ( VertexArray.GetIsIndexed() )
+			glDrawElementsInstanced ( GetGLDrawModeFromDrawMode ( DrawMode ), VertexArray.GetCount(), GL_UNSIGNED_INT, 0, InstanceCount );
+		else
+			glDrawArraysInstanced ( GetGLDrawModeFromDrawMode ( DrawMode ), 0, VertexArray.GetCount(), InstanceCount );
 		LK_RENDER_CHECK_ERROR()
 	}
 
@@ -1,24 +1,39 @@
 #include "Laniakea/Render/Shader.h"
 #include "Laniakea/Render/RenderException.h"
+#include "Laniakea/Render/GLStateCache.h"
+#include "Laniakea/Render/ShaderCache.h"
 #include "glad/glad.h"
 #include <fstream>
 #include <sstream>
+#include <cstdio>
 #include <cstring>
 #include <iostream>
+#include <vector>
+
+#ifndef GL_COMPLETION_STATUS_KHR
+	#define GL_COMPLETION_STATUS_KHR 0x91B1 // KHR_parallel_shader_compile
+#endif
 
 namespace lk
 {
 namespace gfx
 {
 
-	Shader::Shader ( const std::string & VertexShader, const std::string & FragmentShader )
-	: m_Handle ( glCreateProgram() )
+	Shader::Shader ( const std::string & VertexShader, const std::string & FragmentShader, ShaderCache * Cache )
+	: m_Handle ( glCreateProgram() ), m_VSHandle ( 0 ), m_FSHandle ( 0 ), m_CacheKey ( 0 ), m_Cache ( nullptr )
+	{
+		Load ( VertexShader, FragmentShader, Cache );
+	}
+
+	Shader::Shader ( DeferredLoad )
+	: m_Handle ( glCreateProgram() ), m_VSHandle ( 0 ), m_FSHandle ( 0 ), m_CacheKey ( 0 ), m_Cache ( nullptr )
 	{
-		Load ( VertexShader, FragmentShader );
 	}
 
 	Shader::~Shader ()
 	{
+		ReleaseShaders ();
+		GLStateCache::GetCurrent () . OnProgramDeleted ( m_Handle );
 		glDeleteProgram ( m_Handle );
 	}
 
@@ -29,47 +44,127 @@ namespace gfx
 
 	void Shader::Bind () const
 	{
-		glUseProgram ( m_Handle );
+		GLStateCache::GetCurrent () . UseProgram ( m_Handle );
 	}
 
 	void Shader::Unbind () const
 	{
-		glUseProgram ( 0 );
+		GLStateCache::GetCurrent () . UseProgram ( 0 );
+	}
+
+	bool Shader::GetIsAttributeExists ( std::string_view AttributeName ) const
+	{
+		return m_Attributes . GetIsExists ( AttributeName );
+	}
+
+	bool Shader::GetIsAttributeExists ( UniformId Id ) const
+	{
+		return m_Attributes . GetIsExists ( Id );
+	}
+
+	uint32_t Shader::GetAttributeLocation ( std::string_view AttributeName ) const
+	{
+		const int32_t Location = m_Attributes . Find ( AttributeName );
+		if ( Location < 0 )
+			throw RenderException ( "Attribute with name: " + std::string ( AttributeName ) + " doesn't exist in the shader" );
+		return ( uint32_t ) Location;
+	}
+
+	int32_t Shader::FindAttributeLocation ( UniformId Id ) const
+	{
+		return m_Attributes . Find ( Id );
+	}
+
+	bool Shader::GetIsUniformExists ( std::string_view UniformName ) const
+	{
+		return m_Uniforms . GetIsExists ( UniformName );
+	}
+
+	bool Shader::GetIsUniformExists ( UniformId Id ) const
+	{
+		return m_Uniforms . GetIsExists ( Id );
+	}
+
+	uint32_t Shader::GetUniformLocation ( std::string_view UniformName ) const
+	{
+		const int32_t Location = m_Uniforms . Find ( UniformName );
+		if ( Location < 0 )
+			throw RenderException ( "Uniform with name: " + std::string ( UniformName ) + " doesn't exist in the shader" );
+		return ( uint32_t ) Location;
 	}
 
-	bool Shader::GetIsAttributeExists ( const std::string & AttributeName ) const
+	int32_t Shader::FindUniformLocation ( UniformId Id ) const
 	{
-		return m_Attributes . count ( AttributeName ) != 0;
+		return m_Uniforms . Find ( Id );
 	}
 
-	uint32_t Shader::GetAttributeLocation ( const std::string & AttributeName ) const
+	bool Shader::GetIsUniformBlockExists ( const std::string & BlockName ) const
 	{
-		if ( m_Attributes . count ( AttributeName ) == 0 )
-			throw RenderException ( "Attribute with name: " + AttributeName + " doesn't exist in the shader" );
-		return m_Attributes . at ( AttributeName );
+		return m_UniformBlocks . count ( BlockName ) != 0;
 	}
 
-	bool Shader::GetIsUniformExists ( const std::string & UniformName ) const
+	const ShaderUniformBlockData & Shader::GetUniformBlock ( const std::string & BlockName ) const
 	{
-		return m_Uniforms . count ( UniformName ) != 0;
+		if ( m_UniformBlocks . count ( BlockName ) == 0 )
+			throw RenderException ( "Uniform block with name: " + BlockName + " doesn't exist in the shader" );
+		return m_UniformBlocks . at ( BlockName );
 	}
 
-	uint32_t Shader::GetUniformLocation ( const std::string & UniformName ) const
+	void Shader::SetUniformBlockBinding ( const std::string & BlockName, uint32_t Binding )
 	{
-		if ( m_Uniforms . count ( UniformName ) == 0 )
-			throw RenderException ( "Uniform with name: " + UniformName + " doesn't exist in the shader" );
-		return m_Uniforms . at ( UniformName );
+		if ( m_UniformBlocks . count ( BlockName ) == 0 )
+			throw RenderException ( "Uniform block with name: " + BlockName + " doesn't exist in the shader" );
+		auto & Block = m_UniformBlocks . at ( BlockName );
+		glUniformBlockBinding ( m_Handle, Block . Index, Binding );
+		Block . Binding = Binding;
+		LK_RENDER_CHECK_ERROR()
 	}
 
-	void Shader::Load ( const std::string & VertexShader, const std::string & FragmentShader )
+	void Shader::Load ( const std::string & VertexShader, const std::string & FragmentShader, ShaderCache * Cache )
+	{
+		if ( ! Submit ( VertexShader, FragmentShader, Cache ) )
+			Finish ();
+	}
+
+	bool Shader::Submit ( const std::string & VertexShader, const std::string & FragmentShader, ShaderCache * Cache )
 	{
 		std::string VertexSource, FragmentSource;
 		ReadShaders ( VertexShader, FragmentShader, VertexSource, FragmentSource );
-		const GLuint VSHandle = CompileVertexShader ( VertexSource );
-		const GLuint FSHandle = CompileFragmentShader ( FragmentSource );
-		LinkShaders ( VSHandle, FSHandle );
+		m_Cache = Cache;
+		if ( Cache != nullptr )
+		{
+			// A warm start skips the compilation, the linking and the reflection
+			m_CacheKey = Cache -> GetKey ( VertexSource, FragmentSource );
+			if ( Cache -> Load ( m_CacheKey, m_Handle, m_Attributes, m_Uniforms, m_UniformBlocks ) )
+				return true;
+			glProgramParameteri ( m_Handle, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE );
+		}
+		m_VSHandle = CompileShader ( GL_VERTEX_SHADER, VertexSource );
+		m_FSHandle = CompileShader ( GL_FRAGMENT_SHADER, FragmentSource );
+		LinkShaders ();
+		return false;
+	}
+
+	bool Shader::GetIsLinkCompleted () const
+	{
+		GLint IsCompleted = GL_TRUE;
+		glGetProgramiv ( m_Handle, GL_COMPLETION_STATUS_KHR, &IsCompleted );
+		return IsCompleted != GL_FALSE;
+	}
+
+	void Shader::Finish ()
+	{
+		// The statuses are queried only now, so a driver compiling in parallel isn't waited for at the submission
+		CheckShader ( m_VSHandle, "vertex" );
+		CheckShader ( m_FSHandle, "fragment" );
+		CheckLink ();
+		// Program was linked successfully. Delete single shaders.
+		ReleaseShaders ();
 		PopulateAttributes();
 		PopulateUniforms();
+		PopulateUniformBlocks();
+		if ( m_Cache != nullptr )
+			m_Cache -> Store ( m_CacheKey, m_Handle, m_Attributes, m_Uniforms, m_UniformBlocks );
 	}
 
 	void Shader::ReadShaders ( const std::string & VertexShader, const std::string & FragmentShader, std::string & OutVS,
@@ -107,137 +202,194 @@ namespace gfx
 		}
 	}
 
-	uint32_t Shader::CompileVertexShader ( const std::string & VertexSource )
+	uint32_t Shader::CompileShader ( uint32_t Type, const std::string & Source )
 	{
-		const GLuint VSHandle = glCreateShader ( GL_VERTEX_SHADER );
-		const char * VertexSource_C = VertexSource.c_str();
-		glShaderSource ( VSHandle, 1, &VertexSource_C, NULL );
-		glCompileShader( VSHandle );
-		int Status = 0;
-		glGetShaderiv ( VSHandle, GL_COMPILE_STATUS, &Status );
-		if ( Status == 0 )
-		{
-			// Collect the OpenGL log and throw the error
-			char LogString_C [512];
-			glGetShaderInfoLog ( VSHandle, 512, NULL, LogString_C );
-			glDeleteShader( VSHandle );
-			std::string LogString ( LogString_C );
-			throw RenderException ( "Can't compile vertex shader. OpenGL error log: " + LogString );
-		}
-		return VSHandle;
+		const GLuint ShaderHandle = glCreateShader ( Type );
+		const char * Source_C = Source.c_str();
+		glShaderSource ( ShaderHandle, 1, &Source_C, NULL );
+		glCompileShader ( ShaderHandle );
+		return ShaderHandle;
 	}
 
-	uint32_t Shader::CompileFragmentShader ( const std::string & ShaderSource )
+	void Shader::CheckShader ( uint32_t ShaderHandle, const char * Stage )
 	{
-		// Try to compile fragment shader
-		const char * FragmentSource_C = ShaderSource.c_str();
 		int Status = 0;
-		const GLuint FSHandle = glCreateShader ( GL_FRAGMENT_SHADER );
-		glShaderSource ( FSHandle, 1, &FragmentSource_C, NULL );
-		glCompileShader ( FSHandle );
-		glGetShaderiv ( FSHandle, GL_COMPILE_STATUS, &Status );
+		glGetShaderiv ( ShaderHandle, GL_COMPILE_STATUS, &Status );
 		if ( Status == 0 )
 		{
 			// Collect the OpenGL log and throw the error
 			char LogString_C [512];
-			glGetShaderInfoLog ( FSHandle, 512, NULL, LogString_C );
-			glDeleteShader( FSHandle );
+			glGetShaderInfoLog ( ShaderHandle, 512, NULL, LogString_C );
+			ReleaseShaders ();
 			std::string LogString ( LogString_C );
-			throw RenderException ( "Can't compile fragment shader. OpenGL error log: " + LogString );
+			throw RenderException ( "Can't compile " + std::string ( Stage ) + " shader. OpenGL error log: " + LogString );
 		}
-		return FSHandle;
 	}
 
-	void Shader::LinkShaders( uint32_t VSHandle, uint32_t FSHandle )
+	void Shader::LinkShaders ()
 	{
 		// Attach shaders to created program and try to link it.
-		int Status = 0;
-		glAttachShader ( m_Handle, VSHandle );
-		glAttachShader ( m_Handle, FSHandle );
+		glAttachShader ( m_Handle, m_VSHandle );
+		glAttachShader ( m_Handle, m_FSHandle );
 		glLinkProgram ( m_Handle );
+	}
+
+	void Shader::CheckLink ()
+	{
+		int Status = 0;
 		glGetProgramiv (m_Handle, GL_LINK_STATUS, &Status );
 		if ( Status == 0 )
 		{
 			// Collect the OpenGL log and throw the error
 			char LogString_C [512];
 			glGetProgramInfoLog ( m_Handle, 512, NULL, LogString_C );
-			glDeleteShader ( VSHandle );
-			glDeleteShader ( FSHandle );
+			ReleaseShaders ();
 			std::string LogString ( LogString_C );
 			throw RenderException ( "Can't link shader program. OpenGL error log: " + LogString );
 		}
-		// Program was linked successfully. Delete single shaders.
-		glDeleteShader ( VSHandle );
-		glDeleteShader ( FSHandle );
 	}
 
-	void Shader::PopulateAttributes ()
+	void Shader::ReleaseShaders ()
 	{
-		// Variables to fetch attributes shader data
-		int AttributesCount = -1;
-		int AttributeNameLength;
-		char AttributeName[128];
-		int AttributeSize;
-		GLenum AttributeType;
-
-		// Activate shader and get active attribute count
-		glUseProgram ( m_Handle );
-		glGetProgramiv ( m_Handle, GL_ACTIVE_ATTRIBUTES, &AttributesCount );
+		glDeleteShader ( m_VSHandle );
+		glDeleteShader ( m_FSHandle );
+		m_VSHandle = 0;
+		m_FSHandle = 0;
+	}
 
-		for ( int i = 0; i < AttributesCount; i ++ )
+	void Shader::PopulateAttributes ()
+	{
+		int AttributesCount = 0;
+		char AttributeName [ 128 ];
+		if ( GLAD_GL_VERSION_4_3 )
+		{
+			// One query per attribute returns its location, no name lookups
+			glGetProgramInterfaceiv ( m_Handle, GL_PROGRAM_INPUT, GL_ACTIVE_RESOURCES, &AttributesCount );
+			const GLenum Property = GL_LOCATION;
+			for ( int i = 0; i < AttributesCount; i ++ )
+			{
+				GLint AttributeLocation = -1;
+				glGetProgramResourceiv ( m_Handle, GL_PROGRAM_INPUT, (GLuint)i, 1, &Property, 1, NULL, &AttributeLocation );
+				if ( AttributeLocation < 0 ) // Built-in inputs like gl_VertexID
+					continue;
+				glGetProgramResourceName ( m_Handle, GL_PROGRAM_INPUT, (GLuint)i, 128, NULL, AttributeName );
+				m_Attributes . Add ( AttributeName, (uint32_t)AttributeLocation );
+			}
+		}
+		else
 		{
-			// Fetch attribute data and write it into
-			std::memset (AttributeName, 0, sizeof ( char ) * 128 );
-			glGetActiveAttrib (m_Handle, (GLuint)i, 128,
-							   &AttributeNameLength, &AttributeSize, &AttributeType	, AttributeName);
-			int AttributeLocation = glGetAttribLocation (m_Handle, AttributeName );
-			if ( AttributeLocation >= 0 )
-				m_Attributes . insert ( { AttributeName, AttributeLocation } );
+			int AttributeSize;
+			GLenum AttributeType;
+			glGetProgramiv ( m_Handle, GL_ACTIVE_ATTRIBUTES, &AttributesCount );
+			for ( int i = 0; i < AttributesCount; i ++ )
+			{
+				glGetActiveAttrib ( m_Handle, (GLuint)i, 128, NULL, &AttributeSize, &AttributeType, AttributeName );
+				int AttributeLocation = glGetAttribLocation ( m_Handle, AttributeName );
+				if ( AttributeLocation >= 0 )
+					m_Attributes . Add ( AttributeName, (uint32_t)AttributeLocation );
+			}
 		}
-		glUseProgram ( 0 );
+		m_Attributes . Build ();
+		LK_RENDER_CHECK_ERROR()
 	}
 
 	void Shader::PopulateUniforms ()
 	{
-		// Variables to fetch uniforms shader data
-		int UniformsCount = -1;
-		int UniformNameLength;
-		std::string UniformName;
-		char UniformName_C [ 128 ];
-		int UniformSize;
-		GLenum UniformType;
+		// Every uniform is added by its full name ("pointLights[3].position"), an array is added by its name without
+		// the subscript as well ("pointLights"), and each element of an array of basic types by its subscripted name
+		const auto AddUniform = [ this ] ( std::string_view Name, GLint Location, GLint ArraySize )
+		{
+			const size_t FirstBracketPosition = Name . find ( '[' );
+			if ( FirstBracketPosition != std::string_view::npos )
+				m_Uniforms . Add ( Name . substr ( 0, FirstBracketPosition ), (uint32_t)Location );
+			m_Uniforms . Add ( Name, (uint32_t)Location );
+			if ( ArraySize <= 1 || Name . size () < 3 || Name . substr ( Name . size () - 3 ) != "[0]" )
+				return;
+			// The elements of an array of basic types take consecutive locations
+			const std::string_view ArrayName = Name . substr ( 0, Name . size () - 3 );
+			char ElementName [ 160 ];
+			for ( GLint j = 1; j < ArraySize; j ++ )
+			{
+				const int Length = std::snprintf ( ElementName, sizeof ( ElementName ), "%.*s[%d]", (int)ArrayName . size (), ArrayName . data (), (int)j );
+				m_Uniforms . Add ( std::string_view ( ElementName, (size_t)Length ), (uint32_t)( Location + j ) );
+			}
+		};
+
+		int UniformsCount = 0;
+		char UniformName [ 128 ];
+		if ( GLAD_GL_VERSION_4_3 )
+		{
+			// One query per uniform returns the location, the array size and the block index together
+			glGetProgramInterfaceiv ( m_Handle, GL_UNIFORM, GL_ACTIVE_RESOURCES, &UniformsCount );
+			const GLenum Properties[ 3 ] = { GL_LOCATION, GL_ARRAY_SIZE, GL_BLOCK_INDEX };
+			for ( int i = 0; i < UniformsCount; i ++ )
+			{
+				GLint Values[ 3 ] = { -1, 0, -1 };
+				glGetProgramResourceiv ( m_Handle, GL_UNIFORM, (GLuint)i, 3, Properties, 3, NULL, Values );
+				// The members of the uniform blocks have no location, they are reflected with their blocks
+				if ( Values[ 2 ] >= 0 || Values[ 0 ] < 0 )
+					continue;
+				GLsizei NameLength = 0;
+				glGetProgramResourceName ( m_Handle, GL_UNIFORM, (GLuint)i, 128, &NameLength, UniformName );
+				AddUniform ( std::string_view ( UniformName, (size_t)NameLength ), Values[ 0 ], Values[ 1 ] );
+			}
+		}
+		else
+		{
+			int UniformSize;
+			GLenum UniformType;
+			glGetProgramiv ( m_Handle, GL_ACTIVE_UNIFORMS, &UniformsCount );
+			for ( int i = 0; i < UniformsCount; i ++ )
+			{
+				GLsizei NameLength = 0;
+				glGetActiveUniform ( m_Handle, (GLuint)i, 128, &NameLength, &UniformSize, &UniformType, UniformName );
+				GLint BlockIndex = -1;
+				GLuint UniformIndex = (GLuint)i;
+				glGetActiveUniformsiv ( m_Handle, 1, &UniformIndex, GL_UNIFORM_BLOCK_INDEX, &BlockIndex );
+				if ( BlockIndex >= 0 )
+					continue;
+				const GLint UniformLocation = glGetUniformLocation ( m_Handle, UniformName );
+				if ( UniformLocation >= 0 )
+					AddUniform ( std::string_view ( UniformName, (size_t)NameLength ), UniformLocation, UniformSize );
+			}
+		}
+		m_Uniforms . Build ();
+		LK_RENDER_CHECK_ERROR()
+	}
 
-		glUseProgram ( m_Handle );
-		glGetProgramiv ( m_Handle, GL_ACTIVE_UNIFORMS, &UniformsCount );
+	void Shader::PopulateUniformBlocks ()
+	{
+		int BlocksCount = 0;
+		glGetProgramiv ( m_Handle, GL_ACTIVE_UNIFORM_BLOCKS, &BlocksCount );
 
-		for ( int i = 0; i < UniformsCount; i ++ )
+		for ( int i = 0; i < BlocksCount; i ++ )
 		{
-			memset ( UniformName_C, 0, sizeof ( char ) * 128  );
-			glGetActiveUniform ( m_Handle, (GLuint)i, 128,
-								 &UniformNameLength, &UniformSize, &UniformType, UniformName_C );
-			UniformName = UniformName_C;
-			GLint UniformLocation = glGetUniformLocation ( m_Handle, UniformName.c_str() );
-			std::string UniformNameChopped = UniformName;
-			size_t FirstArrayBracketPosition = UniformName.find ( '[' );
-			size_t SecondArrayBracketPosition = UniformName . find ( ']' );
-			if ( FirstArrayBracketPosition != std::string::npos )
+			char BlockName_C [ 128 ] = {};
+			GLint Size = 0;
+			GLint Binding = 0;
+			GLint MembersCount = 0;
+			glGetActiveUniformBlockName ( m_Handle, (GLuint)i, 128, NULL, BlockName_C );
+			glGetActiveUniformBlockiv ( m_Handle, (GLuint)i, GL_UNIFORM_BLOCK_DATA_SIZE, &Size );
+			glGetActiveUniformBlockiv ( m_Handle, (GLuint)i, GL_UNIFORM_BLOCK_BINDING, &Binding );
+			glGetActiveUniformBlockiv ( m_Handle, (GLuint)i, GL_UNIFORM_BLOCK_ACTIVE_UNIFORMS, &MembersCount );
+
+			ShaderUniformBlockData Block { BlockName_C, (uint32_t)i, (uint32_t)Size, (uint32_t)Binding, {} };
+			std::vector<GLint> MemberIndices ( MembersCount );
+			std::vector<GLint> MemberOffsets ( MembersCount );
+			if ( MembersCount > 0 )
+			{
+				glGetActiveUniformBlockiv ( m_Handle, (GLuint)i, GL_UNIFORM_BLOCK_ACTIVE_UNIFORM_INDICES, MemberIndices.data() );
+				glGetActiveUniformsiv ( m_Handle, MembersCount, (const GLuint *)MemberIndices.data(), GL_UNIFORM_OFFSET, MemberOffsets.data() );
+			}
+			for ( int j = 0; j < MembersCount; j ++ )
 			{
-				UniformNameChopped.erase ( UniformNameChopped.begin() + FirstArrayBracketPosition, UniformNameChopped.end() );
-				std::string_view UniformNameBegin ( UniformName.begin(), UniformName.begin() + FirstArrayBracketPosition );
-				std::string_view UniformNameEnd ( UniformName.begin() + SecondArrayBracketPosition, UniformName.end() );
-
-				for ( int j = 0; j <= 256; j ++ )
-				{
-					std::ostringstream StringBuilder;
-					StringBuilder << UniformNameBegin << '[' << j << UniformNameEnd;
-					GLint UniformArrayLocation = glGetUniformLocation ( m_Handle, StringBuilder.str().c_str() );
-					if ( UniformArrayLocation < 0 )
-						break;
-					m_Uniforms . insert ( { StringBuilder.str(), UniformArrayLocation } );
-				}
+				char MemberName_C [ 128 ] = {};
+				glGetActiveUniformName ( m_Handle, (GLuint)MemberIndices[ j ], 128, NULL, MemberName_C );
+				Block . Offsets . insert ( { MemberName_C, (uint32_t)MemberOffsets[ j ] } );
 			}
-			m_Uniforms . insert ( { UniformNameChopped, UniformLocation } );
+			m_UniformBlocks . insert ( { Block . Name, std::move ( Block ) } );
 		}
+		LK_RENDER_CHECK_ERROR()
 	}
 } // gfx
 } // lk
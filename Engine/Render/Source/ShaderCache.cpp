@@ -0,0 +1,339 @@
+#include "glad/glad.h"
+#include "Laniakea/Render/ShaderCache.h"
+#include "Laniakea/Render/RenderException.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+
+namespace lk
+{
+namespace gfx
+{
+
+namespace
+{
+
+constexpr uint64_t FNVOffsetBasis = 14695981039346656037ull;
+constexpr uint64_t FNVPrime = 1099511628211ull;
+
+uint64_t HashBytes ( uint64_t Hash, const void * Data, size_t Size )
+{
+	const auto * Bytes = static_cast <const unsigned char *> ( Data );
+	for ( size_t i = 0; i < Size; i ++ )
+	{
+		Hash ^= Bytes[ i ];
+		Hash *= FNVPrime;
+	}
+	return Hash;
+}
+
+// The length goes first, so "ab" + "c" and "a" + "bc" hash differently
+uint64_t HashString ( uint64_t Hash, const std::string & String )
+{
+	const uint64_t Length = String . size ();
+	Hash = HashBytes ( Hash, & Length, sizeof ( Length ) );
+	return HashBytes ( Hash, String . data (), String . size () );
+}
+
+std::string GetGLString ( GLenum Name )
+{
+	const auto * String = reinterpret_cast <const char *> ( glGetString ( Name ) );
+	return String != nullptr ? String : "";
+}
+
+class EntryWriter
+{
+	public:
+		template <typename T>
+		void Write ( const T & Value )
+		{
+			const auto * Bytes = reinterpret_cast <const char *> ( & Value );
+			m_Data . insert ( m_Data . end (), Bytes, Bytes + sizeof ( T ) );
+		}
+
+		void Write ( const std::string & String )
+		{
+			Write ( ( uint32_t ) String . size () );
+			m_Data . insert ( m_Data . end (), String . begin (), String . end () );
+		}
+
+		void Write ( const std::vector<char> & Bytes )
+		{
+			Write ( ( uint32_t ) Bytes . size () );
+			m_Data . insert ( m_Data . end (), Bytes . begin (), Bytes . end () );
+		}
+
+		const std::vector<char> & GetData () const
+		{
+			return m_Data;
+		}
+
+	private:
+		std::vector<char> m_Data;
+};
+
+// Every read is bounds checked, a truncated entry fails the load instead of reading past the data
+class EntryReader
+{
+	public:
+		explicit EntryReader ( const std::vector<char> & Data )
+		: m_Data ( Data ), m_Position ( 0 )
+		{
+		}
+
+		template <typename T>
+		bool Read ( T & Value )
+		{
+			if ( m_Data . size () - m_Position < sizeof ( T ) )
+				return false;
+			std::memcpy ( & Value, m_Data . data () + m_Position, sizeof ( T ) );
+			m_Position += sizeof ( T );
+			return true;
+		}
+
+		bool Read ( std::string & String )
+		{
+			uint32_t Size = 0;
+			if ( ! Read ( Size ) || m_Data . size () - m_Position < Size )
+				return false;
+			String . assign ( m_Data . data () + m_Position, Size );
+			m_Position += Size;
+			return true;
+		}
+
+		bool Read ( std::vector<char> & Bytes )
+		{
+			uint32_t Size = 0;
+			if ( ! Read ( Size ) || m_Data . size () - m_Position < Size )
+				return false;
+			Bytes . assign ( m_Data . begin () + m_Position, m_Data . begin () + m_Position + Size );
+			m_Position += Size;
+			return true;
+		}
+
+		bool ReadTable ( std::map<std::string, uint32_t> & Table )
+		{
+			uint32_t Count = 0;
+			if ( ! Read ( Count ) )
+				return false;
+			for ( uint32_t i = 0; i < Count; i ++ )
+			{
+				std::string Name;
+				uint32_t Value = 0;
+				if ( ! Read ( Name ) || ! Read ( Value ) )
+					return false;
+				Table . insert ( { std::move ( Name ), Value } );
+			}
+			return true;
+		}
+
+		bool ReadTable ( ShaderLocationTable & Table )
+		{
+			uint32_t Count = 0;
+			if ( ! Read ( Count ) || ( m_Data . size () - m_Position ) / sizeof ( ShaderLocationTable::Entry ) < Count )
+				return false;
+			std::vector<ShaderLocationTable::Entry> Entries ( Count );
+			for ( auto & Item : Entries )
+				Read ( Item );
+			std::vector<std::string> Names ( Count );
+			for ( auto & Name : Names )
+			{
+				if ( ! Read ( Name ) )
+					return false;
+			}
+			return Table . Assign ( std::move ( Entries ), std::move ( Names ) );
+		}
+
+	private:
+		const std::vector<char> & m_Data;
+		size_t m_Position;
+};
+
+void WriteTable ( EntryWriter & Writer, const std::map<std::string, uint32_t> & Table )
+{
+	Writer . Write ( ( uint32_t ) Table . size () );
+	for ( const auto & [ Name, Value ] : Table )
+	{
+		Writer . Write ( Name );
+		Writer . Write ( Value );
+	}
+}
+
+void WriteTable ( EntryWriter & Writer, const ShaderLocationTable & Table )
+{
+	Writer . Write ( ( uint32_t ) Table . GetSize () );
+	for ( const auto & Item : Table . GetEntries () )
+		Writer . Write ( Item );
+	for ( const auto & Name : Table . GetNames () )
+		Writer . Write ( Name );
+}
+
+} // namespace
+
+ShaderCache::ShaderCache ( const std::string & Directory )
+: m_Directory ( Directory ), m_DriverHash ( FNVOffsetBasis ), m_HitsCount ( 0 ), m_MissesCount ( 0 )
+{
+	std::error_code Error;
+	std::filesystem::create_directories ( m_Directory, Error );
+	if ( Error )
+		throw RenderException ( "Can't create the shader cache directory " + m_Directory + ": " + Error . message () );
+
+	m_DriverHash = HashString ( m_DriverHash, GetGLString ( GL_VENDOR ) );
+	m_DriverHash = HashString ( m_DriverHash, GetGLString ( GL_RENDERER ) );
+	m_DriverHash = HashString ( m_DriverHash, GetGLString ( GL_VERSION ) );
+
+	GLint FormatsCount = 0;
+	glGetIntegerv ( GL_NUM_PROGRAM_BINARY_FORMATS, & FormatsCount );
+	if ( FormatsCount > 0 )
+	{
+		m_BinaryFormats . resize ( FormatsCount );
+		glGetIntegerv ( GL_PROGRAM_BINARY_FORMATS, m_BinaryFormats . data () );
+	}
+	LK_RENDER_CHECK_ERROR()
+}
+
+uint64_t ShaderCache::GetKey ( const std::string & VertexSource, const std::string & FragmentSource ) const
+{
+	uint64_t Key = HashBytes ( FNVOffsetBasis, & m_DriverHash, sizeof ( m_DriverHash ) );
+	Key = HashString ( Key, VertexSource );
+	return HashString ( Key, FragmentSource );
+}
+
+bool ShaderCache::Load ( uint64_t Key, uint32_t Program, ShaderLocationTable & Attributes,
+						 ShaderLocationTable & Uniforms, std::map<std::string, ShaderUniformBlockData> & UniformBlocks )
+{
+	const bool IsLoaded = LoadEntry ( Key, Program, Attributes, Uniforms, UniformBlocks );
+	if ( IsLoaded )
+		m_HitsCount ++;
+	else
+		m_MissesCount ++;
+	return IsLoaded;
+}
+
+bool ShaderCache::LoadEntry ( uint64_t Key, uint32_t Program, ShaderLocationTable & Attributes,
+							  ShaderLocationTable & Uniforms, std::map<std::string, ShaderUniformBlockData> & UniformBlocks ) const
+{
+	if ( ! GetIsSupported () )
+		return false;
+	std::ifstream File ( GetPath ( Key ), std::ios::binary );
+	if ( ! File )
+		return false;
+	const std::vector<char> Data { std::istreambuf_iterator<char> ( File ), std::istreambuf_iterator<char> () };
+
+	// The tables are parsed into temporaries, so a failed load leaves the shader's tables untouched
+	EntryReader Reader ( Data );
+	uint32_t EntryMagic = 0, EntryVersion = 0, BlocksCount = 0;
+	uint64_t EntryKey = 0;
+	int32_t Format = 0;
+	std::vector<char> Binary;
+	ShaderLocationTable LoadedAttributes, LoadedUniforms;
+	std::map<std::string, ShaderUniformBlockData> LoadedBlocks;
+	if ( ! Reader . Read ( EntryMagic ) || EntryMagic != Magic || ! Reader . Read ( EntryVersion ) || EntryVersion != Version
+		 || ! Reader . Read ( EntryKey ) || EntryKey != Key || ! Reader . Read ( Format ) || ! Reader . Read ( Binary )
+		 || ! Reader . ReadTable ( LoadedAttributes ) || ! Reader . ReadTable ( LoadedUniforms ) || ! Reader . Read ( BlocksCount ) )
+		return false;
+	for ( uint32_t i = 0; i < BlocksCount; i ++ )
+	{
+		ShaderUniformBlockData Block;
+		if ( ! Reader . Read ( Block . Name ) || ! Reader . Read ( Block . Index ) || ! Reader . Read ( Block . Size )
+			 || ! Reader . Read ( Block . Binding ) || ! Reader . ReadTable ( Block . Offsets ) )
+			return false;
+		LoadedBlocks . insert ( { Block . Name, std::move ( Block ) } );
+	}
+
+	// An unknown format would raise GL_INVALID_ENUM, a known one the driver can't use fails the link status
+	if ( std::find ( m_BinaryFormats . begin (), m_BinaryFormats . end (), Format ) == m_BinaryFormats . end () )
+		return false;
+	glProgramBinary ( Program, ( GLenum ) Format, Binary . data (), ( GLsizei ) Binary . size () );
+	GLint Status = 0;
+	glGetProgramiv ( Program, GL_LINK_STATUS, & Status );
+	LK_RENDER_CHECK_ERROR()
+	if ( Status == 0 )
+		return false;
+
+	Attributes = std::move ( LoadedAttributes );
+	Uniforms = std::move ( LoadedUniforms );
+	UniformBlocks = std::move ( LoadedBlocks );
+	return true;
+}
+
+void ShaderCache::Store ( uint64_t Key, uint32_t Program, const ShaderLocationTable & Attributes,
+						  const ShaderLocationTable & Uniforms, const std::map<std::string, ShaderUniformBlockData> & UniformBlocks )
+{
+	if ( ! GetIsSupported () )
+		return;
+	GLint Length = 0;
+	glGetProgramiv ( Program, GL_PROGRAM_BINARY_LENGTH, & Length );
+	if ( Length <= 0 )
+		return;
+	std::vector<char> Binary ( Length );
+	GLenum Format = 0;
+	glGetProgramBinary ( Program, Length, & Length, & Format, Binary . data () );
+	LK_RENDER_CHECK_ERROR()
+	Binary . resize ( Length );
+
+	EntryWriter Writer;
+	Writer . Write ( Magic );
+	Writer . Write ( Version );
+	Writer . Write ( Key );
+	Writer . Write ( ( int32_t ) Format );
+	Writer . Write ( Binary );
+	WriteTable ( Writer, Attributes );
+	WriteTable ( Writer, Uniforms );
+	Writer . Write ( ( uint32_t ) UniformBlocks . size () );
+	for ( const auto & [ Name, Block ] : UniformBlocks )
+	{
+		Writer . Write ( Block . Name );
+		Writer . Write ( Block . Index );
+		Writer . Write ( Block . Size );
+		Writer . Write ( Block . Binding );
+		WriteTable ( Writer, Block . Offsets );
+	}
+
+	// Written to a temporary file and renamed, so a crash mid write doesn't leave a truncated entry behind
+	const std::string Path = GetPath ( Key );
+	const std::string TemporaryPath = Path + ".tmp";
+	{
+		std::ofstream File ( TemporaryPath, std::ios::binary | std::ios::trunc );
+		if ( ! File )
+			return;
+		File . write ( Writer . GetData () . data (), ( std::streamsize ) Writer . GetData () . size () );
+		if ( ! File )
+			return;
+	}
+	std::error_code Error;
+	std::filesystem::rename ( TemporaryPath, Path, Error );
+}
+
+bool ShaderCache::GetIsSupported () const
+{
+	return ! m_BinaryFormats . empty ();
+}
+
+const std::string & ShaderCache::GetDirectory () const
+{
+	return m_Directory;
+}
+
+unsigned int ShaderCache::GetHitsCount () const
+{
+	return m_HitsCount;
+}
+
+unsigned int ShaderCache::GetMissesCount () const
+{
+	return m_MissesCount;
+}
+
+std::string ShaderCache::GetPath ( uint64_t Key ) const
+{
+	char FileName [ 32 ];
+	std::snprintf ( FileName, sizeof ( FileName ), "%016llx.lkshader", ( unsigned long long ) Key );
+	return ( std::filesystem::path ( m_Directory ) / FileName ) . string ();
+}
+
+} // namespace gfx
+} // namespace lk
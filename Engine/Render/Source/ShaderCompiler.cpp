@@ -0,0 +1,147 @@
+#include "glad/glad.h"
+#include "Laniakea/Render/ShaderCompiler.h"
+#include "Laniakea/Render/RenderException.h"
+#include <algorithm>
+#include <cstring>
+
+namespace lk
+{
+namespace gfx
+{
+
+namespace
+{
+
+// The ARB extension is the same with the enums suffixed _ARB
+bool GetIsParallelCompileSupported ()
+{
+	GLint ExtensionsCount = 0;
+	glGetIntegerv ( GL_NUM_EXTENSIONS, &ExtensionsCount );
+	for ( GLint i = 0; i < ExtensionsCount; i ++ )
+	{
+		const auto * Extension = reinterpret_cast <const char *> ( glGetStringi ( GL_EXTENSIONS, (GLuint)i ) );
+		if ( Extension != nullptr && ( std::strcmp ( Extension, "GL_KHR_parallel_shader_compile" ) == 0
+									   || std::strcmp ( Extension, "GL_ARB_parallel_shader_compile" ) == 0 ) )
+			return true;
+	}
+	return false;
+}
+
+} // namespace
+
+ShaderHandle::ShaderHandle ( std::shared_ptr<State> SharedState )
+: m_State ( std::move ( SharedState ) )
+{
+}
+
+bool ShaderHandle::GetIsReady () const
+{
+	return m_State != nullptr && m_State -> CurrentStatus == Status::Ready;
+}
+
+bool ShaderHandle::GetIsFailed () const
+{
+	return m_State != nullptr && m_State -> CurrentStatus == Status::Failed;
+}
+
+const std::string & ShaderHandle::GetError () const
+{
+	static const std::string NoError;
+	return m_State != nullptr ? m_State -> Error : NoError;
+}
+
+const Shader & ShaderHandle::Get () const
+{
+	if ( m_State == nullptr )
+		throw RenderException ( "The shader handle wasn't returned by ShaderCompiler::Submit" );
+	return m_State -> CurrentStatus == Status::Ready ? * m_State -> Program : * m_State -> Fallback;
+}
+
+ShaderCompiler::ShaderCompiler ( const Shader & Fallback, ShaderCache * Cache )
+: m_Fallback ( Fallback ), m_Cache ( Cache ), m_IsParallel ( GetIsParallelCompileSupported () )
+{
+	LK_RENDER_CHECK_ERROR()
+}
+
+ShaderHandle ShaderCompiler::Submit ( const std::string & VertexShader, const std::string & FragmentShader )
+{
+	auto SubmittedState = std::make_shared<ShaderHandle::State> ();
+	SubmittedState -> Fallback = & m_Fallback;
+	SubmittedState -> CurrentStatus = ShaderHandle::Status::Pending;
+	try
+	{
+		SubmittedState -> Program . reset ( new Shader ( Shader::DeferredLoad {} ) );
+		if ( SubmittedState -> Program -> Submit ( VertexShader, FragmentShader, m_Cache ) )
+			SubmittedState -> CurrentStatus = ShaderHandle::Status::Ready;
+		else
+			m_Pending . push_back ( SubmittedState );
+		LK_RENDER_CHECK_ERROR()
+	}
+	catch ( const RenderException & Exception )
+	{
+		// The handle fails as a failed compilation would, the program pushed as pending is dropped with it
+		if ( ! m_Pending . empty () && m_Pending . back () == SubmittedState )
+			m_Pending . pop_back ();
+		SubmittedState -> Error = Exception . what ();
+		SubmittedState -> Program . reset ();
+		SubmittedState -> CurrentStatus = ShaderHandle::Status::Failed;
+	}
+	return ShaderHandle ( std::move ( SubmittedState ) );
+}
+
+size_t ShaderCompiler::Poll ()
+{
+	if ( m_Pending . empty () )
+		return 0;
+	if ( ! m_IsParallel )
+	{
+		// The status query of the oldest program blocks until it is linked, one stall per call
+		Complete ( * m_Pending . front () );
+		m_Pending . erase ( m_Pending . begin () );
+		return m_Pending . size ();
+	}
+	const auto Completed = std::remove_if ( m_Pending . begin (), m_Pending . end (), [] ( const auto & PendingState )
+	{
+		if ( ! PendingState -> Program -> GetIsLinkCompleted () )
+			return false;
+		Complete ( * PendingState );
+		return true;
+	} );
+	m_Pending . erase ( Completed, m_Pending . end () );
+	return m_Pending . size ();
+}
+
+void ShaderCompiler::Finish ()
+{
+	for ( const auto & PendingState : m_Pending )
+		Complete ( * PendingState );
+	m_Pending . clear ();
+}
+
+size_t ShaderCompiler::GetPendingCount () const
+{
+	return m_Pending . size ();
+}
+
+bool ShaderCompiler::GetIsParallel () const
+{
+	return m_IsParallel;
+}
+
+void ShaderCompiler::Complete ( ShaderHandle::State & PendingState )
+{
+	try
+	{
+		PendingState . Program -> Finish ();
+		PendingState . CurrentStatus = ShaderHandle::Status::Ready;
+	}
+	catch ( const RenderException & Exception )
+	{
+		PendingState . Error = Exception . what ();
+		PendingState . Program . reset ();
+		PendingState . CurrentStatus = ShaderHandle::Status::Failed;
+	}
+}
+
+} // namespace gfx
+} // namespace lk
@@ -0,0 +1,120 @@
+#include "Laniakea/Render/ShaderLocationTable.h"
+#include <algorithm>
+#include <numeric>
+
+namespace lk
+{
+namespace gfx
+{
+
+void ShaderLocationTable::Add ( std::string_view Name, uint32_t Location )
+{
+	m_Entries . push_back ( { MakeUniformId ( Name ) . Hash, Location } );
+	m_Names . emplace_back ( Name );
+}
+
+void ShaderLocationTable::Build ()
+{
+	// The stable sort keeps the first location added for a repeated name in front, the colliding names are ordered
+	// by the name within their id
+	std::vector<size_t> Order ( m_Entries . size () );
+	std::iota ( Order . begin (), Order . end (), size_t ( 0 ) );
+	std::stable_sort ( Order . begin (), Order . end (), [ this ] ( size_t Left, size_t Right )
+	{
+		if ( m_Entries[ Left ] . Id != m_Entries[ Right ] . Id )
+			return m_Entries[ Left ] . Id < m_Entries[ Right ] . Id;
+		return m_Names[ Left ] < m_Names[ Right ];
+	} );
+
+	std::vector<Entry> Sorted;
+	std::vector<std::string> SortedNames;
+	Sorted . reserve ( Order . size () );
+	SortedNames . reserve ( Order . size () );
+	for ( size_t i = 0; i < Order . size (); i ++ )
+	{
+		// The previous name has been moved already
+		if ( i > 0 && m_Entries[ Order[ i ] ] . Id == Sorted . back () . Id && m_Names[ Order[ i ] ] == SortedNames . back () )
+			continue;
+		Sorted . push_back ( m_Entries[ Order[ i ] ] );
+		SortedNames . push_back ( std::move ( m_Names[ Order[ i ] ] ) );
+	}
+	m_Entries = std::move ( Sorted );
+	m_Names = std::move ( SortedNames );
+}
+
+bool ShaderLocationTable::Assign ( std::vector<Entry> Entries, std::vector<std::string> Names )
+{
+	if ( Entries . size () != Names . size () )
+		return false;
+	for ( size_t i = 0; i < Entries . size (); i ++ )
+	{
+		if ( MakeUniformId ( Names[ i ] ) . Hash != Entries[ i ] . Id )
+			return false;
+		if ( i > 0 && ( Entries[ i - 1 ] . Id > Entries[ i ] . Id || ( Entries[ i - 1 ] . Id == Entries[ i ] . Id && Names[ i - 1 ] >= Names[ i ] ) ) )
+			return false;
+	}
+	m_Entries = std::move ( Entries );
+	m_Names = std::move ( Names );
+	return true;
+}
+
+int32_t ShaderLocationTable::Find ( UniformId Id ) const
+{
+	const size_t Index = FindIndex ( Id . Hash );
+	if ( Index == m_Entries . size () )
+		return -1;
+	// The id shared by several names of the shader doesn't tell which one is meant
+	if ( Index + 1 < m_Entries . size () && m_Entries[ Index + 1 ] . Id == Id . Hash )
+		return -1;
+	return ( int32_t ) m_Entries[ Index ] . Location;
+}
+
+int32_t ShaderLocationTable::Find ( std::string_view Name ) const
+{
+	const uint32_t Id = MakeUniformId ( Name ) . Hash;
+	for ( size_t Index = FindIndex ( Id ); Index < m_Entries . size () && m_Entries[ Index ] . Id == Id; Index ++ )
+	{
+		if ( m_Names[ Index ] == Name )
+			return ( int32_t ) m_Entries[ Index ] . Location;
+	}
+	return -1;
+}
+
+bool ShaderLocationTable::GetIsExists ( UniformId Id ) const
+{
+	return Find ( Id ) >= 0;
+}
+
+bool ShaderLocationTable::GetIsExists ( std::string_view Name ) const
+{
+	return Find ( Name ) >= 0;
+}
+
+const std::vector<ShaderLocationTable::Entry> & ShaderLocationTable::GetEntries () const
+{
+	return m_Entries;
+}
+
+const std::vector<std::string> & ShaderLocationTable::GetNames () const
+{
+	return m_Names;
+}
+
+size_t ShaderLocationTable::GetSize () const
+{
+	return m_Entries . size ();
+}
+
+size_t ShaderLocationTable::FindIndex ( uint32_t Id ) const
+{
+	const auto Found = std::lower_bound ( m_Entries . begin (), m_Entries . end (), Id, [] ( const Entry & Item, uint32_t Hash )
+	{
+		return Item . Id < Hash;
+	} );
+	if ( Found == m_Entries . end () || Found -> Id != Id )
+		return m_Entries . size ();
+	return ( size_t ) ( Found - m_Entries . begin () );
+}
+
+} // namespace gfx
+} // namespace lk
@@ -0,0 +1,175 @@
+#include "glad/glad.h"
+#include "Laniakea/Render/StreamBuffer.h"
+#include "Laniakea/Render/GLStateCache.h"
+#include "Laniakea/Render/RenderException.h"
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+namespace lk
+{
+namespace gfx
+{
+
+StreamBuffer::StreamBuffer ( unsigned int Capacity )
+: m_Handle ( 0 ), m_Capacity ( Capacity ), m_Head ( 0 ), m_PendingBegin ( 0 ), m_WaitsCount ( 0 ), m_Mapped ( nullptr )
+{
+	if ( m_Capacity == 0 )
+		throw RenderException ( "Stream buffer capacity must be positive" );
+
+	glGenBuffers ( 1, & m_Handle );
+	// Bound to the copy target, the array and element bindings of the bound vertex array are left alone
+	GLStateCache::GetCurrent () . BindBuffer ( GL_COPY_WRITE_BUFFER, m_Handle );
+	if ( GLAD_GL_VERSION_4_4 )
+	{
+		const GLbitfield Flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+		glBufferStorage ( GL_COPY_WRITE_BUFFER, m_Capacity, nullptr, Flags );
+		m_Mapped = ( unsigned char * ) glMapBufferRange ( GL_COPY_WRITE_BUFFER, 0, m_Capacity, Flags );
+		if ( m_Mapped == nullptr )
+			throw RenderException ( "Can't map the stream buffer persistently" );
+	}
+	else
+		glBufferData ( GL_COPY_WRITE_BUFFER, m_Capacity, nullptr, GL_STREAM_DRAW );
+	LK_RENDER_CHECK_ERROR()
+}
+
+StreamBuffer::~StreamBuffer ()
+{
+	ReleaseFences ();
+	auto & Cache = GLStateCache::GetCurrent ();
+	if ( m_Mapped != nullptr )
+	{
+		Cache . BindBuffer ( GL_COPY_WRITE_BUFFER, m_Handle );
+		glUnmapBuffer ( GL_COPY_WRITE_BUFFER );
+	}
+	Cache . OnBufferDeleted ( m_Handle );
+	glDeleteBuffers ( 1, & m_Handle );
+}
+
+StreamBuffer::Range StreamBuffer::Write ( const void * Data, unsigned int Size, unsigned int Alignment )
+{
+	if ( Size > m_Capacity )
+		throw RenderException ( "Write of " + std::to_string ( Size ) + " bytes exceeds the stream buffer capacity of "
+								+ std::to_string ( m_Capacity ) + " bytes" );
+	if ( Alignment == 0 )
+		Alignment = 1;
+
+	uint64_t Begin = ( ( uint64_t ) m_Head + Alignment - 1 ) / Alignment * Alignment;
+	if ( Begin + Size > m_Capacity )
+	{
+		Begin = 0;
+		if ( m_Mapped != nullptr )
+		{
+			// The ranges fenced so far are behind the head, the wait below finds the ones the wrapped write reaches
+			Fence ();
+		}
+		else
+		{
+			// Orphaning, the draws in flight keep reading the old storage
+			GLStateCache::GetCurrent () . BindBuffer ( GL_COPY_WRITE_BUFFER, m_Handle );
+			glBufferData ( GL_COPY_WRITE_BUFFER, m_Capacity, nullptr, GL_STREAM_DRAW );
+		}
+		m_PendingBegin = 0;
+	}
+	const Range Written { ( unsigned int ) Begin, Size };
+
+	if ( m_Mapped != nullptr )
+	{
+		WaitForRange ( Written . Offset, Written . Offset + Size );
+		std::memcpy ( m_Mapped + Written . Offset, Data, Size );
+	}
+	else if ( Size != 0 )
+	{
+		// The storage is never rewritten before the orphaning, so the map doesn't need to synchronize
+		GLStateCache::GetCurrent () . BindBuffer ( GL_COPY_WRITE_BUFFER, m_Handle );
+		void * Mapped = glMapBufferRange ( GL_COPY_WRITE_BUFFER, Written . Offset, Size,
+										   GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT );
+		if ( Mapped == nullptr )
+			throw RenderException ( "Can't map the stream buffer range" );
+		std::memcpy ( Mapped, Data, Size );
+		glUnmapBuffer ( GL_COPY_WRITE_BUFFER );
+	}
+	m_Head = Written . Offset + Size;
+	LK_RENDER_CHECK_ERROR()
+	return Written;
+}
+
+void StreamBuffer::CopyTo ( unsigned int Buffer, unsigned int Offset, const void * Data, unsigned int Size )
+{
+	if ( Size == 0 )
+		return;
+	const auto Staged = Write ( Data, Size, 4 );
+	auto & Cache = GLStateCache::GetCurrent ();
+	Cache . BindBuffer ( GL_COPY_READ_BUFFER, m_Handle );
+	Cache . BindBuffer ( GL_COPY_WRITE_BUFFER, Buffer );
+	glCopyBufferSubData ( GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, Staged . Offset, Offset, Size );
+	LK_RENDER_CHECK_ERROR()
+}
+
+void StreamBuffer::Fence ()
+{
+	// The fallback path never rewrites a range of the same storage, there's nothing to guard
+	if ( m_Mapped != nullptr && m_Head != m_PendingBegin )
+		m_Fences . push_back ( { m_PendingBegin, m_Head, glFenceSync ( GL_SYNC_GPU_COMMANDS_COMPLETE, 0 ) } );
+	m_PendingBegin = m_Head;
+}
+
+void StreamBuffer::WaitForRange ( unsigned int Begin, unsigned int End )
+{
+	// The fences are signaled in order, waiting for the newest overlapping one releases all older ones as well
+	size_t Count = 0;
+	for ( size_t i = 0; i < m_Fences . size (); i ++ )
+	{
+		if ( m_Fences[ i ] . Begin < End && Begin < m_Fences[ i ] . End )
+			Count = i + 1;
+	}
+	if ( Count == 0 )
+		return;
+
+	GLsync Sync = ( GLsync ) m_Fences[ Count - 1 ] . Sync;
+	GLenum Result = glClientWaitSync ( Sync, GL_SYNC_FLUSH_COMMANDS_BIT, 0 );
+	if ( Result == GL_TIMEOUT_EXPIRED )
+	{
+		m_WaitsCount ++;
+		while ( Result == GL_TIMEOUT_EXPIRED )
+			Result = glClientWaitSync ( Sync, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000 );
+	}
+	if ( Result == GL_WAIT_FAILED )
+		throw RenderException ( "Waiting for the stream buffer fence failed" );
+
+	for ( size_t i = 0; i < Count; i ++ )
+	{
+		glDeleteSync ( ( GLsync ) m_Fences . front () . Sync );
+		m_Fences . pop_front ();
+	}
+}
+
+void StreamBuffer::ReleaseFences ()
+{
+	for ( const auto & Fenced : m_Fences )
+		glDeleteSync ( ( GLsync ) Fenced . Sync );
+	m_Fences . clear ();
+}
+
+unsigned int StreamBuffer::GetHandle () const
+{
+	return m_Handle;
+}
+
+unsigned int StreamBuffer::GetCapacity () const
+{
+	return m_Capacity;
+}
+
+bool StreamBuffer::GetIsPersistent () const
+{
+	return m_Mapped != nullptr;
+}
+
+unsigned int StreamBuffer::GetWaitsCount () const
+{
+	return m_WaitsCount;
+}
+
+} // namespace gfx
+} // namespace lk
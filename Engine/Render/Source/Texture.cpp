@@ -1,8 +1,20 @@
 #include "Laniakea/Render/Texture.h"
 #include "Laniakea/Render/RenderException.h"
+#include "Laniakea/Render/GLStateCache.h"
+#include "Laniakea/Render/CompressedImage.h"
 #include "glad/glad.h"
 #include "stb/stb_image.h"
 
+// EXT_texture_compression_s3tc and its sRGB variant, not a part of the core profile
+#ifndef GL_COMPRESSED_RGBA_S3TC_DXT1_EXT
+	#define GL_COMPRESSED_RGBA_S3TC_DXT1_EXT 0x83F1
+	#define GL_COMPRESSED_RGBA_S3TC_DXT5_EXT 0x83F3
+#endif
+#ifndef GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT1_EXT
+	#define GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT1_EXT 0x8C4D
+	#define GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT 0x8C4F
+#endif
+
 
 namespace lk
 {
@@ -10,13 +22,26 @@ namespace gfx
 {
 
 Texture::Texture ( const std::string & Path )
-: m_Width ( 0 ), m_Height ( 0 ), m_Channels ( 0 ), m_Handle ( 0 ) {
+: m_Width ( 0 ), m_Height ( 0 ), m_Channels ( 0 ), m_Handle ( 0 ), m_IsLoaded ( false ) {
 	glGenTextures ( 1, &m_Handle );
 	Load ( Path );
 }
 
+Texture::Texture ( Placeholder )
+: m_Width ( 1 ), m_Height ( 1 ), m_Channels ( 4 ), m_Handle ( 0 ), m_IsLoaded ( false ) {
+	glGenTextures ( 1, &m_Handle );
+	const unsigned char PlaceholderColor [ 4 ] = { 128, 128, 128, 255 };
+	GLStateCache::GetCurrent () . BindTexture ( 0, GL_TEXTURE_2D, m_Handle );
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, PlaceholderColor);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	GLStateCache::GetCurrent () . BindTexture ( 0, GL_TEXTURE_2D, 0 );
+	LK_RENDER_CHECK_ERROR()
+}
+
 Texture::~Texture ()
 {
+	GLStateCache::GetCurrent () . OnTextureDeleted ( m_Handle );
 	glDeleteTextures ( 1, &m_Handle );
 }
 
@@ -25,8 +50,28 @@ unsigned int Texture::GetHandle () const
 	return m_Handle;
 }
 
+unsigned int Texture::GetWidth () const
+{
+	return m_Width;
+}
+
+unsigned int Texture::GetHeight () const
+{
+	return m_Height;
+}
+
+bool Texture::GetIsLoaded () const
+{
+	return m_IsLoaded;
+}
+
 void Texture::Load ( const std::string & Path )
 {
+	if ( GetIsCompressedImageFile ( Path ) )
+	{
+		Upload ( LoadCompressedImage ( Path ), Path );
+		return;
+	}
 	int Width, Height, NOfChannels;
 	unsigned char * TextureData = stbi_load(Path.c_str(), &Width, &Height, &NOfChannels, 0);
 
@@ -35,18 +80,26 @@ void Texture::Load ( const std::string & Path )
 		stbi_image_free(TextureData);
 		throw RenderException ( "Can't load texture from given path: " + Path );
 	}
-	glBindTexture ( GL_TEXTURE_2D, m_Handle );
+	Upload ( Width, Height, NOfChannels, TextureData );
+	stbi_image_free(TextureData);
+}
+
+void Texture::Upload ( unsigned int Width, unsigned int Height, unsigned int Channels, const void * Pixels )
+{
+	GLStateCache::GetCurrent () . BindTexture ( 0, GL_TEXTURE_2D, m_Handle );
 
 	GLenum TextureFormat = GL_RGB;
-	if (NOfChannels == 1)
+	if (Channels == 1)
 		TextureFormat = GL_RED;
-	else if (NOfChannels == 3)
+	else if (Channels == 3)
 		TextureFormat = GL_RGB;
-	else if (NOfChannels == 4)
+	else if (Channels == 4)
 		TextureFormat = GL_RGBA;
 
-	// Load texture data and generate mipmaps;
-	glTexImage2D(GL_TEXTURE_2D, 0, TextureFormat, Width, Height, 0, TextureFormat, GL_UNSIGNED_BYTE, TextureData);
+	// Load texture data and generate mipmaps. The rows of the decoded images are tightly packed
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	glTexImage2D(GL_TEXTURE_2D, 0, TextureFormat, Width, Height, 0, TextureFormat, GL_UNSIGNED_BYTE, Pixels);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
 	glGenerateMipmap(GL_TEXTURE_2D);
 
 	// Set parameters of borders wrapping and magnification / minification ( SuperSampling )
@@ -54,25 +107,65 @@ void Texture::Load ( const std::string & Path )
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-	glBindTexture(GL_TEXTURE_2D, 0);
+	GLStateCache::GetCurrent () . BindTexture ( 0, GL_TEXTURE_2D, 0 );
 
-	stbi_image_free(TextureData);
+	m_Width = Width;
+	m_Height = Height;
+	m_Channels = Channels;
+	m_IsLoaded = true;
+	LK_RENDER_CHECK_ERROR()
+}
+
+void Texture::Upload ( const CompressedImage & Image, const std::string & Path )
+{
+	GLenum Format = Image . IsSRGB ? GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT1_EXT : GL_COMPRESSED_RGBA_S3TC_DXT1_EXT;
+	if ( Image . Format == CompressedFormat::BC3 )
+		Format = Image . IsSRGB ? GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT : GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+	else if ( Image . Format == CompressedFormat::BC7 )
+		Format = Image . IsSRGB ? GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM : GL_COMPRESSED_RGBA_BPTC_UNORM;
+
+	GLStateCache::GetCurrent () . BindTexture ( 0, GL_TEXTURE_2D, m_Handle );
+	// The errors raised before are reported first, so they aren't taken for an unsupported format
+	LK_RENDER_CHECK_ERROR()
+	for ( size_t i = 0; i < Image . Levels . size (); i ++ )
+	{
+		const auto & Level = Image . Levels[ i ];
+		glCompressedTexImage2D ( GL_TEXTURE_2D, (GLint)i, Format, Level . Width, Level . Height, 0, (GLsizei)Level . Size, Image . Data . data () + Level . Offset );
+		// Checked in release too, a level the driver rejected would leave the texture incomplete
+		const GLenum Error = glGetError ();
+		if ( Error == GL_NO_ERROR )
+			continue;
+		GLStateCache::GetCurrent () . BindTexture ( 0, GL_TEXTURE_2D, 0 );
+		if ( Error == GL_INVALID_ENUM )
+			throw RenderException ( "The driver doesn't support the compressed format of the texture: " + Path );
+		throw RenderException ( "Can't upload level " + std::to_string ( i ) + " of the compressed texture, GL error "
+								+ std::to_string ( Error ) + ": " + Path );
+	}
+	// The chain may stop above 1x1, the missing levels would leave the texture incomplete
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, (GLint)Image . Levels . size () - 1);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, Image . Levels . size () > 1 ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	GLStateCache::GetCurrent () . BindTexture ( 0, GL_TEXTURE_2D, 0 );
+
+	m_Width = Image . Width;
+	m_Height = Image . Height;
+	m_Channels = 4;
+	m_IsLoaded = true;
 	LK_RENDER_CHECK_ERROR()
 }
 
 	void Texture::Set ( unsigned int UniformIndex, unsigned int TextureIndex )
 	{
-		glActiveTexture ( GL_TEXTURE0 + TextureIndex );
-		glBindTexture ( GL_TEXTURE_2D, m_Handle );
+		GLStateCache::GetCurrent () . BindTexture ( TextureIndex, GL_TEXTURE_2D, m_Handle );
 		glUniform1i ( UniformIndex, TextureIndex );
 		LK_RENDER_CHECK_ERROR()
 	}
 
 	void Texture::Unset ( unsigned int TextureIndex )
 	{
-		glActiveTexture ( GL_TEXTURE0 + TextureIndex );
-		glBindTexture ( GL_TEXTURE_2D, 0 );
-		glActiveTexture ( GL_TEXTURE0 );
+		GLStateCache::GetCurrent () . BindTexture ( TextureIndex, GL_TEXTURE_2D, 0 );
 		LK_RENDER_CHECK_ERROR()
 	}
 } // lk
@@ -0,0 +1,226 @@
+#include "glad/glad.h"
+#include "Laniakea/Render/TextureLoader.h"
+#include "Laniakea/Render/GLStateCache.h"
+#include "Laniakea/Render/RenderException.h"
+#include "stb/stb_image.h"
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
+namespace lk
+{
+namespace gfx
+{
+
+TextureLoader::TextureLoader ( size_t UploadBudget, unsigned int ThreadsCount, unsigned int PixelBuffersCount )
+: m_UploadBudget ( UploadBudget ), m_UploadedBytesCount ( 0 ), m_PendingCount ( 0 ), m_NextPixelBuffer ( 0 ), m_IsStopping ( false )
+{
+	if ( PixelBuffersCount == 0 )
+		throw RenderException ( "Texture loader needs at least one pixel buffer" );
+	m_PixelBuffers . resize ( PixelBuffersCount );
+	for ( auto & Buffer : m_PixelBuffers )
+	{
+		glGenBuffers ( 1, & Buffer . Handle );
+		Buffer . Capacity = 0;
+		Buffer . Fence = nullptr;
+	}
+	LK_RENDER_CHECK_ERROR()
+
+	if ( ThreadsCount == 0 )
+		ThreadsCount = std::max ( 1u, std::thread::hardware_concurrency () / 2 );
+	for ( unsigned int i = 0; i < ThreadsCount; i ++ )
+		m_Workers . emplace_back ( & TextureLoader::RunWorker, this );
+}
+
+TextureLoader::~TextureLoader ()
+{
+	{
+		std::lock_guard<std::mutex> Lock ( m_Mutex );
+		m_IsStopping = true;
+	}
+	m_RequestAdded . notify_all ();
+	for ( auto & Worker : m_Workers )
+		Worker . join ();
+	for ( auto & Image : m_Decoded )
+		stbi_image_free ( Image . Pixels );
+
+	auto & Cache = GLStateCache::GetCurrent ();
+	for ( auto & Buffer : m_PixelBuffers )
+	{
+		if ( Buffer . Fence != nullptr )
+			glDeleteSync ( ( GLsync ) Buffer . Fence );
+		Cache . OnBufferDeleted ( Buffer . Handle );
+		glDeleteBuffers ( 1, & Buffer . Handle );
+	}
+}
+
+std::shared_ptr<Texture> TextureLoader::Load ( const std::string & Path )
+{
+	std::shared_ptr<Texture> Result ( new Texture ( Texture::Placeholder {} ) );
+	{
+		std::lock_guard<std::mutex> Lock ( m_Mutex );
+		m_Requests . push_back ( { Result, Path } );
+	}
+	m_RequestAdded . notify_one ();
+	m_PendingCount ++;
+	return Result;
+}
+
+size_t TextureLoader::Update ()
+{
+	m_UploadedBytesCount = 0;
+	UploadDecoded ( m_UploadBudget, false );
+	return m_PendingCount;
+}
+
+void TextureLoader::Finish ()
+{
+	while ( m_PendingCount > 0 )
+	{
+		{
+			std::unique_lock<std::mutex> Lock ( m_Mutex );
+			m_ImageDecoded . wait ( Lock, [ this ] () { return ! m_Decoded . empty (); } );
+		}
+		UploadDecoded ( std::numeric_limits<size_t>::max (), true );
+	}
+}
+
+size_t TextureLoader::GetPendingCount () const
+{
+	return m_PendingCount;
+}
+
+size_t TextureLoader::GetUploadedBytesCount () const
+{
+	return m_UploadedBytesCount;
+}
+
+const std::vector<std::string> & TextureLoader::GetFailedPaths () const
+{
+	return m_FailedPaths;
+}
+
+void TextureLoader::RunWorker ()
+{
+	for ( ;; )
+	{
+		Request Next;
+		{
+			std::unique_lock<std::mutex> Lock ( m_Mutex );
+			m_RequestAdded . wait ( Lock, [ this ] () { return m_IsStopping || ! m_Requests . empty (); } );
+			if ( m_IsStopping )
+				return;
+			Next = std::move ( m_Requests . front () );
+			m_Requests . pop_front ();
+		}
+
+		DecodedImage Image { std::move ( Next . Target ), std::move ( Next . Path ), nullptr, 0, 0, 0 };
+		// A texture released while queued isn't decoded at all
+		if ( ! Image . Target . expired () )
+		{
+			int Width = 0, Height = 0, Channels = 0;
+			Image . Pixels = stbi_load ( Image . Path . c_str (), & Width, & Height, & Channels, 0 );
+			Image . Width = ( unsigned int ) Width;
+			Image . Height = ( unsigned int ) Height;
+			Image . Channels = ( unsigned int ) Channels;
+		}
+		{
+			std::lock_guard<std::mutex> Lock ( m_Mutex );
+			m_Decoded . push_back ( std::move ( Image ) );
+		}
+		m_ImageDecoded . notify_one ();
+	}
+}
+
+void TextureLoader::UploadDecoded ( size_t Budget, bool Wait )
+{
+	size_t UploadedBytesCount = 0;
+	for ( ;; )
+	{
+		DecodedImage Image;
+		{
+			std::lock_guard<std::mutex> Lock ( m_Mutex );
+			if ( m_Decoded . empty () )
+				break;
+			Image = std::move ( m_Decoded . front () );
+			m_Decoded . pop_front ();
+		}
+		const size_t Size = Image . Pixels != nullptr ? ( size_t ) Image . Width * Image . Height * Image . Channels : 0;
+		if ( ( UploadedBytesCount > 0 && UploadedBytesCount + Size > Budget ) || ! Upload ( Image, Wait ) )
+		{
+			// Left for the next frame, in its place in the queue
+			std::lock_guard<std::mutex> Lock ( m_Mutex );
+			m_Decoded . push_front ( std::move ( Image ) );
+			break;
+		}
+		UploadedBytesCount += Size;
+		m_PendingCount --;
+	}
+	m_UploadedBytesCount += UploadedBytesCount;
+}
+
+bool TextureLoader::Upload ( DecodedImage & Image, bool Wait )
+{
+	const auto Target = Image . Target . lock ();
+	if ( Target == nullptr || Image . Pixels == nullptr )
+	{
+		if ( Target != nullptr )
+			m_FailedPaths . push_back ( Image . Path );
+		stbi_image_free ( Image . Pixels );
+		return true;
+	}
+
+	PixelBuffer * Buffer = AcquirePixelBuffer ( Wait );
+	if ( Buffer == nullptr )
+		return false;
+	const size_t Size = ( size_t ) Image . Width * Image . Height * Image . Channels;
+	auto & Cache = GLStateCache::GetCurrent ();
+	Cache . BindBuffer ( GL_PIXEL_UNPACK_BUFFER, Buffer -> Handle );
+	if ( Buffer -> Capacity < Size )
+	{
+		glBufferData ( GL_PIXEL_UNPACK_BUFFER, ( GLsizeiptr ) Size, nullptr, GL_STREAM_DRAW );
+		Buffer -> Capacity = Size;
+	}
+	// The buffer's fence has signaled, so the previous copy from it is done and the mapping doesn't synchronize
+	void * Mapped = glMapBufferRange ( GL_PIXEL_UNPACK_BUFFER, 0, ( GLsizeiptr ) Size,
+									   GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT | GL_MAP_UNSYNCHRONIZED_BIT );
+	if ( Mapped == nullptr )
+	{
+		Cache . BindBuffer ( GL_PIXEL_UNPACK_BUFFER, 0 );
+		throw RenderException ( "Can't map the pixel buffer for the upload of " + Image . Path );
+	}
+	std::memcpy ( Mapped, Image . Pixels, Size );
+	glUnmapBuffer ( GL_PIXEL_UNPACK_BUFFER );
+	stbi_image_free ( Image . Pixels );
+	Image . Pixels = nullptr;
+
+	// With the unpack buffer bound the null pointer is the offset into it, the copy runs on the GPU
+	Target -> Upload ( Image . Width, Image . Height, Image . Channels, nullptr );
+	Buffer -> Fence = glFenceSync ( GL_SYNC_GPU_COMMANDS_COMPLETE, 0 );
+	// Left bound, the pointers passed to the other glTexImage* calls would be taken as offsets into the buffer
+	Cache . BindBuffer ( GL_PIXEL_UNPACK_BUFFER, 0 );
+	LK_RENDER_CHECK_ERROR()
+	return true;
+}
+
+TextureLoader::PixelBuffer * TextureLoader::AcquirePixelBuffer ( bool Wait )
+{
+	// The buffers are used round robin, so the next one is the oldest upload
+	PixelBuffer & Buffer = m_PixelBuffers[ m_NextPixelBuffer ];
+	if ( Buffer . Fence != nullptr )
+	{
+		const GLuint64 Timeout = Wait ? std::numeric_limits<GLuint64>::max () : 0;
+		const GLenum Result = glClientWaitSync ( ( GLsync ) Buffer . Fence, GL_SYNC_FLUSH_COMMANDS_BIT, Timeout );
+		if ( Result == GL_TIMEOUT_EXPIRED )
+			return nullptr;
+		if ( Result == GL_WAIT_FAILED )
+			throw RenderException ( "Waiting for the texture upload failed" );
+		glDeleteSync ( ( GLsync ) Buffer . Fence );
+		Buffer . Fence = nullptr;
+	}
+	m_NextPixelBuffer = ( m_NextPixelBuffer + 1 ) % m_PixelBuffers . size ();
+	return & Buffer;
+}
+
+} // namespace gfx
+} // namespace lk
@@ -0,0 +1,48 @@
+#include "glad/glad.h"
+#include "Laniakea/Render/UniformBuffer.h"
+#include "Laniakea/Render/GLStateCache.h"
+#include "Laniakea/Render/RenderException.h"
+
+namespace lk
+{
+namespace gfx
+{
+
+UniformBuffer::UniformBuffer ( unsigned int Capacity )
+: m_Buffer ( Capacity ), m_OffsetAlignment ( 256 )
+{
+	GLint Alignment = 0;
+	glGetIntegerv ( GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, & Alignment );
+	if ( Alignment > 0 )
+		m_OffsetAlignment = ( unsigned int ) Alignment;
+	LK_RENDER_CHECK_ERROR()
+}
+
+StreamBuffer::Range UniformBuffer::Write ( const void * Data, unsigned int Size )
+{
+	return m_Buffer . Write ( Data, Size, m_OffsetAlignment );
+}
+
+void UniformBuffer::Bind ( unsigned int Binding, const StreamBuffer::Range & Range )
+{
+	GLStateCache::GetCurrent () . BindBufferRange ( GL_UNIFORM_BUFFER, Binding, m_Buffer . GetHandle (), Range . Offset, Range . Size );
+	LK_RENDER_CHECK_ERROR()
+}
+
+void UniformBuffer::EndFrame ()
+{
+	m_Buffer . Fence ();
+}
+
+unsigned int UniformBuffer::GetHandle () const
+{
+	return m_Buffer . GetHandle ();
+}
+
+unsigned int UniformBuffer::GetOffsetAlignment () const
+{
+	return m_OffsetAlignment;
+}
+
+} // namespace gfx
+} // namespace lk
@@ -0,0 +1,86 @@
+#include "glad/glad.h"
+#include "Laniakea/Render/VertexArray.h"
+#include "Laniakea/Render/Attribute.h"
+#include "Laniakea/Render/IndexBuffer.h"
+#include "Laniakea/Render/RenderException.h"
+#include "Laniakea/Render/GLStateCache.h"
+
+namespace lk
+{
+namespace gfx
+{
+
+VertexArray::VertexArray ( const VertexLayout & Layout, const std::vector <std::reference_wrapper <const Attribute>> & Buffers,
+						   const IndexBuffer * Indices )
+: m_Layout ( Layout ), m_VertexCountSource ( nullptr ), m_Indices ( Indices ), m_Handle ( 0 )
+{
+	const auto & Streams = m_Layout . GetStreams ();
+	if ( Streams . size () != Buffers . size () )
+		throw RenderException ( "Vertex array requires one buffer per stream of the layout" );
+
+	auto & Cache = GLStateCache::GetCurrent ();
+	glGenVertexArrays ( 1, & m_Handle );
+	Cache . BindVertexArray ( m_Handle );
+	for ( unsigned int Stream = 0; Stream < Streams . size (); Stream ++ )
+	{
+		const Attribute & Buffer = Buffers[ Stream ] . get ();
+		if ( m_VertexCountSource == nullptr && Streams[ Stream ] . Divisor == 0 )
+			m_VertexCountSource = & Buffer;
+
+		const auto Stride = ( int ) m_Layout . GetStride ( Stream );
+		Cache . BindBuffer ( GL_ARRAY_BUFFER, Buffer . GetHandle () );
+		for ( const auto & Element : Streams[ Stream ] . Elements )
+		{
+			glEnableVertexAttribArray ( Element . Slot );
+			glVertexAttribPointer ( Element . Slot, ( int ) Element . Size, Element . Type, Element . Normalized ? GL_TRUE : GL_FALSE, Stride,
+									( void * ) ( uintptr_t ) Element . Offset );
+			glVertexAttribDivisor ( Element . Slot, Streams[ Stream ] . Divisor );
+		}
+	}
+	// The element buffer binding is a part of the vertex array state, the array buffer binding isn't
+	if ( m_Indices != nullptr )
+		Cache . BindBuffer ( GL_ELEMENT_ARRAY_BUFFER, m_Indices -> GetHandle () );
+	Cache . BindVertexArray ( 0 );
+	LK_RENDER_CHECK_ERROR()
+}
+
+VertexArray::~VertexArray ()
+{
+	GLStateCache::GetCurrent () . OnVertexArrayDeleted ( m_Handle );
+	glDeleteVertexArrays ( 1, & m_Handle );
+}
+
+void VertexArray::Bind () const
+{
+	GLStateCache::GetCurrent () . BindVertexArray ( m_Handle );
+}
+
+void VertexArray::Unbind () const
+{
+	GLStateCache::GetCurrent () . BindVertexArray ( 0 );
+}
+
+unsigned int VertexArray::GetCount () const
+{
+	if ( m_Indices != nullptr )
+		return m_Indices -> GetCount ();
+	return m_VertexCountSource != nullptr ? m_VertexCountSource -> GetCount () : 0;
+}
+
+bool VertexArray::GetIsIndexed () const
+{
+	return m_Indices != nullptr;
+}
+
+const VertexLayout & VertexArray::GetLayout () const
+{
+	return m_Layout;
+}
+
+unsigned int VertexArray::GetHandle () const
+{
+	return m_Handle;
+}
+
+} // namespace gfx
+} // namespace lk
\ No newline at end of file
@@ -0,0 +1,70 @@
+#include "glad/glad.h"
+#include "Laniakea/Render/VertexLayout.h"
+#include "Laniakea/Render/RenderException.h"
+#include <algorithm>
+
+namespace lk
+{
+namespace gfx
+{
+
+VertexLayout & VertexLayout::AddStream ( unsigned int Stride, unsigned int Divisor )
+{
+	m_Streams . push_back ( { Stride, Divisor, {} } );
+	m_PackedStrides . push_back ( 0 );
+	return * this;
+}
+
+VertexLayout & VertexLayout::Add ( unsigned int Slot, unsigned int Size, unsigned int Type, bool Normalized )
+{
+	if ( m_Streams . empty () )
+		AddStream ();
+	return Add ( { Slot, Size, Type, m_PackedStrides . back (), Normalized } );
+}
+
+VertexLayout & VertexLayout::Add ( const VertexElement & Element )
+{
+	if ( m_Streams . empty () )
+		AddStream ();
+	if ( Element . Size == 0 || Element . Size > 4 )
+		throw RenderException ( "Vertex element must have 1 to 4 components" );
+	m_Streams . back () . Elements . push_back ( Element );
+	m_PackedStrides . back () = std::max ( m_PackedStrides . back (), Element . Offset + Element . Size * GetTypeSize ( Element . Type ) );
+	return * this;
+}
+
+const std::vector <VertexStream> & VertexLayout::GetStreams () const
+{
+	return m_Streams;
+}
+
+unsigned int VertexLayout::GetStride ( unsigned int Stream ) const
+{
+	return m_Streams . at ( Stream ) . Stride != 0 ? m_Streams[ Stream ] . Stride : m_PackedStrides[ Stream ];
+}
+
+unsigned int VertexLayout::GetTypeSize ( unsigned int Type )
+{
+	switch ( Type )
+	{
+		case GL_BYTE:
+		case GL_UNSIGNED_BYTE:
+			return 1;
+		case GL_SHORT:
+		case GL_UNSIGNED_SHORT:
+		case GL_HALF_FLOAT:
+			return 2;
+		case GL_INT:
+		case GL_UNSIGNED_INT:
+		case GL_FLOAT:
+		case GL_FIXED:
+			return 4;
+		case GL_DOUBLE:
+			return 8;
+		default:
+			throw RenderException ( "Undefined vertex element type" );
+	}
+}
+
+} // namespace gfx
+} // namespace lk
\ No newline at end of file
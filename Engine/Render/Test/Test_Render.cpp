@@ -6,7 +6,24 @@
 #include "Laniakea/Render/Uniform.h"
 #include "Laniakea/Render/Texture.h"
 #include "Laniakea/Render/RenderException.h"
+#include "Laniakea/Render/IndexBuffer.h"
+#include "Laniakea/Render/Renderer.h"
+#include "Laniakea/Render/VertexArray.h"
+#include "Laniakea/Render/GLStateCache.h"
+#include "Laniakea/Render/StreamBuffer.h"
+#include "Laniakea/Render/Std140.h"
+#include "Laniakea/Render/UniformBuffer.h"
+#include "Laniakea/Render/ShaderCache.h"
+#include "Laniakea/Render/ShaderCompiler.h"
+#include "Laniakea/Render/TextureLoader.h"
+#include "Laniakea/Render/BlockCompression.h"
+#include "Laniakea/Render/CompressedImage.h"
 #include "glm/glm.hpp"
+#include <cstring>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <thread>
 
 
 
@@ -31,6 +48,59 @@ const char * Simple_FS = "#version 330 core\n"
 						 "    FragColor = vertexColor;\n"
 						 "}";
 
+const char * Instanced_VS = "#version 330 core\n"
+							"layout (location = 0) in vec3 aPos;\n"
+							"layout (location = 1) in vec2 aOffset;\n"
+							"\n"
+							"void main()\n"
+							"{\n"
+							"    gl_Position = vec4(aPos.xy + aOffset, 0.0, 1.0);\n"
+							"}";
+
+const char * Instanced_FS = "#version 330 core\n"
+							"out vec4 FragColor;\n"
+							"\n"
+							"void main()\n"
+							"{\n"
+							"    FragColor = vec4(0.0, 1.0, 0.0, 1.0);\n"
+							"}";
+
+const char * Blocks_VS = "#version 330 core\n"
+						 "layout (location = 0) in vec3 aPos;\n"
+						 "layout (std140) uniform Frame { mat4 View; vec3 Tint; float Time; vec4 Weights[2]; };\n"
+						 "layout (std140) uniform Object { vec4 Offset; };\n"
+						 "\n"
+						 "void main()\n"
+						 "{\n"
+						 "    gl_Position = View * vec4(aPos.xy + Offset.xy, 0.0, 1.0);\n"
+						 "}";
+
+const char * Blocks_FS = "#version 330 core\n"
+						 "layout (std140) uniform Frame { mat4 View; vec3 Tint; float Time; vec4 Weights[2]; };\n"
+						 "out vec4 FragColor;\n"
+						 "\n"
+						 "void main()\n"
+						 "{\n"
+						 "    FragColor = vec4(Tint * Weights[1].x, 1.0);\n"
+						 "}";
+
+// Mirrors the Frame block of Blocks_VS
+struct FrameBlock
+{
+	glm::mat4 View;
+	glm::vec3 Tint;
+	float Time;
+	glm::vec4 Weights[ 2 ];
+};
+using FrameLayout = lk::gfx::std140::Layout <glm::mat4, glm::vec3, float, glm::vec4[ 2 ]>;
+LK_STD140_CHECK ( FrameBlock, Tint, FrameLayout, 1 );
+LK_STD140_CHECK ( FrameBlock, Time, FrameLayout, 2 );
+LK_STD140_CHECK ( FrameBlock, Weights, FrameLayout, 3 );
+static_assert ( sizeof ( FrameBlock ) == FrameLayout::Size );
+static_assert ( lk::gfx::std140::Traits <float[ 4 ]>::Size == 64 );
+static_assert ( lk::gfx::std140::Layout <float, glm::vec3>::Offsets[ 1 ] == 16 );
+static_assert ( lk::gfx::std140::Layout <glm::vec3, float>::Size == 16 );
+
 const char * Texture_Path = "Textures/Test_Barrel_Diffuse.png";
 
 const char * VSPath = "Shaders/Test_Vertex.glsl";
@@ -117,6 +187,68 @@ TEST ( Shader, Uniforms )
 }
 
 
+TEST ( Shader, Reflection )
+{
+	using namespace lk::gfx;
+	static_assert ( "PVMMatrix"_uid == MakeUniformId ( "PVMMatrix" ) );
+	static_assert ( ! ( "PVMMatrix"_uid == "PMatrix"_uid ) );
+	Shader shader ( VSPath, FSPath );
+
+	// The hashed lookups agree with the string lookups and with GL
+	const GLuint Handle = shader . GetHandle ();
+	EXPECT_EQ ( shader . FindUniformLocation ( "PVMMatrix"_uid ), glGetUniformLocation ( Handle, "PVMMatrix" ) );
+	EXPECT_EQ ( shader . FindUniformLocation ( "PVMMatrix"_uid ), ( int32_t ) shader . GetUniformLocation ( "PVMMatrix" ) );
+	EXPECT_EQ ( shader . FindUniformLocation ( "pointLights[10].diffuseColor"_uid ), glGetUniformLocation ( Handle, "pointLights[10].diffuseColor" ) );
+	EXPECT_EQ ( shader . FindUniformLocation ( "isPointLightActive[3]"_uid ), glGetUniformLocation ( Handle, "isPointLightActive[3]" ) );
+	EXPECT_EQ ( shader . FindUniformLocation ( "isPointLightActive"_uid ), glGetUniformLocation ( Handle, "isPointLightActive" ) );
+	EXPECT_TRUE ( shader . GetIsUniformExists ( "material.shininess"_uid ) );
+	EXPECT_EQ ( shader . FindUniformLocation ( "isPointLightActive[16]"_uid ), -1 );
+	EXPECT_EQ ( shader . FindUniformLocation ( "VMMMatrix"_uid ), -1 );
+	EXPECT_EQ ( shader . FindAttributeLocation ( "aNormal"_uid ), 1 );
+	EXPECT_FALSE ( shader . GetIsAttributeExists ( "PVMMatrix"_uid ) );
+
+	// The missing uniforms of a material resolve to -1
+	UniformLocationTable <3> Locations ( shader, { "material.diffuseColor"_uid, "material.roughness"_uid, "fogColor"_uid } );
+	EXPECT_EQ ( Locations[ 0 ], glGetUniformLocation ( Handle, "material.diffuseColor" ) );
+	EXPECT_EQ ( Locations[ 1 ], -1 );
+	EXPECT_EQ ( Locations[ 2 ], glGetUniformLocation ( Handle, "fogColor" ) );
+
+	// A repeated name keeps its first location
+	ShaderLocationTable Table;
+	Table . Add ( "Second", 2 );
+	Table . Add ( "First", 1 );
+	Table . Add ( "Second", 3 );
+	Table . Build ();
+	EXPECT_EQ ( Table . GetSize (), 2u );
+	EXPECT_EQ ( Table . Find ( "Second"_uid ), 2 );
+	EXPECT_FALSE ( Table . Assign ( { { 2, 0 }, { 1, 0 } }, { "B", "A" } ) );
+	EXPECT_FALSE ( Table . Assign ( { { MakeUniformId ( "Other" ) . Hash, 0 } }, { "First" } ) );
+	EXPECT_EQ ( Table . Find ( "First"_uid ), 1 );
+
+	// "costarring" and "liquid" share the FNV-1a id, only the lookup by name tells the missing one apart
+	ShaderLocationTable Colliding;
+	Colliding . Add ( "costarring", 4 );
+	Colliding . Build ();
+	EXPECT_EQ ( "liquid"_uid, "costarring"_uid );
+	EXPECT_EQ ( Colliding . Find ( "costarring" ), 4 );
+	EXPECT_EQ ( Colliding . Find ( "liquid" ), -1 );
+	EXPECT_FALSE ( Colliding . GetIsExists ( "liquid" ) );
+	EXPECT_EQ ( Colliding . Find ( "liquid"_uid ), 4 );
+	// Both colliding names of one shader are kept and told apart by name, the ambiguous id resolves to none
+	Colliding . Add ( "liquid", 5 );
+	Colliding . Add ( "First", 1 );
+	Colliding . Build ();
+	EXPECT_EQ ( Colliding . GetSize (), 3u );
+	EXPECT_EQ ( Colliding . Find ( "costarring" ), 4 );
+	EXPECT_EQ ( Colliding . Find ( "liquid" ), 5 );
+	EXPECT_EQ ( Colliding . Find ( "First" ), 1 );
+	EXPECT_EQ ( Colliding . Find ( "liquid"_uid ), -1 );
+	EXPECT_EQ ( Colliding . Find ( "First"_uid ), 1 );
+	EXPECT_TRUE ( Table . Assign ( Colliding . GetEntries (), Colliding . GetNames () ) );
+	EXPECT_EQ ( Table . Find ( "liquid" ), 5 );
+	EXPECT_FALSE ( Table . Assign ( { Colliding . GetEntries ()[ 1 ], Colliding . GetEntries ()[ 0 ] }, { Colliding . GetNames ()[ 1 ], Colliding . GetNames ()[ 0 ] } ) );
+}
+
 TEST ( Attribute, Set )
 {
 	#ifdef LANIAKEA_BUILD_DEBUG // OpenGL low level testing is disabled in release configuration
@@ -191,6 +323,574 @@ TEST ( Texture, Creation )
 
 }
 
+TEST ( VertexArray, Layout )
+{
+	#ifdef LANIAKEA_BUILD_DEBUG // OpenGL low level testing is disabled in release configuration
+	using namespace lk::gfx;
+	VertexLayout Layout;
+	Layout . AddStream () . Add ( 0, 3, GL_FLOAT ) . Add ( 1, 4, GL_UNSIGNED_BYTE, true );
+	Layout . AddStream ( 0, 1 ) . Add ( { .Slot = 2, .Size = 2, .Type = GL_FLOAT, .Offset = 8 } );
+
+	EXPECT_EQ ( Layout . GetStreams () . size (), size_t ( 2 ) );
+	EXPECT_EQ ( Layout . GetStreams ()[ 0 ] . Elements[ 1 ] . Offset, 12u );
+	EXPECT_EQ ( Layout . GetStride ( 0 ), 16u );
+	EXPECT_EQ ( Layout . GetStride ( 1 ), 16u );
+	EXPECT_THROW ( Layout . Add ( 3, 5, GL_FLOAT ), RenderException );
+	EXPECT_THROW ( Layout . Add ( 3, 1, 1337 ), RenderException );
+	#endif
+}
+
+TEST ( VertexArray, Render )
+{
+	#ifdef LANIAKEA_BUILD_DEBUG // OpenGL low level testing is disabled in release configuration
+	using namespace lk::gfx;
+	Shader shader ( Simple_VS, Simple_FS );
+	shader.Bind();
+
+	// Interleaved position and a padding float, the quad covers the whole viewport
+	std::vector <float> Vertices {
+			-1.f, -1.f, 0.f, 0.f,
+			1.f, -1.f, 0.f, 0.f,
+			1.f, 1.f, 0.f, 0.f,
+			-1.f, 1.f, 0.f, 0.f
+	};
+	std::vector <float> Weights { 1.f, 1.f, 1.f, 1.f };
+	std::vector <unsigned int> Indices { 0, 1, 2, 0, 2, 3 };
+	Attribute Positions;
+	Attribute Extra;
+	IndexBuffer QuadIndices;
+	Positions . Set ( Vertices );
+	Extra . Set ( Weights );
+	QuadIndices . Set ( Indices );
+
+	VertexLayout Layout;
+	Layout . AddStream ( 4 * sizeof ( float ) ) . Add ( 0, 3, GL_FLOAT );
+	Layout . AddStream () . Add ( 1, 1, GL_FLOAT );
+	EXPECT_THROW ( VertexArray Mismatched ( Layout, { Positions } ), RenderException );
+
+	VertexArray Quad ( Layout, { Positions, Extra }, & QuadIndices );
+	EXPECT_EQ ( Quad . GetCount (), 6u );
+	EXPECT_TRUE ( Quad . GetIsIndexed () );
+
+	// The attribute setup is recorded in the vertex array
+	Quad . Bind ();
+	GLint Stride = 0;
+	GLint Buffer = 0;
+	GLint ElementBuffer = 0;
+	glGetVertexAttribiv ( 0, GL_VERTEX_ATTRIB_ARRAY_STRIDE, & Stride );
+	glGetVertexAttribiv ( 1, GL_VERTEX_ATTRIB_ARRAY_BUFFER_BINDING, & Buffer );
+	glGetIntegerv ( GL_ELEMENT_ARRAY_BUFFER_BINDING, & ElementBuffer );
+	EXPECT_EQ ( Stride, GLint ( 4 * sizeof ( float ) ) );
+	EXPECT_EQ ( Buffer, GLint ( Extra . GetHandle () ) );
+	EXPECT_EQ ( ElementBuffer, GLint ( QuadIndices . GetHandle () ) );
+	Quad . Unbind ();
+
+	glClearColor ( 0.f, 0.f, 0.f, 1.f );
+	glClear ( GL_COLOR_BUFFER_BIT );
+	EXPECT_NO_THROW ( Renderer::Render ( Quad, DrawMode::Triangles ) );
+	unsigned char Pixel[ 4 ] = {};
+	glReadPixels ( 0, 0, 1, 1, GL_RGBA, GL_UNSIGNED_BYTE, Pixel );
+	EXPECT_NEAR ( Pixel[ 0 ], 128, 1 );
+	Quad . Unbind ();
+	shader.Unbind();
+	#endif
+}
+
+TEST ( VertexArray, RenderInstanced )
+{
+	#ifdef LANIAKEA_BUILD_DEBUG // OpenGL low level testing is disabled in release configuration
+	using namespace lk::gfx;
+	Shader shader ( Instanced_VS, Instanced_FS );
+	shader.Bind();
+
+	// A quad covering the bottom left quarter of the viewport, the second instance is moved to the top right quarter
+	std::vector <float> Vertices { -1.f, -1.f, 0.f, 0.f, -1.f, 0.f, 0.f, 0.f, 0.f, -1.f, 0.f, 0.f };
+	std::vector <unsigned int> Indices { 0, 1, 2, 0, 2, 3 };
+	struct Offset { float X, Y; };
+	std::vector <Offset> Offsets { { 0.f, 0.f }, { 1.f, 1.f } };
+	Attribute Positions;
+	Attribute InstanceOffsets;
+	IndexBuffer QuadIndices;
+	Positions . Set ( Vertices );
+	InstanceOffsets . Stream ( Offsets.data(), 2 );
+	EXPECT_EQ ( InstanceOffsets . GetCount (), 2u );
+	QuadIndices . Set ( Indices );
+
+	VertexLayout Layout;
+	Layout . AddStream () . Add ( 0, 3, GL_FLOAT );
+	Layout . AddStream ( 0, 1 ) . Add ( 1, 2, GL_FLOAT );
+	VertexArray Quads ( Layout, { Positions, InstanceOffsets }, & QuadIndices );
+
+	glClearColor ( 0.f, 0.f, 0.f, 1.f );
+	glClear ( GL_COLOR_BUFFER_BIT );
+	EXPECT_NO_THROW ( Renderer::RenderInstanced ( Quads, 2, DrawMode::Triangles ) );
+	GLint Viewport[ 4 ] = {};
+	glGetIntegerv ( GL_VIEWPORT, Viewport );
+	const GLint Left = Viewport[ 2 ] / 4;
+	const GLint Right = Viewport[ 2 ] * 3 / 4;
+	const GLint Bottom = Viewport[ 3 ] / 4;
+	const GLint Top = Viewport[ 3 ] * 3 / 4;
+	unsigned char Pixels[ 3 ][ 4 ] = {};
+	glReadPixels ( Left, Bottom, 1, 1, GL_RGBA, GL_UNSIGNED_BYTE, Pixels[ 0 ] );
+	glReadPixels ( Right, Top, 1, 1, GL_RGBA, GL_UNSIGNED_BYTE, Pixels[ 1 ] );
+	glReadPixels ( Right, Bottom, 1, 1, GL_RGBA, GL_UNSIGNED_BYTE, Pixels[ 2 ] );
+	EXPECT_EQ ( Pixels[ 0 ][ 1 ], 255 );
+	EXPECT_EQ ( Pixels[ 1 ][ 1 ], 255 );
+	EXPECT_EQ ( Pixels[ 2 ][ 1 ], 0 );
+
+	// The streamed instances are replaced, the vertex array picks up the new contents
+	std::vector <Offset> Moved { { 1.f, 0.f } };
+	InstanceOffsets . Stream ( Moved.data(), 1 );
+	glClear ( GL_COLOR_BUFFER_BIT );
+	Quads . Bind ();
+	EXPECT_NO_THROW ( Renderer::RenderIndexedInstanced ( QuadIndices, InstanceOffsets . GetCount (), DrawMode::Triangles ) );
+	glReadPixels ( Left, Bottom, 1, 1, GL_RGBA, GL_UNSIGNED_BYTE, Pixels[ 0 ] );
+	glReadPixels ( Right, Bottom, 1, 1, GL_RGBA, GL_UNSIGNED_BYTE, Pixels[ 2 ] );
+	EXPECT_EQ ( Pixels[ 0 ][ 1 ], 0 );
+	EXPECT_EQ ( Pixels[ 2 ][ 1 ], 255 );
+	Quads . Unbind ();
+	shader.Unbind();
+	#endif
+}
+
+TEST ( StreamBuffer, Ring )
+{
+	#ifdef LANIAKEA_BUILD_DEBUG // OpenGL low level testing is disabled in release configuration
+	using namespace lk::gfx;
+	StreamBuffer Ring ( 256 );
+	std::vector <unsigned char> Data ( 100 );
+	for ( size_t i = 0; i < Data . size (); i ++ )
+		Data[ i ] = ( unsigned char ) i;
+
+	// The writes are aligned and wrap to the beginning when the tail is too short
+	EXPECT_EQ ( Ring . Write ( Data . data (), 100 ) . Offset, 0u );
+	EXPECT_EQ ( Ring . Write ( Data . data (), 100 ) . Offset, 112u );
+	Ring . Fence ();
+	const auto Wrapped = Ring . Write ( Data . data () + 1, 99, 4 );
+	EXPECT_EQ ( Wrapped . Offset, 0u );
+	EXPECT_EQ ( Wrapped . Size, 99u );
+	Ring . Fence ();
+	EXPECT_THROW ( Ring . Write ( Data . data (), 257 ), RenderException );
+
+	glFinish ();
+	unsigned char Read[ 99 ] = {};
+	GLStateCache::GetCurrent () . BindBuffer ( GL_COPY_READ_BUFFER, Ring . GetHandle () );
+	glGetBufferSubData ( GL_COPY_READ_BUFFER, 0, 99, Read );
+	EXPECT_EQ ( std::memcmp ( Read, Data . data () + 1, 99 ), 0 );
+
+	// Many frames through a small ring, the writes reaching the ranges of the previous frames wait for their fences
+	for ( int Frame = 0; Frame < 64; Frame ++ )
+	{
+		Ring . Write ( Data . data (), 100 );
+		Ring . Fence ();
+	}
+	EXPECT_NO_THROW ( Ring . Fence () );
+	#endif
+}
+
+TEST ( StreamBuffer, Update )
+{
+	#ifdef LANIAKEA_BUILD_DEBUG // OpenGL low level testing is disabled in release configuration
+	using namespace lk::gfx;
+	StreamBuffer Staging ( 1024 );
+	Attribute Values;
+	std::vector <float> Initial { 1.f, 2.f, 3.f, 4.f };
+	Values . Set ( Initial );
+	float Replacement[] = { 20.f, 30.f };
+	EXPECT_NO_THROW ( Values . Update ( Replacement, 1, 2, Staging ) );
+	EXPECT_THROW ( Values . Update ( Replacement, 3, 2, Staging ), RenderException );
+	Attribute Allocated;
+	Allocated . Allocate <float> ( 4 );
+	EXPECT_EQ ( Allocated . GetCount (), 4u );
+	EXPECT_NO_THROW ( Allocated . Update ( Initial . data (), 0, 4, Staging ) );
+	EXPECT_THROW ( Allocated . Update ( Replacement, 3, 2, Staging ), RenderException );
+
+	IndexBuffer Indices;
+	std::vector <unsigned int> InitialIndices { 0, 1, 2, 3, 4, 5 };
+	Indices . Set ( InitialIndices );
+	unsigned int ReplacementIndices[] = { 7 };
+	EXPECT_NO_THROW ( Indices . Update ( ReplacementIndices, 5, 1, Staging ) );
+	EXPECT_THROW ( Indices . Update ( ReplacementIndices, 6, 1, Staging ), RenderException );
+	Staging . Fence ();
+
+	float ReadValues[ 4 ] = {};
+	unsigned int ReadIndices[ 6 ] = {};
+	GLStateCache::GetCurrent () . BindBuffer ( GL_COPY_READ_BUFFER, Values . GetHandle () );
+	glGetBufferSubData ( GL_COPY_READ_BUFFER, 0, sizeof ( ReadValues ), ReadValues );
+	GLStateCache::GetCurrent () . BindBuffer ( GL_COPY_READ_BUFFER, Indices . GetHandle () );
+	glGetBufferSubData ( GL_COPY_READ_BUFFER, 0, sizeof ( ReadIndices ), ReadIndices );
+	EXPECT_FLOAT_EQ ( ReadValues[ 0 ], 1.f );
+	EXPECT_FLOAT_EQ ( ReadValues[ 1 ], 20.f );
+	EXPECT_FLOAT_EQ ( ReadValues[ 2 ], 30.f );
+	EXPECT_FLOAT_EQ ( ReadValues[ 3 ], 4.f );
+	GLStateCache::GetCurrent () . BindBuffer ( GL_COPY_READ_BUFFER, Allocated . GetHandle () );
+	glGetBufferSubData ( GL_COPY_READ_BUFFER, 0, sizeof ( ReadValues ), ReadValues );
+	EXPECT_FLOAT_EQ ( ReadValues[ 0 ], 1.f );
+	EXPECT_FLOAT_EQ ( ReadValues[ 3 ], 4.f );
+	EXPECT_EQ ( ReadIndices[ 4 ], 4u );
+	EXPECT_EQ ( ReadIndices[ 5 ], 7u );
+	#endif
+}
+
+TEST ( UniformBuffer, Blocks )
+{
+	#ifdef LANIAKEA_BUILD_DEBUG // OpenGL low level testing is disabled in release configuration
+	using namespace lk::gfx;
+	Shader shader ( Blocks_VS, Blocks_FS );
+	ASSERT_TRUE ( shader . GetIsUniformBlockExists ( "Frame" ) );
+	ASSERT_TRUE ( shader . GetIsUniformBlockExists ( "Object" ) );
+	EXPECT_FALSE ( shader . GetIsUniformBlockExists ( "Material" ) );
+	EXPECT_THROW ( shader . GetUniformBlock ( "Material" ), RenderException );
+	EXPECT_FALSE ( shader . GetIsUniformExists ( "View" ) );
+
+	// The reflected offsets match the compile time layout
+	const auto & Frame = shader . GetUniformBlock ( "Frame" );
+	EXPECT_GE ( Frame . Size, FrameLayout::Size );
+	EXPECT_EQ ( Frame . Offsets . at ( "Tint" ), FrameLayout::Offsets[ 1 ] );
+	EXPECT_EQ ( Frame . Offsets . at ( "Time" ), FrameLayout::Offsets[ 2 ] );
+	EXPECT_EQ ( Frame . Offsets . at ( "Weights[0]" ), FrameLayout::Offsets[ 3 ] );
+
+	shader . SetUniformBlockBinding ( "Frame", UniformBuffer::FrameBinding );
+	shader . SetUniformBlockBinding ( "Object", UniformBuffer::ObjectBinding );
+	EXPECT_EQ ( shader . GetUniformBlock ( "Object" ) . Binding, UniformBuffer::ObjectBinding );
+
+	std::vector <float> Vertices { -1.f, -1.f, 0.f, 0.f, -1.f, 0.f, 0.f, 0.f, 0.f, -1.f, 0.f, 0.f };
+	std::vector <unsigned int> Indices { 0, 1, 2, 0, 2, 3 };
+	Attribute Positions;
+	IndexBuffer QuadIndices;
+	Positions . Set ( Vertices );
+	QuadIndices . Set ( Indices );
+	VertexLayout Layout;
+	Layout . AddStream () . Add ( 0, 3, GL_FLOAT );
+	VertexArray Quad ( Layout, { Positions }, & QuadIndices );
+
+	FrameBlock Constants {};
+	const float Identity[ 16 ] = { 1.f, 0.f, 0.f, 0.f, 0.f, 1.f, 0.f, 0.f, 0.f, 0.f, 1.f, 0.f, 0.f, 0.f, 0.f, 1.f };
+	std::memcpy ( & Constants . View, Identity, sizeof ( Identity ) );
+	Constants . Tint = { 1.f, 0.f, 0.f };
+	Constants . Weights[ 1 ] = { 0.5f, 0.f, 0.f, 0.f };
+	const glm::vec4 Offsets[ 2 ] = { { 0.f, 0.f, 0.f, 0.f }, { 1.f, 1.f, 0.f, 0.f } };
+
+	UniformBuffer Uniforms ( 64 * 1024 );
+	auto & Cache = GLStateCache::GetCurrent ();
+	shader . Bind ();
+	glClearColor ( 0.f, 0.f, 0.f, 1.f );
+	glClear ( GL_COLOR_BUFFER_BIT );
+	// The frame block is written and bound once, the object blocks once per draw
+	const auto FrameRange = Uniforms . Write ( Constants );
+	Uniforms . Bind ( UniformBuffer::FrameBinding, FrameRange );
+	for ( const auto & Offset : Offsets )
+	{
+		const auto ObjectRange = Uniforms . Write ( Offset );
+		EXPECT_EQ ( ObjectRange . Offset % Uniforms . GetOffsetAlignment (), 0u );
+		Uniforms . Bind ( UniformBuffer::ObjectBinding, ObjectRange );
+		Uniforms . Bind ( UniformBuffer::FrameBinding, FrameRange );
+		Renderer::Render ( Quad, DrawMode::Triangles );
+	}
+	Uniforms . EndFrame ();
+	Cache . BeginFrame ();
+	Uniforms . Bind ( UniformBuffer::FrameBinding, FrameRange );
+	EXPECT_EQ ( Cache . GetAvoidedCallsCount (), 1u );
+
+	GLint Viewport[ 4 ] = {};
+	glGetIntegerv ( GL_VIEWPORT, Viewport );
+	unsigned char Pixels[ 3 ][ 4 ] = {};
+	glReadPixels ( Viewport[ 2 ] / 4, Viewport[ 3 ] / 4, 1, 1, GL_RGBA, GL_UNSIGNED_BYTE, Pixels[ 0 ] );
+	glReadPixels ( Viewport[ 2 ] * 3 / 4, Viewport[ 3 ] * 3 / 4, 1, 1, GL_RGBA, GL_UNSIGNED_BYTE, Pixels[ 1 ] );
+	glReadPixels ( Viewport[ 2 ] * 3 / 4, Viewport[ 3 ] / 4, 1, 1, GL_RGBA, GL_UNSIGNED_BYTE, Pixels[ 2 ] );
+	EXPECT_NEAR ( Pixels[ 0 ][ 0 ], 128, 1 );
+	EXPECT_NEAR ( Pixels[ 1 ][ 0 ], 128, 1 );
+	EXPECT_EQ ( Pixels[ 2 ][ 0 ], 0 );
+	Quad . Unbind ();
+	shader . Unbind ();
+	#endif
+}
+
+TEST ( ShaderCache, WarmStart )
+{
+	#ifdef LANIAKEA_BUILD_DEBUG // OpenGL low level testing is disabled in release configuration
+	using namespace lk::gfx;
+	const auto Directory = std::filesystem::temp_directory_path () / "Laniakea-ShaderCache-Test";
+	std::filesystem::remove_all ( Directory );
+	ShaderCache Cache ( Directory . string () );
+	EXPECT_NE ( Cache . GetKey ( Blocks_VS, Blocks_FS ), Cache . GetKey ( Blocks_FS, Blocks_VS ) );
+
+	Shader Cold ( Blocks_VS, Blocks_FS, & Cache );
+	EXPECT_EQ ( Cache . GetHitsCount (), 0u );
+	EXPECT_EQ ( Cache . GetMissesCount (), 1u );
+	if ( ! Cache . GetIsSupported () )
+		GTEST_SKIP () << "The driver exposes no program binary formats";
+
+	// The warm start loads the binary and the reflection instead of compiling
+	Shader Warm ( Blocks_VS, Blocks_FS, & Cache );
+	EXPECT_EQ ( Cache . GetHitsCount (), 1u );
+	GLint Status = 0;
+	glGetProgramiv ( Warm . GetHandle (), GL_LINK_STATUS, & Status );
+	EXPECT_EQ ( Status, GL_TRUE );
+	EXPECT_EQ ( Warm . GetAttributeLocation ( "aPos" ), Cold . GetAttributeLocation ( "aPos" ) );
+	ASSERT_TRUE ( Warm . GetIsUniformBlockExists ( "Frame" ) );
+	EXPECT_EQ ( Warm . GetUniformBlock ( "Frame" ) . Size, Cold . GetUniformBlock ( "Frame" ) . Size );
+	EXPECT_EQ ( Warm . GetUniformBlock ( "Frame" ) . Offsets, Cold . GetUniformBlock ( "Frame" ) . Offsets );
+	EXPECT_EQ ( Warm . GetUniformBlock ( "Object" ) . Index, Cold . GetUniformBlock ( "Object" ) . Index );
+
+	// A corrupt entry is a miss, the program is compiled and stored again
+	for ( const auto & Entry : std::filesystem::directory_iterator ( Directory ) )
+		std::filesystem::resize_file ( Entry . path (), 16 );
+	Shader Recompiled ( Blocks_VS, Blocks_FS, & Cache );
+	EXPECT_EQ ( Cache . GetMissesCount (), 2u );
+	EXPECT_TRUE ( Recompiled . GetIsUniformBlockExists ( "Object" ) );
+	Shader Reloaded ( Blocks_VS, Blocks_FS, & Cache );
+	EXPECT_EQ ( Cache . GetHitsCount (), 2u );
+	std::filesystem::remove_all ( Directory );
+	#endif
+}
+
+TEST ( ShaderCompiler, Async )
+{
+	#ifdef LANIAKEA_BUILD_DEBUG // OpenGL low level testing is disabled in release configuration
+	using namespace lk::gfx;
+	Shader Fallback ( Simple_VS, Simple_FS );
+	ShaderCompiler Compiler ( Fallback );
+	ShaderHandle Blocks = Compiler . Submit ( Blocks_VS, Blocks_FS );
+	ShaderHandle Broken = Compiler . Submit ( Simple_VS, "#version 330 core\nvoid main() { undefined_call(); }" );
+	EXPECT_EQ ( Compiler . GetPendingCount (), 2u );
+	// The fallback is drawn while the shaders compile
+	EXPECT_FALSE ( Blocks . GetIsReady () );
+	EXPECT_EQ ( Blocks . Get () . GetHandle (), Fallback . GetHandle () );
+
+	for ( int Frame = 0; Frame < 100000 && Compiler . Poll () > 0; Frame ++ );
+	Compiler . Finish ();
+	EXPECT_EQ ( Compiler . GetPendingCount (), 0u );
+	ASSERT_TRUE ( Blocks . GetIsReady () );
+	EXPECT_NE ( Blocks . Get () . GetHandle (), Fallback . GetHandle () );
+	EXPECT_TRUE ( Blocks . Get () . GetIsUniformBlockExists ( "Frame" ) );
+	EXPECT_TRUE ( Broken . GetIsFailed () );
+	EXPECT_NE ( Broken . GetError () . find ( "fragment" ), std::string::npos );
+	EXPECT_EQ ( Broken . Get () . GetHandle (), Fallback . GetHandle () );
+	EXPECT_THROW ( ShaderHandle () . Get (), RenderException );
+
+	// An error raised by the submission itself fails the handle instead of throwing
+	glEnable ( 0xFFFF );
+	ShaderHandle Rejected;
+	EXPECT_NO_THROW ( Rejected = Compiler . Submit ( Simple_VS, Simple_FS ) );
+	EXPECT_TRUE ( Rejected . GetIsFailed () );
+	EXPECT_NE ( Rejected . GetError () . find ( "INVALID_ENUM" ), std::string::npos );
+	EXPECT_EQ ( Rejected . Get () . GetHandle (), Fallback . GetHandle () );
+	EXPECT_EQ ( Compiler . GetPendingCount (), 0u );
+	#endif
+}
+
+TEST ( TextureLoader, Async )
+{
+	#ifdef LANIAKEA_BUILD_DEBUG // OpenGL low level testing is disabled in release configuration
+	using namespace lk::gfx;
+	// With a one byte budget every Update uploads a single image
+	TextureLoader Loader ( 1, 2, 2 );
+	std::vector<std::shared_ptr<Texture>> Textures;
+	for ( int i = 0; i < 4; i ++ )
+		Textures . push_back ( Loader . Load ( Texture_Path ) );
+	auto Missing = Loader . Load ( "Textures/12345.png" );
+	auto Released = Loader . Load ( Texture_Path );
+	Released . reset ();
+	EXPECT_EQ ( Loader . GetPendingCount (), 6u );
+
+	// The placeholder is bound until the data arrives
+	GLint Width = 0;
+	GLStateCache::GetCurrent () . BindTexture ( 0, GL_TEXTURE_2D, Missing -> GetHandle () );
+	glGetTexLevelParameteriv ( GL_TEXTURE_2D, 0, GL_TEXTURE_WIDTH, & Width );
+	EXPECT_EQ ( Width, 1 );
+	EXPECT_FALSE ( Missing -> GetIsLoaded () );
+
+	// Any of the textures may be uploaded first, the others are still placeholders then
+	const Texture Reference ( Texture_Path );
+	const size_t ImageBytes = size_t ( Reference . GetWidth () ) * Reference . GetHeight () * 4;
+
+	size_t Pending = Loader . GetPendingCount ();
+	const auto Deadline = std::chrono::steady_clock::now () + std::chrono::seconds ( 30 );
+	while ( Pending > 0 && std::chrono::steady_clock::now () < Deadline )
+	{
+		const size_t Left = Loader . Update ();
+		EXPECT_LE ( Loader . GetUploadedBytesCount (), ImageBytes );
+		EXPECT_LE ( Pending - Left, 3u );
+		Pending = Left;
+		std::this_thread::sleep_for ( std::chrono::milliseconds ( 1 ) );
+	}
+	Loader . Finish ();
+	EXPECT_EQ ( Loader . GetPendingCount (), 0u );
+	for ( const auto & Loaded : Textures )
+	{
+		EXPECT_TRUE ( Loaded -> GetIsLoaded () );
+		GLStateCache::GetCurrent () . BindTexture ( 0, GL_TEXTURE_2D, Loaded -> GetHandle () );
+		glGetTexLevelParameteriv ( GL_TEXTURE_2D, 0, GL_TEXTURE_WIDTH, & Width );
+		EXPECT_EQ ( Width, ( GLint ) Loaded -> GetWidth () );
+		EXPECT_GT ( Width, 1 );
+	}
+	EXPECT_FALSE ( Missing -> GetIsLoaded () );
+	ASSERT_EQ ( Loader . GetFailedPaths () . size (), 1u );
+	EXPECT_EQ ( Loader . GetFailedPaths () . front (), "Textures/12345.png" );
+	GLStateCache::GetCurrent () . BindTexture ( 0, GL_TEXTURE_2D, 0 );
+	#endif
+}
+
+TEST ( Texture, Compressed )
+{
+	#ifdef LANIAKEA_BUILD_DEBUG // OpenGL low level testing is disabled in release configuration
+	using namespace lk::gfx;
+	const unsigned int Width = 64, Height = 48;
+	std::vector<unsigned char> Pixels ( Width * Height * 4 );
+	for ( unsigned int y = 0; y < Height; y ++ )
+		for ( unsigned int x = 0; x < Width; x ++ )
+		{
+			unsigned char * Pixel = & Pixels[ ( y * Width + x ) * 4 ];
+			Pixel[ 0 ] = ( unsigned char ) ( x * 4 );
+			Pixel[ 1 ] = ( unsigned char ) ( y * 5 );
+			Pixel[ 2 ] = 128;
+			Pixel[ 3 ] = ( unsigned char ) ( 255 - x * 2 );
+		}
+	EXPECT_THROW ( CompressImage ( Pixels . data (), Width, Height, CompressedFormat::BC7, false, true ), RenderException );
+
+	const auto Directory = std::filesystem::temp_directory_path ();
+	const std::pair<CompressedFormat, std::string> Cases [] = {
+		{ CompressedFormat::BC1, ( Directory / "Laniakea-Test-BC1.dds" ) . string () },
+		{ CompressedFormat::BC3, ( Directory / "Laniakea-Test-BC3.ktx2" ) . string () },
+		{ CompressedFormat::BC3, ( Directory / "Laniakea-Test-BC3.dds" ) . string () } };
+	for ( const auto & [ Format, Path ] : Cases )
+	{
+		const auto Image = CompressImage ( Pixels . data (), Width, Height, Format, false, true );
+		ASSERT_EQ ( Image . Levels . size (), 7u );
+		EXPECT_EQ ( Image . Levels . back () . Width, 1u );
+		EXPECT_EQ ( Image . Levels . front () . Size, GetCompressedSize ( Format, Width, Height ) );
+		SaveCompressedImage ( Image, Path );
+		ASSERT_TRUE ( GetIsCompressedImageFile ( Path ) );
+		const auto Loaded = LoadCompressedImage ( Path );
+		EXPECT_EQ ( Loaded . Format, Format );
+		EXPECT_EQ ( Loaded . Levels . size (), Image . Levels . size () );
+		EXPECT_EQ ( Loaded . Data, Image . Data );
+
+		// The blocks go to the GPU as they are and decode close to the source
+		Texture Compressed ( Path );
+		EXPECT_TRUE ( Compressed . GetIsLoaded () );
+		EXPECT_EQ ( Compressed . GetWidth (), Width );
+		GLStateCache::GetCurrent () . BindTexture ( 0, GL_TEXTURE_2D, Compressed . GetHandle () );
+		GLint IsCompressed = 0, SmallestWidth = 0;
+		glGetTexLevelParameteriv ( GL_TEXTURE_2D, 0, GL_TEXTURE_COMPRESSED, & IsCompressed );
+		glGetTexLevelParameteriv ( GL_TEXTURE_2D, 6, GL_TEXTURE_WIDTH, & SmallestWidth );
+		EXPECT_EQ ( IsCompressed, GL_TRUE );
+		EXPECT_EQ ( SmallestWidth, 1 );
+		std::vector<unsigned char> Decoded ( Pixels . size () );
+		glGetTexImage ( GL_TEXTURE_2D, 0, GL_RGBA, GL_UNSIGNED_BYTE, Decoded . data () );
+		int MaxColorError = 0, MaxAlphaError = 0;
+		for ( size_t i = 0; i < Pixels . size (); i ++ )
+		{
+			const int Error = std::abs ( Decoded[ i ] - Pixels[ i ] );
+			if ( i % 4 == 3 )
+				MaxAlphaError = std::max ( MaxAlphaError, Error );
+			else
+				MaxColorError = std::max ( MaxColorError, Error );
+		}
+		EXPECT_LE ( MaxColorError, 16 );
+		if ( Format == CompressedFormat::BC3 )
+		{
+			EXPECT_LE ( MaxAlphaError, 4 );
+		}
+		GLStateCache::GetCurrent () . BindTexture ( 0, GL_TEXTURE_2D, 0 );
+
+		// The header values are checked against the file before anything is allocated from them
+		const bool IsKTX2 = std::filesystem::path ( Path ) . extension () == ".ktx2";
+		const size_t WidthOffset = IsKTX2 ? 20 : 16, HeightOffset = IsKTX2 ? 24 : 12, LevelsOffset = IsKTX2 ? 40 : 28;
+		std::vector<char> File;
+		{
+			std::ifstream Input ( Path, std::ios::binary );
+			File . assign ( std::istreambuf_iterator<char> ( Input ), std::istreambuf_iterator<char> () );
+		}
+		const auto SaveCorrupted = [ & ] ( std::initializer_list<std::pair<size_t, uint32_t>> Values )
+		{
+			auto Corrupted = File;
+			for ( const auto & [ Offset, Value ] : Values )
+				std::memcpy ( Corrupted . data () + Offset, & Value, sizeof ( Value ) );
+			std::ofstream ( Path, std::ios::binary ) . write ( Corrupted . data (), ( std::streamsize ) Corrupted . size () );
+		};
+		SaveCorrupted ( { { LevelsOffset, 8u } } );
+		EXPECT_THROW ( LoadCompressedImage ( Path ), RenderException );
+		SaveCorrupted ( { { WidthOffset, 1u << 30 }, { HeightOffset, 1u << 30 } } );
+		EXPECT_THROW ( LoadCompressedImage ( Path ), RenderException );
+		SaveCorrupted ( { { WidthOffset, 0xFFFFFFFFu }, { HeightOffset, 0xFFFFFFFFu }, { LevelsOffset, 32u } } );
+		EXPECT_THROW ( LoadCompressedImage ( Path ), RenderException );
+		SaveCorrupted ( {} );
+		EXPECT_EQ ( LoadCompressedImage ( Path ) . Data, Image . Data );
+
+		std::filesystem::resize_file ( Path, 100 );
+		EXPECT_THROW ( LoadCompressedImage ( Path ), RenderException );
+		std::filesystem::remove ( Path );
+	}
+	#endif
+}
+
+TEST ( GLStateCache, Redundant )
+{
+	#ifdef LANIAKEA_BUILD_DEBUG // OpenGL low level testing is disabled in release configuration
+	using namespace lk::gfx;
+	auto & Cache = GLStateCache::GetCurrent ();
+	Cache . Invalidate ();
+	Shader shader ( Simple_VS, Simple_FS );
+	Texture texture ( Texture_Path );
+	shader . Unbind ();
+
+	Cache . BeginFrame ();
+	shader . Bind ();
+	EXPECT_EQ ( Cache . GetAvoidedCallsCount (), 0u );
+	shader . Bind ();
+	shader . Bind ();
+	EXPECT_EQ ( Cache . GetAvoidedCallsCount (), 2u );
+	EXPECT_EQ ( Cache . GetProgram (), shader . GetHandle () );
+
+	// Rebinding the same texture to the unit neither activates the unit nor binds it
+	Cache . BindTexture ( 3, GL_TEXTURE_2D, texture . GetHandle () );
+	const auto Issued = Cache . GetIssuedCallsCount ();
+	Cache . BindTexture ( 3, GL_TEXTURE_2D, texture . GetHandle () );
+	EXPECT_EQ ( Cache . GetIssuedCallsCount (), Issued );
+	GLint Bound = 0;
+	GLint ActiveUnit = 0;
+	glGetIntegerv ( GL_TEXTURE_BINDING_2D, & Bound );
+	glGetIntegerv ( GL_ACTIVE_TEXTURE, & ActiveUnit );
+	EXPECT_EQ ( Bound, GLint ( texture . GetHandle () ) );
+	EXPECT_EQ ( ActiveUnit, GLint ( GL_TEXTURE0 + 3 ) );
+	EXPECT_THROW ( Cache . BindTexture ( GLStateCache::TextureUnitsCount, GL_TEXTURE_2D, 0 ), RenderException );
+
+	Cache . SetDepthTest ( true );
+	Cache . SetDepthTest ( true );
+	EXPECT_TRUE ( glIsEnabled ( GL_DEPTH_TEST ) );
+	Cache . SetDepthTest ( false );
+	EXPECT_FALSE ( glIsEnabled ( GL_DEPTH_TEST ) );
+
+	// A deleted buffer is unbound by GL, the cache must not skip binding a new buffer reusing its name
+	unsigned int Handle = 0;
+	{
+		Attribute Buffer;
+		std::vector <float> Data { 1.f };
+		Buffer . Set ( Data );
+		Handle = Buffer . GetHandle ();
+		EXPECT_EQ ( Cache . GetBuffer ( GL_ARRAY_BUFFER ), Handle );
+	}
+	EXPECT_EQ ( Cache . GetBuffer ( GL_ARRAY_BUFFER ), 0u );
+
+	// State changed behind the cache is picked up after the invalidation
+	glUseProgram ( 0 );
+	Cache . Invalidate ();
+	EXPECT_EQ ( Cache . GetProgram (), GLStateCache::Unknown );
+	shader . Bind ();
+	GLint Program = 0;
+	glGetIntegerv ( GL_CURRENT_PROGRAM, & Program );
+	EXPECT_EQ ( Program, GLint ( shader . GetHandle () ) );
+
+	texture . Unset ( 3 );
+	shader . Unbind ();
+	Cache . BeginFrame ();
+	EXPECT_EQ ( Cache . GetAvoidedCallsCount (), 0u );
+	EXPECT_EQ ( Cache . GetIssuedCallsCount (), 0u );
+	#endif
+}
+
 int main ( int argc, char ** argv )
 {
 	if ( !glfwInit() )
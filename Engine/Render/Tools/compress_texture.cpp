@@ -0,0 +1,67 @@
+#include "Laniakea/Render/BlockCompression.h"
+#include "Laniakea/Render/CompressedImage.h"
+#include "Laniakea/Render/RenderException.h"
+#include "stb/stb_image.h"
+#include <chrono>
+#include <iostream>
+#include <string>
+
+int main ( int argc, char ** argv )
+{
+	if ( argc < 3 )
+	{
+		std::cerr << "Usage: Compress-Texture <image> <output.dds|output.ktx2> [--bc1|--bc3] [--srgb] [--no-mips]" << std::endl;
+		return 1;
+	}
+	// BC1 unless the image has an alpha channel
+	int Format = -1;
+	bool IsSRGB = false;
+	bool GenerateMips = true;
+	for ( int i = 3; i < argc; i ++ )
+	{
+		const std::string Argument = argv[ i ];
+		if ( Argument == "--bc1" )
+			Format = ( int ) lk::gfx::CompressedFormat::BC1;
+		else if ( Argument == "--bc3" )
+			Format = ( int ) lk::gfx::CompressedFormat::BC3;
+		else if ( Argument == "--srgb" )
+			IsSRGB = true;
+		else if ( Argument == "--no-mips" )
+			GenerateMips = false;
+		else
+		{
+			std::cerr << "Unknown option " << Argument << std::endl;
+			return 1;
+		}
+	}
+
+	int Width = 0, Height = 0, Channels = 0;
+	unsigned char * Pixels = stbi_load ( argv[ 1 ], & Width, & Height, & Channels, 4 );
+	if ( Pixels == nullptr )
+	{
+		std::cerr << "Can't load image " << argv[ 1 ] << ": " << stbi_failure_reason () << std::endl;
+		return 1;
+	}
+	if ( Format < 0 )
+		Format = ( int ) ( Channels == 2 || Channels == 4 ? lk::gfx::CompressedFormat::BC3 : lk::gfx::CompressedFormat::BC1 );
+
+	try
+	{
+		const auto Start = std::chrono::steady_clock::now ();
+		const auto Image = lk::gfx::CompressImage ( Pixels, ( unsigned int ) Width, ( unsigned int ) Height,
+													( lk::gfx::CompressedFormat ) Format, IsSRGB, GenerateMips );
+		const auto Elapsed = std::chrono::duration<double, std::milli> ( std::chrono::steady_clock::now () - Start );
+		lk::gfx::SaveCompressedImage ( Image, argv[ 2 ] );
+		std::cout << argv[ 1 ] << ": " << Width << "x" << Height << ", " << Image . Levels . size () << " levels, "
+				  << ( Format == ( int ) lk::gfx::CompressedFormat::BC1 ? "BC1" : "BC3" ) << ( IsSRGB ? " sRGB" : "" ) << ", "
+				  << ( size_t ) Width * Height * 4 << " -> " << Image . Data . size () << " bytes in " << Elapsed . count () << " ms" << std::endl;
+	}
+	catch ( const lk::gfx::RenderException & Exception )
+	{
+		std::cerr << Exception . what () << std::endl;
+		stbi_image_free ( Pixels );
+		return 1;
+	}
+	stbi_image_free ( Pixels );
+	return 0;
+}
@@ -0,0 +1,193 @@
+#include "glad/glad.h"
+#include "GLFW/glfw3.h"
+#include "Laniakea/ECS/ECS.h"
+#include "Laniakea/Render/GLStateCache.h"
+#include "Laniakea/Render/IndexBuffer.h"
+#include "Laniakea/Render/Renderer.h"
+#include "Laniakea/Render/Shader.h"
+#include "Laniakea/Render/StreamBuffer.h"
+#include "Laniakea/Render/Uniform.h"
+#include "Laniakea/Render/VertexArray.h"
+#include "Laniakea/Scene/InstanceBuffer.h"
+#include "Laniakea/Scene/TransformSystem.h"
+#include "glm/glm.hpp"
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+
+// Compares drawing the same mesh once per object with a matrix uniform each against one instanced draw call.
+// Run on a software GL context, e.g. LIBGL_ALWAYS_SOFTWARE=1 with Mesa, to measure the CPU cost of the draw
+// submission rather than the GPU; glFinish closes each frame so the driver work is included.
+
+const char * PerObject_VS = "#version 330 core\n"
+							"layout (location = 0) in vec3 aPos;\n"
+							"uniform mat4 Model;\n"
+							"void main()\n"
+							"{\n"
+							"    gl_Position = Model * vec4(aPos, 1.0);\n"
+							"}";
+
+const char * Instanced_VS = "#version 330 core\n"
+							"layout (location = 0) in vec3 aPos;\n"
+							"layout (location = 1) in mat4 aModel;\n"
+							"void main()\n"
+							"{\n"
+							"    gl_Position = aModel * vec4(aPos, 1.0);\n"
+							"}";
+
+const char * Rock_FS = "#version 330 core\n"
+					   "out vec4 FragColor;\n"
+					   "void main()\n"
+					   "{\n"
+					   "    FragColor = vec4(0.5, 0.4, 0.3, 1.0);\n"
+					   "}";
+
+struct RockComponent : public ComponentBase
+{
+	explicit RockComponent ( EntityHandle owner )
+			: ComponentBase ( owner )
+	{};
+};
+
+template <typename Func>
+double MeasureMicroseconds ( std::size_t iterations, Func && func )
+{
+	const auto Start = std::chrono::steady_clock::now ();
+	for ( std::size_t i = 0; i < iterations; i ++ )
+		func ();
+	const std::chrono::duration <double, std::micro> Elapsed = std::chrono::steady_clock::now () - Start;
+	return Elapsed . count () / ( double ) iterations;
+}
+
+void Report ( const std::string & name, std::size_t rocksCount, double microseconds )
+{
+	std::cout << std::left << std::setw ( 48 ) << name << std::setw ( 10 ) << rocksCount
+			<< std::fixed << std::setprecision ( 2 ) << microseconds << " us" << std::endl;
+}
+
+void RunInstancingBenchmark ( std::size_t rocksCount )
+{
+	using namespace lk::gfx;
+	ECS ecs;
+	ecs . RegisterComponent <TransformComponent> ();
+	ecs . RegisterComponent <RockComponent> ();
+	ecs . RegisterSystem <TransformSystem, TransformComponent> ();
+	const auto Rocks = ecs . RegisterQuery <TransformComponent, query::With <RockComponent>> ();
+
+	// Rocks of about a pixel scattered over the viewport, so the rasterization of the software context doesn't hide the submission
+	std::default_random_engine Generator;
+	std::uniform_real_distribution <float> Distribution ( - 1.f, 1.f );
+	for ( std::size_t i = 0; i < rocksCount; i ++ ) {
+		const auto e = ecs . CreateEntity ();
+		TransformComponent Transform ( e );
+		Transform . SetPosition ( { Distribution ( Generator ), Distribution ( Generator ), 0.f } );
+		const float Angle = Distribution ( Generator );
+		Transform . SetRotation ( { 0.f, 0.f, std::sin ( Angle * 0.5f ), std::cos ( Angle * 0.5f ) } );
+		Transform . SetScale ( { 0.002f, 0.002f, 0.002f } );
+		ecs . AddComponent <TransformComponent> ( e, Transform );
+		ecs . AddComponent <RockComponent> ( e, RockComponent ( e ) );
+	}
+	ecs . RunSystem <TransformSystem> ();
+
+	// A cube standing in for the rock mesh
+	std::vector <float> Vertices {
+			- 1.f, - 1.f, - 1.f, 1.f, - 1.f, - 1.f, 1.f, 1.f, - 1.f, - 1.f, 1.f, - 1.f,
+			- 1.f, - 1.f, 1.f, 1.f, - 1.f, 1.f, 1.f, 1.f, 1.f, - 1.f, 1.f, 1.f
+	};
+	std::vector <unsigned int> Indices {
+			0, 1, 2, 0, 2, 3, 4, 6, 5, 4, 7, 6, 0, 4, 5, 0, 5, 1,
+			3, 2, 6, 3, 6, 7, 0, 3, 7, 0, 7, 4, 1, 5, 6, 1, 6, 2
+	};
+	Attribute Positions;
+	IndexBuffer MeshIndices;
+	Positions . Set ( Vertices );
+	MeshIndices . Set ( Indices );
+
+	VertexLayout MeshLayout;
+	MeshLayout . AddStream () . Add ( 0, 3, GL_FLOAT );
+	VertexArray Mesh ( MeshLayout, { Positions }, & MeshIndices );
+
+	StreamBuffer Staging;
+	InstanceBuffer Instances ( Staging );
+	VertexLayout InstancedLayout;
+	InstancedLayout . AddStream () . Add ( 0, 3, GL_FLOAT );
+	InstanceBuffer::AddInstanceStream ( InstancedLayout, 1 );
+	VertexArray InstancedMesh ( InstancedLayout, { Positions, Instances . GetBuffer () }, & MeshIndices );
+
+	Shader PerObjectShader ( PerObject_VS, Rock_FS );
+	Shader InstancedShader ( Instanced_VS, Rock_FS );
+	const auto ModelSlot = PerObjectShader . GetUniformLocation ( "Model" );
+	auto & Cache = GLStateCache::GetCurrent ();
+
+	std::uint64_t PerObjectAvoided = 0;
+	Report ( "per object: uniform + draw each", rocksCount, MeasureMicroseconds ( 20, [ & ] ()
+	{
+		Cache . BeginFrame ();
+		glClear ( GL_COLOR_BUFFER_BIT );
+		PerObjectShader . Bind ();
+		ecs . ForEach ( Rocks, [ & ] ( EntityHandle, const TransformComponent & transform, RockComponent & )
+		{
+			glm::mat4 Model;
+			std::memcpy ( & Model, transform . GetWorldMatrix () . Elements, sizeof ( Model ) );
+			Uniform::Set <glm::mat4> ( ModelSlot, & Model, 1 );
+			Renderer::Render ( Mesh, DrawMode::Triangles );
+		} );
+		glFinish ();
+		PerObjectAvoided = Cache . GetAvoidedCallsCount ();
+	} ) );
+
+	std::uint64_t InstancedAvoided = 0;
+	Report ( "instanced: gather + one draw", rocksCount, MeasureMicroseconds ( 20, [ & ] ()
+	{
+		Cache . BeginFrame ();
+		glClear ( GL_COLOR_BUFFER_BIT );
+		InstancedShader . Bind ();
+		Instances . Gather ( ecs, Rocks );
+		Renderer::RenderInstanced ( InstancedMesh, Instances . GetInstancesCount (), DrawMode::Triangles );
+		Staging . Fence ();
+		glFinish ();
+		InstancedAvoided = Cache . GetAvoidedCallsCount ();
+	} ) );
+
+	Report ( "instanced: gather only", rocksCount, MeasureMicroseconds ( 20, [ & ] ()
+	{
+		std::vector <Matrix4> Matrices;
+		GatherInstanceTransforms ( ecs, Rocks, Matrices );
+	} ) );
+	Mesh . Unbind ();
+	std::cout << "(draw calls per frame: per object " << Rocks . Size () << ", instanced 1; redundant binds skipped per frame: per object "
+			<< PerObjectAvoided << ", instanced " << InstancedAvoided << ")" << std::endl << std::endl;
+}
+
+int main ()
+{
+	if ( ! glfwInit () )
+	{
+		std::cerr << "Error: glfw can't be initialized" << std::endl;
+		return 1;
+	}
+	glfwWindowHint ( GLFW_VISIBLE, GLFW_FALSE );
+	GLFWwindow * Window = glfwCreateWindow ( 800, 600, "Instancing Benchmark", NULL, NULL );
+	if ( ! Window )
+	{
+		std::cerr << "Error: glfw window can't be created" << std::endl;
+		return 1;
+	}
+	glfwMakeContextCurrent ( Window );
+	if ( ! gladLoadGLLoader ( ( GLADloadproc ) glfwGetProcAddress ) )
+	{
+		std::cerr << "Error: GLAD can't be initialized" << std::endl;
+		return 1;
+	}
+	std::cout << "GL renderer: " << glGetString ( GL_RENDERER ) << std::endl << std::endl;
+
+	for ( const std::size_t RocksCount : { 1000, 5000, 20000 } ) {
+		RunInstancingBenchmark ( RocksCount );
+	}
+	glfwTerminate ();
+	return 0;
+}
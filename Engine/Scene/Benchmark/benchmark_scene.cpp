@@ -0,0 +1,104 @@
+#include "Laniakea/ECS/ECS.h"
+#include "Laniakea/Scene/TransformSystem.h"
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <unordered_map>
+
+template <typename Func>
+double MeasureMicroseconds ( std::size_t iterations, Func && func )
+{
+	const auto Start = std::chrono::steady_clock::now ();
+	for ( std::size_t i = 0; i < iterations; i ++ )
+		func ();
+	const std::chrono::duration <double, std::micro> Elapsed = std::chrono::steady_clock::now () - Start;
+	return Elapsed . count () / ( double ) iterations;
+}
+
+void Report ( const std::string & name, std::size_t transformsCount, double microseconds )
+{
+	std::cout << std::left << std::setw ( 48 ) << name << std::setw ( 10 ) << transformsCount
+			<< std::fixed << std::setprecision ( 2 ) << microseconds << " us" << std::endl;
+}
+
+void RunTransformBenchmark ( std::size_t transformsCount )
+{
+	ECS ecs;
+	ecs . RegisterComponent <TransformComponent> ();
+	ecs . RegisterSystem <TransformSystem, TransformComponent> ();
+	auto System = ecs . GetSystem <TransformSystem> () . lock ();
+
+	// Hierarchies of about a hundred transforms, e.g. skeletons or prefabs
+	std::default_random_engine Generator;
+	std::uniform_real_distribution <float> Distribution ( - 1.f, 1.f );
+	std::vector <EntityHandle> Entities;
+	for ( std::size_t i = 0; i < transformsCount; i ++ ) {
+		auto e = ecs . CreateEntity ();
+		const auto Parent = i % 100 != 0 ? Entities[ i - 1 - Generator () % ( i % 100 ) ] : NULL_HANDLE;
+		TransformComponent Transform ( e, Parent );
+		Transform . SetPosition ( { Distribution ( Generator ), Distribution ( Generator ), Distribution ( Generator ) } );
+		const float Angle = Distribution ( Generator );
+		Transform . SetRotation ( { 0.f, 0.f, std::sin ( Angle * 0.5f ), std::cos ( Angle * 0.5f ) } );
+		ecs . AddComponent <TransformComponent> ( e, Transform );
+		Entities . push_back ( e );
+	}
+	const auto Transforms = ecs . GetComponentsByType <TransformComponent> () . lock ();
+
+	Report ( "hierarchy build + sort + all matrices", transformsCount, MeasureMicroseconds ( 1, [ & ] ()
+	{
+		ecs . RunSystem <TransformSystem> ();
+	} ) );
+
+	Report ( "all roots moved", transformsCount, MeasureMicroseconds ( 30, [ & ] ()
+	{
+		for ( std::size_t i = 0; i < transformsCount; i += 100 ) {
+			Transforms -> GetObjectByIndex ( i ) . SetPosition ( { Distribution ( Generator ), 0.f, 0.f } );
+		}
+		ecs . RunSystem <TransformSystem> ();
+	} ) );
+
+	Report ( "1% of leaves moved", transformsCount, MeasureMicroseconds ( 30, [ & ] ()
+	{
+		for ( std::size_t i = 99; i < transformsCount; i += 100 ) {
+			Transforms -> GetObjectByIndex ( i ) . SetPosition ( { Distribution ( Generator ), 0.f, 0.f } );
+		}
+		ecs . RunSystem <TransformSystem> ();
+	} ) );
+
+	Report ( "no changes", transformsCount, MeasureMicroseconds ( 30, [ & ] ()
+	{
+		ecs . RunSystem <TransformSystem> ();
+	} ) );
+
+	// The baseline multiplies the matrices one by one in the same order
+	std::vector <Matrix4> WorldMatrices ( transformsCount );
+	std::unordered_map <EntityHandle, std::size_t> Indices;
+	for ( std::size_t i = 0; i < transformsCount; i ++ ) {
+		Indices[ Transforms -> GetObjectByIndex ( i ) . GetOwner () ] = i;
+	}
+	std::vector <std::size_t> ParentIndices ( transformsCount );
+	for ( std::size_t i = 0; i < transformsCount; i ++ ) {
+		const auto Parent = Transforms -> GetObjectByIndex ( i ) . GetParent ();
+		ParentIndices[ i ] = Parent != NULL_HANDLE ? Indices[ Parent ] : SIZE_MAX;
+	}
+	Report ( "baseline: one by one, all matrices", transformsCount, MeasureMicroseconds ( 30, [ & ] ()
+	{
+		for ( std::size_t i = 0; i < transformsCount; i ++ ) {
+			const auto & Transform = Transforms -> GetObjectByIndex ( i );
+			const auto Local = Matrix4::FromTRS ( Transform . GetPosition (), Transform . GetRotation (), Transform . GetScale () );
+			WorldMatrices[ i ] = ParentIndices[ i ] != SIZE_MAX ? WorldMatrices[ ParentIndices[ i ] ] * Local : Local;
+		}
+	} ) );
+	std::cout << "(checksum " << WorldMatrices . back () . Elements[ 12 ] + System -> GetWorldMatrices () . back () . Elements[ 12 ] << ")" << std::endl << std::endl;
+}
+
+int main ()
+{
+	for ( const std::size_t TransformsCount : { 10000, 100000 } ) {
+		RunTransformBenchmark ( TransformsCount );
+	}
+	return 0;
+}
@@ -0,0 +1,16 @@
+#pragma once
+
+#ifdef LANIAKEA_PLATFORM_WINDOWS
+	#ifdef LANIAKEA_BUILD_DLL
+		#define LANIAKEA_SCENE_API __declspec (dllexport)
+	#else
+		#define LANIAKEA_SCENE_API __declspec(dllimport)
+	#endif
+#else
+	#error Laniakea supports only windows
+#endif
+
+// SSE2 is the baseline of x64, the scalar path is used on other targets
+#if defined ( __SSE2__ ) || defined ( _M_X64 ) || ( defined ( _M_IX86_FP ) && _M_IX86_FP >= 2 )
+	#define LANIAKEA_SCENE_SSE 1
+#endif
@@ -0,0 +1,116 @@
+#pragma once
+
+#include "TransformComponent.h"
+#include "Laniakea/ECS/ECS.h"
+#include "Laniakea/Render/Attribute.h"
+#include "Laniakea/Render/StreamBuffer.h"
+#include "Laniakea/Render/VertexLayout.h"
+#include <span>
+#include <vector>
+
+/**
+ * @brief Appends the world matrices of the entities of the query.
+ * @tparam Terms The query terms following the TransformComponent, e.g. query::With <RockComponent> selecting the mesh.
+ * @param ecs The ECS owning the components.
+ * @param query The registered query, the TransformComponent must be its first term.
+ * @param matrices The buffer receiving the matrices in the order of the query.
+ * @return The number of the appended matrices.
+ */
+template <typename ... Terms>
+std::size_t GatherInstanceTransforms ( ECS & ecs, const Query <TransformComponent, Terms ...> & query, std::vector <Matrix4> & matrices )
+{
+	const auto First = matrices . size ();
+	matrices . reserve ( First + query . Size () );
+	ecs . ForEach ( query, [ & ] ( EntityHandle, const TransformComponent & transform, auto && ... )
+	{
+		matrices . push_back ( transform . GetWorldMatrix () );
+	} );
+	return matrices . size () - First;
+}
+
+/**
+ * @class InstanceBuffer
+ * @brief Streams the world matrices of the instances of a mesh to the per instance vertex buffer.
+ *
+ * The matrices are gathered from the ECS each frame, written to the staging ring and copied into the buffer on the GPU,
+ * so the upload neither reallocates the storage nor waits for the draws of the previous frame. The storage only grows
+ * when the number of instances exceeds it. The mesh is then drawn with one instanced draw call instead of a draw call
+ * and a matrix uniform per object. The buffer is the source of the stream added by AddInstanceStream, a mat4 attribute
+ * taking four consecutive locations. The buffer requires the current GL context.
+ */
+class LANIAKEA_SCENE_API InstanceBuffer
+{
+
+public:
+
+	/**
+     * @brief Constructor for InstanceBuffer.
+     * @param staging The staging ring the matrices are written to, must outlive the buffer. The owner calls
+     * StreamBuffer::Fence once the draws of the frame are issued.
+     */
+	explicit InstanceBuffer ( lk::gfx::StreamBuffer & staging );
+
+	InstanceBuffer ( const InstanceBuffer & ) = delete;
+
+	InstanceBuffer & operator = ( const InstanceBuffer & ) = delete;
+
+	/**
+     * @brief Adds the per instance stream of the world matrices to the layout.
+     * @param layout The layout of the mesh, the buffer sources the stream added last.
+     * @param firstSlot The location of the mat4 attribute, the columns take the locations firstSlot to firstSlot + 3.
+     */
+	static void AddInstanceStream ( lk::gfx::VertexLayout & layout, unsigned int firstSlot );
+
+	/**
+     * @brief Gathers the world matrices of the entities of the query and uploads them.
+     * Throws lk::gfx::RenderException if the matrices exceed the capacity of the staging ring.
+     * @param ecs The ECS owning the components.
+     * @param query The registered query, the TransformComponent must be its first term.
+     * @return The number of the instances.
+     */
+	template <typename ... Terms>
+	std::size_t Gather ( ECS & ecs, const Query <TransformComponent, Terms ...> & query )
+	{
+		m_Matrices . clear ();
+		GatherInstanceTransforms ( ecs, query, m_Matrices );
+		Upload ();
+		return m_Matrices . size ();
+	}
+
+	/**
+     * @brief Uploads the matrices, e.g. TransformSystem::GetWorldMatrices drawing every transform with the mesh.
+     * @param matrices The world matrices of the instances.
+     * @return The number of the instances.
+     */
+	std::size_t Gather ( std::span <const Matrix4> matrices );
+
+	/**
+     * @brief Get the vertex buffer of the matrices.
+     * @return A constant reference to the buffer, the source of the instance stream of the vertex array.
+     */
+	const lk::gfx::Attribute & GetBuffer () const;
+
+	/**
+     * @brief Get the number of the uploaded instances.
+     * @return The instance count of the instanced draw.
+     */
+	unsigned int GetInstancesCount () const;
+
+	/**
+     * @brief Get the matrices of the last upload.
+     * @return A span over the matrices, valid until the next gather.
+     */
+	std::span <const Matrix4> GetMatrices () const;
+
+private:
+
+	/**
+     * @brief Uploads the gathered matrices to the buffer.
+     */
+	void Upload ();
+
+	lk::gfx::Attribute m_Buffer; /**< The per instance world matrices. */
+	lk::gfx::StreamBuffer & m_Staging; /**< The staging ring of the uploads. */
+	unsigned int m_Capacity = 0; /**< The number of matrices the buffer storage holds. */
+	std::vector <Matrix4> m_Matrices; /**< The gathered matrices, reused between the frames. */
+};
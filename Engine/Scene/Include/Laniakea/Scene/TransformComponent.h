@@ -0,0 +1,141 @@
+#pragma once
+
+#include "Core.h"
+#include "Laniakea/ECS/ComponentBase.h"
+#include "Laniakea/ECS/SpatialPartition.h"
+
+/**
+ * @struct Quaternion
+ * @brief Unit quaternion describing the rotation.
+ */
+struct LANIAKEA_SCENE_API Quaternion
+{
+	float X = 0.f;
+	float Y = 0.f;
+	float Z = 0.f;
+	float W = 1.f;
+};
+
+/**
+ * @struct Matrix4
+ * @brief Column major 4x4 matrix, the memory layout matches glm::mat4 and the GL uniforms.
+ */
+struct LANIAKEA_SCENE_API Matrix4
+{
+	float Elements[ 16 ] = { 1.f, 0.f, 0.f, 0.f, 0.f, 1.f, 0.f, 0.f, 0.f, 0.f, 1.f, 0.f, 0.f, 0.f, 0.f, 1.f }; /**< The columns one after another. */
+
+	/**
+     * @brief Builds the matrix applying the scale, the rotation and the translation in this order.
+     * @param translation The translation.
+     * @param rotation The unit quaternion of the rotation.
+     * @param scale The scale along each axis.
+     * @return The affine matrix.
+     */
+	static Matrix4 FromTRS ( const SpatialPoint & translation, const Quaternion & rotation, const SpatialPoint & scale );
+
+	/**
+     * @brief Get the element of the matrix.
+     * @param row The row of the element.
+     * @param column The column of the element.
+     * @return The element.
+     */
+	float Get ( std::size_t row, std::size_t column ) const;
+
+	/**
+     * @brief Multiplies the matrices, the right hand side is applied first.
+     */
+	Matrix4 operator * ( const Matrix4 & rhs ) const;
+};
+
+/**
+ * @struct TransformComponent
+ * @brief Position, rotation and scale of the entity relative to its parent, processed by the TransformSystem.
+ *
+ * The setters mark the transform dirty, the TransformSystem recomputes the world matrices of the dirty transforms
+ * and of their descendants only. The world matrix is the one computed by the last update of the system.
+ */
+class LANIAKEA_SCENE_API TransformComponent : public ComponentBase
+{
+
+public:
+
+	/**
+     * @brief Constructor for TransformComponent.
+     * @param owner The handle of the entity that owns this component.
+     * @param parent The entity the transform is relative to, NULL_HANDLE for the world space.
+     */
+	explicit TransformComponent ( EntityHandle owner, EntityHandle parent = NULL_HANDLE );
+
+	/**
+     * @brief Set the translation relative to the parent.
+     * @param position The translation.
+     */
+	void SetPosition ( const SpatialPoint & position );
+
+	/**
+     * @brief Get the translation relative to the parent.
+     * @return A constant reference to the translation.
+     */
+	const SpatialPoint & GetPosition () const;
+
+	/**
+     * @brief Set the rotation relative to the parent.
+     * @param rotation The unit quaternion of the rotation.
+     */
+	void SetRotation ( const Quaternion & rotation );
+
+	/**
+     * @brief Get the rotation relative to the parent.
+     * @return A constant reference to the rotation.
+     */
+	const Quaternion & GetRotation () const;
+
+	/**
+     * @brief Set the scale relative to the parent.
+     * @param scale The scale along each axis.
+     */
+	void SetScale ( const SpatialPoint & scale );
+
+	/**
+     * @brief Get the scale relative to the parent.
+     * @return A constant reference to the scale.
+     */
+	const SpatialPoint & GetScale () const;
+
+	/**
+     * @brief Set the parent of the transform, the hierarchy is rebuilt by the next update.
+     * @param parent The entity the transform is relative to, NULL_HANDLE for the world space.
+     *
+     * The parent without a TransformComponent, or closing a cycle, is ignored and the transform is in the world space.
+     */
+	void SetParent ( EntityHandle parent );
+
+	/**
+     * @brief Get the parent of the transform.
+     * @return The entity the transform is relative to, NULL_HANDLE for the world space.
+     */
+	EntityHandle GetParent () const;
+
+	/**
+     * @brief Get the world matrix computed by the last update of the TransformSystem.
+     * @return A constant reference to the cached world matrix.
+     */
+	const Matrix4 & GetWorldMatrix () const;
+
+	/**
+     * @brief Check whether the local transform has changed since the last update.
+     * @return True if the world matrix is out of date.
+     */
+	bool GetIsDirty () const;
+
+private:
+	friend class TransformSystem;
+
+	SpatialPoint m_Position; /**< The translation relative to the parent. */
+	Quaternion m_Rotation; /**< The rotation relative to the parent. */
+	SpatialPoint m_Scale = { 1.f, 1.f, 1.f }; /**< The scale relative to the parent. */
+	EntityHandle m_Parent; /**< The entity the transform is relative to. */
+	Matrix4 m_WorldMatrix; /**< The world matrix cache. */
+	bool m_IsDirty = true; /**< Whether the local transform has changed since the last update. */
+	bool m_IsParentChanged = true; /**< Whether the parent has changed since the last update. */
+};
@@ -0,0 +1,103 @@
+#pragma once
+
+#include "TransformComponent.h"
+#include "Laniakea/ECS/System.h"
+#include <cstdint>
+#include <span>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @class TransformSystem
+ * @brief Propagates the TransformComponent hierarchy into the world matrices.
+ *
+ * Registered as ecs . RegisterSystem <TransformSystem, TransformComponent> (). The transforms are ordered by their
+ * depth in the hierarchy, so each parent is computed before its children. When the hierarchy changes, Run also sorts
+ * the component array into this order, unless a group owns it, so the updates walk the components linearly. Only the
+ * dirty transforms and their descendants are recomputed, four matrices at a time with SSE. The world matrices are also
+ * written to a packed array in the hierarchy order, which the renderer uploads directly together with the matching
+ * entity array.
+ */
+class LANIAKEA_SCENE_API TransformSystem : public System
+{
+
+public:
+
+	static constexpr std::uint32_t NoParent = UINT32_MAX; /**< The parent slot of the root transforms. */
+
+	/**
+     * @brief Updates the world matrices of the TransformComponent array of the ECS.
+     * @param ecs The ECS owning the components.
+     */
+	void Run ( ECS & ecs ) override;
+
+	/**
+     * @brief Updates the world matrices of the transforms.
+     * @param transforms The transforms, e.g. the packed TransformComponent array. Their world matrix caches are updated.
+     */
+	void Update ( std::span <TransformComponent> transforms );
+
+	/**
+     * @brief Get the world matrices in the hierarchy order.
+     * @return A span over the packed matrices, valid until the next update.
+     */
+	std::span <const Matrix4> GetWorldMatrices () const;
+
+	/**
+     * @brief Get the entities of the world matrices.
+     * @return A span over the owners of the matrices returned by GetWorldMatrices.
+     */
+	std::span <const EntityHandle> GetEntities () const;
+
+	/**
+     * @brief Get the number of the world matrices recomputed by the last update.
+     * @return The number of the dirty transforms and their descendants.
+     */
+	std::size_t GetLastUpdatedCount () const;
+
+	/**
+     * @brief Get the depth of the hierarchy.
+     * @return The number of the levels, one if all transforms are in the world space.
+     */
+	std::size_t GetLevelsCount () const;
+
+private:
+
+	/**
+     * @brief Rebuilds the hierarchy if the transforms were added, removed or reparented.
+     * @return True if the hierarchy was rebuilt.
+     */
+	bool UpdateHierarchy ( std::span <TransformComponent> transforms );
+
+	/**
+     * @brief Orders the transforms by their depth and resolves the parent slots.
+     */
+	void BuildHierarchy ( std::span <TransformComponent> transforms );
+
+	/**
+     * @brief Sorts the component array into the hierarchy order, so each slot is the component index.
+     */
+	void SortComponents ( ObjectManager <TransformComponent> & components );
+
+	/**
+     * @brief Recomputes the world matrices of the dirty transforms and their descendants.
+     */
+	void UpdateWorldMatrices ( std::span <TransformComponent> transforms, bool isAllDirty );
+
+	/**
+     * @brief Computes the world matrices of the slots, none of them may be the parent of another.
+     */
+	void ComputeWorldMatrices ( const std::uint32_t * slots, std::size_t count, std::span <TransformComponent> transforms );
+
+	std::vector <EntityHandle> m_Owners; /**< The owners of the components at the last update, detect the structural changes. */
+	std::vector <std::uint32_t> m_Order; /**< The component index of each slot. */
+	std::vector <std::uint32_t> m_ParentSlots; /**< The slot of the parent of each slot, NoParent for the roots. */
+	std::vector <std::uint32_t> m_LevelStarts; /**< The first slot of each level followed by the number of slots. */
+	std::vector <Matrix4> m_WorldMatrices; /**< The world matrix of each slot. */
+	std::vector <EntityHandle> m_Entities; /**< The owner of each slot. */
+	std::vector <std::uint8_t> m_IsSlotDirty; /**< Whether the slot is recomputed by the current update. */
+	std::vector <std::uint32_t> m_DirtySlots; /**< The dirty slots of the current level, reused between the levels. */
+	std::vector <std::uint32_t> m_Scratch; /**< The parent indices and the child lists of the hierarchy build. */
+	std::unordered_map <EntityHandle, std::uint32_t> m_ComponentIndices; /**< The component index of each owner during the hierarchy build. */
+	std::size_t m_LastUpdatedCount = 0; /**< The number of the world matrices recomputed by the last update. */
+};
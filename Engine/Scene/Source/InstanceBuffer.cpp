@@ -0,0 +1,50 @@
+#include "Laniakea/Scene/InstanceBuffer.h"
+#include "glad/glad.h"
+#include <algorithm>
+
+InstanceBuffer::InstanceBuffer ( lk::gfx::StreamBuffer & staging )
+: m_Staging ( staging )
+{
+
+}
+
+void InstanceBuffer::AddInstanceStream ( lk::gfx::VertexLayout & layout, unsigned int firstSlot )
+{
+	layout . AddStream ( sizeof ( Matrix4 ), 1 );
+	for ( unsigned int Column = 0; Column < 4; Column ++ ) {
+		layout . Add ( { firstSlot + Column, 4, GL_FLOAT, ( unsigned int ) ( Column * 4 * sizeof ( float ) ) } );
+	}
+}
+
+std::size_t InstanceBuffer::Gather ( std::span <const Matrix4> matrices )
+{
+	m_Matrices . assign ( matrices . begin (), matrices . end () );
+	Upload ();
+	return m_Matrices . size ();
+}
+
+const lk::gfx::Attribute & InstanceBuffer::GetBuffer () const
+{
+	return m_Buffer;
+}
+
+unsigned int InstanceBuffer::GetInstancesCount () const
+{
+	return ( unsigned int ) m_Matrices . size ();
+}
+
+std::span <const Matrix4> InstanceBuffer::GetMatrices () const
+{
+	return m_Matrices;
+}
+
+void InstanceBuffer::Upload ()
+{
+	const auto Count = ( unsigned int ) m_Matrices . size ();
+	if ( Count > m_Capacity )
+	{
+		m_Capacity = std::max ( Count, m_Capacity * 2 );
+		m_Buffer . Allocate <Matrix4> ( m_Capacity );
+	}
+	m_Buffer . Update ( m_Matrices . data (), 0, Count, m_Staging );
+}
\ No newline at end of file
@@ -0,0 +1,101 @@
+#include "Laniakea/Scene/TransformComponent.h"
+
+Matrix4 Matrix4::FromTRS ( const SpatialPoint & translation, const Quaternion & rotation, const SpatialPoint & scale )
+{
+	const auto & q = rotation;
+	Matrix4 Result;
+	Result . Elements[ 0 ] = ( 1.f - 2.f * ( q . Y * q . Y + q . Z * q . Z ) ) * scale . X;
+	Result . Elements[ 1 ] = ( 2.f * ( q . X * q . Y + q . W * q . Z ) ) * scale . X;
+	Result . Elements[ 2 ] = ( 2.f * ( q . X * q . Z - q . W * q . Y ) ) * scale . X;
+	Result . Elements[ 4 ] = ( 2.f * ( q . X * q . Y - q . W * q . Z ) ) * scale . Y;
+	Result . Elements[ 5 ] = ( 1.f - 2.f * ( q . X * q . X + q . Z * q . Z ) ) * scale . Y;
+	Result . Elements[ 6 ] = ( 2.f * ( q . Y * q . Z + q . W * q . X ) ) * scale . Y;
+	Result . Elements[ 8 ] = ( 2.f * ( q . X * q . Z + q . W * q . Y ) ) * scale . Z;
+	Result . Elements[ 9 ] = ( 2.f * ( q . Y * q . Z - q . W * q . X ) ) * scale . Z;
+	Result . Elements[ 10 ] = ( 1.f - 2.f * ( q . X * q . X + q . Y * q . Y ) ) * scale . Z;
+	Result . Elements[ 12 ] = translation . X;
+	Result . Elements[ 13 ] = translation . Y;
+	Result . Elements[ 14 ] = translation . Z;
+	return Result;
+}
+
+float Matrix4::Get ( std::size_t row, std::size_t column ) const
+{
+	return Elements[ column * 4 + row ];
+}
+
+Matrix4 Matrix4::operator * ( const Matrix4 & rhs ) const
+{
+	Matrix4 Result;
+	for ( std::size_t Column = 0; Column < 4; Column ++ ) {
+		for ( std::size_t Row = 0; Row < 4; Row ++ ) {
+			float Sum = 0.f;
+			for ( std::size_t k = 0; k < 4; k ++ ) {
+				Sum += Get ( Row, k ) * rhs . Get ( k, Column );
+			}
+			Result . Elements[ Column * 4 + Row ] = Sum;
+		}
+	}
+	return Result;
+}
+
+TransformComponent::TransformComponent ( EntityHandle owner, EntityHandle parent )
+: ComponentBase ( owner ), m_Parent ( parent )
+{
+
+}
+
+void TransformComponent::SetPosition ( const SpatialPoint & position )
+{
+	m_Position = position;
+	m_IsDirty = true;
+}
+
+const SpatialPoint & TransformComponent::GetPosition () const
+{
+	return m_Position;
+}
+
+void TransformComponent::SetRotation ( const Quaternion & rotation )
+{
+	m_Rotation = rotation;
+	m_IsDirty = true;
+}
+
+const Quaternion & TransformComponent::GetRotation () const
+{
+	return m_Rotation;
+}
+
+void TransformComponent::SetScale ( const SpatialPoint & scale )
+{
+	m_Scale = scale;
+	m_IsDirty = true;
+}
+
+const SpatialPoint & TransformComponent::GetScale () const
+{
+	return m_Scale;
+}
+
+void TransformComponent::SetParent ( EntityHandle parent )
+{
+	m_Parent = parent;
+	m_IsDirty = true;
+	m_IsParentChanged = true;
+}
+
+EntityHandle TransformComponent::GetParent () const
+{
+	return m_Parent;
+}
+
+const Matrix4 & TransformComponent::GetWorldMatrix () const
+{
+	return m_WorldMatrix;
+}
+
+bool TransformComponent::GetIsDirty () const
+{
+	return m_IsDirty;
+}
\ No newline at end of file
@@ -0,0 +1,287 @@
+#include "Laniakea/Scene/TransformSystem.h"
+#include "Laniakea/ECS/ECS.h"
+#include <algorithm>
+#ifdef LANIAKEA_SCENE_SSE
+#include <emmintrin.h>
+#endif
+
+namespace
+{
+	constexpr std::size_t BatchSize = 4; /**< The number of the matrices computed at once. */
+
+	const Matrix4 Identity; /**< The parent matrix of the roots. */
+}
+
+void TransformSystem::Run ( ECS & ecs )
+{
+	const auto Components = ecs . GetComponentsByType <TransformComponent> () . lock ();
+	if ( ! Components )
+	{
+		Update ( {} );
+		return;
+	}
+	const std::span <TransformComponent> Transforms ( Components -> Data (), Components -> Size () );
+	const bool IsChanged = UpdateHierarchy ( Transforms );
+	if ( IsChanged && ! ecs . GetIsComponentGrouped <TransformComponent> () )
+		SortComponents ( * Components );
+	UpdateWorldMatrices ( Transforms, IsChanged );
+}
+
+void TransformSystem::Update ( std::span <TransformComponent> transforms )
+{
+	UpdateWorldMatrices ( transforms, UpdateHierarchy ( transforms ) );
+}
+
+std::span <const Matrix4> TransformSystem::GetWorldMatrices () const
+{
+	return m_WorldMatrices;
+}
+
+std::span <const EntityHandle> TransformSystem::GetEntities () const
+{
+	return m_Entities;
+}
+
+std::size_t TransformSystem::GetLastUpdatedCount () const
+{
+	return m_LastUpdatedCount;
+}
+
+std::size_t TransformSystem::GetLevelsCount () const
+{
+	return m_LevelStarts . empty () ? 0 : m_LevelStarts . size () - 1;
+}
+
+bool TransformSystem::UpdateHierarchy ( std::span <TransformComponent> transforms )
+{
+	bool IsChanged = transforms . size () != m_Owners . size ();
+	for ( std::size_t i = 0; i < transforms . size () && ! IsChanged; i ++ ) {
+		IsChanged = m_Owners[ i ] != transforms[ i ] . GetOwner () || transforms[ i ] . m_IsParentChanged;
+	}
+	if ( IsChanged )
+		BuildHierarchy ( transforms );
+	return IsChanged;
+}
+
+void TransformSystem::BuildHierarchy ( std::span <TransformComponent> transforms )
+{
+	const auto Count = ( std::uint32_t ) transforms . size ();
+	m_Owners . resize ( Count );
+	m_ComponentIndices . clear ();
+	m_ComponentIndices . reserve ( Count );
+	for ( std::uint32_t i = 0; i < Count; i ++ ) {
+		m_Owners[ i ] = transforms[ i ] . GetOwner ();
+		m_ComponentIndices . emplace ( m_Owners[ i ], i );
+	}
+
+	// The scratch holds the parent of each component, the slot of each component and the child lists
+	m_Scratch . assign ( Count * 4 + 1, 0 );
+	const auto Parents = m_Scratch . data ();
+	const auto Slots = Parents + Count;
+	const auto ChildStarts = Slots + Count;
+	const auto Children = ChildStarts + Count + 1;
+	for ( std::uint32_t i = 0; i < Count; i ++ ) {
+		const auto Iterator = m_ComponentIndices . find ( transforms[ i ] . GetParent () );
+		Parents[ i ] = Iterator != m_ComponentIndices . end () && Iterator -> second != i ? Iterator -> second : NoParent;
+		transforms[ i ] . m_IsParentChanged = false;
+		if ( Parents[ i ] != NoParent )
+			ChildStarts[ Parents[ i ] + 1 ] ++;
+	}
+	for ( std::uint32_t i = 0; i < Count; i ++ ) {
+		ChildStarts[ i + 1 ] += ChildStarts[ i ];
+	}
+	// The slots serve as the fill cursors of the child lists until the traversal
+	std::copy ( ChildStarts, ChildStarts + Count, Slots );
+	for ( std::uint32_t i = 0; i < Count; i ++ ) {
+		if ( Parents[ i ] != NoParent )
+			Children[ Slots[ Parents[ i ] ] ++ ] = i;
+	}
+	std::fill ( Slots, Slots + Count, NoParent );
+
+	// Breadth first from the roots, each level starts once the previous one is complete
+	m_Order . clear ();
+	m_LevelStarts . clear ();
+	const auto AddSlot = [ this, Slots ] ( std::uint32_t component )
+	{
+		Slots[ component ] = ( std::uint32_t ) m_Order . size ();
+		m_Order . push_back ( component );
+	};
+	for ( std::uint32_t i = 0; i < Count; i ++ ) {
+		if ( Parents[ i ] == NoParent )
+			AddSlot ( i );
+	}
+	std::uint32_t NextRoot = 0;
+	std::size_t LevelBegin = 0;
+	while ( m_Order . size () < Count || LevelBegin < m_Order . size () )
+	{
+		// The transforms unreachable from the roots form a cycle, it is broken at the first of them
+		if ( LevelBegin == m_Order . size () )
+		{
+			while ( Slots[ NextRoot ] != NoParent )
+				NextRoot ++;
+			Parents[ NextRoot ] = NoParent;
+			AddSlot ( NextRoot );
+		}
+		m_LevelStarts . push_back ( ( std::uint32_t ) LevelBegin );
+		const auto LevelEnd = m_Order . size ();
+		for ( auto Slot = LevelBegin; Slot < LevelEnd; Slot ++ ) {
+			const auto Component = m_Order[ Slot ];
+			for ( auto Child = ChildStarts[ Component ]; Child < ChildStarts[ Component + 1 ]; Child ++ ) {
+				if ( Slots[ Children[ Child ] ] == NoParent )
+					AddSlot ( Children[ Child ] );
+			}
+		}
+		LevelBegin = LevelEnd;
+	}
+	m_LevelStarts . push_back ( Count );
+
+	m_ParentSlots . resize ( Count );
+	m_Entities . resize ( Count );
+	m_WorldMatrices . resize ( Count );
+	for ( std::uint32_t Slot = 0; Slot < Count; Slot ++ ) {
+		const auto Component = m_Order[ Slot ];
+		m_ParentSlots[ Slot ] = Parents[ Component ] != NoParent ? Slots[ Parents[ Component ] ] : NoParent;
+		m_Entities[ Slot ] = m_Owners[ Component ];
+	}
+}
+
+void TransformSystem::SortComponents ( ObjectManager <TransformComponent> & components )
+{
+	// The scratch tracks the current index of each original component and the original component at each index
+	const auto Count = m_Order . size ();
+	m_Scratch . resize ( Count * 2 );
+	const auto Indices = m_Scratch . data ();
+	const auto Components = Indices + Count;
+	for ( std::uint32_t i = 0; i < Count; i ++ ) {
+		Indices[ i ] = i;
+		Components[ i ] = i;
+	}
+	for ( std::uint32_t Slot = 0; Slot < Count; Slot ++ ) {
+		const auto Index = Indices[ m_Order[ Slot ] ];
+		if ( Index == Slot )
+			continue;
+		components . SwapObjectsByIndex ( Slot, Index );
+		const auto Displaced = Components[ Slot ];
+		Components[ Index ] = Displaced;
+		Indices[ Displaced ] = Index;
+		Components[ Slot ] = m_Order[ Slot ];
+		Indices[ m_Order[ Slot ] ] = Slot;
+	}
+	for ( std::uint32_t Slot = 0; Slot < Count; Slot ++ ) {
+		m_Order[ Slot ] = Slot;
+		m_Owners[ Slot ] = m_Entities[ Slot ];
+	}
+}
+
+void TransformSystem::UpdateWorldMatrices ( std::span <TransformComponent> transforms, bool isAllDirty )
+{
+	// The parents precede their children, so the dirty flags flow down the hierarchy in a single pass
+	const auto Count = transforms . size ();
+	m_IsSlotDirty . resize ( Count );
+	for ( std::size_t Slot = 0; Slot < Count; Slot ++ ) {
+		const auto Parent = m_ParentSlots[ Slot ];
+		m_IsSlotDirty[ Slot ] = isAllDirty || transforms[ m_Order[ Slot ] ] . m_IsDirty || ( Parent != NoParent && m_IsSlotDirty[ Parent ] );
+	}
+
+	m_LastUpdatedCount = 0;
+	for ( std::size_t Level = 0; Level + 1 < m_LevelStarts . size (); Level ++ ) {
+		m_DirtySlots . clear ();
+		for ( auto Slot = m_LevelStarts[ Level ]; Slot < m_LevelStarts[ Level + 1 ]; Slot ++ ) {
+			if ( m_IsSlotDirty[ Slot ] )
+				m_DirtySlots . push_back ( Slot );
+		}
+		for ( std::size_t i = 0; i < m_DirtySlots . size (); i += BatchSize ) {
+			ComputeWorldMatrices ( m_DirtySlots . data () + i, std::min ( BatchSize, m_DirtySlots . size () - i ), transforms );
+		}
+		m_LastUpdatedCount += m_DirtySlots . size ();
+	}
+}
+
+void TransformSystem::ComputeWorldMatrices ( const std::uint32_t * slots, std::size_t count, std::span <TransformComponent> transforms )
+{
+#ifdef LANIAKEA_SCENE_SSE
+	// The lanes hold the same element of four transforms, the missing lanes repeat the first transform
+	alignas ( 16 ) float Values[ 10 ][ BatchSize ];
+	const Matrix4 * ParentMatrices[ BatchSize ];
+	for ( std::size_t Lane = 0; Lane < BatchSize; Lane ++ ) {
+		const auto Slot = slots[ Lane < count ? Lane : 0 ];
+		const auto & Transform = transforms[ m_Order[ Slot ] ];
+		const float Local[ 10 ] = { Transform . m_Position . X, Transform . m_Position . Y, Transform . m_Position . Z,
+									Transform . m_Rotation . X, Transform . m_Rotation . Y, Transform . m_Rotation . Z, Transform . m_Rotation . W,
+									Transform . m_Scale . X, Transform . m_Scale . Y, Transform . m_Scale . Z };
+		for ( std::size_t i = 0; i < 10; i ++ ) {
+			Values[ i ][ Lane ] = Local[ i ];
+		}
+		ParentMatrices[ Lane ] = m_ParentSlots[ Slot ] != NoParent ? & m_WorldMatrices[ m_ParentSlots[ Slot ] ] : & Identity;
+	}
+
+	const __m128 One = _mm_set1_ps ( 1.f );
+	const __m128 Two = _mm_set1_ps ( 2.f );
+	const __m128 X = _mm_load_ps ( Values[ 3 ] );
+	const __m128 Y = _mm_load_ps ( Values[ 4 ] );
+	const __m128 Z = _mm_load_ps ( Values[ 5 ] );
+	const __m128 W = _mm_load_ps ( Values[ 6 ] );
+	const __m128 ScaleX = _mm_load_ps ( Values[ 7 ] );
+	const __m128 ScaleY = _mm_load_ps ( Values[ 8 ] );
+	const __m128 ScaleZ = _mm_load_ps ( Values[ 9 ] );
+	const __m128 XX = _mm_mul_ps ( X, X ), YY = _mm_mul_ps ( Y, Y ), ZZ = _mm_mul_ps ( Z, Z );
+	const __m128 XY = _mm_mul_ps ( X, Y ), XZ = _mm_mul_ps ( X, Z ), YZ = _mm_mul_ps ( Y, Z );
+	const __m128 WX = _mm_mul_ps ( W, X ), WY = _mm_mul_ps ( W, Y ), WZ = _mm_mul_ps ( W, Z );
+
+	// The local matrix is affine, its last row is 0 0 0 1 and is not stored
+	__m128 Local[ 3 ][ 4 ];
+	Local[ 0 ][ 0 ] = _mm_mul_ps ( _mm_sub_ps ( One, _mm_mul_ps ( Two, _mm_add_ps ( YY, ZZ ) ) ), ScaleX );
+	Local[ 1 ][ 0 ] = _mm_mul_ps ( _mm_mul_ps ( Two, _mm_add_ps ( XY, WZ ) ), ScaleX );
+	Local[ 2 ][ 0 ] = _mm_mul_ps ( _mm_mul_ps ( Two, _mm_sub_ps ( XZ, WY ) ), ScaleX );
+	Local[ 0 ][ 1 ] = _mm_mul_ps ( _mm_mul_ps ( Two, _mm_sub_ps ( XY, WZ ) ), ScaleY );
+	Local[ 1 ][ 1 ] = _mm_mul_ps ( _mm_sub_ps ( One, _mm_mul_ps ( Two, _mm_add_ps ( XX, ZZ ) ) ), ScaleY );
+	Local[ 2 ][ 1 ] = _mm_mul_ps ( _mm_mul_ps ( Two, _mm_add_ps ( YZ, WX ) ), ScaleY );
+	Local[ 0 ][ 2 ] = _mm_mul_ps ( _mm_mul_ps ( Two, _mm_add_ps ( XZ, WY ) ), ScaleZ );
+	Local[ 1 ][ 2 ] = _mm_mul_ps ( _mm_mul_ps ( Two, _mm_sub_ps ( YZ, WX ) ), ScaleZ );
+	Local[ 2 ][ 2 ] = _mm_mul_ps ( _mm_sub_ps ( One, _mm_mul_ps ( Two, _mm_add_ps ( XX, YY ) ) ), ScaleZ );
+	Local[ 0 ][ 3 ] = _mm_load_ps ( Values[ 0 ] );
+	Local[ 1 ][ 3 ] = _mm_load_ps ( Values[ 1 ] );
+	Local[ 2 ][ 3 ] = _mm_load_ps ( Values[ 2 ] );
+
+	// Transposing the same column of the four parents gives its rows across the lanes
+	__m128 Parent[ 4 ][ 4 ];
+	for ( std::size_t Column = 0; Column < 4; Column ++ ) {
+		__m128 Rows[ 4 ];
+		for ( std::size_t Lane = 0; Lane < BatchSize; Lane ++ ) {
+			Rows[ Lane ] = _mm_loadu_ps ( ParentMatrices[ Lane ] -> Elements + Column * 4 );
+		}
+		_MM_TRANSPOSE4_PS ( Rows[ 0 ], Rows[ 1 ], Rows[ 2 ], Rows[ 3 ] );
+		for ( std::size_t Row = 0; Row < 4; Row ++ ) {
+			Parent[ Row ][ Column ] = Rows[ Row ];
+		}
+	}
+
+	for ( std::size_t Column = 0; Column < 4; Column ++ ) {
+		__m128 World[ 4 ];
+		for ( std::size_t Row = 0; Row < 4; Row ++ ) {
+			World[ Row ] = _mm_add_ps ( _mm_add_ps ( _mm_mul_ps ( Parent[ Row ][ 0 ], Local[ 0 ][ Column ] ), _mm_mul_ps ( Parent[ Row ][ 1 ], Local[ 1 ][ Column ] ) ),
+										_mm_mul_ps ( Parent[ Row ][ 2 ], Local[ 2 ][ Column ] ) );
+			if ( Column == 3 )
+				World[ Row ] = _mm_add_ps ( World[ Row ], Parent[ Row ][ 3 ] );
+		}
+		// Transposed back, each register is the column of one transform
+		_MM_TRANSPOSE4_PS ( World[ 0 ], World[ 1 ], World[ 2 ], World[ 3 ] );
+		for ( std::size_t Lane = 0; Lane < count; Lane ++ ) {
+			_mm_storeu_ps ( m_WorldMatrices[ slots[ Lane ] ] . Elements + Column * 4, World[ Lane ] );
+		}
+	}
+#else
+	for ( std::size_t Lane = 0; Lane < count; Lane ++ ) {
+		const auto Slot = slots[ Lane ];
+		const auto & Transform = transforms[ m_Order[ Slot ] ];
+		const auto & ParentMatrix = m_ParentSlots[ Slot ] != NoParent ? m_WorldMatrices[ m_ParentSlots[ Slot ] ] : Identity;
+		m_WorldMatrices[ Slot ] = ParentMatrix * Matrix4::FromTRS ( Transform . m_Position, Transform . m_Rotation, Transform . m_Scale );
+	}
+#endif
+
+	for ( std::size_t Lane = 0; Lane < count; Lane ++ ) {
+		auto & Transform = transforms[ m_Order[ slots[ Lane ] ] ];
+		Transform . m_WorldMatrix = m_WorldMatrices[ slots[ Lane ] ];
+		Transform . m_IsDirty = false;
+	}
+}
\ No newline at end of file
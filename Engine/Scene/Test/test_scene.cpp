@@ -0,0 +1,187 @@
+#include "gtest/gtest.h"
+#include "Laniakea/ECS/ECS.h"
+#include "Laniakea/Scene/InstanceBuffer.h"
+#include "Laniakea/Scene/TransformSystem.h"
+#include <cmath>
+#include <cstring>
+#include <map>
+#include <random>
+
+#pragma region TestClasses
+class Transforms : public testing::Test
+{
+
+	public:
+		Transforms ()
+		{
+			ecs . RegisterComponent <TransformComponent> ();
+			ecs . RegisterSystem <TransformSystem, TransformComponent> ();
+			System = ecs . GetSystem <TransformSystem> () . lock ();
+		}
+
+		ECS ecs;
+		std::shared_ptr <TransformSystem> System;
+};
+
+Quaternion MakeRotation ( std::default_random_engine & gen )
+{
+	std::uniform_real_distribution <float> value ( - 1.f, 1.f );
+	Quaternion q { value ( gen ), value ( gen ), value ( gen ), value ( gen ) };
+	const float Length = std::sqrt ( q . X * q . X + q . Y * q . Y + q . Z * q . Z + q . W * q . W );
+	return { q . X / Length, q . Y / Length, q . Z / Length, q . W / Length };
+}
+
+Matrix4 GetReferenceWorldMatrix ( ECS & ecs, EntityHandle entity )
+{
+	const auto & Transform = ecs . GetComponent <TransformComponent> ( entity );
+	const auto Local = Matrix4::FromTRS ( Transform . GetPosition (), Transform . GetRotation (), Transform . GetScale () );
+	if ( Transform . GetParent () == NULL_HANDLE || ! ecs . GetEntityHasComponent <TransformComponent> ( Transform . GetParent () ) )
+		return Local;
+	return GetReferenceWorldMatrix ( ecs, Transform . GetParent () ) * Local;
+}
+
+void ExpectMatricesNear ( const Matrix4 & lhs, const Matrix4 & rhs )
+{
+	for ( std::size_t i = 0; i < 16; i ++ ) {
+		EXPECT_NEAR ( lhs . Elements[ i ], rhs . Elements[ i ], 1e-3f * std::max ( 1.f, std::abs ( rhs . Elements[ i ] ) ) );
+	}
+}
+
+void ExpectHierarchyMatches ( ECS & ecs, const TransformSystem & system )
+{
+	std::map <EntityHandle, std::size_t> Slots;
+	for ( std::size_t Slot = 0; Slot < system . GetEntities () . size (); Slot ++ ) {
+		Slots[ system . GetEntities ()[ Slot ] ] = Slot;
+	}
+	for ( std::size_t Slot = 0; Slot < system . GetEntities () . size (); Slot ++ ) {
+		const auto Entity = system . GetEntities ()[ Slot ];
+		const auto & Transform = ecs . GetComponent <TransformComponent> ( Entity );
+		EXPECT_FALSE ( Transform . GetIsDirty () );
+		ExpectMatricesNear ( system . GetWorldMatrices ()[ Slot ], GetReferenceWorldMatrix ( ecs, Entity ) );
+		EXPECT_EQ ( std::memcmp ( & system . GetWorldMatrices ()[ Slot ], & Transform . GetWorldMatrix (), sizeof ( Matrix4 ) ), 0 );
+		if ( Slots . contains ( Transform . GetParent () ) )
+		{
+			EXPECT_LT ( Slots[ Transform . GetParent () ], Slot );
+		}
+	}
+}
+struct RockComponent : public ComponentBase
+{
+	explicit RockComponent ( EntityHandle owner )
+			: ComponentBase ( owner )
+	{};
+};
+#pragma endregion
+
+TEST_F ( Transforms, Propagation )
+{
+	// The parents are created in a random order, so the component order differs from the hierarchy order
+	std::default_random_engine gen;
+	std::uniform_real_distribution <float> value ( - 5.f, 5.f );
+	std::uniform_real_distribution <float> scale ( 0.5f, 1.5f );
+	std::vector <EntityHandle> Entities;
+	for ( int i = 0; i < 2000; i ++ ) {
+		Entities . push_back ( ecs . CreateEntity () );
+	}
+	std::vector <EntityHandle> Ranks = Entities;
+	std::shuffle ( Ranks . begin (), Ranks . end (), gen );
+	for ( std::size_t i = 0; i < Ranks . size (); i ++ ) {
+		const auto Parent = i > 0 && gen () % 5 != 0 ? Ranks[ gen () % i ] : NULL_HANDLE;
+		TransformComponent Transform ( Ranks[ i ], Parent );
+		Transform . SetPosition ( { value ( gen ), value ( gen ), value ( gen ) } );
+		Transform . SetRotation ( MakeRotation ( gen ) );
+		Transform . SetScale ( { scale ( gen ), scale ( gen ), scale ( gen ) } );
+		ecs . AddComponent <TransformComponent> ( Ranks[ i ], Transform );
+	}
+
+	ecs . RunSystem <TransformSystem> ();
+	EXPECT_EQ ( System -> GetLastUpdatedCount (), Entities . size () );
+	EXPECT_GT ( System -> GetLevelsCount (), size_t ( 3 ) );
+	ExpectHierarchyMatches ( ecs, * System );
+
+	ecs . RunSystem <TransformSystem> ();
+	EXPECT_EQ ( System -> GetLastUpdatedCount (), size_t ( 0 ) );
+
+	// Moving one transform recomputes its subtree only
+	const auto Moved = Ranks[ 10 ];
+	std::size_t SubtreeSize = 0;
+	for ( const auto Entity : Entities ) {
+		for ( auto Ancestor = Entity; Ancestor != NULL_HANDLE; Ancestor = ecs . GetComponent <TransformComponent> ( Ancestor ) . GetParent () ) {
+			if ( Ancestor == Moved )
+			{
+				SubtreeSize ++;
+				break;
+			}
+		}
+	}
+	ecs . GetComponent <TransformComponent> ( Moved ) . SetPosition ( { 100.f, 0.f, 0.f } );
+	ecs . RunSystem <TransformSystem> ();
+	EXPECT_EQ ( System -> GetLastUpdatedCount (), SubtreeSize );
+	ExpectHierarchyMatches ( ecs, * System );
+}
+
+TEST_F ( Transforms, Reparenting )
+{
+	const auto a = ecs . CreateEntity ();
+	const auto b = ecs . CreateEntity ();
+	const auto c = ecs . CreateEntity ();
+	for ( const auto e : { a, b, c } ) {
+		TransformComponent Transform ( e );
+		Transform . SetPosition ( { 1.f, 0.f, 0.f } );
+		ecs . AddComponent <TransformComponent> ( e, Transform );
+	}
+	ecs . GetComponent <TransformComponent> ( c ) . SetParent ( b );
+	ecs . GetComponent <TransformComponent> ( b ) . SetParent ( a );
+	ecs . RunSystem <TransformSystem> ();
+	EXPECT_EQ ( System -> GetLevelsCount (), size_t ( 3 ) );
+	EXPECT_FLOAT_EQ ( ecs . GetComponent <TransformComponent> ( c ) . GetWorldMatrix () . Get ( 0, 3 ), 3.f );
+	ExpectHierarchyMatches ( ecs, * System );
+
+	// Removing the parent moves its children to the world space
+	ecs . RemoveEntity ( b );
+	ecs . RunSystem <TransformSystem> ();
+	EXPECT_EQ ( System -> GetLevelsCount (), size_t ( 1 ) );
+	EXPECT_FLOAT_EQ ( ecs . GetComponent <TransformComponent> ( c ) . GetWorldMatrix () . Get ( 0, 3 ), 1.f );
+
+	// The cycle is broken instead of hanging the update
+	ecs . GetComponent <TransformComponent> ( a ) . SetParent ( c );
+	ecs . GetComponent <TransformComponent> ( c ) . SetParent ( a );
+	ecs . RunSystem <TransformSystem> ();
+	EXPECT_EQ ( System -> GetEntities () . size (), size_t ( 2 ) );
+	EXPECT_EQ ( System -> GetLevelsCount (), size_t ( 2 ) );
+	EXPECT_FLOAT_EQ ( System -> GetWorldMatrices ()[ 1 ] . Get ( 0, 3 ), 2.f );
+}
+
+TEST_F ( Transforms, InstanceGather )
+{
+	ecs . RegisterComponent <RockComponent> ();
+	const auto Rocks = ecs . RegisterQuery <TransformComponent, query::With <RockComponent>> ();
+	std::map <EntityHandle, float> Positions;
+	for ( int i = 0; i < 10; i ++ ) {
+		const auto e = ecs . CreateEntity ();
+		TransformComponent Transform ( e );
+		Transform . SetPosition ( { ( float ) i, 0.f, 0.f } );
+		ecs . AddComponent <TransformComponent> ( e, Transform );
+		if ( i % 3 == 0 )
+		{
+			ecs . AddComponent <RockComponent> ( e, RockComponent ( e ) );
+			Positions[ e ] = ( float ) i;
+		}
+	}
+	ecs . RunSystem <TransformSystem> ();
+
+	// Only the rocks are gathered, in the order of the query, appended after the existing matrices
+	std::vector <Matrix4> Matrices ( 1 );
+	EXPECT_EQ ( GatherInstanceTransforms ( ecs, Rocks, Matrices ), size_t ( 4 ) );
+	ASSERT_EQ ( Matrices . size (), size_t ( 5 ) );
+	std::size_t Index = 1;
+	for ( const auto e : Rocks ) {
+		EXPECT_FLOAT_EQ ( Matrices[ Index ++ ] . Get ( 0, 3 ), Positions[ e ] );
+	}
+}
+
+int main ( int argc, char ** argv )
+{
+	testing::InitGoogleTest ( & argc, argv );
+	return RUN_ALL_TESTS ();
+}
\ No newline at end of file